@@ -8,6 +8,7 @@
 
 #include "derivation.h"
 #include "psi_protocol.h"
+#include "serialization_utils.h"
 
 namespace {
 
@@ -223,13 +224,27 @@ AuditResult auditTranscript(const std::vector<TranscriptRecord>& records,
     // function of the peer's blinded points plus Bob's own scalar, so it is
     // recomputable without the peer opening anything).
     //
+    // Alice's blinded flight does not depend on Bob's tag flight
+    // (alicePrepareBlinded), so the two may be recorded in either order; the
+    // flights a recomputation needs are looked up by (turn, level, dir)
+    // rather than expected earlier in the transcript.
+    //
     // Per (level, dir) state while walking the records.
     struct DirState {
         bool haveBobState{false};
         BobSessionState bobState{};
-        const std::vector<unsigned char>* peerTagsBody{nullptr};
     };
     std::map<std::pair<std::uint32_t, std::uint8_t>, DirState> dirStates;
+    auto findBody = [&records](const TranscriptRecord& record,
+                               std::uint8_t msgType) -> const std::vector<unsigned char>* {
+        for (const auto& other : records) {
+            if (other.turn == record.turn && other.level == record.level &&
+                other.dir == record.dir && other.msgType == msgType) {
+                return &other.body;
+            }
+        }
+        return nullptr;
+    };
 
     for (const auto& record : records) {
         if (record.turn != opening.turn) {
@@ -248,12 +263,22 @@ AuditResult auditTranscript(const std::vector<TranscriptRecord>& records,
         switch (record.msgType) {
             case kMsgTypeTags: {
                 if (!accusedSent) {
-                    state.peerTagsBody = &record.body;
                     break;
                 }
+                // The suite and wire format are Bob's choice and travel in
+                // the signed body, so recompute under the ones the flight
+                // names: v1 text transcripts keep auditing exactly as before
+                // either existed. Later flights follow this one's format.
+                const std::string body = bodyToString(record.body);
+                CipherSuite suite = CipherSuite::V1;
+                try {
+                    suite = messageCipherSuite(body);
+                } catch (const std::runtime_error&) {
+                    return fraudAt(record, 0, "tag flight header is malformed");
+                }
                 DeterministicRng rng(seed, record.level, record.dir);
-                auto expected = bobCreateInitialTagMessageFromElements(paddedAccused(), nullptr,
-                                                                       &rng);
+                auto expected = bobCreateInitialTagMessageFromElements(
+                    paddedAccused(), nullptr, &rng, nullptr, suite, messageWireFormat(body));
                 state.bobState = expected.state;
                 state.haveBobState = true;
                 std::size_t offset = 0;
@@ -268,12 +293,13 @@ AuditResult auditTranscript(const std::vector<TranscriptRecord>& records,
                     // transformed flight, handled below via the recorded body.
                     break;
                 }
-                if (state.peerTagsBody == nullptr) {
-                    throw std::runtime_error("Blinded flight without preceding tag flight");
+                const std::vector<unsigned char>* tagsBody = findBody(record, kMsgTypeTags);
+                if (tagsBody == nullptr) {
+                    throw std::runtime_error("Blinded flight without a tag flight");
                 }
                 DeterministicRng rng(seed, record.level, record.dir);
                 auto expected = aliceProcessBobTagMessageFromElements(
-                    bodyToString(*state.peerTagsBody), paddedAccused(), nullptr, &rng);
+                    bodyToString(*tagsBody), paddedAccused(), nullptr, &rng);
                 std::size_t offset = 0;
                 if (firstMismatch(record.body, expected.serialized, offset)) {
                     return fraudAt(record, offset, "blinded flight differs from recomputation");
@@ -292,15 +318,8 @@ AuditResult auditTranscript(const std::vector<TranscriptRecord>& records,
                     // we cannot have gotten here without the throw above.
                     throw std::runtime_error("Transformed flight without preceding tag flight");
                 }
-                // Find the peer's blinded body for this (level, dir).
-                const std::vector<unsigned char>* blindedBody = nullptr;
-                for (const auto& other : records) {
-                    if (other.turn == record.turn && other.level == record.level &&
-                        other.dir == record.dir && other.msgType == kMsgTypeBlinded) {
-                        blindedBody = &other.body;
-                        break;
-                    }
-                }
+                const std::vector<unsigned char>* blindedBody =
+                    findBody(record, kMsgTypeBlinded);
                 if (blindedBody == nullptr) {
                     throw std::runtime_error("Transformed flight without a blinded flight");
                 }
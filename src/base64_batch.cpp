@@ -0,0 +1,203 @@
+#include "base64_batch.h"
+
+#include <array>
+#include <atomic>
+#include <stdexcept>
+
+namespace {
+
+constexpr char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+// Character to 6-bit value, 0xff outside the alphabet.
+constexpr std::array<unsigned char, 256> makeDecodeTable() {
+    std::array<unsigned char, 256> table{};
+    for (auto& entry : table) {
+        entry = 0xff;
+    }
+    for (unsigned i = 0; i < 64; ++i) {
+        table[static_cast<unsigned char>(kAlphabet[i])] = static_cast<unsigned char>(i);
+    }
+    return table;
+}
+
+constexpr std::array<unsigned char, 256> kDecodeTable = makeDecodeTable();
+
+// -1 until first use, then the Base64Backend value.
+std::atomic<int> activeBackend{-1};
+
+// Three bytes to four characters.
+inline void encodeGroup(const unsigned char* in, char* out) {
+    const unsigned word = (static_cast<unsigned>(in[0]) << 16) |
+                          (static_cast<unsigned>(in[1]) << 8) | in[2];
+    out[0] = kAlphabet[(word >> 18) & 63];
+    out[1] = kAlphabet[(word >> 12) & 63];
+    out[2] = kAlphabet[(word >> 6) & 63];
+    out[3] = kAlphabet[word & 63];
+}
+
+// The last 1 or 2 bytes to 2 or 3 characters; unused low bits are zero.
+inline void encodeTail(const unsigned char* in, std::size_t size, char* out) {
+    const unsigned word = (static_cast<unsigned>(in[0]) << 16) |
+                          (size == 2 ? static_cast<unsigned>(in[1]) << 8 : 0u);
+    out[0] = kAlphabet[(word >> 18) & 63];
+    out[1] = kAlphabet[(word >> 12) & 63];
+    if (size == 2) {
+        out[2] = kAlphabet[(word >> 6) & 63];
+    }
+}
+
+// Four characters to three bytes; false on a character outside the alphabet.
+inline bool decodeGroup(const char* in, unsigned char* out) {
+    const unsigned a = kDecodeTable[static_cast<unsigned char>(in[0])];
+    const unsigned b = kDecodeTable[static_cast<unsigned char>(in[1])];
+    const unsigned c = kDecodeTable[static_cast<unsigned char>(in[2])];
+    const unsigned d = kDecodeTable[static_cast<unsigned char>(in[3])];
+    if ((a | b | c | d) > 63) {
+        return false;
+    }
+    const unsigned word = (a << 18) | (b << 12) | (c << 6) | d;
+    out[0] = static_cast<unsigned char>(word >> 16);
+    out[1] = static_cast<unsigned char>(word >> 8);
+    out[2] = static_cast<unsigned char>(word);
+    return true;
+}
+
+// Bytes 24..31 of a value from characters 32..42: two full groups, then two
+// bytes from three characters whose last two bits must be zero.
+inline bool decodeValueTail(const char* in, unsigned char* out) {
+    if (!decodeGroup(in, out) || !decodeGroup(in + 4, out + 3)) {
+        return false;
+    }
+    const unsigned a = kDecodeTable[static_cast<unsigned char>(in[8])];
+    const unsigned b = kDecodeTable[static_cast<unsigned char>(in[9])];
+    const unsigned c = kDecodeTable[static_cast<unsigned char>(in[10])];
+    if ((a | b | c) > 63 || (c & 3) != 0) {
+        return false;
+    }
+    const unsigned word = (a << 12) | (b << 6) | c;
+    out[6] = static_cast<unsigned char>(word >> 10);
+    out[7] = static_cast<unsigned char>(word >> 2);
+    return true;
+}
+
+bool decodeValuePortable(const char* in, unsigned char* out) {
+    for (std::size_t group = 0; group < 8; ++group) {
+        if (!decodeGroup(in + 4 * group, out + 3 * group)) {
+            return false;
+        }
+    }
+    return decodeValueTail(in + 32, out + 24);
+}
+
+void encodeValuePortable(const unsigned char* in, char* out) {
+    for (std::size_t group = 0; group < 10; ++group) {
+        encodeGroup(in + 3 * group, out + 4 * group);
+    }
+    encodeTail(in + 30, 2, out + 40);
+}
+
+}  // namespace
+
+const char* base64BackendName(Base64Backend backend) {
+    switch (backend) {
+        case Base64Backend::Portable:
+            return "portable";
+        case Base64Backend::Avx2:
+            return "avx2";
+    }
+    return "unknown";
+}
+
+Base64Backend parseBase64Backend(const std::string& name) {
+    for (const auto backend : {Base64Backend::Portable, Base64Backend::Avx2}) {
+        if (name == base64BackendName(backend)) {
+            return backend;
+        }
+    }
+    throw std::runtime_error("Unknown base64 backend: " + name);
+}
+
+bool base64BackendSupported(Base64Backend backend) {
+    switch (backend) {
+        case Base64Backend::Portable:
+            return true;
+        case Base64Backend::Avx2:
+            return cpuFeatures().avx2;
+    }
+    return false;
+}
+
+Base64Backend activeBase64Backend() {
+    int backend = activeBackend.load(std::memory_order_relaxed);
+    if (backend < 0) {
+        backend = static_cast<int>(base64BackendSupported(Base64Backend::Avx2)
+                                       ? Base64Backend::Avx2
+                                       : Base64Backend::Portable);
+        activeBackend.store(backend, std::memory_order_relaxed);
+    }
+    return static_cast<Base64Backend>(backend);
+}
+
+void setBase64Backend(Base64Backend backend) {
+    if (!base64BackendSupported(backend)) {
+        throw std::runtime_error(std::string("base64 backend not supported on this CPU: ") +
+                                 base64BackendName(backend));
+    }
+    activeBackend.store(static_cast<int>(backend), std::memory_order_relaxed);
+}
+
+void base64EncodeBatch32(const unsigned char* values, std::size_t count, char* out,
+                         std::size_t stride) {
+#if defined(PSI_HAVE_X86_CPUID)
+    if (activeBase64Backend() == Base64Backend::Avx2) {
+        for (std::size_t i = 0; i < count; ++i) {
+            const unsigned char* in = values + i * kBase64ValueBytes;
+            char* encoded = out + i * stride;
+            base64Encode24Avx2(in, encoded);
+            encodeGroup(in + 24, encoded + 32);
+            encodeGroup(in + 27, encoded + 36);
+            encodeTail(in + 30, 2, encoded + 40);
+        }
+        return;
+    }
+#endif
+    for (std::size_t i = 0; i < count; ++i) {
+        encodeValuePortable(values + i * kBase64ValueBytes, out + i * stride);
+    }
+}
+
+std::size_t base64DecodeBatch32(const char* in, std::size_t stride, std::size_t count,
+                                unsigned char* values) {
+#if defined(PSI_HAVE_X86_CPUID)
+    if (activeBase64Backend() == Base64Backend::Avx2) {
+        for (std::size_t i = 0; i < count; ++i) {
+            const char* encoded = in + i * stride;
+            unsigned char* out = values + i * kBase64ValueBytes;
+            if (!base64Decode32Avx2(encoded, out) || !decodeValueTail(encoded + 32, out + 24)) {
+                return i;
+            }
+        }
+        return count;
+    }
+#endif
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!decodeValuePortable(in + i * stride, values + i * kBase64ValueBytes)) {
+            return i;
+        }
+    }
+    return count;
+}
+
+std::size_t base64EncodedLength(std::size_t size) {
+    return size / 3 * 4 + (size % 3 == 0 ? 0 : size % 3 + 1);
+}
+
+void base64EncodeTo(const unsigned char* data, std::size_t size, char* out) {
+    const std::size_t groups = size / 3;
+    for (std::size_t group = 0; group < groups; ++group) {
+        encodeGroup(data + 3 * group, out + 4 * group);
+    }
+    if (size % 3 != 0) {
+        encodeTail(data + 3 * groups, size % 3, out + 4 * groups);
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef BASE64_BATCH_H
+#define BASE64_BATCH_H
+
+// Batched base64 for the text and JSON wire paths: the unpadded URL-safe
+// variant (sodium_base64_VARIANT_URLSAFE_NO_PADDING) of many 32-byte values,
+// encoded into or decoded from one caller-owned buffer with no allocation per
+// value. A 32-byte value is always 43 characters; values sit `stride` bytes
+// apart, so text flights (43 characters and a newline) and JSON objects are
+// filled in place.
+//
+// Output is byte-identical to libsodium's. Decoding accepts what libsodium
+// accepts for that variant (no padding, no whitespace, and the two unused low
+// bits of the last character must be zero) with one exception: libsodium
+// 1.0.18 reads any byte from 0x80 up as '_' where char is signed, and these
+// decoders reject such bytes, so every value has exactly one encoding.
+//
+// The AVX2 backend handles 24 bytes (32 characters) of each value in vector
+// registers and the rest like the portable one. The backend is picked from
+// CPUID like the SHA-512 backend (sha512_batch.h) and can be pinned for tests
+// and benchmarks.
+
+#include <cstddef>
+#include <string>
+
+#include "cpu_features.h"
+
+inline constexpr std::size_t kBase64ValueBytes = 32;
+inline constexpr std::size_t kBase64ValueChars = 43;
+
+enum class Base64Backend {
+    Portable,
+    Avx2,
+};
+
+const char* base64BackendName(Base64Backend backend);
+
+// Inverse of base64BackendName; throws std::runtime_error on unknown names.
+Base64Backend parseBase64Backend(const std::string& name);
+
+bool base64BackendSupported(Base64Backend backend);
+
+// The widest supported backend unless setBase64Backend chose another.
+Base64Backend activeBase64Backend();
+
+// Throws std::runtime_error if the backend is not supported here.
+void setBase64Backend(Base64Backend backend);
+
+// Encodes values[i * 32, i * 32 + 32) to out[i * stride, i * stride + 43) for
+// i in [0, count). Bytes between the values are left alone.
+void base64EncodeBatch32(const unsigned char* values, std::size_t count, char* out,
+                         std::size_t stride);
+
+// Inverse of base64EncodeBatch32. Returns count when every value decodes,
+// otherwise the index of the first one that does not (values before it are
+// decoded, the rest are unspecified).
+std::size_t base64DecodeBatch32(const char* in, std::size_t stride, std::size_t count,
+                                unsigned char* values);
+
+// Any length: the number of characters base64EncodeTo writes, and the
+// encoding itself (portable; for nonces and ciphertexts).
+std::size_t base64EncodedLength(std::size_t size);
+void base64EncodeTo(const unsigned char* data, std::size_t size, char* out);
+
+#if defined(PSI_HAVE_X86_CPUID)
+
+// Kernels (base64_batch_x86.cpp): the first 24 bytes of a value to its first
+// 32 characters, and back. The decoder returns false on any character
+// outside the alphabet.
+void base64Encode24Avx2(const unsigned char* in, char* out);
+bool base64Decode32Avx2(const char* in, unsigned char* out);
+
+#endif  // PSI_HAVE_X86_CPUID
+
+#endif // BASE64_BATCH_H
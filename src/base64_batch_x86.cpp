@@ -0,0 +1,91 @@
+// AVX2 base64 for 32-byte values, after Muła and Lemire's vector codec: the
+// first 24 bytes of a value are one register of 32 characters. Encoding
+// spreads each 3-byte group over four 6-bit indices with two multiplies and
+// maps them to the URL-safe alphabet with one byte shuffle; decoding
+// range-checks every character, maps it back and packs the indices with two
+// multiply-adds. Like sha512_batch_x86.cpp, the vector code carries target
+// attributes instead of the file being built with -mavx2.
+
+#include "base64_batch.h"
+
+#if defined(PSI_HAVE_X86_CPUID)
+
+#include <immintrin.h>
+
+#define PSI_AVX2 __attribute__((target("avx2")))
+
+PSI_AVX2 void base64Encode24Avx2(const unsigned char* in, char* out) {
+    // Bytes 0..11 in the low lane and 12..23 in the high one; both loads stay
+    // inside the 32-byte value.
+    const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 12));
+    __m256i bytes = _mm256_set_m128i(high, low);
+
+    // Each dword holds one group [a b c] as b a c b, so the four indices can
+    // be cut out with 16-bit multiplies.
+    bytes = _mm256_shuffle_epi8(
+        bytes, _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+    const __m256i ac = _mm256_mulhi_epu16(_mm256_and_si256(bytes, _mm256_set1_epi32(0x0fc0fc00)),
+                                          _mm256_set1_epi32(0x04000040));
+    const __m256i bd = _mm256_mullo_epi16(_mm256_and_si256(bytes, _mm256_set1_epi32(0x003f03f0)),
+                                          _mm256_set1_epi32(0x01000010));
+    const __m256i indices = _mm256_or_si256(ac, bd);
+
+    // Offset per index range: 0..25 'A', 26..51 'a' - 26, 52..61 '0' - 52,
+    // 62 '-' - 62, 63 '_' - 63. Saturating subtraction sends 0..51 to 0,
+    // 52..63 to 1..12; the letters are then told apart and 0..25 moved to 13.
+    __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    const __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+    range = _mm256_or_si256(range, _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+    const __m256i offsets = _mm256_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '-' - 62, '_' - 63, 'A', 0, 0,
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '-' - 62, '_' - 63, 'A', 0, 0);
+    const __m256i encoded = _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), indices);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), encoded);
+}
+
+PSI_AVX2 bool base64Decode32Avx2(const char* in, unsigned char* out) {
+    const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+
+    // Signed compares: bytes from 0x80 up are negative and fall in no range.
+    auto inRange = [&chars](char first, char last) PSI_AVX2 {
+        return _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8(first - 1)),
+                                _mm256_cmpgt_epi8(_mm256_set1_epi8(last + 1), chars));
+    };
+    const __m256i upper = inRange('A', 'Z');
+    const __m256i lower = inRange('a', 'z');
+    const __m256i digit = inRange('0', '9');
+    const __m256i dash = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('-'));
+    const __m256i underscore = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('_'));
+    const __m256i valid = _mm256_or_si256(_mm256_or_si256(upper, lower),
+                                          _mm256_or_si256(digit, _mm256_or_si256(dash, underscore)));
+    if (_mm256_movemask_epi8(valid) != -1) {
+        return false;
+    }
+
+    __m256i shift = _mm256_and_si256(upper, _mm256_set1_epi8(-'A'));
+    shift = _mm256_or_si256(shift, _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a')));
+    shift = _mm256_or_si256(shift, _mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')));
+    shift = _mm256_or_si256(shift, _mm256_and_si256(dash, _mm256_set1_epi8(62 - '-')));
+    shift = _mm256_or_si256(shift, _mm256_and_si256(underscore, _mm256_set1_epi8(63 - '_')));
+    const __m256i indices = _mm256_add_epi8(chars, shift);
+
+    // Pairs of indices to 12-bit words, pairs of words to 24-bit groups, then
+    // the three bytes of every group in order at the front of each lane.
+    const __m256i words = _mm256_maddubs_epi16(indices, _mm256_set1_epi32(0x01400140));
+    const __m256i groups = _mm256_madd_epi16(words, _mm256_set1_epi32(0x00011000));
+    const __m256i packed = _mm256_shuffle_epi8(
+        groups, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    // 16-byte stores of 12 useful bytes each; the second overwrites the
+    // first's spare bytes and its own land in bytes 24..27, which the caller
+    // decodes next.
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(packed));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm256_extracti128_si256(packed, 1));
+    return true;
+}
+
+#endif  // PSI_HAVE_X86_CPUID
@@ -0,0 +1,182 @@
+// Single-block BLAKE3 root compressions across SIMD lanes, one independent
+// input per 32-bit lane, eight to an AVX2 register. There is no AVX-512F
+// kernel, as the library itself is built with BLAKE3_NO_AVX512. Every input
+// the batch API accepts fits in one block, so each lane is exactly one
+// compression with CHUNK_START | CHUNK_END | ROOT and counter 0; the vendored
+// kernels (third_party/blake3) only batch whole 64-byte blocks and cannot
+// express the shorter final block these inputs need. The Xof kernels take a
+// block length per lane and return the whole 64-byte output block. As in
+// sha512_batch_x86.cpp the vector code carries target attributes instead of
+// file-wide ISA flags.
+
+#include "blake3_utils.h"
+
+#if defined(PSI_HAVE_X86_CPUID)
+
+#include <immintrin.h>
+
+#define PSI_AVX2 __attribute__((target("avx2")))
+
+namespace {
+
+constexpr std::uint32_t kIv[8] = {0x6A09E667UL, 0xBB67AE85UL, 0x3C6EF372UL, 0xA54FF53AUL,
+                                  0x510E527FUL, 0x9B05688CUL, 0x1F83D9ABUL, 0x5BE0CD19UL};
+
+constexpr std::uint8_t kSchedule[7][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8},
+    {3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1},
+    {10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6},
+    {12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4},
+    {9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7},
+    {11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13},
+};
+
+// ---------------------------------------------------------------------------
+// AVX2, eight lanes. Inputs and outputs move through 8x8 word transposes.
+
+PSI_AVX2 inline __m256i rotBytes(__m256i x, __m256i shuffle) {
+    return _mm256_shuffle_epi8(x, shuffle);
+}
+
+PSI_AVX2 inline __m256i rotShift(__m256i x, int n) {
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+// The G function on eight lanes; rotations by 16 and 8 are byte shuffles.
+PSI_AVX2 inline void mix8(__m256i& a, __m256i& b, __m256i& c, __m256i& d, __m256i x,
+                          __m256i y) {
+    const __m256i r16 = _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2, 13,
+                                        12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+    const __m256i r8 = _mm256_set_epi8(12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1, 12,
+                                       15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1);
+    a = _mm256_add_epi32(_mm256_add_epi32(a, b), x);
+    d = rotBytes(_mm256_xor_si256(d, a), r16);
+    c = _mm256_add_epi32(c, d);
+    b = rotShift(_mm256_xor_si256(b, c), 12);
+    a = _mm256_add_epi32(_mm256_add_epi32(a, b), y);
+    d = rotBytes(_mm256_xor_si256(d, a), r8);
+    c = _mm256_add_epi32(c, d);
+    b = rotShift(_mm256_xor_si256(b, c), 7);
+}
+
+PSI_AVX2 inline void rounds8(__m256i v[16], const __m256i m[16]) {
+    for (const auto& s : kSchedule) {
+        mix8(v[0], v[4], v[8], v[12], m[s[0]], m[s[1]]);
+        mix8(v[1], v[5], v[9], v[13], m[s[2]], m[s[3]]);
+        mix8(v[2], v[6], v[10], v[14], m[s[4]], m[s[5]]);
+        mix8(v[3], v[7], v[11], v[15], m[s[6]], m[s[7]]);
+        mix8(v[0], v[5], v[10], v[15], m[s[8]], m[s[9]]);
+        mix8(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+        mix8(v[2], v[7], v[8], v[13], m[s[12]], m[s[13]]);
+        mix8(v[3], v[4], v[9], v[14], m[s[14]], m[s[15]]);
+    }
+}
+
+PSI_AVX2 void transpose8(__m256i v[8]) {
+    const __m256i ab0145 = _mm256_unpacklo_epi32(v[0], v[1]);
+    const __m256i ab2367 = _mm256_unpackhi_epi32(v[0], v[1]);
+    const __m256i cd0145 = _mm256_unpacklo_epi32(v[2], v[3]);
+    const __m256i cd2367 = _mm256_unpackhi_epi32(v[2], v[3]);
+    const __m256i ef0145 = _mm256_unpacklo_epi32(v[4], v[5]);
+    const __m256i ef2367 = _mm256_unpackhi_epi32(v[4], v[5]);
+    const __m256i gh0145 = _mm256_unpacklo_epi32(v[6], v[7]);
+    const __m256i gh2367 = _mm256_unpackhi_epi32(v[6], v[7]);
+
+    const __m256i abcd04 = _mm256_unpacklo_epi64(ab0145, cd0145);
+    const __m256i abcd15 = _mm256_unpackhi_epi64(ab0145, cd0145);
+    const __m256i abcd26 = _mm256_unpacklo_epi64(ab2367, cd2367);
+    const __m256i abcd37 = _mm256_unpackhi_epi64(ab2367, cd2367);
+    const __m256i efgh04 = _mm256_unpacklo_epi64(ef0145, gh0145);
+    const __m256i efgh15 = _mm256_unpackhi_epi64(ef0145, gh0145);
+    const __m256i efgh26 = _mm256_unpacklo_epi64(ef2367, gh2367);
+    const __m256i efgh37 = _mm256_unpackhi_epi64(ef2367, gh2367);
+
+    v[0] = _mm256_permute2x128_si256(abcd04, efgh04, 0x20);
+    v[1] = _mm256_permute2x128_si256(abcd15, efgh15, 0x20);
+    v[2] = _mm256_permute2x128_si256(abcd26, efgh26, 0x20);
+    v[3] = _mm256_permute2x128_si256(abcd37, efgh37, 0x20);
+    v[4] = _mm256_permute2x128_si256(abcd04, efgh04, 0x31);
+    v[5] = _mm256_permute2x128_si256(abcd15, efgh15, 0x31);
+    v[6] = _mm256_permute2x128_si256(abcd26, efgh26, 0x31);
+    v[7] = _mm256_permute2x128_si256(abcd37, efgh37, 0x31);
+}
+
+// Runs the seven rounds for eight lanes; lane l compresses blocks[l] with
+// block length lane l of blockLengths.
+PSI_AVX2 void state8(const std::uint32_t key[8], const unsigned char blocks[8][64],
+                     __m256i blockLengths, unsigned flags, __m256i v[16]) {
+    __m256i m[16];
+    for (int lane = 0; lane < 8; ++lane) {
+        m[lane] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blocks[lane]));
+        m[lane + 8] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blocks[lane] + 32));
+    }
+    transpose8(m);
+    transpose8(m + 8);
+
+    for (int i = 0; i < 8; ++i) {
+        v[i] = _mm256_set1_epi32(static_cast<int>(key[i]));
+    }
+    for (int i = 0; i < 4; ++i) {
+        v[8 + i] = _mm256_set1_epi32(static_cast<int>(kIv[i]));
+    }
+    v[12] = _mm256_setzero_si256();
+    v[13] = _mm256_setzero_si256();
+    v[14] = blockLengths;
+    v[15] = _mm256_set1_epi32(static_cast<int>(flags));
+    rounds8(v, m);
+}
+
+// Stores words [0, 8) of each lane's output block at out[lane] + offset.
+PSI_AVX2 void storeLanes8(__m256i h[8], unsigned char* out, std::size_t stride,
+                          std::size_t offset) {
+    transpose8(h);
+    for (int lane = 0; lane < 8; ++lane) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + lane * stride + offset), h[lane]);
+    }
+}
+
+PSI_AVX2 void compress8(const std::uint32_t key[8], const unsigned char blocks[8][64],
+                        unsigned blockLength, unsigned flags, unsigned char out[8][32]) {
+    __m256i v[16];
+    state8(key, blocks, _mm256_set1_epi32(static_cast<int>(blockLength)), flags, v);
+    __m256i h[8];
+    for (int i = 0; i < 8; ++i) {
+        h[i] = _mm256_xor_si256(v[i], v[i + 8]);
+    }
+    storeLanes8(h, out[0], 32, 0);
+}
+
+// Full 64-byte root output: the second half is the upper state words folded
+// with the chaining value, as in BLAKE3's compress_xof.
+PSI_AVX2 void compressXof8(const std::uint32_t key[8], const unsigned char blocks[8][64],
+                           const unsigned blockLengths[8], unsigned flags,
+                           unsigned char out[8][64]) {
+    __m256i v[16];
+    state8(key, blocks, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blockLengths)), flags,
+           v);
+    __m256i h[8];
+    for (int i = 0; i < 8; ++i) {
+        h[i] = _mm256_xor_si256(v[i], v[i + 8]);
+    }
+    storeLanes8(h, out[0], 64, 0);
+    for (int i = 0; i < 8; ++i) {
+        h[i] = _mm256_xor_si256(v[i + 8], _mm256_set1_epi32(static_cast<int>(key[i])));
+    }
+    storeLanes8(h, out[0], 64, 32);
+}
+
+}  // namespace
+
+void blake3CompressBlocks8Avx2(const std::uint32_t key[8], const unsigned char blocks[8][64],
+                               unsigned blockLength, unsigned flags, unsigned char out[8][32]) {
+    compress8(key, blocks, blockLength, flags, out);
+}
+
+void blake3CompressBlocksXof8Avx2(const std::uint32_t key[8], const unsigned char blocks[8][64],
+                                  const unsigned blockLengths[8], unsigned flags,
+                                  unsigned char out[8][64]) {
+    compressXof8(key, blocks, blockLengths, flags, out);
+}
+
+#endif  // PSI_HAVE_X86_CPUID
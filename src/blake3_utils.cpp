@@ -1,11 +1,126 @@
 #include "blake3_utils.h"
 
+#include <cstring>
 #include <stdexcept>
 
 extern "C" {
 #include "blake3.h"
+#include <sodium.h>
 }
 
+namespace {
+
+// blake3_impl.h flag bits for a single-block (hence single-chunk, root)
+// input, plus the derive_key material bit.
+constexpr unsigned kChunkStart = 1U << 0;
+constexpr unsigned kChunkEnd = 1U << 1;
+constexpr unsigned kRoot = 1U << 3;
+constexpr unsigned kDeriveKeyMaterial = 1U << 6;
+
+// Runs the whole-lane groups of inputs through the SIMD kernels and returns
+// how many inputs it covered; the caller hashes the rest one by one.
+std::size_t compressManyInLanes(const std::uint32_t key[8], unsigned flags,
+                                const unsigned char* const* inputs, std::size_t inputLength,
+                                std::size_t count, std::array<unsigned char, 32>* out) {
+    std::size_t done = 0;
+#if defined(PSI_HAVE_X86_CPUID)
+    if (!cpuFeatures().avx2) {
+        return done;
+    }
+    unsigned char blocks[8][BLAKE3_BLOCK_LEN];
+    unsigned char digests[8][BLAKE3_OUT_LEN];
+    for (; done + 8 <= count; done += 8) {
+        for (std::size_t lane = 0; lane < 8; ++lane) {
+            std::memset(blocks[lane], 0, sizeof blocks[lane]);
+            if (inputLength != 0) {
+                std::memcpy(blocks[lane], inputs[done + lane], inputLength);
+            }
+        }
+        blake3CompressBlocks8Avx2(key, blocks, static_cast<unsigned>(inputLength), flags, digests);
+        for (std::size_t lane = 0; lane < 8; ++lane) {
+            std::memcpy(out[done + lane].data(), digests[lane], BLAKE3_OUT_LEN);
+        }
+    }
+    sodium_memzero(blocks, sizeof blocks);
+    sodium_memzero(digests, sizeof digests);
+#else
+    (void)key;
+    (void)flags;
+    (void)inputs;
+    (void)inputLength;
+    (void)count;
+    (void)out;
+#endif
+    return done;
+}
+
+// compressManyInLanes for 64-byte outputs of inputs with their own lengths.
+// Groups are taken in index order and only from inputs that fit one block;
+// the returned flags mark which inputs were covered.
+std::vector<bool> compressXofInLanes(const std::uint32_t key[8], unsigned flags,
+                                     const unsigned char* const* inputs,
+                                     const std::size_t* lengths, std::size_t count,
+                                     Blake3Xof64* out) {
+    std::vector<bool> covered(count, false);
+#if defined(PSI_HAVE_X86_CPUID)
+    if (!cpuFeatures().avx2) {
+        return covered;
+    }
+    std::vector<std::size_t> pending;
+    pending.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (lengths[i] <= BLAKE3_BLOCK_LEN) {
+            pending.push_back(i);
+        }
+    }
+    unsigned char blocks[8][BLAKE3_BLOCK_LEN];
+    unsigned blockLengths[8];
+    unsigned char outputs[8][2 * BLAKE3_OUT_LEN];
+    for (std::size_t next = 0; next + 8 <= pending.size(); next += 8) {
+        for (std::size_t lane = 0; lane < 8; ++lane) {
+            const std::size_t index = pending[next + lane];
+            std::memset(blocks[lane], 0, sizeof blocks[lane]);
+            if (lengths[index] != 0) {
+                std::memcpy(blocks[lane], inputs[index], lengths[index]);
+            }
+            blockLengths[lane] = static_cast<unsigned>(lengths[index]);
+        }
+        blake3CompressBlocksXof8Avx2(key, blocks, blockLengths, flags, outputs);
+        for (std::size_t lane = 0; lane < 8; ++lane) {
+            const std::size_t index = pending[next + lane];
+            std::memcpy(out[index].data(), outputs[lane], out[index].size());
+            covered[index] = true;
+        }
+    }
+    sodium_memzero(blocks, sizeof blocks);
+    sodium_memzero(outputs, sizeof outputs);
+#else
+    (void)key;
+    (void)flags;
+    (void)inputs;
+    (void)lengths;
+    (void)out;
+#endif
+    return covered;
+}
+
+void requireSingleBlock(std::size_t inputLength) {
+    if (inputLength > BLAKE3_BLOCK_LEN) {
+        throw std::invalid_argument("BLAKE3 batch inputs must fit one 64-byte block");
+    }
+}
+
+std::vector<const unsigned char*> arrayPointers(const std::array<unsigned char, 32>* inputs,
+                                                std::size_t count) {
+    std::vector<const unsigned char*> pointers(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        pointers[i] = inputs[i].data();
+    }
+    return pointers;
+}
+
+}  // namespace
+
 std::array<unsigned char, 32> blake3Hash(const unsigned char* data, std::size_t size) {
     if (data == nullptr && size != 0) {
         throw std::invalid_argument("blake3Hash received null data with non-zero size");
@@ -58,3 +173,76 @@ std::array<unsigned char, 32> blake3DeriveKey(const std::string& context,
                                               const std::array<unsigned char, 32>& material) {
     return blake3DeriveKey(context, material.data(), material.size());
 }
+
+void blake3HashMany(const unsigned char* const* inputs, std::size_t inputLength,
+                    std::size_t count, std::array<unsigned char, 32>* out) {
+    requireSingleBlock(inputLength);
+    blake3_hasher hasher;
+    blake3_hasher_init(&hasher);
+    std::size_t i = compressManyInLanes(hasher.key, kChunkStart | kChunkEnd | kRoot, inputs,
+                                        inputLength, count, out);
+    for (; i < count; ++i) {
+        out[i] = blake3Hash(inputs[i], inputLength);
+    }
+}
+
+void blake3DeriveKeyMany(const std::string& context, const unsigned char* const* inputs,
+                         std::size_t inputLength, std::size_t count,
+                         std::array<unsigned char, 32>* out) {
+    requireSingleBlock(inputLength);
+    // The context hash becomes the chaining value every material input
+    // starts from; blake3_hasher keeps it in its key words.
+    blake3_hasher hasher;
+    blake3_hasher_init_derive_key(&hasher, context.c_str());
+    std::size_t i = compressManyInLanes(hasher.key,
+                                        kChunkStart | kChunkEnd | kRoot | kDeriveKeyMaterial,
+                                        inputs, inputLength, count, out);
+    for (; i < count; ++i) {
+        out[i] = blake3DeriveKey(context, inputs[i], inputLength);
+    }
+}
+
+void blake3HashMany(const std::array<unsigned char, 32>* inputs, std::size_t count,
+                    std::array<unsigned char, 32>* out) {
+    const auto pointers = arrayPointers(inputs, count);
+    blake3HashMany(pointers.data(), 32, count, out);
+}
+
+void blake3DeriveKeyMany(const std::string& context, const std::array<unsigned char, 32>* inputs,
+                         std::size_t count, std::array<unsigned char, 32>* out) {
+    const auto pointers = arrayPointers(inputs, count);
+    blake3DeriveKeyMany(context, pointers.data(), 32, count, out);
+}
+
+Blake3Xof64 blake3DeriveKeyXof64(const std::string& context, const unsigned char* material,
+                                 std::size_t size) {
+    if (material == nullptr && size != 0) {
+        throw std::invalid_argument(
+            "blake3DeriveKeyXof64 received null material with non-zero size");
+    }
+
+    blake3_hasher hasher;
+    blake3_hasher_init_derive_key(&hasher, context.c_str());
+
+    if (size > 0) {
+        blake3_hasher_update(&hasher, material, size);
+    }
+
+    Blake3Xof64 output{};
+    blake3_hasher_finalize(&hasher, output.data(), output.size());
+    return output;
+}
+
+void blake3DeriveKeyXof64Many(const std::string& context, const unsigned char* const* inputs,
+                              const std::size_t* lengths, std::size_t count, Blake3Xof64* out) {
+    blake3_hasher hasher;
+    blake3_hasher_init_derive_key(&hasher, context.c_str());
+    const auto covered =
+        compressXofInLanes(hasher.key, kChunkStart | kChunkEnd | kRoot | kDeriveKeyMaterial,
+                           inputs, lengths, count, out);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!covered[i]) {
+            out[i] = blake3DeriveKeyXof64(context, inputs[i], lengths[i]);
+        }
+    }
+}
@@ -3,9 +3,12 @@
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include "cpu_features.h"
+
 // Returns the 32-byte BLAKE3 hash of an arbitrary byte buffer.
 std::array<unsigned char, 32> blake3Hash(const unsigned char* data, std::size_t size);
 
@@ -29,4 +32,50 @@ std::array<unsigned char, 32> blake3DeriveKey(const std::string& context,
 std::array<unsigned char, 32> blake3DeriveKey(const std::string& context,
                                               const std::array<unsigned char, 32>& material);
 
+// Many independent inputs at once: out[i] = blake3Hash / blake3DeriveKey of
+// inputs[i][0..inputLength). Each input must fit one 64-byte BLAKE3 block
+// (std::invalid_argument otherwise), which makes each output a single
+// compression that runs in its own SIMD lane: eight at a time on AVX2, one
+// by one elsewhere. Byte-identical to the per-input calls.
+void blake3HashMany(const unsigned char* const* inputs, std::size_t inputLength,
+                    std::size_t count, std::array<unsigned char, 32>* out);
+void blake3DeriveKeyMany(const std::string& context, const unsigned char* const* inputs,
+                         std::size_t inputLength, std::size_t count,
+                         std::array<unsigned char, 32>* out);
+
+// Convenience overloads for 32-byte inputs (keys, seeds).
+void blake3HashMany(const std::array<unsigned char, 32>* inputs, std::size_t count,
+                    std::array<unsigned char, 32>* out);
+void blake3DeriveKeyMany(const std::string& context, const std::array<unsigned char, 32>* inputs,
+                         std::size_t count, std::array<unsigned char, 32>* out);
+
+using Blake3Xof64 = std::array<unsigned char, 64>;
+
+// The first 64 bytes of the derive_key XOF stream for the given context and
+// key material. Its first 32 bytes equal blake3DeriveKey of the same inputs.
+Blake3Xof64 blake3DeriveKeyXof64(const std::string& context, const unsigned char* material,
+                                 std::size_t size);
+
+// blake3DeriveKeyXof64 over inputs[i][0..lengths[i]). Lengths may differ per
+// input; inputs of up to one block share the SIMD lanes as in
+// blake3DeriveKeyMany, longer ones go through the streaming hasher.
+void blake3DeriveKeyXof64Many(const std::string& context, const unsigned char* const* inputs,
+                              const std::size_t* lengths, std::size_t count, Blake3Xof64* out);
+
+#if defined(PSI_HAVE_X86_CPUID)
+
+// Lane kernels (blake3_batch_x86.cpp): out[l] = the first 32 bytes of the
+// root compression of blocks[l] (zero-padded, blockLength bytes used) under
+// chaining value key, counter 0 and the given flags.
+void blake3CompressBlocks8Avx2(const std::uint32_t key[8], const unsigned char blocks[8][64],
+                               unsigned blockLength, unsigned flags, unsigned char out[8][32]);
+
+// As above, but lane l uses blockLengths[l] and out[l] receives the full
+// 64-byte output block (the first 64 bytes of the XOF stream).
+void blake3CompressBlocksXof8Avx2(const std::uint32_t key[8], const unsigned char blocks[8][64],
+                                  const unsigned blockLengths[8], unsigned flags,
+                                  unsigned char out[8][64]);
+
+#endif  // PSI_HAVE_X86_CPUID
+
 #endif // BLAKE3_UTILS_H
@@ -0,0 +1,281 @@
+#include "calibration.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "crypto_utils.h"
+#include "derivation.h"
+#include "ristretto_batch.h"
+
+extern "C" {
+#include <sodium.h>
+}
+
+namespace {
+
+constexpr char kProfileVersion[] = "psi-calibration-v1";
+constexpr std::size_t kSampleElements = 64;
+constexpr int kKernelRepeats = 3;
+constexpr int kDispatchRepeats = 20;
+constexpr double kSpinUs = 20.0;
+// Below this measured speedup a parallel loop cannot repay its dispatch.
+constexpr double kMinUsefulParallelism = 1.1;
+
+const std::array<ProtocolPhase, kProtocolPhaseCount> kPhases = {
+    ProtocolPhase::BobTagging, ProtocolPhase::AliceBlinding, ProtocolPhase::BobResponse,
+    ProtocolPhase::AliceUnblinding};
+
+double elapsedUs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// Fixed sample inputs shared by every kernel, so the timings differ only by
+// the work each phase does per element.
+struct Sample {
+    std::vector<std::string> elements;
+    std::vector<RistrettoPoint> points;
+    std::vector<RistrettoScalar> scalars;
+};
+
+Sample makeSample() {
+    Sample sample;
+    for (std::size_t i = 0; i < kSampleElements; ++i) {
+        sample.elements.push_back("calibrate " + std::to_string(i));
+        sample.points.push_back(hashToGroup(sample.elements.back()));
+        std::array<unsigned char, 32> derived{};
+        derived.fill(static_cast<unsigned char>(i + 1));
+        sample.scalars.push_back(scalarFromDerived(derived));
+    }
+    return sample;
+}
+
+// Mirrors the per-element body of each phase in psi_protocol.cpp using the
+// same primitives.
+void runKernel(ProtocolPhase phase, const Sample& sample, const FixedScalarMultiplier& bob,
+               const std::vector<RistrettoScalar>& inverses, std::size_t i) {
+    switch (phase) {
+        case ProtocolPhase::BobTagging: {
+            const auto shared = bob.multiply(hashToGroupElement(sample.elements[i]), "calibration");
+            (void)keyToMembershipTag(hashPointToKey(shared));
+            break;
+        }
+        case ProtocolPhase::AliceBlinding: {
+            std::array<unsigned char, 32> derived{};
+            derived[0] = static_cast<unsigned char>(i);
+            (void)multiplyElement(scalarFromDerived(derived), hashToGroupElement(sample.elements[i]),
+                                  "calibration");
+            break;
+        }
+        case ProtocolPhase::BobResponse:
+            (void)bob.multiply(sample.points[i].data(), "calibration");
+            break;
+        case ProtocolPhase::AliceUnblinding: {
+            // The inverse comes from the batch computed in measurePerElementUs.
+            const auto transformed = decodeElement(sample.points[i].data(), "calibration");
+            (void)keyToMembershipTag(
+                hashPointToKey(multiplyElement(inverses[i], transformed, "calibration")));
+            break;
+        }
+    }
+}
+
+double measurePerElementUs(ProtocolPhase phase, const Sample& sample) {
+    const FixedScalarMultiplier bob(sample.scalars[0]);
+    double best = std::numeric_limits<double>::max();
+    for (int repeat = 0; repeat < kKernelRepeats; ++repeat) {
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<RistrettoScalar> inverses;
+        if (phase == ProtocolPhase::AliceUnblinding) {
+            inverses.resize(kSampleElements);
+            invertScalarsBatch(sample.scalars.data(), kSampleElements, inverses.data());
+        }
+        for (std::size_t i = 0; i < kSampleElements; ++i) {
+            runKernel(phase, sample, bob, inverses, i);
+        }
+        best = std::min(best, elapsedUs(start) / static_cast<double>(kSampleElements));
+    }
+    return best;
+}
+
+// Best-of-N wall time of one parallelForRange over `count` indices, each
+// busy-waiting kSpinUs, on `threads` participants.
+double timeSpinLoopUs(ThreadPool& pool, std::size_t count, std::size_t threads) {
+    const auto spin = [](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            while (elapsedUs(start) < kSpinUs) {
+            }
+        }
+    };
+    double best = std::numeric_limits<double>::max();
+    for (int repeat = 0; repeat < kDispatchRepeats; ++repeat) {
+        const auto start = std::chrono::steady_clock::now();
+        parallelForRange(pool, count, 1, threads, spin);
+        best = std::min(best, elapsedUs(start));
+    }
+    return best;
+}
+
+// Fits t(n) = overhead + n * kSpinUs / effectiveThreads from a short and a
+// long loop. The fixed part is the pool round trip (submission, wake-up,
+// chunk claiming, join); effectiveThreads is the parallelism the host really
+// delivers, which is lower than the nominal count when threads share cores.
+void measureDispatch(ThreadPool& pool, CalibrationProfile& profile) {
+    const std::size_t shortCount = profile.threads * 4;
+    const std::size_t longCount = profile.threads * 32;
+    const double shortUs = timeSpinLoopUs(pool, shortCount, profile.threads);
+    const double longUs = timeSpinLoopUs(pool, longCount, profile.threads);
+
+    const double slope =
+        std::max((longUs - shortUs) / static_cast<double>(longCount - shortCount), 1e-9);
+    profile.effectiveThreads = std::max(kSpinUs / slope, 1.0);
+    profile.dispatchOverheadUs =
+        std::max(shortUs - static_cast<double>(shortCount) * slope, 0.0);
+}
+
+std::size_t crossover(double overheadUs, double perElementUs, double effectiveThreads,
+                      std::size_t threads) {
+    if (effectiveThreads < kMinUsefulParallelism || perElementUs <= 0.0) {
+        return std::numeric_limits<std::size_t>::max();
+    }
+    const double gain = perElementUs * (1.0 - 1.0 / effectiveThreads);
+    const double n = std::ceil(overheadUs / gain);
+    // At least two elements per thread; below that chunking is pure overhead.
+    return std::max(static_cast<std::size_t>(n), threads * 2);
+}
+
+}  // namespace
+
+const char* protocolPhaseName(ProtocolPhase phase) {
+    switch (phase) {
+        case ProtocolPhase::BobTagging:
+            return "bob_tagging";
+        case ProtocolPhase::AliceBlinding:
+            return "alice_blinding";
+        case ProtocolPhase::BobResponse:
+            return "bob_response";
+        case ProtocolPhase::AliceUnblinding:
+            return "alice_unblinding";
+    }
+    return "unknown";  // unreachable
+}
+
+CalibrationProfile calibrateExecutionPolicy(const ExecutionPolicy& base) {
+    ThreadPool& pool = base.pool != nullptr ? *base.pool : ThreadPool::shared();
+    const std::size_t available = pool.workerCount() + 1;
+
+    CalibrationProfile profile;
+    profile.threads =
+        base.threadCount == 0 ? available : std::min(base.threadCount, available);
+
+    const Sample sample = makeSample();
+    if (profile.threads > 1) {
+        // Warm-up pass so first-touch costs (page faults, lazy pool start) do
+        // not land in the measurements.
+        timeSpinLoopUs(pool, profile.threads, profile.threads);
+        measureDispatch(pool, profile);
+    }
+
+    for (const auto phase : kPhases) {
+        const auto index = static_cast<std::size_t>(phase);
+        profile.perElementUs[index] = measurePerElementUs(phase, sample);
+        profile.thresholds[index] = crossover(profile.dispatchOverheadUs,
+                                              profile.perElementUs[index],
+                                              profile.effectiveThreads, profile.threads);
+    }
+    return profile;
+}
+
+void applyCalibrationProfile(const CalibrationProfile& profile, ExecutionPolicy& policy) {
+    policy.phaseThresholds = profile.thresholds;
+}
+
+void saveCalibrationProfile(const CalibrationProfile& profile, const std::string& path) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot write calibration profile: " + path);
+    }
+    out << kProfileVersion << "\n";
+    out << "threads " << profile.threads << "\n";
+    out << "effective_threads " << profile.effectiveThreads << "\n";
+    out << "dispatch_overhead_us " << profile.dispatchOverheadUs << "\n";
+    for (const auto phase : kPhases) {
+        const auto index = static_cast<std::size_t>(phase);
+        out << protocolPhaseName(phase) << "_us " << profile.perElementUs[index] << "\n";
+        out << protocolPhaseName(phase) << "_threshold " << profile.thresholds[index] << "\n";
+    }
+    if (!out) {
+        throw std::runtime_error("Failed writing calibration profile: " + path);
+    }
+}
+
+CalibrationProfile loadCalibrationProfile(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Cannot open calibration profile: " + path);
+    }
+    std::string line;
+    if (!std::getline(in, line) || line != kProfileVersion) {
+        throw std::runtime_error("Not a " + std::string(kProfileVersion) + " profile: " + path);
+    }
+
+    CalibrationProfile profile;
+    // Bit per field: threads, overhead, effective threads, then
+    // (us, threshold) per phase.
+    std::size_t seen = 0;
+    const std::size_t allFields = (std::size_t{1} << (3 + 2 * kProtocolPhaseCount)) - 1;
+
+    while (std::getline(in, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string key;
+        if (!(fields >> key)) {
+            continue;
+        }
+        bool parsed = false;
+        if (key == "threads") {
+            parsed = static_cast<bool>(fields >> profile.threads);
+            seen |= 1;
+        } else if (key == "dispatch_overhead_us") {
+            parsed = static_cast<bool>(fields >> profile.dispatchOverheadUs);
+            seen |= 2;
+        } else if (key == "effective_threads") {
+            parsed = static_cast<bool>(fields >> profile.effectiveThreads);
+            seen |= 4;
+        } else {
+            for (const auto phase : kPhases) {
+                const auto index = static_cast<std::size_t>(phase);
+                const std::string name = protocolPhaseName(phase);
+                if (key == name + "_us") {
+                    parsed = static_cast<bool>(fields >> profile.perElementUs[index]);
+                    seen |= std::size_t{1} << (3 + 2 * index);
+                } else if (key == name + "_threshold") {
+                    parsed = static_cast<bool>(fields >> profile.thresholds[index]);
+                    seen |= std::size_t{1} << (4 + 2 * index);
+                } else {
+                    continue;
+                }
+                break;
+            }
+        }
+        if (!parsed) {
+            // Unknown key or unparsable value.
+            throw std::runtime_error("Malformed calibration profile line: " + line);
+        }
+    }
+
+    if (seen != allFields) {
+        throw std::runtime_error("Calibration profile is missing fields: " + path);
+    }
+    return profile;
+}
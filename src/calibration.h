@@ -0,0 +1,62 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+// Startup calibration of the serial/parallel crossover per protocol phase.
+//
+// The default 192-element cutoff (ExecutionPolicy::serialThreshold) was tuned
+// on one developer machine. The real crossover depends on the host (core
+// count, clock, how expensive a pool dispatch is) and on the phase, because
+// each phase does a different amount of work per element. Calibration times
+// the per-element kernel of every phase and the pool's dispatch overhead, then
+// derives one threshold per phase:
+//
+//   parallel time  ~ overhead + n * c / T
+//   serial time    ~ n * c
+//   crossover      n* = overhead / (c * (1 - 1/T))
+//
+// for per-element cost c and T effective threads (the speedup the host really
+// delivers, which is below the nominal count when threads share cores). The
+// profile is a small text file so a server can load it at boot instead of
+// re-measuring (psi_bench --calibrate writes one, psi_server --profile reads
+// it).
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+#include "execution_policy.h"
+
+struct CalibrationProfile {
+    std::size_t threads{1};          // nominal participants, caller included
+    double effectiveThreads{1.0};    // measured speedup on those participants
+    double dispatchOverheadUs{0.0};  // fixed cost of one pooled loop
+    std::array<double, kProtocolPhaseCount> perElementUs{};
+    std::array<std::size_t, kProtocolPhaseCount> thresholds{};
+};
+
+// Measures on the pool and thread count `base` resolves to. Takes on the order
+// of tens of milliseconds; requires sodium_init to have run.
+CalibrationProfile calibrateExecutionPolicy(const ExecutionPolicy& base = ExecutionPolicy{});
+
+// Copies the profile's per-phase thresholds into policy.phaseThresholds.
+void applyCalibrationProfile(const CalibrationProfile& profile, ExecutionPolicy& policy);
+
+// Text format, one "key value" pair per line after a version line:
+//
+//   psi-calibration-v1
+//   threads 8
+//   effective_threads 7.6
+//   dispatch_overhead_us 14.2
+//   bob_tagging_us 61.0
+//   bob_tagging_threshold 3
+//   ...
+//
+// Throws std::runtime_error on I/O failure, a wrong version line, unknown keys
+// or missing fields.
+void saveCalibrationProfile(const CalibrationProfile& profile, const std::string& path);
+CalibrationProfile loadCalibrationProfile(const std::string& path);
+
+// Stable lower-case name of a phase ("bob_tagging", ...), as used in the file.
+const char* protocolPhaseName(ProtocolPhase phase);
+
+#endif // CALIBRATION_H
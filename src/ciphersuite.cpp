@@ -0,0 +1,38 @@
+#include "ciphersuite.h"
+
+#include <stdexcept>
+
+const char* cipherSuiteName(CipherSuite suite) {
+    switch (suite) {
+        case CipherSuite::V1:
+            return "v1";
+        case CipherSuite::V2:
+            return "v2";
+        case CipherSuite::V3:
+            return "v3";
+    }
+    return "unknown";
+}
+
+CipherSuite parseCipherSuite(const std::string& name) {
+    for (const auto suite : kCipherSuites) {
+        if (name == cipherSuiteName(suite)) {
+            return suite;
+        }
+    }
+    throw std::runtime_error("Unknown ciphersuite: " + name);
+}
+
+Group cipherSuiteGroup(CipherSuite suite) {
+    return suite == CipherSuite::V3 ? Group::X25519 : Group::Ristretto255;
+}
+
+const char* groupName(Group group) {
+    switch (group) {
+        case Group::Ristretto255:
+            return "ristretto255";
+        case Group::X25519:
+            return "x25519";
+    }
+    return "unknown";
+}
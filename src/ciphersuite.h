@@ -0,0 +1,75 @@
+#ifndef CIPHERSUITE_H
+#define CIPHERSUITE_H
+
+// Versioned ciphersuites: the group the protocol runs in and the hash
+// functions behind its three per-element derivations, hash-to-group H1
+// (element -> point), key derivation H2 (shared point -> symmetric key) and
+// membership tags (key -> tag). The scalars are the same in every suite: both
+// groups have the prime order of ristretto255, so scalars are sampled,
+// reduced and inverted identically (group_backend.h).
+//
+//   v1  ristretto255
+//       H1 = from_hash(SHA-512(x))
+//       H2 = SHA-512(point)[0..32)
+//       tag = BLAKE3 derive_key("PSI-membership-tag-v1", key)
+//   v2  ristretto255
+//       H1 = from_hash(BLAKE3 derive_key("PSI-hash-to-group-v2", x), 64-byte XOF)
+//       key || tag = BLAKE3 derive_key("PSI-key-and-tag-v2", point), 64-byte XOF
+//   v3  x25519: the prime-order subgroup of Curve25519, points sent as their
+//       Montgomery u-coordinate and multiplied with the X25519 ladder
+//       H1 = x25519FromHash(BLAKE3 derive_key("PSI-hash-to-group-v3", x), 64-byte XOF)
+//       key || tag = BLAKE3 derive_key("PSI-key-and-tag-v3", point), 64-byte XOF
+//
+// v1 is the original construction and is FROZEN: signed transcripts recorded
+// with it must keep auditing byte for byte (docs/commit_reveal_spec.md,
+// section 7), so its functions and context strings never change. A new
+// construction gets a new suite id instead. v2 costs two single-block BLAKE3
+// compressions per element where v1 costs two SHA-512 digests plus one BLAKE3
+// compression; key and tag are disjoint halves of one XOF output, so the tag
+// still reveals nothing about the key. v3 is v2's hashing over the other
+// group, so the two compare the groups alone (psi_bench --group).
+//
+// Bob picks the suite; his first flight names it in its header line
+// (serialization_utils.h) and Alice follows it. Flights without a suite token
+// are v1, which keeps every message written before suites existed readable.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum class CipherSuite : std::uint8_t {
+    V1 = 1,
+    V2 = 2,
+    V3 = 3,
+};
+
+enum class Group : std::uint8_t {
+    Ristretto255,
+    X25519,
+};
+
+inline constexpr CipherSuite kDefaultCipherSuite = CipherSuite::V1;
+
+// Every registered suite, oldest first.
+inline constexpr std::array<CipherSuite, 3> kCipherSuites = {CipherSuite::V1, CipherSuite::V2,
+                                                             CipherSuite::V3};
+
+// "v1", "v2", "v3": the token used in message headers and on command lines.
+const char* cipherSuiteName(CipherSuite suite);
+
+// Inverse of cipherSuiteName; throws std::runtime_error on unknown names.
+CipherSuite parseCipherSuite(const std::string& name);
+
+// The group the suite runs in.
+Group cipherSuiteGroup(CipherSuite suite);
+
+// "ristretto255" or "x25519".
+const char* groupName(Group group);
+
+// Dense index into per-suite tables, 0 for v1.
+inline std::size_t cipherSuiteIndex(CipherSuite suite) {
+    return static_cast<std::size_t>(suite) - 1;
+}
+
+#endif // CIPHERSUITE_H
@@ -0,0 +1,46 @@
+#include "cpu_features.h"
+
+#if defined(PSI_HAVE_X86_CPUID)
+#include <cpuid.h>
+#endif
+
+namespace {
+
+CpuFeatures detectCpuFeatures() {
+    CpuFeatures features;
+#if defined(PSI_HAVE_X86_CPUID)
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0) {
+        return features;
+    }
+    const bool osxsave = (ecx & (1U << 27)) != 0;
+    const bool avx = (ecx & (1U << 28)) != 0;
+    unsigned int xcr0 = 0;
+    if (osxsave && avx) {
+        // XGETBV: which register state the OS saves across context switches.
+        unsigned int xcr0High = 0;
+        __asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+    }
+    const bool ymmState = (xcr0 & 0x6U) == 0x6U;
+    const bool zmmState = ymmState && (xcr0 & 0xe0U) == 0xe0U;
+
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) == 0) {
+        return features;
+    }
+    features.bmi2 = (ebx & (1U << 8)) != 0;
+    features.adx = (ebx & (1U << 19)) != 0;
+    features.avx2 = ymmState && (ebx & (1U << 5)) != 0;
+    features.avx512f = zmmState && (ebx & (1U << 16)) != 0;
+#endif
+    return features;
+}
+
+}  // namespace
+
+const CpuFeatures& cpuFeatures() {
+    static const CpuFeatures features = detectCpuFeatures();
+    return features;
+}
@@ -0,0 +1,21 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+// x86-64 instruction-set extensions the SIMD kernels dispatch on, read once
+// from CPUID (and XGETBV, so a vector extension only counts when the OS saves
+// its registers). Everything is false on other architectures and compilers.
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PSI_HAVE_X86_CPUID 1
+#endif
+
+struct CpuFeatures {
+    bool bmi2{false};
+    bool adx{false};
+    bool avx2{false};
+    bool avx512f{false};
+};
+
+const CpuFeatures& cpuFeatures();
+
+#endif // CPU_FEATURES_H
@@ -1,14 +1,127 @@
 #include "crypto_utils.h"
 
 #include <cstring>
+#include <memory>
 #include <stdexcept>
 
 #include "blake3_utils.h"
+#include "sha512_batch.h"
 
 namespace {
+// Suite v1 (frozen, see ciphersuite.h).
 constexpr char kMembershipTagContext[] = "PSI-membership-tag-v1";
+// Suite v2.
+constexpr char kHashToGroupV2Context[] = "PSI-hash-to-group-v2";
+constexpr char kKeyAndTagV2Context[] = "PSI-key-and-tag-v2";
+// Suite v3.
+constexpr char kHashToGroupV3Context[] = "PSI-hash-to-group-v3";
+constexpr char kKeyAndTagV3Context[] = "PSI-key-and-tag-v3";
+
+const char* hashToGroupContext(CipherSuite suite) {
+    return suite == CipherSuite::V3 ? kHashToGroupV3Context : kHashToGroupV2Context;
+}
+
+const char* keyAndTagContext(CipherSuite suite) {
+    return suite == CipherSuite::V3 ? kKeyAndTagV3Context : kKeyAndTagV2Context;
+}
+
+void requireGroup(CipherSuite suite, Group group) {
+    if (cipherSuiteGroup(suite) != group) {
+        throw std::runtime_error(std::string("Ciphersuite ") + cipherSuiteName(suite) +
+                                 " does not hash to " + groupName(group));
+    }
+}
+
+const RistrettoElement& storedElement(const GroupElement& stored, const RistrettoElement*) {
+    return stored.ristretto;
+}
+
+const X25519Element& storedElement(const GroupElement& stored, const X25519Element*) {
+    return stored.x25519;
+}
+
+GroupElement toStored(const RistrettoElement& element) {
+    GroupElement stored{};
+    stored.ristretto = element;
+    return stored;
+}
+
+GroupElement toStored(const X25519Element& element) {
+    GroupElement stored{};
+    stored.x25519 = element;
+    return stored;
+}
+
+// SHA-512 of every message in one multi-buffer batch.
+std::vector<Sha512Digest> sha512Strings(const std::string* messages, std::size_t count) {
+    std::vector<const unsigned char*> inputs(count);
+    std::vector<std::size_t> lengths(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        inputs[i] = reinterpret_cast<const unsigned char*>(messages[i].data());
+        lengths[i] = messages[i].size();
+    }
+    std::vector<Sha512Digest> digests(count);
+    sha512Batch(inputs.data(), lengths.data(), count, digests.data());
+    return digests;
+}
+
+// The 64-byte v2 or v3 hash-to-group input of every message, from one
+// batched BLAKE3 XOF call.
+std::vector<Blake3Xof64> blake3Strings(const std::string* messages, std::size_t count,
+                                       CipherSuite suite) {
+    std::vector<const unsigned char*> inputs(count);
+    std::vector<std::size_t> lengths(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        inputs[i] = reinterpret_cast<const unsigned char*>(messages[i].data());
+        lengths[i] = messages[i].size();
+    }
+    std::vector<Blake3Xof64> outputs(count);
+    blake3DeriveKeyXof64Many(hashToGroupContext(suite), inputs.data(), lengths.data(), count,
+                             outputs.data());
+    return outputs;
 }
 
+std::vector<const unsigned char*> pointPointers(const RistrettoPoint* points, std::size_t count) {
+    std::vector<const unsigned char*> inputs(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        inputs[i] = points[i].data();
+    }
+    return inputs;
+}
+
+template <typename Digest>
+void wipeDigests(std::vector<Digest>& digests) {
+    sodium_memzero(digests.data(), digests.size() * sizeof(Digest));
+}
+
+// hashToGroupElementBatch through the cache: hits under one lock, misses
+// hashed as one batch and inserted.
+template <typename Element>
+void hashToGroupElementsCached(const std::string* messages, std::size_t count, Element* out,
+                               HashToGroupCache& cache, CipherSuite suite) {
+    std::unique_ptr<bool[]> found(new bool[count]);
+    cache.getElements(messages, count, out, found.get(), suite);
+    std::vector<std::string> misses;
+    std::vector<std::size_t> missIndex;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!found[i]) {
+            misses.push_back(messages[i]);
+            missIndex.push_back(i);
+        }
+    }
+    if (misses.empty()) {
+        return;
+    }
+
+    std::vector<Element> computed(misses.size());
+    hashToGroupElementBatch(misses.data(), misses.size(), computed.data(), nullptr, suite);
+    for (std::size_t j = 0; j < misses.size(); ++j) {
+        out[missIndex[j]] = computed[j];
+    }
+    cache.put(misses.data(), computed.data(), misses.size(), suite);
+}
+}  // namespace
+
 RistrettoPoint hashToGroup(const std::string& message) {
     unsigned char fullHash[crypto_hash_sha512_BYTES];
     const unsigned char* input = reinterpret_cast<const unsigned char*>(message.data());
@@ -26,28 +139,135 @@ RistrettoPoint hashToGroup(const std::string& message) {
     return point;
 }
 
+RistrettoElement hashToGroupElement(const std::string& message) {
+    unsigned char fullHash[crypto_hash_sha512_BYTES];
+    const unsigned char* input = reinterpret_cast<const unsigned char*>(message.data());
+    if (crypto_hash_sha512(fullHash, input, message.size()) != 0) {
+        throw std::runtime_error("libsodium SHA-512 hashing failed");
+    }
+
+    const RistrettoElement element = ristrettoFromHash(fullHash);
+    sodium_memzero(fullHash, sizeof fullHash);
+    return element;
+}
+
+void invertScalarsBatch(const RistrettoScalar* scalars, std::size_t count,
+                        RistrettoScalar* inverses) {
+    if (count == 0) {
+        return;
+    }
+
+    // Forward pass: inverses[i] holds the running product s_0 * ... * s_i.
+    for (std::size_t i = 0; i < count; ++i) {
+        if (sodium_is_zero(scalars[i].data(), scalars[i].size())) {
+            throw std::runtime_error("Cannot invert a zero scalar");
+        }
+        if (i == 0) {
+            inverses[0] = scalars[0];
+        } else {
+            crypto_core_ristretto255_scalar_mul(inverses[i].data(), inverses[i - 1].data(),
+                                                scalars[i].data());
+        }
+    }
+
+    // One inversion of the full product, then walk back peeling one factor
+    // off per step: inv(s_i) = inv(s_0..s_i) * (s_0..s_{i-1}).
+    RistrettoScalar running{};
+    if (crypto_core_ristretto255_scalar_invert(running.data(), inverses[count - 1].data()) != 0) {
+        throw std::runtime_error("Failed to invert scalar product");
+    }
+    for (std::size_t i = count - 1; i > 0; --i) {
+        crypto_core_ristretto255_scalar_mul(inverses[i].data(), running.data(),
+                                            inverses[i - 1].data());
+        RistrettoScalar next{};
+        crypto_core_ristretto255_scalar_mul(next.data(), running.data(), scalars[i].data());
+        running = next;
+    }
+    inverses[0] = running;
+    sodium_memzero(running.data(), running.size());
+}
+
 RistrettoPoint HashToGroupCache::get(const std::string& message) {
+    RistrettoPoint point{};
+    ristrettoEncode(point.data(), getElement(message));
+    return point;
+}
+
+RistrettoElement HashToGroupCache::getElement(const std::string& message) {
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        const auto it = points_.find(message);
-        if (it != points_.end()) {
-            return it->second;
+        const auto& elements = elements_[cipherSuiteIndex(CipherSuite::V1)];
+        const auto it = elements.find(message);
+        if (it != elements.end()) {
+            return it->second.ristretto;
         }
     }
 
     // Compute outside the lock; hashToGroup is deterministic, so a concurrent
-    // duplicate computation produces the same point and either insert wins.
-    const auto point = hashToGroup(message);
+    // duplicate computation produces the same element and either insert wins.
+    const auto element = hashToGroupElement(message);
 
     std::lock_guard<std::mutex> lock(mutex_);
-    points_.emplace(message, point);
-    return point;
+    elements_[cipherSuiteIndex(CipherSuite::V1)].emplace(message, toStored(element));
+    return element;
+}
+
+template <typename Element>
+void HashToGroupCache::lookup(const std::string* messages, std::size_t count, Element* out,
+                              bool* found, CipherSuite suite) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto& elements = elements_[cipherSuiteIndex(suite)];
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto it = elements.find(messages[i]);
+        found[i] = it != elements.end();
+        if (found[i]) {
+            out[i] = storedElement(it->second, out);
+        }
+    }
+}
+
+template <typename Element>
+void HashToGroupCache::insert(const std::string* messages, const Element* elements,
+                              std::size_t count, CipherSuite suite) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& stored = elements_[cipherSuiteIndex(suite)];
+    for (std::size_t i = 0; i < count; ++i) {
+        stored.emplace(messages[i], toStored(elements[i]));
+    }
+}
+
+void HashToGroupCache::getElements(const std::string* messages, std::size_t count,
+                                   RistrettoElement* out, bool* found, CipherSuite suite) {
+    requireGroup(suite, Group::Ristretto255);
+    lookup(messages, count, out, found, suite);
+}
+
+void HashToGroupCache::put(const std::string* messages, const RistrettoElement* elements,
+                           std::size_t count, CipherSuite suite) {
+    requireGroup(suite, Group::Ristretto255);
+    insert(messages, elements, count, suite);
+}
+
+void HashToGroupCache::getElements(const std::string* messages, std::size_t count,
+                                   X25519Element* out, bool* found, CipherSuite suite) {
+    requireGroup(suite, Group::X25519);
+    lookup(messages, count, out, found, suite);
+}
+
+void HashToGroupCache::put(const std::string* messages, const X25519Element* elements,
+                           std::size_t count, CipherSuite suite) {
+    requireGroup(suite, Group::X25519);
+    insert(messages, elements, count, suite);
 }
 
 RistrettoPoint hashToGroupCached(const std::string& message, HashToGroupCache* cache) {
     return cache != nullptr ? cache->get(message) : hashToGroup(message);
 }
 
+RistrettoElement hashToGroupElementCached(const std::string& message, HashToGroupCache* cache) {
+    return cache != nullptr ? cache->getElement(message) : hashToGroupElement(message);
+}
+
 std::array<unsigned char, 32> hashPointToKey(const RistrettoPoint& point) {
     unsigned char fullHash[crypto_hash_sha512_BYTES];
     if (crypto_hash_sha512(fullHash, point.data(), point.size()) != 0) {
@@ -60,6 +280,108 @@ std::array<unsigned char, 32> hashPointToKey(const RistrettoPoint& point) {
     return key;
 }
 
+void hashToGroupBatch(const std::string* messages, std::size_t count, RistrettoPoint* out) {
+    std::vector<RistrettoElement> elements(count);
+    hashToGroupElementBatch(messages, count, elements.data());
+    for (std::size_t i = 0; i < count; ++i) {
+        ristrettoEncode(out[i].data(), elements[i]);
+    }
+}
+
+void hashToUniformBatch(const std::string* messages, std::size_t count, UniformBytes* out,
+                        CipherSuite suite) {
+    if (suite == CipherSuite::V1) {
+        auto digests = sha512Strings(messages, count);
+        std::memcpy(out, digests.data(), count * sizeof(UniformBytes));
+        wipeDigests(digests);
+    } else {
+        auto digests = blake3Strings(messages, count, suite);
+        std::memcpy(out, digests.data(), count * sizeof(UniformBytes));
+        wipeDigests(digests);
+    }
+}
+
+void hashToGroupElementBatch(const std::string* messages, std::size_t count,
+                             RistrettoElement* out, HashToGroupCache* cache, CipherSuite suite) {
+    requireGroup(suite, Group::Ristretto255);
+    if (cache != nullptr) {
+        hashToGroupElementsCached(messages, count, out, *cache, suite);
+        return;
+    }
+    std::vector<UniformBytes> uniform(count);
+    hashToUniformBatch(messages, count, uniform.data(), suite);
+    for (std::size_t i = 0; i < count; ++i) {
+        out[i] = ristrettoFromHash(uniform[i].data());
+    }
+    wipeDigests(uniform);
+}
+
+void hashToGroupElementBatch(const std::string* messages, std::size_t count, X25519Element* out,
+                             HashToGroupCache* cache, CipherSuite suite) {
+    requireGroup(suite, Group::X25519);
+    if (cache != nullptr) {
+        hashToGroupElementsCached(messages, count, out, *cache, suite);
+        return;
+    }
+    std::vector<UniformBytes> uniform(count);
+    hashToUniformBatch(messages, count, uniform.data(), suite);
+    x25519FromHashBatch(uniform.data(), count, out);
+    wipeDigests(uniform);
+}
+
+void hashPointToKeyBatch(const RistrettoPoint* points, std::size_t count,
+                         std::array<unsigned char, 32>* keys, CipherSuite suite) {
+    const auto inputs = pointPointers(points, count);
+    if (suite != CipherSuite::V1) {
+        // The key is the first half of the key-and-tag XOF output, which is
+        // exactly the 32-byte derive_key output.
+        blake3DeriveKeyMany(keyAndTagContext(suite), inputs.data(), crypto_core_ristretto255_BYTES,
+                            count, keys);
+        return;
+    }
+    const std::vector<std::size_t> lengths(count, crypto_core_ristretto255_BYTES);
+    std::vector<Sha512Digest> digests(count);
+    sha512Batch(inputs.data(), lengths.data(), count, digests.data());
+    for (std::size_t i = 0; i < count; ++i) {
+        std::memcpy(keys[i].data(), digests[i].data(), keys[i].size());
+    }
+    wipeDigests(digests);
+}
+
 MembershipTag keyToMembershipTag(const std::array<unsigned char, 32>& key) {
     return blake3DeriveKey(kMembershipTagContext, key);
 }
+
+void keysToMembershipTags(const std::array<unsigned char, 32>* keys, std::size_t count,
+                          MembershipTag* tags) {
+    blake3DeriveKeyMany(kMembershipTagContext, keys, count, tags);
+}
+
+void pointsToKeysAndTags(const RistrettoPoint* points, std::size_t count,
+                         std::array<unsigned char, 32>* keys, MembershipTag* tags,
+                         CipherSuite suite) {
+    if (suite == CipherSuite::V1) {
+        std::vector<std::array<unsigned char, 32>> scratch;
+        if (keys == nullptr) {
+            scratch.resize(count);
+        }
+        std::array<unsigned char, 32>* derived = keys != nullptr ? keys : scratch.data();
+        hashPointToKeyBatch(points, count, derived, suite);
+        keysToMembershipTags(derived, count, tags);
+        sodium_memzero(scratch.data(), scratch.size() * sizeof(scratch[0]));
+        return;
+    }
+
+    const auto inputs = pointPointers(points, count);
+    const std::vector<std::size_t> lengths(count, crypto_core_ristretto255_BYTES);
+    std::vector<Blake3Xof64> outputs(count);
+    blake3DeriveKeyXof64Many(keyAndTagContext(suite), inputs.data(), lengths.data(), count,
+                             outputs.data());
+    for (std::size_t i = 0; i < count; ++i) {
+        if (keys != nullptr) {
+            std::memcpy(keys[i].data(), outputs[i].data(), keys[i].size());
+        }
+        std::memcpy(tags[i].data(), outputs[i].data() + 32, tags[i].size());
+    }
+    wipeDigests(outputs);
+}
@@ -2,6 +2,7 @@
 #define CRYPTO_UTILS_H
 
 #include <array>
+#include <cstddef>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -10,9 +11,21 @@ extern "C" {
 #include <sodium.h>
 }
 
+#include "ciphersuite.h"
+#include "ristretto_point.h"
+#include "x25519_point.h"
+
 using RistrettoPoint = std::array<unsigned char, crypto_core_ristretto255_BYTES>;
 using RistrettoScalar = std::array<unsigned char, crypto_core_ristretto255_SCALARBYTES>;
 
+// A hashed or decoded element of the suite's group (ciphersuite.h) in
+// internal form: ristretto for v1 and v2, x25519 for v3. Wire encodings are
+// 32 bytes in both groups and travel as RistrettoPoint.
+union GroupElement {
+    RistrettoElement ristretto;
+    X25519Element x25519;
+};
+
 // Maps a message to a ristretto255 group element with UNKNOWN discrete log
 // (SHA-512 then crypto_core_ristretto255_from_hash, i.e. Elligator 2).
 //
@@ -23,9 +36,32 @@ using RistrettoScalar = std::array<unsigned char, crypto_core_ristretto255_SCALA
 // transcript. See docs/security_hardening.md, issue 2.
 RistrettoPoint hashToGroup(const std::string& message);
 
+// hashToGroup without the final encoding, for callers that multiply the
+// element next. ristrettoEncode(hashToGroupElement(m)) == hashToGroup(m).
+RistrettoElement hashToGroupElement(const std::string& message);
+
 // H2: derives a 32-byte symmetric key from a group element.
 std::array<unsigned char, 32> hashPointToKey(const RistrettoPoint& point);
 
+// Batch forms of the above: the SHA-512 calls run side by side on the
+// multi-buffer backend (sha512_batch.h). out[i] / keys[i] is byte-identical
+// to the single-message function applied to element i. hashPointToKeyBatch
+// takes the suite's key derivation; the single-message functions are v1.
+void hashToGroupBatch(const std::string* messages, std::size_t count, RistrettoPoint* out);
+void hashPointToKeyBatch(const RistrettoPoint* points, std::size_t count,
+                         std::array<unsigned char, 32>* keys,
+                         CipherSuite suite = CipherSuite::V1);
+
+// Inverts scalars[0..count) into inverses[0..count) with Montgomery's trick:
+// one field-order inversion plus about 3*count scalar multiplications instead
+// of count inversions. Every output is byte-identical to
+// crypto_core_ristretto255_scalar_invert on the same input (both are the
+// canonical reduced inverse). Throws std::runtime_error if any scalar is zero;
+// nothing useful is written in that case. scalars and inverses must not
+// overlap.
+void invertScalarsBatch(const RistrettoScalar* scalars, std::size_t count,
+                        RistrettoScalar* inverses);
+
 // Local cache of hashToGroup outputs (element string -> group element).
 //
 // SECURITY: caching here is safe ONLY because it is purely local state that
@@ -45,6 +81,11 @@ std::array<unsigned char, 32> hashPointToKey(const RistrettoPoint& point);
 // war. Bob's scalar MUST be fresh per exchange; only this local
 // element-to-point map may persist.
 //
+// Entries are stored as internal elements so hits feed scalar multiplication
+// directly; get() encodes on the way out. Each ciphersuite maps elements
+// differently, so entries are kept per suite, in the suite's group; get() and
+// getElement() are v1.
+//
 // Thread-safe: lookups and inserts are serialised by an internal mutex so the
 // cache can be shared by the parallel per-element loops. On a concurrent miss
 // the point may be computed twice, but hashToGroup is deterministic, so both
@@ -52,15 +93,54 @@ std::array<unsigned char, 32> hashPointToKey(const RistrettoPoint& point);
 class HashToGroupCache {
 public:
     RistrettoPoint get(const std::string& message);
+    RistrettoElement getElement(const std::string& message);
+
+    // Looks up messages[0..count) under a single lock. Hits are written to
+    // out and flagged in found; misses are left for the caller to compute
+    // and put() back. The element type must be the suite's group.
+    void getElements(const std::string* messages, std::size_t count, RistrettoElement* out,
+                     bool* found, CipherSuite suite = CipherSuite::V1);
+    void put(const std::string* messages, const RistrettoElement* elements, std::size_t count,
+             CipherSuite suite = CipherSuite::V1);
+    void getElements(const std::string* messages, std::size_t count, X25519Element* out,
+                     bool* found, CipherSuite suite);
+    void put(const std::string* messages, const X25519Element* elements, std::size_t count,
+             CipherSuite suite);
 
 private:
+    template <typename Element>
+    void lookup(const std::string* messages, std::size_t count, Element* out, bool* found,
+                CipherSuite suite);
+    template <typename Element>
+    void insert(const std::string* messages, const Element* elements, std::size_t count,
+                CipherSuite suite);
+
     std::mutex mutex_;
-    std::unordered_map<std::string, RistrettoPoint> points_;
+    std::array<std::unordered_map<std::string, GroupElement>, kCipherSuites.size()> elements_;
 };
 
-// Convenience wrapper: uses the cache when non-null, plain hashToGroup
-// otherwise. Byte-identical output either way.
+// Convenience wrappers: use the cache when non-null, plain hashToGroup /
+// hashToGroupElement otherwise. Byte-identical output either way.
 RistrettoPoint hashToGroupCached(const std::string& message, HashToGroupCache* cache);
+RistrettoElement hashToGroupElementCached(const std::string& message, HashToGroupCache* cache);
+
+// The 64 uniform bytes the given suite's hash-to-group feeds to its
+// Elligator map for each message: SHA-512 for v1, the BLAKE3 XOF for v2 and
+// v3. Exposed so the hashing can be timed apart from the map.
+using UniformBytes = std::array<unsigned char, crypto_core_ristretto255_HASHBYTES>;
+void hashToUniformBatch(const std::string* messages, std::size_t count, UniformBytes* out,
+                        CipherSuite suite = CipherSuite::V1);
+
+// The given suite's hash-to-group (ciphersuite.h) over messages[0..count),
+// consulting the cache when non-null: hits are read under one lock, and only
+// the misses are hashed (as one multi-buffer batch) and inserted. For v1,
+// out[i] == hashToGroupElement(messages[i]). The element type must be the
+// suite's group; std::runtime_error otherwise.
+void hashToGroupElementBatch(const std::string* messages, std::size_t count,
+                             RistrettoElement* out, HashToGroupCache* cache = nullptr,
+                             CipherSuite suite = CipherSuite::V1);
+void hashToGroupElementBatch(const std::string* messages, std::size_t count, X25519Element* out,
+                             HashToGroupCache* cache, CipherSuite suite);
 
 using MembershipTag = std::array<unsigned char, 32>;
 
@@ -70,4 +150,17 @@ using MembershipTag = std::array<unsigned char, 32>;
 // hashPointToKey) keeps tags unrelated to the keys they are derived from.
 MembershipTag keyToMembershipTag(const std::array<unsigned char, 32>& key);
 
+// keyToMembershipTag over keys[0..count), hashed side by side
+// (blake3DeriveKeyMany); tags[i] is byte-identical to the single-key call.
+void keysToMembershipTags(const std::array<unsigned char, 32>* keys, std::size_t count,
+                          MembershipTag* tags);
+
+// Key and membership tag of every shared point under the given suite. v1 is
+// hashPointToKeyBatch followed by keysToMembershipTags; v2 and v3 take both
+// from a single BLAKE3 call per point. keys may be null when only tags are
+// needed.
+void pointsToKeysAndTags(const RistrettoPoint* points, std::size_t count,
+                         std::array<unsigned char, 32>* keys, MembershipTag* tags,
+                         CipherSuite suite = CipherSuite::V1);
+
 #endif // CRYPTO_UTILS_H
@@ -0,0 +1,79 @@
+#include "curve25519_backend.h"
+
+#include <atomic>
+#include <stdexcept>
+
+#include "cpu_features.h"
+
+namespace {
+
+FieldBackend bestSupportedBackend() {
+    if (fieldBackendSupported(FieldBackend::Avx2)) {
+        return FieldBackend::Avx2;
+    }
+    if (fieldBackendSupported(FieldBackend::Mulx)) {
+        return FieldBackend::Mulx;
+    }
+    return FieldBackend::Portable;
+}
+
+// -1 until first use, then the FieldBackend value.
+std::atomic<int> activeBackend{-1};
+
+}  // namespace
+
+const char* fieldBackendName(FieldBackend backend) {
+    switch (backend) {
+        case FieldBackend::Portable:
+            return "portable";
+        case FieldBackend::Mulx:
+            return "mulx";
+        case FieldBackend::Avx2:
+            return "avx2";
+    }
+    return "unknown";
+}
+
+FieldBackend parseFieldBackend(const std::string& name) {
+    for (const auto backend : {FieldBackend::Portable, FieldBackend::Mulx, FieldBackend::Avx2}) {
+        if (name == fieldBackendName(backend)) {
+            return backend;
+        }
+    }
+    throw std::runtime_error("Unknown field backend: " + name);
+}
+
+bool fieldBackendSupported(FieldBackend backend) {
+    switch (backend) {
+        case FieldBackend::Portable:
+            return true;
+#if defined(PSI_HAVE_X86_BACKENDS)
+        case FieldBackend::Mulx:
+            return cpuFeatures().bmi2 && cpuFeatures().adx;
+        case FieldBackend::Avx2:
+            return cpuFeatures().avx2;
+#else
+        case FieldBackend::Mulx:
+        case FieldBackend::Avx2:
+            return false;
+#endif
+    }
+    return false;
+}
+
+FieldBackend activeFieldBackend() {
+    int backend = activeBackend.load(std::memory_order_relaxed);
+    if (backend < 0) {
+        backend = static_cast<int>(bestSupportedBackend());
+        activeBackend.store(backend, std::memory_order_relaxed);
+    }
+    return static_cast<FieldBackend>(backend);
+}
+
+void setFieldBackend(FieldBackend backend) {
+    if (!fieldBackendSupported(backend)) {
+        throw std::runtime_error(std::string("Field backend not supported on this CPU: ") +
+                                 fieldBackendName(backend));
+    }
+    activeBackend.store(static_cast<int>(backend), std::memory_order_relaxed);
+}
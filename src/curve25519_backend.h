@@ -0,0 +1,67 @@
+#ifndef CURVE25519_BACKEND_H
+#define CURVE25519_BACKEND_H
+
+// Field-arithmetic backends behind the ristretto255 scalar multiplication
+// ladder (ristretto_point.h), picked at runtime from CPUID:
+//
+//   portable  radix 2^51 in unsigned __int128, plain C++ (any 64-bit target)
+//   mulx      the same radix-2^51 ladder compiled for BMI2/ADX, so the
+//             compiler emits mulx for the 64x64->128 products
+//   avx2      radix 2^25.5, ten 26/25-bit limbs per 64-bit lane, four points
+//             per ladder; only the batch entry points use it, the tail of a
+//             batch (count % 4) and single multiplications take mulx
+//
+// Only the ladder is backend-specific; decoding, encoding and hash-to-group
+// stay on the portable radix-2^51 code. The X25519 Montgomery ladder of
+// ciphersuite v3 (x25519_point.h) follows the same choice, except that it has
+// no four-way form: under avx2 it runs the mulx build. Every backend produces the bytes
+// libsodium produces (tests/curve25519_backend_test.cpp runs each one that
+// the CPU supports against crypto_scalarmult_ristretto255), so the choice
+// changes timing only, never a transcript.
+
+#include <string>
+
+#include "ristretto_point.h"
+
+#if defined(PSI_HAVE_FE51) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PSI_HAVE_X86_BACKENDS 1
+#endif
+
+enum class FieldBackend {
+    Portable,
+    Mulx,
+    Avx2,
+};
+
+const char* fieldBackendName(FieldBackend backend);
+
+// "portable", "mulx" or "avx2"; throws std::runtime_error otherwise.
+FieldBackend parseFieldBackend(const std::string& name);
+
+// Compiled in, and the CPU (and OS, for AVX2 state) supports it.
+bool fieldBackendSupported(FieldBackend backend);
+
+// The backend the ladder uses: the fastest supported one (avx2, mulx,
+// portable in that order) unless setFieldBackend chose another.
+FieldBackend activeFieldBackend();
+
+// Process-wide override, for benchmarks and tests. Throws std::runtime_error
+// if the backend is not supported here.
+void setFieldBackend(FieldBackend backend);
+
+#if defined(PSI_HAVE_X86_BACKENDS)
+
+// Per-instruction-set ladders; called only through ristretto_point.cpp.
+RistrettoElement ristrettoScalarMultMulx(const RecodedScalar& scalar,
+                                         const RistrettoElement& element);
+
+// out[l] = scalars[l] * in[l] for the four lanes l.
+void ristrettoScalarMult4Avx2(const RecodedScalar* const scalars[4], const RistrettoElement* in,
+                              RistrettoElement* out);
+
+// montgomery_detail::montgomeryLadder built for BMI2/ADX.
+void x25519LadderMulx(const unsigned char scalar[32], const Fe51& u, Fe51& outU, Fe51& outW);
+
+#endif  // PSI_HAVE_X86_BACKENDS
+
+#endif // CURVE25519_BACKEND_H
@@ -0,0 +1,278 @@
+#ifndef CURVE25519_FE51_H
+#define CURVE25519_FE51_H
+
+// Arithmetic in GF(2^255 - 19), five 51-bit limbs in 64-bit words, products
+// accumulated in unsigned __int128. This is the representation libsodium
+// itself uses on 64-bit targets (its fe_51 backend); it exists here so the
+// batch engine in ristretto_batch.cpp can keep points in internal form
+// between operations instead of round-tripping through 32-byte encodings.
+//
+// Limb bounds: outputs of fe51Mul/fe51Sq/fe51Sub/fe51FromBytes are below
+// 2^52. fe51Add does not carry, so a sum of two such values is below 2^53;
+// every multiplication input in ristretto_batch.cpp is at most one addition
+// deep, well inside the 2^54 the 128-bit accumulators allow.
+//
+// Everything here is constant-time: no branches or memory indices depend on
+// field values (callers handle secret scalars).
+//
+// The functions have internal linkage (PSI_FE51_INLINE) because the same code
+// is compiled more than once: ristretto_point_mulx.cpp defines the macro with
+// a BMI2/ADX target attribute before including this header. With ordinary
+// inline linkage the linker could keep that copy for every translation unit
+// and run mulx on CPUs without it.
+
+#include <cstdint>
+#include <cstring>
+
+#ifndef PSI_FE51_INLINE
+#define PSI_FE51_INLINE static inline
+#endif
+
+#if defined(__SIZEOF_INT128__)
+#define PSI_HAVE_FE51 1
+
+struct Fe51 {
+    std::uint64_t v[5];
+};
+
+namespace fe51_detail {
+
+constexpr std::uint64_t kMask = (std::uint64_t{1} << 51) - 1;
+using u128 = unsigned __int128;
+
+PSI_FE51_INLINE std::uint64_t load64(const unsigned char* in) {
+    std::uint64_t word = 0;
+    for (int i = 7; i >= 0; --i) {
+        word = (word << 8) | in[i];
+    }
+    return word;
+}
+
+// Propagates carries once around the ring; result limbs below 2^51 + 2^13.
+PSI_FE51_INLINE void carry(std::uint64_t& r0, std::uint64_t& r1, std::uint64_t& r2,
+                           std::uint64_t& r3, std::uint64_t& r4) {
+    r1 += r0 >> 51;
+    r0 &= kMask;
+    r2 += r1 >> 51;
+    r1 &= kMask;
+    r3 += r2 >> 51;
+    r2 &= kMask;
+    r4 += r3 >> 51;
+    r3 &= kMask;
+    r0 += 19 * (r4 >> 51);
+    r4 &= kMask;
+}
+
+}  // namespace fe51_detail
+
+PSI_FE51_INLINE Fe51 fe51Zero() {
+    return Fe51{{0, 0, 0, 0, 0}};
+}
+
+PSI_FE51_INLINE Fe51 fe51One() {
+    return Fe51{{1, 0, 0, 0, 0}};
+}
+
+PSI_FE51_INLINE Fe51 fe51Add(const Fe51& f, const Fe51& g) {
+    return Fe51{{f.v[0] + g.v[0], f.v[1] + g.v[1], f.v[2] + g.v[2], f.v[3] + g.v[3],
+                 f.v[4] + g.v[4]}};
+}
+
+// f - g, computed as f + 2p - g after carrying g, so no limb goes negative.
+PSI_FE51_INLINE Fe51 fe51Sub(const Fe51& f, const Fe51& g) {
+    std::uint64_t g0 = g.v[0], g1 = g.v[1], g2 = g.v[2], g3 = g.v[3], g4 = g.v[4];
+    fe51_detail::carry(g0, g1, g2, g3, g4);
+    std::uint64_t h0 = (f.v[0] + 0xfffffffffffdaULL) - g0;
+    std::uint64_t h1 = (f.v[1] + 0xffffffffffffeULL) - g1;
+    std::uint64_t h2 = (f.v[2] + 0xffffffffffffeULL) - g2;
+    std::uint64_t h3 = (f.v[3] + 0xffffffffffffeULL) - g3;
+    std::uint64_t h4 = (f.v[4] + 0xffffffffffffeULL) - g4;
+    fe51_detail::carry(h0, h1, h2, h3, h4);
+    return Fe51{{h0, h1, h2, h3, h4}};
+}
+
+PSI_FE51_INLINE Fe51 fe51Neg(const Fe51& f) {
+    return fe51Sub(fe51Zero(), f);
+}
+
+PSI_FE51_INLINE Fe51 fe51Mul(const Fe51& f, const Fe51& g) {
+    using fe51_detail::u128;
+    const std::uint64_t f0 = f.v[0], f1 = f.v[1], f2 = f.v[2], f3 = f.v[3], f4 = f.v[4];
+    const std::uint64_t g0 = g.v[0], g1 = g.v[1], g2 = g.v[2], g3 = g.v[3], g4 = g.v[4];
+    const std::uint64_t g1_19 = 19 * g1, g2_19 = 19 * g2, g3_19 = 19 * g3, g4_19 = 19 * g4;
+
+    u128 r0 = (u128)f0 * g0 + (u128)f1 * g4_19 + (u128)f2 * g3_19 + (u128)f3 * g2_19 +
+              (u128)f4 * g1_19;
+    u128 r1 = (u128)f0 * g1 + (u128)f1 * g0 + (u128)f2 * g4_19 + (u128)f3 * g3_19 +
+              (u128)f4 * g2_19;
+    u128 r2 = (u128)f0 * g2 + (u128)f1 * g1 + (u128)f2 * g0 + (u128)f3 * g4_19 +
+              (u128)f4 * g3_19;
+    u128 r3 = (u128)f0 * g3 + (u128)f1 * g2 + (u128)f2 * g1 + (u128)f3 * g0 +
+              (u128)f4 * g4_19;
+    u128 r4 = (u128)f0 * g4 + (u128)f1 * g3 + (u128)f2 * g2 + (u128)f3 * g1 + (u128)f4 * g0;
+
+    r1 += static_cast<std::uint64_t>(r0 >> 51);
+    std::uint64_t h0 = static_cast<std::uint64_t>(r0) & fe51_detail::kMask;
+    r2 += static_cast<std::uint64_t>(r1 >> 51);
+    std::uint64_t h1 = static_cast<std::uint64_t>(r1) & fe51_detail::kMask;
+    r3 += static_cast<std::uint64_t>(r2 >> 51);
+    std::uint64_t h2 = static_cast<std::uint64_t>(r2) & fe51_detail::kMask;
+    r4 += static_cast<std::uint64_t>(r3 >> 51);
+    std::uint64_t h3 = static_cast<std::uint64_t>(r3) & fe51_detail::kMask;
+    h0 += 19 * static_cast<std::uint64_t>(r4 >> 51);
+    std::uint64_t h4 = static_cast<std::uint64_t>(r4) & fe51_detail::kMask;
+    h1 += h0 >> 51;
+    h0 &= fe51_detail::kMask;
+    return Fe51{{h0, h1, h2, h3, h4}};
+}
+
+PSI_FE51_INLINE Fe51 fe51Sq(const Fe51& f) {
+    using fe51_detail::u128;
+    const std::uint64_t f0 = f.v[0], f1 = f.v[1], f2 = f.v[2], f3 = f.v[3], f4 = f.v[4];
+    const std::uint64_t f0_2 = 2 * f0, f1_2 = 2 * f1;
+    const std::uint64_t f1_38 = 38 * f1, f2_38 = 38 * f2, f3_38 = 38 * f3;
+    const std::uint64_t f3_19 = 19 * f3, f4_19 = 19 * f4;
+
+    u128 r0 = (u128)f0 * f0 + (u128)f1_38 * f4 + (u128)f2_38 * f3;
+    u128 r1 = (u128)f0_2 * f1 + (u128)f2_38 * f4 + (u128)f3_19 * f3;
+    u128 r2 = (u128)f0_2 * f2 + (u128)f1 * f1 + (u128)f3_38 * f4;
+    u128 r3 = (u128)f0_2 * f3 + (u128)f1_2 * f2 + (u128)f4_19 * f4;
+    u128 r4 = (u128)f0_2 * f4 + (u128)f1_2 * f3 + (u128)f2 * f2;
+
+    r1 += static_cast<std::uint64_t>(r0 >> 51);
+    std::uint64_t h0 = static_cast<std::uint64_t>(r0) & fe51_detail::kMask;
+    r2 += static_cast<std::uint64_t>(r1 >> 51);
+    std::uint64_t h1 = static_cast<std::uint64_t>(r1) & fe51_detail::kMask;
+    r3 += static_cast<std::uint64_t>(r2 >> 51);
+    std::uint64_t h2 = static_cast<std::uint64_t>(r2) & fe51_detail::kMask;
+    r4 += static_cast<std::uint64_t>(r3 >> 51);
+    std::uint64_t h3 = static_cast<std::uint64_t>(r3) & fe51_detail::kMask;
+    h0 += 19 * static_cast<std::uint64_t>(r4 >> 51);
+    std::uint64_t h4 = static_cast<std::uint64_t>(r4) & fe51_detail::kMask;
+    h1 += h0 >> 51;
+    h0 &= fe51_detail::kMask;
+    return Fe51{{h0, h1, h2, h3, h4}};
+}
+
+// f^(2^n), n >= 1.
+PSI_FE51_INLINE Fe51 fe51SqTimes(Fe51 f, int n) {
+    for (int i = 0; i < n; ++i) {
+        f = fe51Sq(f);
+    }
+    return f;
+}
+
+// Ignores the top bit of the input, as libsodium does; non-canonical values
+// (>= p) are accepted and reduced by arithmetic.
+PSI_FE51_INLINE Fe51 fe51FromBytes(const unsigned char in[32]) {
+    using fe51_detail::kMask;
+    using fe51_detail::load64;
+    return Fe51{{load64(in) & kMask, (load64(in + 6) >> 3) & kMask, (load64(in + 12) >> 6) & kMask,
+                 (load64(in + 19) >> 1) & kMask, (load64(in + 24) >> 12) & kMask}};
+}
+
+// Canonical (fully reduced) little-endian encoding.
+PSI_FE51_INLINE void fe51ToBytes(unsigned char out[32], const Fe51& f) {
+    using fe51_detail::kMask;
+    std::uint64_t t0 = f.v[0], t1 = f.v[1], t2 = f.v[2], t3 = f.v[3], t4 = f.v[4];
+    fe51_detail::carry(t0, t1, t2, t3, t4);
+    fe51_detail::carry(t0, t1, t2, t3, t4);
+    // Now t < 2^255. Adding 19 carries past 2^255 exactly when t >= p.
+    t0 += 19;
+    fe51_detail::carry(t0, t1, t2, t3, t4);
+    // t + 19 (mod 2^255); add 2^255 - 19 and drop bit 255.
+    t0 += 0x8000000000000ULL - 19;
+    t1 += 0x8000000000000ULL - 1;
+    t2 += 0x8000000000000ULL - 1;
+    t3 += 0x8000000000000ULL - 1;
+    t4 += 0x8000000000000ULL - 1;
+    t1 += t0 >> 51;
+    t0 &= kMask;
+    t2 += t1 >> 51;
+    t1 &= kMask;
+    t3 += t2 >> 51;
+    t2 &= kMask;
+    t4 += t3 >> 51;
+    t3 &= kMask;
+    t4 &= kMask;
+
+    const std::uint64_t words[4] = {t0 | (t1 << 51), (t1 >> 13) | (t2 << 38),
+                                    (t2 >> 26) | (t3 << 25), (t3 >> 39) | (t4 << 12)};
+    for (int w = 0; w < 4; ++w) {
+        for (int b = 0; b < 8; ++b) {
+            out[8 * w + b] = static_cast<unsigned char>(words[w] >> (8 * b));
+        }
+    }
+}
+
+// Replaces f with g when flag is 1; flag must be 0 or 1.
+PSI_FE51_INLINE void fe51Cmov(Fe51& f, const Fe51& g, unsigned int flag) {
+    const std::uint64_t mask = 0 - static_cast<std::uint64_t>(flag);
+    for (int i = 0; i < 5; ++i) {
+        f.v[i] ^= mask & (f.v[i] ^ g.v[i]);
+    }
+}
+
+PSI_FE51_INLINE unsigned int fe51IsNegative(const Fe51& f) {
+    unsigned char bytes[32];
+    fe51ToBytes(bytes, f);
+    return bytes[0] & 1;
+}
+
+PSI_FE51_INLINE unsigned int fe51IsZero(const Fe51& f) {
+    unsigned char bytes[32];
+    fe51ToBytes(bytes, f);
+    unsigned char acc = 0;
+    for (const unsigned char b : bytes) {
+        acc |= b;
+    }
+    return (static_cast<unsigned int>(acc) - 1) >> 31;
+}
+
+PSI_FE51_INLINE Fe51 fe51Abs(const Fe51& f) {
+    Fe51 result = f;
+    fe51Cmov(result, fe51Neg(f), fe51IsNegative(f));
+    return result;
+}
+
+PSI_FE51_INLINE Fe51 fe51CondNeg(const Fe51& f, unsigned int flag) {
+    Fe51 result = f;
+    fe51Cmov(result, fe51Neg(f), flag);
+    return result;
+}
+
+// z^((p - 5) / 8) = z^(2^252 - 3), the exponent of the square-root ratio.
+PSI_FE51_INLINE Fe51 fe51Pow22523(const Fe51& z) {
+    Fe51 t0 = fe51Sq(z);                        // 2
+    Fe51 t1 = fe51SqTimes(t0, 2);               // 8
+    t1 = fe51Mul(z, t1);                        // 9
+    t0 = fe51Mul(t0, t1);                       // 11
+    t0 = fe51Sq(t0);                            // 22
+    t0 = fe51Mul(t1, t0);                       // 2^5 - 1
+    t1 = fe51SqTimes(t0, 5);
+    t0 = fe51Mul(t1, t0);                       // 2^10 - 1
+    t1 = fe51SqTimes(t0, 10);
+    t1 = fe51Mul(t1, t0);                       // 2^20 - 1
+    Fe51 t2 = fe51SqTimes(t1, 20);
+    t1 = fe51Mul(t2, t1);                       // 2^40 - 1
+    t1 = fe51SqTimes(t1, 10);
+    t0 = fe51Mul(t1, t0);                       // 2^50 - 1
+    t1 = fe51SqTimes(t0, 50);
+    t1 = fe51Mul(t1, t0);                       // 2^100 - 1
+    t2 = fe51SqTimes(t1, 100);
+    t1 = fe51Mul(t2, t1);                       // 2^200 - 1
+    t1 = fe51SqTimes(t1, 50);
+    t0 = fe51Mul(t1, t0);                       // 2^250 - 1
+    t0 = fe51SqTimes(t0, 2);                    // 2^252 - 4
+    return fe51Mul(t0, z);                      // 2^252 - 3
+}
+
+// 1/z = z^(p - 2) = z^(2^255 - 21); zero maps to zero.
+PSI_FE51_INLINE Fe51 fe51Invert(const Fe51& z) {
+    const Fe51 z3 = fe51Mul(fe51Sq(z), z);
+    return fe51Mul(fe51SqTimes(fe51Pow22523(z), 3), z3);  // 2^255 - 24 + 3
+}
+
+#endif  // __SIZEOF_INT128__
+
+#endif // CURVE25519_FE51_H
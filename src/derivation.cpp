@@ -107,14 +107,28 @@ std::vector<std::string> padElements(const std::vector<std::string>& elements,
     std::vector<std::string> padded = elements;
     padded.reserve(nMax);
 
-    for (std::uint32_t i = 0; padded.size() < nMax; ++i) {
-        std::vector<unsigned char> material(subseedForDummies.begin(), subseedForDummies.end());
-        appendLE32(material, i);
-        const auto derived = blake3DeriveKey(kDummyContext, material.data(), material.size());
+    // All dummy materials up front so their derivations run side by side
+    // (blake3DeriveKeyMany); each is subseedForDummies || LE32(i).
+    const std::size_t dummyCount = nMax - elements.size();
+    constexpr std::size_t kMaterialSize = 32 + 4;
+    std::vector<unsigned char> materials;
+    materials.reserve(dummyCount * kMaterialSize);
+    std::vector<const unsigned char*> inputs(dummyCount);
+    for (std::uint32_t i = 0; i < dummyCount; ++i) {
+        materials.insert(materials.end(), subseedForDummies.begin(), subseedForDummies.end());
+        appendLE32(materials, i);
+    }
+    for (std::size_t i = 0; i < dummyCount; ++i) {
+        inputs[i] = materials.data() + i * kMaterialSize;
+    }
+    std::vector<std::array<unsigned char, 32>> derived(dummyCount);
+    blake3DeriveKeyMany(kDummyContext, inputs.data(), kMaterialSize, dummyCount, derived.data());
+
+    for (const auto& key : derived) {
         // hex(...)[0:16]: the first 16 hex characters, i.e. the first 8 bytes
         // of the derived key. The "D:" prefix keeps dummies out of every real
         // cell namespace ("L<size>:x y").
-        padded.push_back("D:" + hexEncode(derived.data(), 8));
+        padded.push_back("D:" + hexEncode(key.data(), 8));
     }
 
     // Canonical protocol input order so recomputation at audit time is
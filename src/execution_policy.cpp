@@ -0,0 +1,31 @@
+#include "execution_policy.h"
+
+#include <mutex>
+
+namespace {
+
+std::mutex& defaultPolicyMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+ExecutionPolicy& defaultPolicyStorage() {
+    static ExecutionPolicy policy;
+    return policy;
+}
+
+}  // namespace
+
+void setDefaultExecutionPolicy(const ExecutionPolicy& policy) {
+    std::lock_guard<std::mutex> lock(defaultPolicyMutex());
+    defaultPolicyStorage() = policy;
+}
+
+ExecutionPolicy defaultExecutionPolicy() {
+    std::lock_guard<std::mutex> lock(defaultPolicyMutex());
+    return defaultPolicyStorage();
+}
+
+ExecutionPolicy resolveExecutionPolicy(const ExecutionPolicy* policy) {
+    return policy != nullptr ? *policy : defaultExecutionPolicy();
+}
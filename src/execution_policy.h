@@ -0,0 +1,118 @@
+#ifndef EXECUTION_POLICY_H
+#define EXECUTION_POLICY_H
+
+// How the per-element protocol loops are spread over threads. One fixed
+// answer does not fit every deployment: a latency-critical per-turn exchange
+// on a shared 64-core host wants a handful of threads, an offline batch job
+// wants every core. Every public entry point in psi_protocol.h (and
+// runCascadePSI) takes an optional `const ExecutionPolicy*`; nullptr means
+// the process-wide default below.
+//
+// A policy only changes scheduling. Outputs are written by index, so the
+// wire transcript is byte-identical for every policy, including fully
+// serial execution.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+#include "thread_pool.h"
+
+// The parallel per-element phases of an exchange. Their per-element cost
+// differs (Bob's tagging hashes twice around one multiplication, Bob's
+// response is a bare multiplication, Alice's unblinding adds an inversion), so
+// the serial/parallel crossover differs too; calibration.h measures it.
+enum class ProtocolPhase : std::size_t {
+    BobTagging = 0,       // hash-to-group, multiply, key and tag derivation
+    AliceBlinding = 1,    // scalar reduction, hash-to-group, multiply
+    BobResponse = 2,      // decode and multiply
+    AliceUnblinding = 3,  // invert, multiply, key (and tag) derivation
+};
+inline constexpr std::size_t kProtocolPhaseCount = 4;
+
+struct ExecutionPolicy {
+    // Threads working on one loop, caller included. 0: every pool worker plus
+    // the caller.
+    std::size_t threadCount{0};
+    // Indices per chunk. 0: derived from the count so each thread gets about
+    // four chunks (room for stealing without per-chunk overhead dominating).
+    std::size_t grainSize{0};
+    // Loops shorter than this run serially on the caller; below it, pool
+    // dispatch costs more than it saves.
+    std::size_t serialThreshold{192};
+    // Per-phase overrides of serialThreshold, indexed by ProtocolPhase.
+    // 0: use serialThreshold for that phase.
+    std::array<std::size_t, kProtocolPhaseCount> phaseThresholds{};
+    // Pool to run on. nullptr: ThreadPool::shared().
+    ThreadPool* pool{nullptr};
+    // Start inverting Alice's blinding scalars on the pool as soon as her
+    // blinded flight is serialized, so the round trip to Bob hides the cost
+    // (AliceSessionState::precomputedInverses). Opt-in: it only pays with a
+    // spare core and a real network wait, and it keeps a second copy of the
+    // scalars until it runs. Ignored when threadCount is 1 or the flight is
+    // below the AliceUnblinding threshold.
+    bool precomputeInverses{false};
+
+    // This policy with serialThreshold replaced by the phase's override (if
+    // any), ready to hand to parallelForIndex.
+    ExecutionPolicy forPhase(ProtocolPhase phase) const {
+        ExecutionPolicy scoped = *this;
+        const std::size_t threshold = phaseThresholds[static_cast<std::size_t>(phase)];
+        if (threshold != 0) {
+            scoped.serialThreshold = threshold;
+        }
+        return scoped;
+    }
+};
+
+// Process-wide default used whenever an entry point receives nullptr.
+// Intended to be set once at startup, before exchanges run; later calls are
+// safe but only affect loops that start afterwards.
+void setDefaultExecutionPolicy(const ExecutionPolicy& policy);
+ExecutionPolicy defaultExecutionPolicy();
+
+// policy when non-null, the process-wide default otherwise.
+ExecutionPolicy resolveExecutionPolicy(const ExecutionPolicy* policy);
+
+// Runs fn(begin, end) over disjoint chunks covering [0, count) under the
+// given policy, for loops that amortise work across a chunk (batched scalar
+// inversion, say). Below the serial cutoff fn sees the whole range at once.
+// fn must only touch state for indices in its chunk (or thread-safe state).
+// Exceptions thrown by workers are captured and rethrown on the caller
+// (first failing chunk wins).
+template <typename Fn>
+void parallelForChunks(const ExecutionPolicy& policy, std::size_t count, Fn&& fn) {
+    if (count == 0) {
+        return;
+    }
+    if (count < policy.serialThreshold || policy.threadCount == 1) {
+        fn(std::size_t{0}, count);
+        return;
+    }
+
+    ThreadPool& pool = policy.pool != nullptr ? *policy.pool : ThreadPool::shared();
+    const std::size_t available = pool.workerCount() + 1;
+    const std::size_t threadCount = std::min(
+        policy.threadCount == 0 ? available : std::min(policy.threadCount, available), count);
+    const std::size_t grain = policy.grainSize != 0
+                                  ? policy.grainSize
+                                  : std::max<std::size_t>(1, (count + threadCount * 4 - 1) /
+                                                                 (threadCount * 4));
+
+    parallelForRange(pool, count, grain, threadCount,
+                     [&](std::size_t begin, std::size_t end) { fn(begin, end); });
+}
+
+// Runs fn(i) for i in [0, count) under the given policy. fn must only touch
+// index-i state (or thread-safe state). Exceptions thrown by workers are
+// captured and rethrown on the caller (first failing chunk wins).
+template <typename Fn>
+void parallelForIndex(const ExecutionPolicy& policy, std::size_t count, Fn&& fn) {
+    parallelForChunks(policy, count, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            fn(i);
+        }
+    });
+}
+
+#endif // EXECUTION_POLICY_H
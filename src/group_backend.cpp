@@ -0,0 +1,192 @@
+#include "group_backend.h"
+
+#include <stdexcept>
+#include <vector>
+
+#include "ristretto_batch.h"
+#include "x25519_point.h"
+
+namespace {
+
+std::vector<RistrettoElement> ristrettoElements(const GroupElement* elements, std::size_t count) {
+    std::vector<RistrettoElement> unpacked(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        unpacked[i] = elements[i].ristretto;
+    }
+    return unpacked;
+}
+
+class RistrettoMultiplier final : public GroupMultiplier {
+public:
+    explicit RistrettoMultiplier(const RistrettoScalar& scalar) : multiplier_(scalar) {}
+
+    void multiplyBatch(const GroupElement* elements, std::size_t count, RistrettoPoint* out,
+                       const char* context) const override {
+        const auto unpacked = ristrettoElements(elements, count);
+        multiplier_.multiplyBatch(unpacked.data(), count, out, context);
+    }
+
+    void multiplyBatch(const RistrettoPoint* points, std::size_t count, RistrettoPoint* out,
+                       const char* context) const override {
+        multiplier_.multiplyBatch(points, count, out, context);
+    }
+
+private:
+    FixedScalarMultiplier multiplier_;
+};
+
+class RistrettoBackend final : public GroupBackend {
+public:
+    Group group() const override { return Group::Ristretto255; }
+
+    void hashToGroup(const std::string* messages, std::size_t count, GroupElement* out,
+                     HashToGroupCache* cache, CipherSuite suite) const override {
+        std::vector<RistrettoElement> hashed(count);
+        hashToGroupElementBatch(messages, count, hashed.data(), cache, suite);
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i].ristretto = hashed[i];
+        }
+    }
+
+    void decode(const RistrettoPoint* points, std::size_t count, GroupElement* out,
+                const char* context) const override {
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i].ristretto = decodeElement(points[i].data(), context);
+        }
+    }
+
+    void multiply(const RistrettoScalar* scalars, const GroupElement* elements, std::size_t count,
+                  RistrettoPoint* out, const char* context) const override {
+        const auto unpacked = ristrettoElements(elements, count);
+        multiplyElements(scalars, unpacked.data(), count, out, context);
+    }
+
+    std::unique_ptr<GroupMultiplier> fixedMultiplier(const RistrettoScalar& scalar) const override {
+        return std::make_unique<RistrettoMultiplier>(scalar);
+    }
+
+    void invertScalars(const RistrettoScalar* scalars, std::size_t count,
+                       RistrettoScalar* inverses) const override {
+        invertScalarsBatch(scalars, count, inverses);
+    }
+};
+
+[[noreturn]] void throwX25519Failure(const char* context) {
+    throw std::runtime_error(std::string("x25519 scalar multiplication failed: ") + context);
+}
+
+std::vector<X25519Element> x25519Elements(const GroupElement* elements, std::size_t count) {
+    std::vector<X25519Element> unpacked(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        unpacked[i] = elements[i].x25519;
+    }
+    return unpacked;
+}
+
+std::vector<X25519Element> decodeX25519(const RistrettoPoint* points, std::size_t count,
+                                        const char* context) {
+    std::vector<X25519Element> decoded(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!x25519Decode(decoded[i], points[i].data())) {
+            throwX25519Failure(context);
+        }
+    }
+    return decoded;
+}
+
+// The point at infinity encodes to zero bytes; reject it like libsodium
+// rejects an identity ristretto255 product.
+void checkProducts(const RistrettoPoint* out, std::size_t count, const char* context) {
+    for (std::size_t i = 0; i < count; ++i) {
+        if (sodium_is_zero(out[i].data(), out[i].size())) {
+            throwX25519Failure(context);
+        }
+    }
+}
+
+// Bob's multiplier. It multiplies by 8 * scalar as an integer, not reduced
+// modulo l: on the order-l subgroup that is just another scalar (Alice
+// unblinds to 8b * H(x) and Bob tags with 8b * H(x)), but it also sends any
+// small-order component of a point Alice crafted to the identity, so her
+// blinded values cannot probe Bob's scalar modulo 8.
+class X25519Multiplier final : public GroupMultiplier {
+public:
+    explicit X25519Multiplier(const RistrettoScalar& scalar) {
+        // Reduced scalars are below l < 2^253, so the product fits 256 bits.
+        if ((scalar[31] & 0xe0) != 0) {
+            throw std::runtime_error("x25519 scalars must be reduced modulo the group order");
+        }
+        for (std::size_t i = scalar_.size() - 1; i > 0; --i) {
+            scalar_[i] = static_cast<unsigned char>((scalar[i] << 3) | (scalar[i - 1] >> 5));
+        }
+        scalar_[0] = static_cast<unsigned char>(scalar[0] << 3);
+    }
+
+    ~X25519Multiplier() override { sodium_memzero(scalar_.data(), scalar_.size()); }
+
+    void multiplyBatch(const GroupElement* elements, std::size_t count, RistrettoPoint* out,
+                       const char* context) const override {
+        const auto unpacked = x25519Elements(elements, count);
+        x25519ScalarMultBatch(scalar_, unpacked.data(), count, out);
+        checkProducts(out, count, context);
+    }
+
+    void multiplyBatch(const RistrettoPoint* points, std::size_t count, RistrettoPoint* out,
+                       const char* context) const override {
+        const auto decoded = decodeX25519(points, count, context);
+        x25519ScalarMultBatch(scalar_, decoded.data(), count, out);
+        checkProducts(out, count, context);
+    }
+
+private:
+    RistrettoScalar scalar_{};
+};
+
+class X25519Backend final : public GroupBackend {
+public:
+    Group group() const override { return Group::X25519; }
+
+    void hashToGroup(const std::string* messages, std::size_t count, GroupElement* out,
+                     HashToGroupCache* cache, CipherSuite suite) const override {
+        std::vector<X25519Element> hashed(count);
+        hashToGroupElementBatch(messages, count, hashed.data(), cache, suite);
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i].x25519 = hashed[i];
+        }
+    }
+
+    void decode(const RistrettoPoint* points, std::size_t count, GroupElement* out,
+                const char* context) const override {
+        const auto decoded = decodeX25519(points, count, context);
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i].x25519 = decoded[i];
+        }
+    }
+
+    void multiply(const RistrettoScalar* scalars, const GroupElement* elements, std::size_t count,
+                  RistrettoPoint* out, const char* context) const override {
+        const auto unpacked = x25519Elements(elements, count);
+        x25519ScalarMultBatch(scalars, unpacked.data(), count, out);
+        checkProducts(out, count, context);
+    }
+
+    std::unique_ptr<GroupMultiplier> fixedMultiplier(const RistrettoScalar& scalar) const override {
+        return std::make_unique<X25519Multiplier>(scalar);
+    }
+
+    void invertScalars(const RistrettoScalar* scalars, std::size_t count,
+                       RistrettoScalar* inverses) const override {
+        invertScalarsBatch(scalars, count, inverses);
+    }
+};
+
+}  // namespace
+
+const GroupBackend& groupBackend(Group group) {
+    static const RistrettoBackend ristretto;
+    static const X25519Backend x25519;
+    if (group == Group::X25519) {
+        return x25519;
+    }
+    return ristretto;
+}
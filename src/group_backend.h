@@ -0,0 +1,84 @@
+#ifndef GROUP_BACKEND_H
+#define GROUP_BACKEND_H
+
+// The group operations of the protocol behind one interface, so that
+// psi_protocol.cpp runs unchanged in either group a ciphersuite names
+// (ciphersuite.h):
+//
+//   ristretto255  ristretto_batch.h: fixed-window Edwards ladder, encoding
+//                 and decoding through an inverse square root
+//   x25519        x25519_point.h: the X25519 Montgomery ladder on
+//                 u-coordinates, Elligator 2 hash-to-curve with the cofactor
+//                 cleared, batched inversions for encoding
+//
+// Both groups have prime order l, so scalars are shared: they are sampled
+// and reduced the same way in either group, and inversion is
+// invertScalarsBatch for both. Every product is encoded once, for the wire
+// or for key derivation, and an identity product is an error naming the
+// caller's context, as crypto_scalarmult_ristretto255 fails there. Encodings
+// are 32 bytes in both groups and travel as RistrettoPoint.
+//
+// The backend is chosen by the session's ciphersuite, which Bob picks and
+// names in his first flight, so a process can run exchanges in both groups
+// side by side. Implementations are stateless singletons and thread-safe.
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "ciphersuite.h"
+#include "crypto_utils.h"
+
+// Multiplication by one scalar fixed for the whole exchange (Bob's phases).
+// Holds whatever the backend precomputes from the scalar; wiped on
+// destruction. Never keep one beyond the exchange it was made for.
+class GroupMultiplier {
+public:
+    virtual ~GroupMultiplier() = default;
+
+    // out[i] = encoding of scalar * elements[i]; the first failing index
+    // throws std::runtime_error naming context.
+    virtual void multiplyBatch(const GroupElement* elements, std::size_t count, RistrettoPoint* out,
+                               const char* context) const = 0;
+
+    // The same for encoded points from the counterparty: decode, multiply,
+    // encode. Invalid encodings throw like identity products.
+    virtual void multiplyBatch(const RistrettoPoint* points, std::size_t count, RistrettoPoint* out,
+                               const char* context) const = 0;
+};
+
+class GroupBackend {
+public:
+    virtual ~GroupBackend() = default;
+
+    virtual Group group() const = 0;
+
+    // Hash-to-group: out[i] = H1(messages[i]) under the suite's hashing,
+    // through the local cache when non-null (crypto_utils.h).
+    virtual void hashToGroup(const std::string* messages, std::size_t count, GroupElement* out,
+                             HashToGroupCache* cache, CipherSuite suite) const = 0;
+
+    // Decodes a counterparty's points; throws std::runtime_error naming
+    // context on an invalid encoding.
+    virtual void decode(const RistrettoPoint* points, std::size_t count, GroupElement* out,
+                        const char* context) const = 0;
+
+    // out[i] = encoding of scalars[i] * elements[i] (Alice's blinding and
+    // unblinding). Same errors as GroupMultiplier.
+    virtual void multiply(const RistrettoScalar* scalars, const GroupElement* elements,
+                          std::size_t count, RistrettoPoint* out, const char* context) const = 0;
+
+    virtual std::unique_ptr<GroupMultiplier> fixedMultiplier(const RistrettoScalar& scalar) const = 0;
+
+    // Inverses modulo l, for unblinding (invertScalarsBatch's contract).
+    virtual void invertScalars(const RistrettoScalar* scalars, std::size_t count,
+                               RistrettoScalar* inverses) const = 0;
+};
+
+const GroupBackend& groupBackend(Group group);
+
+inline const GroupBackend& groupBackendFor(CipherSuite suite) {
+    return groupBackend(cipherSuiteGroup(suite));
+}
+
+#endif // GROUP_BACKEND_H
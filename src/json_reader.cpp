@@ -0,0 +1,310 @@
+#include "json_reader.h"
+
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+namespace {
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+}  // namespace
+
+JsonReader::JsonReader(std::string_view text, const JsonLimits& limits)
+    : text_(text), limits_(limits) {
+    if (text_.size() > limits_.maxBytes) {
+        throw std::runtime_error("JSON document of " + std::to_string(text_.size()) +
+                                 " bytes exceeds the limit of " +
+                                 std::to_string(limits_.maxBytes));
+    }
+}
+
+void JsonReader::fail(const std::string& what) const {
+    std::size_t line = 1;
+    std::size_t lineStart = 0;
+    for (std::size_t i = 0; i < pos_ && i < text_.size(); ++i) {
+        if (text_[i] == '\n') {
+            ++line;
+            lineStart = i + 1;
+        }
+    }
+    throw std::runtime_error("JSON error at byte " + std::to_string(pos_) + " (line " +
+                             std::to_string(line) + ", column " +
+                             std::to_string(pos_ - lineStart + 1) + "): " + what);
+}
+
+void JsonReader::skipWhitespace() {
+    while (pos_ < text_.size()) {
+        const char c = text_[pos_];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            return;
+        }
+        ++pos_;
+    }
+}
+
+char JsonReader::peek() {
+    skipWhitespace();
+    return pos_ < text_.size() ? text_[pos_] : '\0';
+}
+
+void JsonReader::expect(char c) {
+    if (peek() != c) {
+        fail(pos_ < text_.size() ? std::string("expected '") + c + "'"
+                                 : std::string("unexpected end of document, expected '") + c +
+                                       "'");
+    }
+    ++pos_;
+}
+
+void JsonReader::open(char c) {
+    expect(c);
+    if (counts_.size() >= limits_.maxDepth) {
+        fail("nesting deeper than " + std::to_string(limits_.maxDepth));
+    }
+    counts_.push_back(0);
+}
+
+void JsonReader::beginObject() {
+    open('{');
+}
+
+void JsonReader::beginArray() {
+    open('[');
+}
+
+bool JsonReader::nextMember(std::string_view& key) {
+    const char c = peek();
+    if (c == '}') {
+        ++pos_;
+        counts_.pop_back();
+        return false;
+    }
+    if (counts_.back() > 0) {
+        if (c != ',') {
+            fail("expected ',' or '}'");
+        }
+        ++pos_;
+    }
+    if (++counts_.back() > limits_.maxArrayItems) {
+        fail("more than " + std::to_string(limits_.maxArrayItems) + " members");
+    }
+    if (peek() != '"') {
+        fail("expected a member name");
+    }
+    key = readString(keyScratch_);
+    expect(':');
+    return true;
+}
+
+bool JsonReader::nextItem() {
+    const char c = peek();
+    if (c == ']') {
+        ++pos_;
+        counts_.pop_back();
+        return false;
+    }
+    if (counts_.back() > 0) {
+        if (c != ',') {
+            fail("expected ',' or ']'");
+        }
+        ++pos_;
+    }
+    if (++counts_.back() > limits_.maxArrayItems) {
+        fail("more than " + std::to_string(limits_.maxArrayItems) + " items");
+    }
+    return true;
+}
+
+std::string_view JsonReader::string() {
+    if (peek() != '"') {
+        fail("expected a string");
+    }
+    return readString(valueScratch_);
+}
+
+// At the opening quote. Unescaped strings are returned in place; the first
+// backslash switches to decoding into scratch.
+std::string_view JsonReader::readString(std::string& scratch) {
+    const std::size_t start = ++pos_;
+    bool escaped = false;
+    while (true) {
+        if (pos_ >= text_.size()) {
+            fail("unterminated string");
+        }
+        if (pos_ - start > limits_.maxStringBytes) {
+            fail("string longer than " + std::to_string(limits_.maxStringBytes) + " bytes");
+        }
+        const char c = text_[pos_];
+        if (c == '"') {
+            ++pos_;
+            return escaped ? std::string_view(scratch) : text_.substr(start, pos_ - 1 - start);
+        }
+        if (static_cast<unsigned char>(c) < 0x20) {
+            fail("control character in string");
+        }
+        if (c != '\\') {
+            if (escaped) {
+                scratch.push_back(c);
+            }
+            ++pos_;
+            continue;
+        }
+        if (!escaped) {
+            scratch.assign(text_.data() + start, pos_ - start);
+            escaped = true;
+        }
+        if (++pos_ >= text_.size()) {
+            fail("unterminated string");
+        }
+        switch (text_[pos_++]) {
+            case '"': scratch.push_back('"'); break;
+            case '\\': scratch.push_back('\\'); break;
+            case '/': scratch.push_back('/'); break;
+            case 'b': scratch.push_back('\b'); break;
+            case 'f': scratch.push_back('\f'); break;
+            case 'n': scratch.push_back('\n'); break;
+            case 'r': scratch.push_back('\r'); break;
+            case 't': scratch.push_back('\t'); break;
+            case 'u': appendCodePoint(scratch); break;
+            default:
+                --pos_;
+                fail("invalid escape in string");
+        }
+    }
+}
+
+unsigned JsonReader::hex4() {
+    unsigned value = 0;
+    for (int i = 0; i < 4; ++i, ++pos_) {
+        const char c = pos_ < text_.size() ? text_[pos_] : '\0';
+        value <<= 4;
+        if (isDigit(c)) {
+            value |= static_cast<unsigned>(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            value |= static_cast<unsigned>(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            value |= static_cast<unsigned>(c - 'A' + 10);
+        } else {
+            fail("invalid \\u escape");
+        }
+    }
+    return value;
+}
+
+// After "\u": one code point, or a surrogate pair, as UTF-8.
+void JsonReader::appendCodePoint(std::string& out) {
+    unsigned code = hex4();
+    if (code >= 0xdc00 && code <= 0xdfff) {
+        fail("unpaired low surrogate");
+    }
+    if (code >= 0xd800 && code <= 0xdbff) {
+        if (text_.substr(pos_, 2) != "\\u") {
+            fail("unpaired high surrogate");
+        }
+        pos_ += 2;
+        const unsigned low = hex4();
+        if (low < 0xdc00 || low > 0xdfff) {
+            fail("unpaired high surrogate");
+        }
+        code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+    }
+    if (code < 0x80) {
+        out.push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+        out.push_back(static_cast<char>(0xc0 | (code >> 6)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    } else if (code < 0x10000) {
+        out.push_back(static_cast<char>(0xe0 | (code >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    } else {
+        out.push_back(static_cast<char>(0xf0 | (code >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    }
+}
+
+// The JSON number grammar is checked here, so from_chars never sees the
+// "inf", "nan" or hexadecimal forms it would otherwise accept.
+double JsonReader::number() {
+    skipWhitespace();
+    const std::size_t start = pos_;
+    auto at = [this]() { return pos_ < text_.size() ? text_[pos_] : '\0'; };
+    auto digits = [&]() {
+        if (!isDigit(at())) {
+            fail(pos_ == start ? "expected a value" : "expected a digit");
+        }
+        while (isDigit(at())) {
+            ++pos_;
+        }
+    };
+    if (at() == '-') {
+        ++pos_;
+    }
+    if (at() == '0') {
+        ++pos_;
+    } else {
+        digits();
+    }
+    if (at() == '.') {
+        ++pos_;
+        digits();
+    }
+    if (at() == 'e' || at() == 'E') {
+        ++pos_;
+        if (at() == '+' || at() == '-') {
+            ++pos_;
+        }
+        digits();
+    }
+    double value = 0;
+    const auto result = std::from_chars(text_.data() + start, text_.data() + pos_, value);
+    if (result.ec != std::errc()) {
+        pos_ = start;
+        fail("number out of range");
+    }
+    return value;
+}
+
+void JsonReader::skipValue() {
+    switch (peek()) {
+        case '{': {
+            beginObject();
+            std::string_view key;
+            while (nextMember(key)) {
+                skipValue();
+            }
+            return;
+        }
+        case '[':
+            beginArray();
+            while (nextItem()) {
+                skipValue();
+            }
+            return;
+        case '"':
+            string();
+            return;
+        default:
+            break;
+    }
+    for (const std::string_view literal : {"true", "false", "null"}) {
+        if (text_.substr(pos_, literal.size()) == literal) {
+            pos_ += literal.size();
+            return;
+        }
+    }
+    number();
+}
+
+void JsonReader::end() {
+    skipWhitespace();
+    if (pos_ != text_.size()) {
+        fail("unexpected data after the document");
+    }
+}
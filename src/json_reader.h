@@ -0,0 +1,71 @@
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+// Single-pass pull reader for JSON requests, the counterpart of JsonWriter
+// (json_writer.h). The caller walks the document it expects: beginObject /
+// nextMember, beginArray / nextItem, then string, number or skipValue for
+// each value. Nothing is copied except strings that contain escapes, numbers
+// go through std::from_chars, and every error is a std::runtime_error naming
+// the byte offset, line and column where the document stopped making sense.
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct JsonLimits {
+    std::size_t maxBytes = std::size_t{64} << 20;
+    std::size_t maxDepth = 32;
+    std::size_t maxStringBytes = 4096;
+    std::size_t maxArrayItems = std::size_t{1} << 20;
+};
+
+class JsonReader {
+public:
+    // Throws if text is over limits.maxBytes. text must outlive the reader.
+    explicit JsonReader(std::string_view text, const JsonLimits& limits = {});
+
+    void beginObject();
+    // Reads the next member's key and its ':'; false (and the object closed)
+    // at '}'. The key is valid until the next nextMember.
+    bool nextMember(std::string_view& key);
+
+    void beginArray();
+    // True if another item follows; false (and the array closed) at ']'.
+    bool nextItem();
+
+    // The view points into the text unless the string has escapes; either way
+    // it is valid until the next call to string.
+    std::string_view string();
+    double number();
+    // Any value, nested containers included.
+    void skipValue();
+
+    // Only whitespace may follow the top-level value.
+    void end();
+
+    std::size_t offset() const { return pos_; }
+
+    // Throws std::runtime_error("JSON error at byte N (line L, column C): what")
+    // for the current position.
+    [[noreturn]] void fail(const std::string& what) const;
+
+private:
+    void skipWhitespace();
+    char peek();
+    void expect(char c);
+    void open(char c);
+    std::string_view readString(std::string& scratch);
+    void appendCodePoint(std::string& out);
+    unsigned hex4();
+
+    std::string_view text_;
+    JsonLimits limits_;
+    std::size_t pos_{0};
+    // Items read so far in each open container.
+    std::vector<std::size_t> counts_;
+    std::string keyScratch_;
+    std::string valueScratch_;
+};
+
+#endif // JSON_READER_H
@@ -0,0 +1,80 @@
+#include "json_writer.h"
+
+#include <charconv>
+#include <cmath>
+
+namespace {
+
+// The escape for c, or nullptr if it is written as is. Other control
+// characters take the six-byte \u00XX form.
+const char* shortEscape(char c) {
+    switch (c) {
+        case '"':
+            return "\\\"";
+        case '\\':
+            return "\\\\";
+        case '\n':
+            return "\\n";
+        case '\r':
+            return "\\r";
+        case '\t':
+            return "\\t";
+        default:
+            return nullptr;
+    }
+}
+
+bool isControl(char c) {
+    return static_cast<unsigned char>(c) < 0x20;
+}
+
+}  // namespace
+
+std::size_t jsonStringSize(std::string_view text) {
+    std::size_t size = 2;
+    for (const char c : text) {
+        size += shortEscape(c) != nullptr ? 2 : isControl(c) ? 6 : 1;
+    }
+    return size;
+}
+
+void JsonWriter::string(std::string_view text) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    out_.push_back('"');
+    std::size_t run = 0;  // start of the unescaped run being copied
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        const char c = text[i];
+        const char* escape = shortEscape(c);
+        if (escape == nullptr && !isControl(c)) {
+            continue;
+        }
+        out_.append(text.data() + run, i - run);
+        run = i + 1;
+        if (escape != nullptr) {
+            out_.append(escape, 2);
+        } else {
+            const auto byte = static_cast<unsigned char>(c);
+            const char unicode[] = {'\\', 'u', '0', '0', kHex[byte >> 4], kHex[byte & 15]};
+            out_.append(unicode, sizeof unicode);
+        }
+    }
+    out_.append(text.data() + run, text.size() - run);
+    out_.push_back('"');
+}
+
+void JsonWriter::number(double value) {
+    if (!std::isfinite(value)) {
+        raw("null");
+        return;
+    }
+    char buffer[32];
+    const auto result =
+        std::to_chars(buffer, buffer + sizeof buffer, value, std::chars_format::general, 6);
+    out_.append(buffer, result.ptr);
+}
+
+char* JsonWriter::extend(std::size_t size) {
+    const std::size_t offset = out_.size();
+    out_.resize(offset + size);
+    return out_.data() + offset;
+}
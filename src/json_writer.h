@@ -0,0 +1,47 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+// Append-only JSON output into one std::string. The caller reserves the
+// final size up front (the *JsonSize functions next to each serializer give
+// it exactly for flights) and writes every token once, so a response that
+// nests several flights is built without an intermediate string per flight
+// or per item. The writer does not track nesting: punctuation is written by
+// the caller, as in the wire formats it produces.
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+
+class JsonWriter {
+public:
+    explicit JsonWriter(std::size_t expectedSize = 0) { out_.reserve(expectedSize); }
+
+    void raw(std::string_view text) { out_.append(text.data(), text.size()); }
+    void raw(char c) { out_.push_back(c); }
+
+    // A quoted string with '"', '\\' and control characters escaped.
+    void string(std::string_view text);
+
+    // As "%g" formats it, which is also what std::ostream writes by default;
+    // non-finite values become null.
+    void number(double value);
+
+    // Appends size bytes and returns where they start, for callers that fill
+    // a fixed layout in place. Valid until the next append.
+    char* extend(std::size_t size);
+
+    std::size_t size() const { return out_.size(); }
+    std::size_t capacity() const { return out_.capacity(); }
+
+    // The document; the writer is left empty.
+    std::string take() { return std::move(out_); }
+
+private:
+    std::string out_;
+};
+
+// Bytes JsonWriter::string writes for text, quotes included.
+std::size_t jsonStringSize(std::string_view text);
+
+#endif // JSON_WRITER_H
@@ -143,7 +143,8 @@ std::size_t CascadeResult::totalWireBytes() const {
 
 CascadeResult runCascadePSI(const std::vector<Unit>& bobUnits,
                             const std::vector<Unit>& aliceUnits,
-                            const MeshConfig& config) {
+                            const MeshConfig& config,
+                            const ExecutionPolicy* policy) {
     validateMeshConfig(config);
 
     CascadeResult result;
@@ -201,16 +202,17 @@ CascadeResult runCascadePSI(const std::vector<Unit>& bobUnits,
         // across levels would let Alice correlate tags between levels and
         // test coarse-level guesses against fine-level tags.
         const auto bobMessage = timed(stats.bobSetupMs, [&]() {
-            return bobCreateInitialTagMessageFromElements(bobElements);
+            return bobCreateInitialTagMessageFromElements(bobElements, nullptr, nullptr, policy);
         });
         const auto aliceMessage = timed(stats.aliceSetupMs, [&]() {
-            return aliceProcessBobTagMessageFromElements(bobMessage.serialized, aliceElements);
+            return aliceProcessBobTagMessageFromElements(bobMessage.serialized, aliceElements,
+                                                         nullptr, nullptr, policy);
         });
         const auto bobResponse = timed(stats.bobResponseMs, [&]() {
-            return bobProcessAliceMessage(aliceMessage.serialized, bobMessage.state);
+            return bobProcessAliceMessage(aliceMessage.serialized, bobMessage.state, policy);
         });
         const auto matches = timed(stats.aliceFinalizeMs, [&]() {
-            return aliceFinalizeIntersectionTags(bobResponse.serialized, aliceMessage.state);
+            return aliceFinalizeIntersectionTags(bobResponse.serialized, aliceMessage.state, policy);
         });
 
         stats.wireBytes = bobMessage.serialized.size() + aliceMessage.serialized.size() +
@@ -27,6 +27,7 @@
 #include <string>
 #include <vector>
 
+#include "execution_policy.h"
 #include "psi_types.h"
 
 struct MeshConfig {
@@ -97,9 +98,11 @@ struct CascadeResult {
 };
 
 // Runs the full coarse-to-fine cascade described above. A single-level config
-// degenerates to flat tag-mode PSI over that level's cells.
+// degenerates to flat tag-mode PSI over that level's cells. `policy` is
+// passed to every level's exchange (nullptr: process-wide default).
 CascadeResult runCascadePSI(const std::vector<Unit>& bobUnits,
                             const std::vector<Unit>& aliceUnits,
-                            const MeshConfig& config);
+                            const MeshConfig& config,
+                            const ExecutionPolicy* policy = nullptr);
 
 #endif // MESH_PSI_H
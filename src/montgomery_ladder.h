@@ -0,0 +1,75 @@
+#ifndef MONTGOMERY_LADDER_H
+#define MONTGOMERY_LADDER_H
+
+// The X25519 Montgomery ladder (RFC 7748, section 5) over Fe51, shared by the
+// portable and BMI2/ADX builds (x25519_point.cpp and
+// ristretto_point_mulx.cpp). Internal to those files: like curve25519_fe51.h,
+// everything has internal linkage so each instruction-set build keeps its own
+// copy.
+//
+// Unlike crypto_scalarmult_curve25519 the scalar is not clamped: all 256 bits
+// are used as given, because the protocol multiplies by inverses of blinding
+// scalars, which clamping would change. Clamp the scalar first and the result
+// is crypto_scalarmult_curve25519's (tests/x25519_point_test.cpp checks this).
+
+#include "curve25519_fe51.h"
+
+#if defined(PSI_HAVE_FE51)
+
+namespace montgomery_detail {
+
+constexpr Fe51 kA24 = {{121665, 0, 0, 0, 0}};  // (A - 2) / 4
+
+// Swaps f and g when flag is 1; flag must be 0 or 1.
+PSI_FE51_INLINE void fe51CSwap(Fe51& f, Fe51& g, unsigned int flag) {
+    const std::uint64_t mask = 0 - static_cast<std::uint64_t>(flag);
+    for (int i = 0; i < 5; ++i) {
+        const std::uint64_t x = mask & (f.v[i] ^ g.v[i]);
+        f.v[i] ^= x;
+        g.v[i] ^= x;
+    }
+}
+
+// Projective u-coordinate (U:W) of scalar * P, where u is the affine
+// u-coordinate of P. W is zero exactly when the product is the point at
+// infinity. One differential addition and one doubling per scalar bit, all
+// 256 bits, with conditional swaps instead of branches.
+PSI_FE51_INLINE void montgomeryLadder(const unsigned char scalar[32], const Fe51& u, Fe51& outU,
+                                      Fe51& outW) {
+    Fe51 x2 = fe51One();
+    Fe51 z2 = fe51Zero();
+    Fe51 x3 = u;
+    Fe51 z3 = fe51One();
+    unsigned int swap = 0;
+    for (int t = 255; t >= 0; --t) {
+        const unsigned int bit = (scalar[t >> 3] >> (t & 7)) & 1U;
+        swap ^= bit;
+        fe51CSwap(x2, x3, swap);
+        fe51CSwap(z2, z3, swap);
+        swap = bit;
+
+        const Fe51 a = fe51Add(x2, z2);
+        const Fe51 aa = fe51Sq(a);
+        const Fe51 b = fe51Sub(x2, z2);
+        const Fe51 bb = fe51Sq(b);
+        const Fe51 e = fe51Sub(aa, bb);
+        const Fe51 c = fe51Add(x3, z3);
+        const Fe51 d = fe51Sub(x3, z3);
+        const Fe51 da = fe51Mul(d, a);
+        const Fe51 cb = fe51Mul(c, b);
+        x3 = fe51Sq(fe51Add(da, cb));
+        z3 = fe51Mul(u, fe51Sq(fe51Sub(da, cb)));
+        x2 = fe51Mul(aa, bb);
+        z2 = fe51Mul(e, fe51Add(aa, fe51Mul(e, kA24)));
+    }
+    fe51CSwap(x2, x3, swap);
+    fe51CSwap(z2, z3, swap);
+    outU = x2;
+    outW = z2;
+}
+
+}  // namespace montgomery_detail
+
+#endif  // PSI_HAVE_FE51
+
+#endif // MONTGOMERY_LADDER_H
@@ -0,0 +1,100 @@
+#ifndef POINT_BATCH_H
+#define POINT_BATCH_H
+
+// Contiguous storage for a flight's fixed-width values: the 32-byte points of
+// Alice's blinded and Bob's transformed flights (PointBatch) and Bob's
+// membership tags (TagBatch). Entries sit back to back in one buffer aligned
+// to a cache line, N x 32 bytes, so a 100k-element flight is one allocation
+// and the serializers copy it in a single pass instead of visiting a heap
+// vector per element.
+//
+// An entry is a std::array<unsigned char, Width>, the type RistrettoPoint and
+// MembershipTag already are, so operator[] hands out points and tags
+// directly, and data() is a plain array of them for the batch APIs
+// (pointsToKeysAndTags, GroupMultiplier::multiplyBatch). bytes() is the same
+// buffer as raw bytes, Width * size() long.
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+template <typename T, std::size_t Alignment>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(std::size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t{Alignment}));
+    }
+
+    void deallocate(T* pointer, std::size_t) {
+        ::operator delete(pointer, std::align_val_t{Alignment});
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const {
+        return false;
+    }
+};
+
+template <std::size_t Width>
+class FixedWidthBatch {
+public:
+    using Entry = std::array<unsigned char, Width>;
+    static constexpr std::size_t kWidth = Width;
+    static constexpr std::size_t kAlignment = 64;
+    static_assert(sizeof(Entry) == Width, "entries must be packed");
+
+    FixedWidthBatch() = default;
+    // count zeroed entries.
+    explicit FixedWidthBatch(std::size_t count) : entries_(count) {}
+
+    std::size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+    void resize(std::size_t count) { entries_.resize(count); }
+    void reserve(std::size_t count) { entries_.reserve(count); }
+    void clear() { entries_.clear(); }
+    void push_back(const Entry& entry) { entries_.push_back(entry); }
+
+    Entry& operator[](std::size_t i) { return entries_[i]; }
+    const Entry& operator[](std::size_t i) const { return entries_[i]; }
+
+    Entry* data() { return entries_.data(); }
+    const Entry* data() const { return entries_.data(); }
+    Entry* begin() { return entries_.data(); }
+    Entry* end() { return entries_.data() + entries_.size(); }
+    const Entry* begin() const { return entries_.data(); }
+    const Entry* end() const { return entries_.data() + entries_.size(); }
+
+    unsigned char* bytes() { return reinterpret_cast<unsigned char*>(entries_.data()); }
+    const unsigned char* bytes() const {
+        return reinterpret_cast<const unsigned char*>(entries_.data());
+    }
+    std::size_t byteSize() const { return entries_.size() * Width; }
+
+    bool operator==(const FixedWidthBatch& other) const { return entries_ == other.entries_; }
+    bool operator!=(const FixedWidthBatch& other) const { return entries_ != other.entries_; }
+
+private:
+    std::vector<Entry, AlignedAllocator<Entry, kAlignment>> entries_;
+};
+
+// Encoded group elements (ristretto255 or x25519, 32 bytes either way).
+using PointBatch = FixedWidthBatch<32>;
+// Membership tags (crypto_utils.h).
+using TagBatch = FixedWidthBatch<32>;
+
+#endif // POINT_BATCH_H
@@ -1,18 +1,22 @@
 #include "psi_protocol.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
-#include <exception>
+#include <memory>
 #include <stdexcept>
-#include <thread>
 #include <unordered_set>
 #include <utility>
 
 #include "crypto_utils.h"
 #include "derivation.h"
+#include "execution_policy.h"
+#include "group_backend.h"
 #include "position_utils.h"
 #include "random_utils.h"
 #include "serialization_utils.h"
+#include "tag_filter.h"
+#include "tag_set.h"
 
 extern "C" {
 #include <sodium.h>
@@ -24,10 +28,11 @@ namespace {
 // Thread-parallel per-element execution.
 //
 // The per-element work in every protocol phase is an independent scalar
-// multiplication (plus hashing), so it is embarrassingly parallel. The
-// libsodium primitives used inside the loops (crypto_scalarmult_ristretto255,
-// crypto_core_ristretto255_*, crypto_hash_sha512) are thread-safe once
-// sodium_init has run.
+// multiplication (plus hashing), so it is embarrassingly parallel. The group
+// backends (group_backend.h) and the libsodium primitives used inside the
+// loops (crypto_core_ristretto255_scalar_*, crypto_hash_sha512) are
+// thread-safe once sodium_init has run. Chunks run on a persistent work-stealing pool
+// (thread_pool.h) rather than on threads spawned per phase.
 //
 // SECURITY invariants preserved by this design:
 //   - Randomness generation is NEVER parallelised. Bob's fresh private scalar
@@ -39,54 +44,20 @@ namespace {
 //   - Workers write results by index into pre-sized vectors, so the output
 //     (and therefore the wire transcript) is byte-identical to the serial
 //     path. Parallelism changes timing only, never message content or order.
-constexpr std::size_t kParallelThreshold = 192;  // serial below this: thread
-                                                 // spawn overhead dominates
-                                                 // for demo/server sizes
-constexpr std::size_t kMaxThreads = 16;
-
-// Runs fn(i) for i in [0, count), chunked across worker threads when count is
-// large enough. fn must only touch index-i state (or thread-safe state).
-// Exceptions thrown by workers are captured and rethrown on the caller.
-template <typename Fn>
-void parallelForIndex(std::size_t count, Fn&& fn) {
-    if (count < kParallelThreshold) {
-        for (std::size_t i = 0; i < count; ++i) {
-            fn(i);
-        }
-        return;
-    }
-
-    const unsigned hardware = std::thread::hardware_concurrency();
-    const std::size_t threadCount =
-        std::min({static_cast<std::size_t>(hardware != 0 ? hardware : 4), kMaxThreads, count});
-    const std::size_t chunk = (count + threadCount - 1) / threadCount;
-
-    std::vector<std::thread> workers;
-    std::vector<std::exception_ptr> errors(threadCount);
-    workers.reserve(threadCount);
-
-    for (std::size_t t = 0; t < threadCount; ++t) {
-        workers.emplace_back([&, t]() {
-            const std::size_t begin = t * chunk;
-            const std::size_t end = std::min(begin + chunk, count);
-            try {
-                for (std::size_t i = begin; i < end; ++i) {
-                    fn(i);
-                }
-            } catch (...) {
-                errors[t] = std::current_exception();
-            }
-        });
-    }
-    for (auto& worker : workers) {
-        worker.join();
-    }
-    for (const auto& error : errors) {
-        if (error) {
-            std::rethrow_exception(error);
-        }
-    }
-}
+//   - Scheduling comes from an ExecutionPolicy (execution_policy.h): thread
+//     count, chunk size and serial cutoff change timing only.
+//   - Every group operation goes through the backend of the session's
+//     ciphersuite (group_backend.h). Bob's phases multiply through its
+//     GroupMultiplier, which prepares his scalar once per exchange (for
+//     ristretto255, byte-identical to crypto_scalarmult_ristretto255). The
+//     multiplier lives only as long as the call; it is never cached across
+//     exchanges.
+//   - Hashed elements stay in internal form (GroupElement) until after the
+//     multiplication: each point is decoded at most once where it comes off
+//     the wire and encoded once for the wire or key derivation.
+//   - Alice's unblinding inverses may be computed early on a background task
+//     (PrecomputedInverses). They are a pure function of scalars already
+//     fixed, and identical to the ones finalisation would compute itself.
 
 // scalarFromDerived now lives in derivation.h so the live protocol and the
 // dispute auditor share one reduction code path.
@@ -100,25 +71,6 @@ RistrettoScalar randomScalar() {
     return scalar;
 }
 
-RistrettoPoint scalarMultiply(const RistrettoScalar& scalar,
-                              const unsigned char* pointEncoded,
-                              const char* context) {
-    RistrettoPoint result{};
-    if (crypto_scalarmult_ristretto255(result.data(), scalar.data(), pointEncoded) != 0) {
-        throw std::runtime_error(std::string("ristretto255 scalar multiplication failed: ") + context);
-    }
-    return result;
-}
-
-RistrettoPoint decodeWirePoint(const std::vector<unsigned char>& encoded, const char* context) {
-    if (encoded.size() != crypto_core_ristretto255_BYTES) {
-        throw std::runtime_error(std::string("Invalid point length in ") + context);
-    }
-    RistrettoPoint point{};
-    std::memcpy(point.data(), encoded.data(), point.size());
-    return point;
-}
-
 // Fills Alice's blinding state and outgoing values; shared by both modes.
 // Alice's blinding scalars MUST stay fresh per run. With the default
 // SystemRng a new random seed is drawn every call; with DeterministicRng the
@@ -128,7 +80,8 @@ RistrettoPoint decodeWirePoint(const std::vector<unsigned char>& encoded, const
 // fresh scalars.
 void aliceBlindPositions(AliceResponseMessage& response,
                          HashToGroupCache* hashCache,
-                         ProtocolRng* rng = nullptr) {
+                         ProtocolRng* rng,
+                         const ExecutionPolicy& execution) {
     SystemRng systemRng;
     ProtocolRng& randomness = (rng != nullptr) ? *rng : systemRng;
     const std::array<unsigned char, 32> aliceSeed = randomness.aliceBlindingSeed();
@@ -141,36 +94,112 @@ void aliceBlindPositions(AliceResponseMessage& response,
     response.state.randomScalars.resize(count);
     response.values.resize(count);
 
-    parallelForIndex(count, [&](std::size_t i) {
-        const auto scalar = scalarFromDerived(derivedValues[i]);
-        response.state.randomScalars[i] = scalar;
-
-        const auto hashedPoint = hashToGroupCached(response.state.flooredPositions[i], hashCache);
-        const auto blinded = scalarMultiply(scalar, hashedPoint.data(), "Alice's blinding");
-
-        response.values[i] = {std::vector<unsigned char>(blinded.begin(), blinded.end())};
+    const GroupBackend& group = groupBackendFor(response.state.suite);
+    const ExecutionPolicy blindingPolicy = execution.forPhase(ProtocolPhase::AliceBlinding);
+    parallelForChunks(blindingPolicy, count, [&](std::size_t begin, std::size_t end) {
+        std::vector<GroupElement> hashed(end - begin);
+        for (std::size_t i = begin; i < end; ++i) {
+            response.state.randomScalars[i] = scalarFromDerived(derivedValues[i]);
+        }
+        group.hashToGroup(response.state.flooredPositions.data() + begin, end - begin,
+                          hashed.data(), hashCache, response.state.suite);
+        group.multiply(response.state.randomScalars.data() + begin, hashed.data(), hashed.size(),
+                       response.values.data() + begin, "Alice's blinding");
     });
 
-    response.serialized = serializeAliceBlindedMessage(response.values);
+    response.serialized = serializeAliceBlindedMessage(response.values, response.state.format);
+
+    // The scalars are fixed from here on; invert them while the flight is on
+    // the wire instead of after Bob's response arrives. The job holds only a
+    // weak reference, so a session dropped before it runs costs nothing.
+    const ExecutionPolicy unblindingPolicy = execution.forPhase(ProtocolPhase::AliceUnblinding);
+    if (execution.precomputeInverses && execution.threadCount != 1 && count != 0 &&
+        count >= unblindingPolicy.serialThreshold) {
+        auto inverses = std::make_shared<PrecomputedInverses>();
+        const std::weak_ptr<PrecomputedInverses> target = inverses;
+        ThreadPool& pool = execution.pool != nullptr ? *execution.pool : ThreadPool::shared();
+        inverses->task = BackgroundTask::start(
+            pool, [target, scalars = response.state.randomScalars, unblindingPolicy,
+                   &group]() mutable {
+                const auto owner = target.lock();
+                if (owner) {
+                    owner->values.resize(scalars.size());
+                    parallelForChunks(unblindingPolicy, scalars.size(),
+                                      [&](std::size_t begin, std::size_t end) {
+                                          group.invertScalars(scalars.data() + begin, end - begin,
+                                                              owner->values.data() + begin);
+                                      });
+                }
+                sodium_memzero(scalars.data(), scalars.size() * sizeof(RistrettoScalar));
+            });
+        response.state.precomputedInverses = std::move(inverses);
+    }
+}
+
+// The precomputed inverses of aliceState.randomScalars when they cover the
+// first `count` indices (waiting for the background task if it is still
+// running), nullptr otherwise.
+const RistrettoScalar* precomputedInversesFor(const AliceSessionState& aliceState,
+                                              std::size_t count) {
+    const auto& precomputed = aliceState.precomputedInverses;
+    if (!precomputed || precomputed->task == nullptr) {
+        return nullptr;
+    }
+    precomputed->task->wait();
+    return precomputed->values.size() >= count ? precomputed->values.data() : nullptr;
 }
 
-// Unblinds one transformed value back to the shared point b * H(x_i).
-RistrettoPoint aliceUnblind(const BobTransformedValue& transformed,
-                            const RistrettoScalar& randomScalar) {
-    RistrettoScalar inverse{};
-    if (crypto_core_ristretto255_scalar_invert(inverse.data(), randomScalar.data()) != 0) {
-        throw std::runtime_error("Failed to invert Alice's blinding scalar");
+// Unblinds transformed values [begin, end), read from Bob's flight in place,
+// back to the shared points b * H(x_i) and derives their keys into
+// keys[begin, end), plus their membership tags into tags[begin, end) when tags is non-null. Uses the
+// precomputed inverses when given; otherwise the chunk's blinding scalars are
+// inverted together (GroupBackend::invertScalars: one inversion per chunk
+// instead of one per element). The inverses are identical either way, so the keys are
+// too.
+void aliceUnblindRange(const FlightView& transformedValues,
+                       const AliceSessionState& aliceState,
+                       const RistrettoScalar* precomputed,
+                       std::size_t begin,
+                       std::size_t end,
+                       std::array<unsigned char, 32>* keys,
+                       MembershipTag* tags) {
+    const GroupBackend& group = groupBackendFor(aliceState.suite);
+    std::vector<RistrettoScalar> batch;
+    const RistrettoScalar* inverses = precomputed != nullptr ? precomputed + begin : nullptr;
+    if (inverses == nullptr) {
+        batch.resize(end - begin);
+        group.invertScalars(aliceState.randomScalars.data() + begin, end - begin, batch.data());
+        inverses = batch.data();
     }
 
-    const auto transformedPoint =
-        decodeWirePoint(transformed.transformedPointEncoded, "Bob's transformed message");
-    return scalarMultiply(inverse, transformedPoint.data(), "Alice's unblinding");
+    std::vector<FlightView::Entry> scratch;
+    std::vector<GroupElement> transformed(end - begin);
+    group.decode(transformedValues.entries(begin, end, scratch), end - begin, transformed.data(),
+                 "Alice's unblinding");
+    std::vector<RistrettoPoint> shared(end - begin);
+    group.multiply(inverses, transformed.data(), transformed.size(), shared.data(),
+                   "Alice's unblinding");
+    if (tags != nullptr) {
+        pointsToKeysAndTags(shared.data(), shared.size(), keys + begin, tags + begin,
+                            aliceState.suite);
+    } else {
+        hashPointToKeyBatch(shared.data(), shared.size(), keys + begin, aliceState.suite);
+    }
+    sodium_memzero(batch.data(), batch.size() * sizeof(RistrettoScalar));
 }
 
 }  // namespace
 
+PrecomputedInverses::~PrecomputedInverses() {
+    sodium_memzero(values.data(), values.size() * sizeof(RistrettoScalar));
+}
+
 BobInitialMessage bobCreateInitialMessage(const std::vector<Unit>& bobUnits,
-                                          HashToGroupCache* hashCache) {
+                                          HashToGroupCache* hashCache,
+                                          const ExecutionPolicy* policy,
+                                          CipherSuite suite,
+                                          WireFormat format) {
+    const ExecutionPolicy execution = resolveExecutionPolicy(policy);
     BobInitialMessage message;
     // SECURITY: Bob's private scalar MUST be fresh for every exchange. Never
     // cache or reuse it (and never cache the tags/ciphertexts derived from
@@ -178,17 +207,23 @@ BobInitialMessage bobCreateInitialMessage(const std::vector<Unit>& bobUnits,
     // runs, letting the counterparty diff runs and re-identify previously
     // matched elements. Only the local hashToGroup cache may persist.
     message.state.privateScalar = randomScalar();
+    message.state.suite = suite;
 
     const auto bobPositions = convertToFlooredStrings(bobUnits);
     const std::size_t count = bobPositions.size();
 
     // Stage 1 (parallel): deterministic per-element key derivation.
     std::vector<std::array<unsigned char, 32>> keys(count);
-    parallelForIndex(count, [&](std::size_t i) {
-        const auto hashedPoint = hashToGroupCached(bobPositions[i], hashCache);
-        const auto sharedPoint =
-            scalarMultiply(message.state.privateScalar, hashedPoint.data(), "Bob's encryption");
-        keys[i] = hashPointToKey(sharedPoint);
+    const ExecutionPolicy taggingPolicy = execution.forPhase(ProtocolPhase::BobTagging);
+    const GroupBackend& group = groupBackendFor(suite);
+    const auto multiplier = group.fixedMultiplier(message.state.privateScalar);
+    parallelForChunks(taggingPolicy, count, [&](std::size_t begin, std::size_t end) {
+        std::vector<GroupElement> hashed(end - begin);
+        std::vector<RistrettoPoint> shared(end - begin);
+        group.hashToGroup(bobPositions.data() + begin, end - begin, hashed.data(), hashCache,
+                          suite);
+        multiplier->multiplyBatch(hashed.data(), hashed.size(), shared.data(), "Bob's encryption");
+        hashPointToKeyBatch(shared.data(), shared.size(), keys.data() + begin, suite);
     });
 
     // Stage 2 (serial): secretbox nonces come from randombytes; keep all
@@ -198,47 +233,58 @@ BobInitialMessage bobCreateInitialMessage(const std::vector<Unit>& bobUnits,
         message.units.push_back({secretboxEncrypt(keys[i], bobPositions[i])});
     }
 
-    message.serialized = serializeBobEncryptedMessage(message.units);
+    message.serialized = serializeBobEncryptedMessage(message.units, suite, format);
     return message;
 }
 
 AliceResponseMessage aliceProcessBobMessage(const std::string& serializedBobMessage,
                                             const std::vector<Unit>& aliceUnits,
-                                            HashToGroupCache* hashCache) {
+                                            HashToGroupCache* hashCache,
+                                            const ExecutionPolicy* policy) {
     AliceResponseMessage response;
-    response.state.bobEncryptedUnits = deserializeBobEncryptedMessage(serializedBobMessage);
+    response.state.bobEncryptedUnits =
+        deserializeBobEncryptedMessage(serializedBobMessage, &response.state.suite, policy);
+    response.state.format = messageWireFormat(serializedBobMessage);
     response.state.flooredPositions = convertToFlooredStrings(aliceUnits);
-    aliceBlindPositions(response, hashCache);
+    aliceBlindPositions(response, hashCache, nullptr, resolveExecutionPolicy(policy));
     return response;
 }
 
 BobResponseMessage bobProcessAliceMessage(const std::string& serializedAliceMessage,
-                                          const BobSessionState& bobState) {
-    const auto aliceValues = deserializeAliceBlindedMessage(serializedAliceMessage);
+                                          const BobSessionState& bobState,
+                                          const ExecutionPolicy* policy) {
+    const ExecutionPolicy execution = resolveExecutionPolicy(policy);
+    const FlightView aliceValues = viewAliceBlindedMessage(serializedAliceMessage);
     BobResponseMessage response;
     response.values.resize(aliceValues.size());
 
-    parallelForIndex(aliceValues.size(), [&](std::size_t i) {
-        const auto point = decodeWirePoint(aliceValues[i].blindedPointEncoded, "Alice's blinded message");
-        const auto transformed = scalarMultiply(bobState.privateScalar, point.data(), "Bob's response");
-        response.values[i] = {std::vector<unsigned char>(transformed.begin(), transformed.end())};
+    const ExecutionPolicy responsePolicy = execution.forPhase(ProtocolPhase::BobResponse);
+    const auto multiplier = groupBackendFor(bobState.suite).fixedMultiplier(bobState.privateScalar);
+    parallelForChunks(responsePolicy, aliceValues.size(), [&](std::size_t begin, std::size_t end) {
+        std::vector<FlightView::Entry> scratch;
+        multiplier->multiplyBatch(aliceValues.entries(begin, end, scratch), end - begin,
+                                  response.values.data() + begin, "Bob's response");
     });
 
-    response.serialized = serializeBobTransformedMessage(response.values);
+    response.serialized = serializeBobTransformedMessage(response.values, aliceValues.format());
     return response;
 }
 
 std::vector<MatchedUnit> aliceFinalizeIntersection(const std::string& serializedBobResponse,
-                                                     const AliceSessionState& aliceState) {
-    const auto transformedValues = deserializeBobTransformedMessage(serializedBobResponse);
+                                                     const AliceSessionState& aliceState,
+                                                     const ExecutionPolicy* policy) {
+    const ExecutionPolicy execution = resolveExecutionPolicy(policy);
+    const FlightView transformedValues = viewBobTransformedMessage(serializedBobResponse);
     const std::size_t count = std::min(transformedValues.size(), aliceState.randomScalars.size());
 
     // Stage 1 (parallel): unblind and derive each candidate key. Pure math on
     // fixed inputs, independent per index.
     std::vector<std::array<unsigned char, 32>> keys(count);
-    parallelForIndex(count, [&](std::size_t i) {
-        const auto sharedPoint = aliceUnblind(transformedValues[i], aliceState.randomScalars[i]);
-        keys[i] = hashPointToKey(sharedPoint);
+    const RistrettoScalar* precomputed = precomputedInversesFor(aliceState, count);
+    const ExecutionPolicy unblindingPolicy = execution.forPhase(ProtocolPhase::AliceUnblinding);
+    parallelForChunks(unblindingPolicy, count, [&](std::size_t begin, std::size_t end) {
+        aliceUnblindRange(transformedValues, aliceState, precomputed, begin, end, keys.data(),
+                          nullptr);
     });
 
     // Stage 2 (serial): matching. The usedKeys dedup set is shared state, so
@@ -274,23 +320,234 @@ std::vector<MatchedUnit> aliceFinalizeIntersection(const std::string& serialized
 std::vector<MatchedUnit> runPSIProtocol(const std::vector<Unit>& bobUnits,
                                           const std::vector<Unit>& aliceUnits,
                                           HashToGroupCache* bobHashCache,
-                                          HashToGroupCache* aliceHashCache) {
-    auto bobMessage = bobCreateInitialMessage(bobUnits, bobHashCache);
-    auto aliceMessage = aliceProcessBobMessage(bobMessage.serialized, aliceUnits, aliceHashCache);
-    auto bobResponse = bobProcessAliceMessage(aliceMessage.serialized, bobMessage.state);
-    return aliceFinalizeIntersection(bobResponse.serialized, aliceMessage.state);
+                                          HashToGroupCache* aliceHashCache,
+                                          const ExecutionPolicy* policy,
+                                          CipherSuite suite,
+                                          WireFormat format) {
+    auto bobMessage = bobCreateInitialMessage(bobUnits, bobHashCache, policy, suite, format);
+    auto aliceMessage =
+        aliceProcessBobMessage(bobMessage.serialized, aliceUnits, aliceHashCache, policy);
+    auto bobResponse = bobProcessAliceMessage(aliceMessage.serialized, bobMessage.state, policy);
+    return aliceFinalizeIntersection(bobResponse.serialized, aliceMessage.state, policy);
+}
+
+BobInitialIndexedMessage bobCreateInitialIndexedMessage(const std::vector<Unit>& bobUnits,
+                                                        HashToGroupCache* hashCache,
+                                                        const ExecutionPolicy* policy,
+                                                        CipherSuite suite,
+                                                        WireFormat format) {
+    const ExecutionPolicy execution = resolveExecutionPolicy(policy);
+    BobInitialIndexedMessage message;
+    // SECURITY: fresh scalar per exchange, as in bobCreateInitialMessage.
+    // The locators are tag prefixes, so a reused scalar would make them
+    // stable identifiers just as it would tags.
+    message.state.privateScalar = randomScalar();
+    message.state.suite = suite;
+
+    const auto bobPositions = convertToFlooredStrings(bobUnits);
+    const std::size_t count = bobPositions.size();
+
+    // Stage 1 (parallel): per-element key and tag, whose prefix is the
+    // locator.
+    std::vector<std::array<unsigned char, 32>> keys(count);
+    std::vector<MembershipTag> tags(count);
+    const ExecutionPolicy taggingPolicy = execution.forPhase(ProtocolPhase::BobTagging);
+    const GroupBackend& group = groupBackendFor(suite);
+    const auto multiplier = group.fixedMultiplier(message.state.privateScalar);
+    parallelForChunks(taggingPolicy, count, [&](std::size_t begin, std::size_t end) {
+        std::vector<GroupElement> hashed(end - begin);
+        std::vector<RistrettoPoint> shared(end - begin);
+        group.hashToGroup(bobPositions.data() + begin, end - begin, hashed.data(), hashCache,
+                          suite);
+        multiplier->multiplyBatch(hashed.data(), hashed.size(), shared.data(), "Bob's encryption");
+        pointsToKeysAndTags(shared.data(), shared.size(), keys.data() + begin, tags.data() + begin,
+                            suite);
+    });
+
+    // Stage 2 (serial): nonces come from randombytes, as in secretbox mode.
+    message.units.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::copy(tags[i].begin(), tags[i].begin() + kLocatorBytes,
+                  message.units[i].locator.begin());
+        message.units[i].ciphertext = secretboxEncrypt(keys[i], bobPositions[i]);
+    }
+    std::sort(message.units.begin(), message.units.end(),
+              [](const IndexedEncryptedUnit& a, const IndexedEncryptedUnit& b) {
+                  return a.locator < b.locator;
+              });
+
+    message.serialized = serializeBobIndexedMessage(message.units, suite, format);
+    return message;
+}
+
+AliceResponseMessage aliceProcessBobIndexedMessage(const std::string& serializedBobMessage,
+                                                   const std::vector<Unit>& aliceUnits,
+                                                   HashToGroupCache* hashCache,
+                                                   const ExecutionPolicy* policy) {
+    AliceResponseMessage response;
+    response.state.bobIndexedUnits =
+        deserializeBobIndexedMessage(serializedBobMessage, &response.state.suite, policy);
+    response.state.format = messageWireFormat(serializedBobMessage);
+    response.state.flooredPositions = convertToFlooredStrings(aliceUnits);
+    aliceBlindPositions(response, hashCache, nullptr, resolveExecutionPolicy(policy));
+    return response;
+}
+
+namespace {
+
+// Bob's locators in an open-addressing table. They are uniformly random, so
+// the low bits of the first eight bytes pick the home slot directly, and a
+// probe run far longer than random values produce means the flight was
+// crafted to slow Alice down. A repeated locator keeps its first unit: it can
+// only come from a repeated element, whose ciphertexts all open to the same
+// plaintext.
+class LocatorIndex {
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    explicit LocatorIndex(const std::vector<IndexedEncryptedUnit>& units) {
+        std::size_t slots = 16;
+        while (slots < 2 * units.size()) {
+            slots *= 2;
+        }
+        mask_ = slots - 1;
+        slots_.resize(slots);
+        for (std::size_t unit = 0; unit < units.size(); ++unit) {
+            const std::uint64_t locator = value(units[unit].locator.data());
+            std::size_t slot = locator & mask_;
+            for (std::size_t probe = 0;; ++probe, slot = (slot + 1) & mask_) {
+                if (probe == kMaxProbe) {
+                    throw std::runtime_error(
+                        "Bob's locators are too clustered to be uniformly random");
+                }
+                if (slots_[slot].unit == 0) {
+                    slots_[slot] = {locator, unit + 1};
+                    break;
+                }
+                if (slots_[slot].locator == locator) {
+                    break;
+                }
+            }
+        }
+    }
+
+    // The unit filed under the locator at these kLocatorBytes bytes, or npos.
+    std::size_t find(const unsigned char* locator) const {
+        const std::uint64_t wanted = value(locator);
+        for (std::size_t slot = wanted & mask_;; slot = (slot + 1) & mask_) {
+            if (slots_[slot].unit == 0) {
+                return npos;
+            }
+            if (slots_[slot].locator == wanted) {
+                return slots_[slot].unit - 1;
+            }
+        }
+    }
+
+private:
+    static constexpr std::size_t kMaxProbe = 512;
+
+    struct Slot {
+        std::uint64_t locator{0};
+        std::size_t unit{0};  // index + 1; 0 is empty
+    };
+
+    static std::uint64_t value(const unsigned char* locator) {
+        static_assert(kLocatorBytes == sizeof(std::uint64_t), "locators are one word");
+        std::uint64_t v;
+        std::memcpy(&v, locator, sizeof v);
+        return v;
+    }
+
+    std::vector<Slot> slots_;
+    std::size_t mask_{0};
+};
+
+}  // namespace
+
+std::vector<MatchedUnit> aliceFinalizeIntersectionIndexed(const std::string& serializedBobResponse,
+                                                            const AliceSessionState& aliceState,
+                                                            const ExecutionPolicy* policy) {
+    const ExecutionPolicy execution = resolveExecutionPolicy(policy);
+    const FlightView transformedValues = viewBobTransformedMessage(serializedBobResponse);
+    const std::size_t count = std::min(transformedValues.size(), aliceState.randomScalars.size());
+    const auto& bobUnits = aliceState.bobIndexedUnits;
+    const LocatorIndex index(bobUnits);
+
+    // Stage 1 (parallel): unblind, derive key and tag, look the tag's
+    // locator up and open the one ciphertext filed under it. Each index only
+    // reads shared state and writes its own outputs.
+    std::vector<std::array<unsigned char, 32>> keys(count);
+    std::vector<MembershipTag> tags(count);
+    std::vector<std::size_t> opened(count, LocatorIndex::npos);
+    std::vector<std::string> plaintexts(count);
+    const RistrettoScalar* precomputed = precomputedInversesFor(aliceState, count);
+    const ExecutionPolicy unblindingPolicy = execution.forPhase(ProtocolPhase::AliceUnblinding);
+    parallelForChunks(unblindingPolicy, count, [&](std::size_t begin, std::size_t end) {
+        aliceUnblindRange(transformedValues, aliceState, precomputed, begin, end, keys.data(),
+                          tags.data());
+        for (std::size_t i = begin; i < end; ++i) {
+            const std::size_t unit = index.find(tags[i].data());
+            if (unit == LocatorIndex::npos) {
+                continue;
+            }
+            // Authenticated, so opening is itself proof of an intersection.
+            auto decrypted = secretboxDecrypt(keys[i], bobUnits[unit].ciphertext);
+            if (decrypted) {
+                opened[i] = unit;
+                plaintexts[i] = std::move(*decrypted);
+            }
+        }
+    });
+
+    // Stage 2 (serial): a unit opened by several of Alice's indices (her
+    // element repeated) counts once, at the first, as in secretbox mode.
+    std::vector<MatchedUnit> results;
+    std::vector<char> used(bobUnits.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        if (opened[i] != LocatorIndex::npos && used[opened[i]] == 0) {
+            used[opened[i]] = 1;
+            results.push_back({std::move(plaintexts[i]), keys[i]});
+        }
+    }
+    return results;
+}
+
+std::vector<MatchedUnit> runPSIProtocolIndexed(const std::vector<Unit>& bobUnits,
+                                                 const std::vector<Unit>& aliceUnits,
+                                                 HashToGroupCache* bobHashCache,
+                                                 HashToGroupCache* aliceHashCache,
+                                                 const ExecutionPolicy* policy,
+                                                 CipherSuite suite,
+                                                 WireFormat format) {
+    auto bobMessage =
+        bobCreateInitialIndexedMessage(bobUnits, bobHashCache, policy, suite, format);
+    auto aliceMessage =
+        aliceProcessBobIndexedMessage(bobMessage.serialized, aliceUnits, aliceHashCache, policy);
+    auto bobResponse = bobProcessAliceMessage(aliceMessage.serialized, bobMessage.state, policy);
+    return aliceFinalizeIntersectionIndexed(bobResponse.serialized, aliceMessage.state, policy);
 }
 
 BobInitialTagMessage bobCreateInitialTagMessage(const std::vector<Unit>& bobUnits,
                                                 HashToGroupCache* hashCache,
-                                                ProtocolRng* rng) {
-    return bobCreateInitialTagMessageFromElements(convertToFlooredStrings(bobUnits), hashCache, rng);
+                                                ProtocolRng* rng,
+                                                const ExecutionPolicy* policy,
+                                                CipherSuite suite,
+                                                WireFormat format,
+                                                double tagFilterRate) {
+    return bobCreateInitialTagMessageFromElements(convertToFlooredStrings(bobUnits), hashCache, rng,
+                                                  policy, suite, format, tagFilterRate);
 }
 
 BobInitialTagMessage bobCreateInitialTagMessageFromElements(
     const std::vector<std::string>& elements,
     HashToGroupCache* hashCache,
-    ProtocolRng* rng) {
+    ProtocolRng* rng,
+    const ExecutionPolicy* policy,
+    CipherSuite suite,
+    WireFormat format,
+    double tagFilterRate) {
+    const ExecutionPolicy execution = resolveExecutionPolicy(policy);
     BobInitialTagMessage message;
     // SECURITY: fresh scalar per exchange, same reasoning as
     // bobCreateInitialMessage. In tag mode this matters even more: with a
@@ -303,93 +560,311 @@ BobInitialTagMessage bobCreateInitialTagMessageFromElements(
     SystemRng systemRng;
     ProtocolRng& randomness = (rng != nullptr) ? *rng : systemRng;
     message.state.privateScalar = randomness.bobPrivateScalar();
+    message.state.suite = suite;
 
     const auto& bobPositions = elements;
     const std::size_t count = bobPositions.size();
     message.tags.resize(count);
 
-    parallelForIndex(count, [&](std::size_t i) {
-        const auto hashedPoint = hashToGroupCached(bobPositions[i], hashCache);
-        const auto sharedPoint =
-            scalarMultiply(message.state.privateScalar, hashedPoint.data(), "Bob's tagging");
-        message.tags[i] = keyToMembershipTag(hashPointToKey(sharedPoint));
+    const ExecutionPolicy taggingPolicy = execution.forPhase(ProtocolPhase::BobTagging);
+    const GroupBackend& group = groupBackendFor(suite);
+    const auto multiplier = group.fixedMultiplier(message.state.privateScalar);
+    parallelForChunks(taggingPolicy, count, [&](std::size_t begin, std::size_t end) {
+        std::vector<GroupElement> hashed(end - begin);
+        std::vector<RistrettoPoint> shared(end - begin);
+        group.hashToGroup(bobPositions.data() + begin, end - begin, hashed.data(), hashCache,
+                          suite);
+        multiplier->multiplyBatch(hashed.data(), hashed.size(), shared.data(), "Bob's tagging");
+        pointsToKeysAndTags(shared.data(), shared.size(), nullptr, message.tags.data() + begin,
+                            suite);
     });
 
-    message.serialized = serializeBobTagMessage(message.tags);
+    // The full flight lists tags in element order under every suite: the
+    // commit-reveal audit recomputes it byte for byte, so the order is frozen
+    // with the suites (docs/commit_reveal_spec.md, section 5).
+    if (tagFilterRate > 0.0) {
+        // The filter is filled in tag order, so which bucket a fingerprint
+        // landed in says nothing about Bob's element order.
+        TagBatch sortedTags = message.tags;
+        std::sort(sortedTags.begin(), sortedTags.end());
+        const TagFilter filter =
+            TagFilter::build(sortedTags, tagFilterFingerprintBytes(tagFilterRate));
+        message.serialized = serializeBobTagFilterMessage(filter, count, suite, format);
+    } else {
+        message.serialized = serializeBobTagMessage(message.tags, suite, format);
+    }
     return message;
 }
 
 AliceResponseMessage aliceProcessBobTagMessage(const std::string& serializedBobTagMessage,
                                                const std::vector<Unit>& aliceUnits,
                                                HashToGroupCache* hashCache,
-                                               ProtocolRng* rng) {
+                                               ProtocolRng* rng,
+                                               const ExecutionPolicy* policy) {
     return aliceProcessBobTagMessageFromElements(serializedBobTagMessage,
                                                  convertToFlooredStrings(aliceUnits), hashCache,
-                                                 rng);
+                                                 rng, policy);
 }
 
+namespace {
+
+// Checks a T or F flight's framing and returns the suite and format it names.
+std::pair<CipherSuite, WireFormat> readTagFlightHeader(const std::string& serialized) {
+    if (messageType(serialized) == 'F') {
+        CipherSuite suite = CipherSuite::V1;
+        deserializeBobTagFilterMessage(serialized, &suite);
+        return {suite, messageWireFormat(serialized)};
+    }
+    const FlightView bobTags = viewBobTagMessage(serialized);
+    return {bobTags.suite(), bobTags.format()};
+}
+
+}  // namespace
+
 AliceResponseMessage aliceProcessBobTagMessageFromElements(
     const std::string& serializedBobTagMessage,
     const std::vector<std::string>& elements,
     HashToGroupCache* hashCache,
-    ProtocolRng* rng) {
+    ProtocolRng* rng,
+    const ExecutionPolicy* policy) {
+    const auto [suite, format] = readTagFlightHeader(serializedBobTagMessage);
+    AliceResponseMessage response =
+        alicePrepareBlinded(elements, hashCache, rng, policy, suite, format);
+    response.state.bobTagFlight = serializedBobTagMessage;
+    return response;
+}
+
+AliceResponseMessage alicePrepareBlinded(const std::vector<std::string>& elements,
+                                         HashToGroupCache* hashCache,
+                                         ProtocolRng* rng,
+                                         const ExecutionPolicy* policy,
+                                         CipherSuite suite,
+                                         WireFormat format) {
     AliceResponseMessage response;
-    response.state.bobTags = deserializeBobTagMessage(serializedBobTagMessage);
+    response.state.suite = suite;
+    response.state.format = format;
     response.state.flooredPositions = elements;
-    aliceBlindPositions(response, hashCache, rng);
+    aliceBlindPositions(response, hashCache, rng, resolveExecutionPolicy(policy));
     return response;
 }
 
+void aliceAttachBobTags(const std::string& serializedBobTagMessage, AliceSessionState& state) {
+    const auto [suite, format] = readTagFlightHeader(serializedBobTagMessage);
+    if (suite != state.suite) {
+        throw std::runtime_error(std::string("Bob's tag flight names ciphersuite ") +
+                                 cipherSuiteName(suite) + ", Alice blinded under " +
+                                 cipherSuiteName(state.suite));
+    }
+    if (format != state.format) {
+        throw std::runtime_error(std::string("Bob's tag flight is ") + wireFormatName(format) +
+                                 ", Alice's blinded flight " + wireFormatName(state.format));
+    }
+    state.bobTagFlight = serializedBobTagMessage;
+}
+
+namespace {
+
+// Below this many tags on Alice's side, or this many times fewer than Bob's,
+// her tags are indexed and Bob's flight streamed past them.
+constexpr std::size_t kIndexAliceMaxTags = 4096;
+constexpr std::size_t kIndexAliceRatio = 16;
+// Bob's flight is streamed in runs of this many tags (decoded into scratch
+// for text flights, read in place for binary ones).
+constexpr std::size_t kTagStreamRun = 4096;
+// Lookups are loaded this many tags ahead.
+constexpr std::size_t kPrefetchDistance = 8;
+
+// Calls fn(tags, n) for successive runs of the flight's tags until it
+// returns false.
+template <typename Fn>
+void streamFlightTags(const FlightView& flight, Fn&& fn) {
+    std::vector<FlightView::Entry> scratch;
+    for (std::size_t begin = 0; begin < flight.size(); begin += kTagStreamRun) {
+        const std::size_t end = std::min(flight.size(), begin + kTagStreamRun);
+        if (!fn(flight.entries(begin, end, scratch), end - begin)) {
+            return;
+        }
+    }
+}
+
+// Each strategy marks first[i] for the first index i of every tag of
+// Alice's that Bob holds; the caller turns those into results in index order.
+
+void matchByIndexingAlice(const FlightView& bobTags, const TagBatch& aliceTags,
+                          const ExecutionPolicy& execution, std::vector<char>& first) {
+    const TagSet aliceSet(aliceTags, &execution);
+    std::vector<std::uint64_t> held((aliceSet.slotCount() + 63) / 64);
+    streamFlightTags(bobTags, [&](const TagBatch::Entry* tags, std::size_t n) {
+        for (std::size_t k = 0; k < n; ++k) {
+            if (k + kPrefetchDistance < n) {
+                aliceSet.prefetch(tags[k + kPrefetchDistance]);
+            }
+            const std::size_t slot = aliceSet.find(tags[k]);
+            if (slot != TagSet::npos) {
+                held[slot / 64] |= std::uint64_t{1} << (slot % 64);
+            }
+        }
+        return true;
+    });
+    for (std::size_t i = 0; i < aliceTags.size(); ++i) {
+        const std::size_t slot = aliceSet.find(aliceTags[i]);
+        if (slot == TagSet::npos) {
+            continue;  // shares a prefix with another of her tags
+        }
+        const std::uint64_t bit = std::uint64_t{1} << (slot % 64);
+        if ((held[slot / 64] & bit) != 0) {
+            held[slot / 64] &= ~bit;
+            first[i] = 1;
+        }
+    }
+}
+
+void matchByHashingBob(const FlightView& bobTags, const TagBatch& aliceTags,
+                       const ExecutionPolicy& execution, std::vector<char>& first) {
+    const TagSet bobTagSet(bobTags.toBatch(&execution), &execution);
+    std::vector<std::uint64_t> matchedSlots((bobTagSet.slotCount() + 63) / 64);
+    for (std::size_t i = 0; i < aliceTags.size(); ++i) {
+        if (i + kPrefetchDistance < aliceTags.size()) {
+            bobTagSet.prefetch(aliceTags[i + kPrefetchDistance]);
+        }
+        const std::size_t slot = bobTagSet.find(aliceTags[i]);
+        if (slot == TagSet::npos) {
+            continue;
+        }
+        const std::uint64_t bit = std::uint64_t{1} << (slot % 64);
+        if ((matchedSlots[slot / 64] & bit) == 0) {
+            matchedSlots[slot / 64] |= bit;
+            first[i] = 1;
+        }
+    }
+}
+
+// A compact (F) flight: Alice's tags probe Bob's filter. A tag Bob does not
+// hold can still pass, at the rate the flight header states.
+void matchByFilter(const TagFilter& bobFilter, const TagBatch& aliceTags,
+                   const ExecutionPolicy& execution, std::vector<char>& first) {
+    const TagSet aliceSet(aliceTags, &execution);
+    std::vector<std::uint64_t> seen((aliceSet.slotCount() + 63) / 64);
+    for (std::size_t i = 0; i < aliceTags.size(); ++i) {
+        const std::size_t slot = aliceSet.find(aliceTags[i]);
+        if (slot == TagSet::npos) {
+            continue;  // shares a prefix with another of her tags
+        }
+        const std::uint64_t bit = std::uint64_t{1} << (slot % 64);
+        if ((seen[slot / 64] & bit) == 0) {
+            seen[slot / 64] |= bit;
+            first[i] = bobFilter.mayContain(aliceTags[i]) ? 1 : 0;
+        }
+    }
+}
+
+}  // namespace
+
+const char* tagMatchStrategyName(TagMatchStrategy strategy) {
+    switch (strategy) {
+        case TagMatchStrategy::Auto:
+            return "auto";
+        case TagMatchStrategy::IndexAlice:
+            return "index-alice";
+        case TagMatchStrategy::HashBob:
+            return "hash-bob";
+    }
+    return "unknown";
+}
+
+TagMatchStrategy chooseTagMatchStrategy(std::size_t aliceTags, std::size_t bobTags) {
+    if (aliceTags <= kIndexAliceMaxTags || aliceTags * kIndexAliceRatio <= bobTags) {
+        return TagMatchStrategy::IndexAlice;
+    }
+    return TagMatchStrategy::HashBob;
+}
+
 std::vector<MatchedUnit> aliceFinalizeIntersectionTags(const std::string& serializedBobResponse,
-                                                         const AliceSessionState& aliceState) {
-    const auto transformedValues = deserializeBobTransformedMessage(serializedBobResponse);
+                                                         const AliceSessionState& aliceState,
+                                                         const ExecutionPolicy* policy,
+                                                         TagMatchStrategy strategy) {
+    const ExecutionPolicy execution = resolveExecutionPolicy(policy);
+    const FlightView transformedValues = viewBobTransformedMessage(serializedBobResponse);
     const std::size_t count = std::min({transformedValues.size(),
                                         aliceState.randomScalars.size(),
                                         aliceState.flooredPositions.size()});
 
-    std::unordered_set<std::string> bobTagSet;
-    bobTagSet.reserve(aliceState.bobTags.size());
-    for (const auto& tag : aliceState.bobTags) {
-        bobTagSet.emplace(reinterpret_cast<const char*>(tag.data()), tag.size());
-    }
-
     // Stage 1 (parallel): unblind, derive key and tag per index. Independent
-    // pure computation; bobTagSet is not touched here.
+    // pure computation; Bob's tags are not touched here.
     std::vector<std::array<unsigned char, 32>> keys(count);
-    std::vector<MembershipTag> tags(count);
-    parallelForIndex(count, [&](std::size_t i) {
-        const auto sharedPoint = aliceUnblind(transformedValues[i], aliceState.randomScalars[i]);
-        keys[i] = hashPointToKey(sharedPoint);
-        tags[i] = keyToMembershipTag(keys[i]);
+    TagBatch tags(count);
+    const RistrettoScalar* precomputed = precomputedInversesFor(aliceState, count);
+    const ExecutionPolicy unblindingPolicy = execution.forPhase(ProtocolPhase::AliceUnblinding);
+    parallelForChunks(unblindingPolicy, count, [&](std::size_t begin, std::size_t end) {
+        aliceUnblindRange(transformedValues, aliceState, precomputed, begin, end, keys.data(),
+                          tags.data());
     });
 
-    // Stage 2 (serial): matching. bobTagSet lookups are read-only, but the
-    // matchedTags dedup set is shared mutable state, so this stays serial to
-    // keep results and their order identical to the single-threaded version.
-    std::vector<MatchedUnit> results;
-    std::unordered_set<std::string> matchedTags;
+    // Stage 2 (serial): matching, by the strategy the two sizes call for.
+    // A tag match means Bob derived the same key for this element, which
+    // only happens when the element is in his set too. Alice already knows
+    // the element: it is her own input at this index. Only the first index
+    // of a repeated tag counts, so results and their order are the same
+    // whichever strategy ran. A compact flight has only the one way to
+    // match, so strategy is ignored for it.
+    std::vector<char> first(count);
+    if (messageType(aliceState.bobTagFlight) == 'F') {
+        matchByFilter(deserializeBobTagFilterMessage(aliceState.bobTagFlight), tags, execution,
+                      first);
+    } else {
+        const FlightView bobTags = viewBobTagMessage(aliceState.bobTagFlight);
+        if (strategy == TagMatchStrategy::Auto) {
+            strategy = chooseTagMatchStrategy(count, bobTags.size());
+        }
+        if (strategy == TagMatchStrategy::IndexAlice) {
+            matchByIndexingAlice(bobTags, tags, execution, first);
+        } else {
+            matchByHashingBob(bobTags, tags, execution, first);
+        }
+    }
 
+    std::vector<MatchedUnit> results;
     for (std::size_t i = 0; i < count; ++i) {
-        const std::string tagString(reinterpret_cast<const char*>(tags[i].data()), tags[i].size());
-
-        // A tag match means Bob derived the same key for this element, which
-        // only happens when the element is in his set too. Alice already knows
-        // the element: it is her own input at this index.
-        if (bobTagSet.find(tagString) != bobTagSet.end() &&
-            matchedTags.insert(tagString).second) {
+        if (first[i] != 0) {
             results.push_back({aliceState.flooredPositions[i], keys[i]});
         }
     }
-
     return results;
 }
 
 std::vector<MatchedUnit> runPSIProtocolTags(const std::vector<Unit>& bobUnits,
                                               const std::vector<Unit>& aliceUnits,
                                               HashToGroupCache* bobHashCache,
-                                              HashToGroupCache* aliceHashCache) {
-    auto bobMessage = bobCreateInitialTagMessage(bobUnits, bobHashCache);
-    auto aliceMessage = aliceProcessBobTagMessage(bobMessage.serialized, aliceUnits, aliceHashCache);
-    auto bobResponse = bobProcessAliceMessage(aliceMessage.serialized, bobMessage.state);
-    return aliceFinalizeIntersectionTags(bobResponse.serialized, aliceMessage.state);
+                                              HashToGroupCache* aliceHashCache,
+                                              const ExecutionPolicy* policy,
+                                              CipherSuite suite,
+                                              WireFormat format) {
+    // Alice's blinding does not wait for Bob's tags: it runs on the pool
+    // while Bob tags on the caller, and Bob answers it as soon as both are
+    // done.
+    const ExecutionPolicy execution = resolveExecutionPolicy(policy);
+    ThreadPool& pool = execution.pool != nullptr ? *execution.pool : ThreadPool::shared();
+    const auto aliceElements = convertToFlooredStrings(aliceUnits);
+    AliceResponseMessage aliceMessage;
+    const auto aliceTask = BackgroundTask::start(pool, [&]() {
+        aliceMessage = alicePrepareBlinded(aliceElements, aliceHashCache, nullptr, &execution,
+                                           suite, format);
+    });
+    BobInitialTagMessage bobMessage;
+    try {
+        bobMessage =
+            bobCreateInitialTagMessage(bobUnits, bobHashCache, nullptr, &execution, suite, format);
+    } catch (...) {
+        // Bob's error is the one reported; Alice's, if she failed too, is
+        // dropped once her job has finished.
+        try {
+            aliceTask->wait();
+        } catch (...) {
+        }
+        throw;
+    }
+    aliceTask->wait();
+    auto bobResponse = bobProcessAliceMessage(aliceMessage.serialized, bobMessage.state, policy);
+    aliceAttachBobTags(bobMessage.serialized, aliceMessage.state);
+    return aliceFinalizeIntersectionTags(bobResponse.serialized, aliceMessage.state, policy);
 }
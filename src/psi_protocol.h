@@ -1,15 +1,21 @@
 #ifndef PSI_PROTOCOL_H
 #define PSI_PROTOCOL_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "ciphersuite.h"
 #include "crypto_utils.h"
 #include "derivation.h"
+#include "execution_policy.h"
 #include "psi_types.h"
+#include "serialization_utils.h"
+#include "thread_pool.h"
 
 struct BobSessionState {
     RistrettoScalar privateScalar;
+    CipherSuite suite{CipherSuite::V1};  // named in his first flight
 };
 
 struct BobInitialMessage {
@@ -18,21 +24,42 @@ struct BobInitialMessage {
     std::string serialized;
 };
 
+// Inverses of AliceSessionState::randomScalars, filled by a pool task that
+// starts right after Alice's blinded flight is serialized. values is only
+// valid after task->wait() returns.
+struct PrecomputedInverses {
+    std::shared_ptr<BackgroundTask> task;
+    std::vector<RistrettoScalar> values;
+
+    ~PrecomputedInverses();
+};
+
 struct AliceSessionState {
+    CipherSuite suite{CipherSuite::V1};            // from Bob's first flight
+    WireFormat format{WireFormat::Text};           // likewise; Alice replies in it
     std::vector<EncryptedUnit> bobEncryptedUnits;  // secretbox mode
-    std::vector<MembershipTag> bobTags;            // tag mode
+    std::vector<IndexedEncryptedUnit> bobIndexedUnits;  // indexed secretbox mode
+    // Tag mode: Bob's tag flight as received. Only its header is checked on
+    // arrival; finalisation reads the tags straight off it (FlightView), so
+    // a large flight is never copied into a batch unless the strategy needs
+    // an index of it. A compact (F) flight is checked whole on arrival and
+    // its filter rebuilt at finalisation.
+    std::string bobTagFlight;
     std::vector<RistrettoScalar> randomScalars;
     std::vector<std::string> flooredPositions;
+    // Optional (ExecutionPolicy::precomputeInverses). When null, finalisation
+    // inverts randomScalars itself.
+    std::shared_ptr<PrecomputedInverses> precomputedInverses;
 };
 
 struct AliceResponseMessage {
     AliceSessionState state;
-    std::vector<AliceSentValue> values;
+    PointBatch values;  // blinded points
     std::string serialized;
 };
 
 struct BobResponseMessage {
-    std::vector<BobTransformedValue> values;
+    PointBatch values;  // transformed points
     std::string serialized;
 };
 
@@ -42,23 +69,84 @@ struct BobResponseMessage {
 // cached points never reach the wire without first being multiplied by a
 // fresh per-exchange scalar. Bob's private scalar and Alice's blinding
 // scalars remain fresh every run; nothing wire-visible is ever cached.
+//
+// The optional ExecutionPolicy (execution_policy.h) on every entry point
+// controls how the per-element loops are scheduled: thread count, chunk size,
+// serial cutoff and pool. nullptr uses the process-wide default. It never
+// changes message content.
+//
+// Bob chooses the ciphersuite (ciphersuite.h) when he opens an exchange; his
+// first flight's header names it and Alice's side follows that header, so
+// only Bob's entry points and the run* helpers take the parameter. The suite
+// also picks the group every phase runs in (group_backend.h). The wire format
+// (serialization_utils.h) works the same way: Bob picks it for his first
+// flight and each reply is encoded like the flight it answers.
 BobInitialMessage bobCreateInitialMessage(const std::vector<Unit>& bobUnits,
-                                          HashToGroupCache* hashCache = nullptr);
+                                          HashToGroupCache* hashCache = nullptr,
+                                          const ExecutionPolicy* policy = nullptr,
+                                          CipherSuite suite = kDefaultCipherSuite,
+                                          WireFormat format = kDefaultWireFormat);
 
 AliceResponseMessage aliceProcessBobMessage(const std::string& serializedBobMessage,
                                             const std::vector<Unit>& aliceUnits,
-                                            HashToGroupCache* hashCache = nullptr);
+                                            HashToGroupCache* hashCache = nullptr,
+                                            const ExecutionPolicy* policy = nullptr);
 
 BobResponseMessage bobProcessAliceMessage(const std::string& serializedAliceMessage,
-                                          const BobSessionState& bobState);
+                                          const BobSessionState& bobState,
+                                          const ExecutionPolicy* policy = nullptr);
 
 std::vector<MatchedUnit> aliceFinalizeIntersection(const std::string& serializedBobResponse,
-                                                     const AliceSessionState& aliceState);
+                                                     const AliceSessionState& aliceState,
+                                                     const ExecutionPolicy* policy = nullptr);
 
 std::vector<MatchedUnit> runPSIProtocol(const std::vector<Unit>& bobUnits,
                                           const std::vector<Unit>& aliceUnits,
                                           HashToGroupCache* bobHashCache = nullptr,
-                                          HashToGroupCache* aliceHashCache = nullptr);
+                                          HashToGroupCache* aliceHashCache = nullptr,
+                                          const ExecutionPolicy* policy = nullptr,
+                                          CipherSuite suite = kDefaultCipherSuite,
+                                          WireFormat format = kDefaultWireFormat);
+
+// Indexed secretbox mode: secretbox mode with each ciphertext led by a
+// locator, the first kLocatorBytes of the membership tag of its key (one-way
+// in the key, and less than tag mode already sends). Bob sends the units
+// sorted by locator, so their order says nothing about his elements'. Alice
+// indexes the locators once, then each of her keys costs one lookup and at
+// most one decryption: finalisation is O(|Alice| + |Bob|) instead of
+// O(|Alice| x |Bob|) and still returns Bob's authenticated plaintexts.
+struct BobInitialIndexedMessage {
+    BobSessionState state;
+    std::vector<IndexedEncryptedUnit> units;  // sorted by locator, as on the wire
+    std::string serialized;
+};
+
+BobInitialIndexedMessage bobCreateInitialIndexedMessage(
+    const std::vector<Unit>& bobUnits,
+    HashToGroupCache* hashCache = nullptr,
+    const ExecutionPolicy* policy = nullptr,
+    CipherSuite suite = kDefaultCipherSuite,
+    WireFormat format = kDefaultWireFormat);
+
+AliceResponseMessage aliceProcessBobIndexedMessage(const std::string& serializedBobMessage,
+                                                   const std::vector<Unit>& aliceUnits,
+                                                   HashToGroupCache* hashCache = nullptr,
+                                                   const ExecutionPolicy* policy = nullptr);
+
+// Throws std::runtime_error if Bob's locators cluster far beyond what
+// uniformly random values do.
+std::vector<MatchedUnit> aliceFinalizeIntersectionIndexed(
+    const std::string& serializedBobResponse,
+    const AliceSessionState& aliceState,
+    const ExecutionPolicy* policy = nullptr);
+
+std::vector<MatchedUnit> runPSIProtocolIndexed(const std::vector<Unit>& bobUnits,
+                                                 const std::vector<Unit>& aliceUnits,
+                                                 HashToGroupCache* bobHashCache = nullptr,
+                                                 HashToGroupCache* aliceHashCache = nullptr,
+                                                 const ExecutionPolicy* policy = nullptr,
+                                                 CipherSuite suite = kDefaultCipherSuite,
+                                                 WireFormat format = kDefaultWireFormat);
 
 // Tag mode: instead of encrypting each element under its derived key, Bob
 // sends a one-way membership tag of the key. Phases 2 and 3 are identical to
@@ -74,28 +162,86 @@ std::vector<MatchedUnit> runPSIProtocol(const std::vector<Unit>& bobUnits,
 // still holds there because the seed differs per turn, level and direction.
 // Only tag mode takes the parameter: the dispute spec freezes tag mode.
 
+// Bob's tags are sent in the order of his elements, under every suite: the
+// commit-reveal audit recomputes the flight byte for byte, so the order is
+// part of what each suite freezes.
+//
+// A positive tagFilterRate sends the compact flight (F) instead: a cuckoo
+// filter of the tags (tag_filter.h) at the narrowest fingerprint whose
+// false-positive rate is at most tagFilterRate, a few bytes per element in
+// place of 32. Each of Alice's elements Bob does not hold then still shows up
+// in her result with at most that probability. Alice's functions accept
+// either flight. The commit-reveal session (session.h) always sends full tags.
 struct BobInitialTagMessage {
     BobSessionState state;
-    std::vector<MembershipTag> tags;
+    TagBatch tags;  // in element order, as on the wire
     std::string serialized;
 };
 
 BobInitialTagMessage bobCreateInitialTagMessage(const std::vector<Unit>& bobUnits,
                                                 HashToGroupCache* hashCache = nullptr,
-                                                ProtocolRng* rng = nullptr);
+                                                ProtocolRng* rng = nullptr,
+                                                const ExecutionPolicy* policy = nullptr,
+                                                CipherSuite suite = kDefaultCipherSuite,
+                                                WireFormat format = kDefaultWireFormat,
+                                                double tagFilterRate = 0.0);
 
 AliceResponseMessage aliceProcessBobTagMessage(const std::string& serializedBobTagMessage,
                                                const std::vector<Unit>& aliceUnits,
                                                HashToGroupCache* hashCache = nullptr,
-                                               ProtocolRng* rng = nullptr);
+                                               ProtocolRng* rng = nullptr,
+                                               const ExecutionPolicy* policy = nullptr);
+
+// Alice's side split in two. Her blinded points r_i * H(x_i) depend only on
+// her elements, the suite (which fixes the group) and the wire format, not on
+// Bob's tags, so when the parties agree those up front she can blind and send
+// her flight while Bob is still tagging, and Bob can answer it as soon as it
+// lands. alicePrepareBlinded returns the flight and a state with no tags yet;
+// aliceAttachBobTags files Bob's tag flight (T or F) into that state once it
+// arrives and throws std::runtime_error if it names a different suite or
+// format. Flight and state are byte for byte those of
+// aliceProcessBobTagMessageFromElements for the same inputs and rng, so a
+// transcript may record the blinded flight before or after the tag flight
+// and audits the same.
+AliceResponseMessage alicePrepareBlinded(const std::vector<std::string>& elements,
+                                         HashToGroupCache* hashCache = nullptr,
+                                         ProtocolRng* rng = nullptr,
+                                         const ExecutionPolicy* policy = nullptr,
+                                         CipherSuite suite = kDefaultCipherSuite,
+                                         WireFormat format = kDefaultWireFormat);
+
+void aliceAttachBobTags(const std::string& serializedBobTagMessage, AliceSessionState& state);
+
+// How aliceFinalizeIntersectionTags matches Alice's tags against Bob's
+// flight. Every strategy returns the same matches in the same order.
+enum class TagMatchStrategy {
+    Auto,        // chooseTagMatchStrategy from the two sizes
+    IndexAlice,  // index Alice's tags and stream Bob's flight past them
+    HashBob,     // index Bob's tags and probe with Alice's
+};
+
+const char* tagMatchStrategyName(TagMatchStrategy strategy);
+
+// IndexAlice when Alice's side is small, absolutely or next to Bob's (the
+// index stays in cache and Bob's flight is read once, in order); otherwise
+// HashBob.
+TagMatchStrategy chooseTagMatchStrategy(std::size_t aliceTags, std::size_t bobTags);
 
-std::vector<MatchedUnit> aliceFinalizeIntersectionTags(const std::string& serializedBobResponse,
-                                                         const AliceSessionState& aliceState);
+std::vector<MatchedUnit> aliceFinalizeIntersectionTags(
+    const std::string& serializedBobResponse,
+    const AliceSessionState& aliceState,
+    const ExecutionPolicy* policy = nullptr,
+    TagMatchStrategy strategy = TagMatchStrategy::Auto);
 
+// Both parties in one process, Alice's blinding (alicePrepareBlinded) on the
+// pool while Bob tags on the caller.
 std::vector<MatchedUnit> runPSIProtocolTags(const std::vector<Unit>& bobUnits,
                                               const std::vector<Unit>& aliceUnits,
                                               HashToGroupCache* bobHashCache = nullptr,
-                                              HashToGroupCache* aliceHashCache = nullptr);
+                                              HashToGroupCache* aliceHashCache = nullptr,
+                                              const ExecutionPolicy* policy = nullptr,
+                                              CipherSuite suite = kDefaultCipherSuite,
+                                              WireFormat format = kDefaultWireFormat);
 
 // Element-list entry points for callers that already hold the exact strings to
 // intersect (e.g. the multi-level mesh cascade in mesh_psi.h, which
@@ -105,12 +251,17 @@ std::vector<MatchedUnit> runPSIProtocolTags(const std::vector<Unit>& bobUnits,
 BobInitialTagMessage bobCreateInitialTagMessageFromElements(
     const std::vector<std::string>& elements,
     HashToGroupCache* hashCache = nullptr,
-    ProtocolRng* rng = nullptr);
+    ProtocolRng* rng = nullptr,
+    const ExecutionPolicy* policy = nullptr,
+    CipherSuite suite = kDefaultCipherSuite,
+    WireFormat format = kDefaultWireFormat,
+    double tagFilterRate = 0.0);
 
 AliceResponseMessage aliceProcessBobTagMessageFromElements(
     const std::string& serializedBobTagMessage,
     const std::vector<std::string>& elements,
     HashToGroupCache* hashCache = nullptr,
-    ProtocolRng* rng = nullptr);
+    ProtocolRng* rng = nullptr,
+    const ExecutionPolicy* policy = nullptr);
 
 #endif // PSI_PROTOCOL_H
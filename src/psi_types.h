@@ -2,9 +2,11 @@
 #define PSI_TYPES_H
 
 #include <array>
+#include <cstddef>
 #include <string>
 #include <vector>
 
+#include "point_batch.h"
 #include "secretbox_utils.h"
 
 struct Unit {
@@ -22,14 +24,20 @@ struct EncryptedUnit {
     SecretBoxCiphertext ciphertext;
 };
 
-struct AliceSentValue {
-    std::vector<unsigned char> blindedPointEncoded;
-};
+// Indexed secretbox mode: each ciphertext travels with a short one-way
+// locator of the key it is sealed under, so Alice looks up the one
+// ciphertext each of her keys can open instead of trying them all.
+inline constexpr std::size_t kLocatorBytes = 8;
+using Locator = std::array<unsigned char, kLocatorBytes>;
 
-struct BobTransformedValue {
-    std::vector<unsigned char> transformedPointEncoded;
+struct IndexedEncryptedUnit {
+    Locator locator;
+    SecretBoxCiphertext ciphertext;
 };
 
+// Alice's blinded points, Bob's transformed points and Bob's tags travel as
+// contiguous batches of 32-byte entries (point_batch.h).
+
 // One element of the computed intersection, with the key both parties derived
 // for it. In tag mode the element is Alice's own matching input; in secretbox
 // mode it is the decrypted (identical) value from Bob's ciphertext.
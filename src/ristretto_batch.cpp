@@ -0,0 +1,83 @@
+#include "ristretto_batch.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+[[noreturn]] void throwMultiplyFailure(const char* context) {
+    throw std::runtime_error(std::string("ristretto255 scalar multiplication failed: ") + context);
+}
+
+// Encodes a product, rejecting the identity the way libsodium does (its
+// encoding is all zero bytes).
+RistrettoPoint encodeProduct(const RistrettoElement& product, const char* context) {
+    RistrettoPoint out{};
+    ristrettoEncode(out.data(), product);
+    if (sodium_is_zero(out.data(), out.size())) {
+        throwMultiplyFailure(context);
+    }
+    return out;
+}
+
+}  // namespace
+
+RistrettoElement decodeElement(const unsigned char* pointEncoded, const char* context) {
+    RistrettoElement element{};
+    if (!ristrettoDecode(element, pointEncoded)) {
+        throwMultiplyFailure(context);
+    }
+    return element;
+}
+
+RistrettoPoint multiplyElement(const RistrettoScalar& scalar, const RistrettoElement& element,
+                               const char* context) {
+    const RecodedScalar recoded(scalar.data());
+    return encodeProduct(ristrettoScalarMult(recoded, element), context);
+}
+
+void multiplyElements(const RistrettoScalar* scalars, const RistrettoElement* elements,
+                      std::size_t count, RistrettoPoint* out, const char* context) {
+    std::vector<RecodedScalar> recoded;
+    recoded.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        recoded.emplace_back(scalars[i].data());
+    }
+    std::vector<RistrettoElement> products(count);
+    ristrettoScalarMultBatch(recoded.data(), elements, count, products.data());
+    for (std::size_t i = 0; i < count; ++i) {
+        out[i] = encodeProduct(products[i], context);
+    }
+}
+
+FixedScalarMultiplier::FixedScalarMultiplier(const RistrettoScalar& scalar)
+    : scalar_(scalar.data()) {}
+
+RistrettoPoint FixedScalarMultiplier::multiply(const RistrettoElement& element,
+                                               const char* context) const {
+    return encodeProduct(ristrettoScalarMult(scalar_, element), context);
+}
+
+RistrettoPoint FixedScalarMultiplier::multiply(const unsigned char* pointEncoded,
+                                               const char* context) const {
+    return multiply(decodeElement(pointEncoded, context), context);
+}
+
+void FixedScalarMultiplier::multiplyBatch(const RistrettoElement* elements, std::size_t count,
+                                          RistrettoPoint* out, const char* context) const {
+    std::vector<RistrettoElement> products(count);
+    ristrettoScalarMultBatch(scalar_, elements, count, products.data());
+    for (std::size_t i = 0; i < count; ++i) {
+        out[i] = encodeProduct(products[i], context);
+    }
+}
+
+void FixedScalarMultiplier::multiplyBatch(const RistrettoPoint* points, std::size_t count,
+                                          RistrettoPoint* out, const char* context) const {
+    std::vector<RistrettoElement> elements(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        elements[i] = decodeElement(points[i].data(), context);
+    }
+    multiplyBatch(elements.data(), count, out, context);
+}
@@ -0,0 +1,69 @@
+#ifndef RISTRETTO_BATCH_H
+#define RISTRETTO_BATCH_H
+
+// Scalar multiplication kernels of the protocol, over internal group
+// elements (ristretto_point.h).
+//
+// Both of Bob's per-element phases multiply every element by the same private
+// scalar (tagging: b * H(x); response: b * (r * H(y))). Calling
+// crypto_scalarmult_ristretto255 per element redoes the scalar's signed
+// radix-16 recoding every time and round-trips through libsodium's opaque
+// API. FixedScalarMultiplier recodes the scalar once at construction and
+// keeps the pipeline in internal form: a hashed element goes straight into
+// the multiplication, and the product is encoded once, for the wire or for
+// key derivation.
+//
+// Output is byte-identical to crypto_scalarmult_ristretto255, failures
+// included: like libsodium, the top bit of the scalar is ignored, and a
+// non-canonical input encoding or an identity result is an error. Whether bit
+// 255 of an input encoding is ignored or rejected differs between libsodium
+// releases; decoding probes the linked library once and follows it. The
+// differential tests in tests/ristretto_batch_test.cpp pin this down.
+
+#include <cstddef>
+
+#include "crypto_utils.h"
+#include "ristretto_point.h"
+
+// Decodes a point received from the counterparty. Throws std::runtime_error
+// naming `context` where libsodium would reject the encoding.
+RistrettoElement decodeElement(const unsigned char* pointEncoded, const char* context);
+
+// Encoding of scalar * element, for per-element scalars (Alice's blinding and
+// unblinding). Throws std::runtime_error naming `context` on an identity
+// result, as crypto_scalarmult_ristretto255 fails there.
+RistrettoPoint multiplyElement(const RistrettoScalar& scalar, const RistrettoElement& element,
+                               const char* context);
+
+// out[i] = encoding of scalars[i] * elements[i] for i in [0, count), on the
+// batch path of the field backend. Same errors as multiplyElement.
+void multiplyElements(const RistrettoScalar* scalars, const RistrettoElement* elements,
+                      std::size_t count, RistrettoPoint* out, const char* context);
+
+class FixedScalarMultiplier {
+public:
+    explicit FixedScalarMultiplier(const RistrettoScalar& scalar);
+
+    FixedScalarMultiplier(const FixedScalarMultiplier&) = delete;
+    FixedScalarMultiplier& operator=(const FixedScalarMultiplier&) = delete;
+
+    // Encoding of scalar * element; identity results throw.
+    RistrettoPoint multiply(const RistrettoElement& element, const char* context) const;
+
+    // scalar * point for an encoded point: decode, multiply, encode. Throws
+    // std::runtime_error naming `context` when crypto_scalarmult_ristretto255
+    // would have failed.
+    RistrettoPoint multiply(const unsigned char* pointEncoded, const char* context) const;
+
+    // out[i] = scalar * input[i] for i in [0, count). Same errors as
+    // multiply(); the first failing index wins.
+    void multiplyBatch(const RistrettoElement* elements, std::size_t count, RistrettoPoint* out,
+                       const char* context) const;
+    void multiplyBatch(const RistrettoPoint* points, std::size_t count, RistrettoPoint* out,
+                       const char* context) const;
+
+private:
+    RecodedScalar scalar_;
+};
+
+#endif // RISTRETTO_BATCH_H
@@ -0,0 +1,159 @@
+#ifndef RISTRETTO_LADDER_H
+#define RISTRETTO_LADDER_H
+
+// Edwards point arithmetic and the fixed-window scalar multiplication ladder
+// over Fe51, shared by the portable and BMI2/ADX builds of the ladder
+// (ristretto_point.cpp and ristretto_point_mulx.cpp) and by the x25519
+// hash-to-curve (x25519_point.cpp), which works on edwards25519 before
+// moving to the Montgomery u-coordinate. Internal to those files: like
+// curve25519_fe51.h, everything has internal linkage so each
+// instruction-set build keeps its own copy.
+
+#include <array>
+
+#include "curve25519_fe51.h"
+#include "ristretto_point.h"
+
+#if defined(PSI_HAVE_FE51)
+
+namespace ristretto_detail {
+
+constexpr Fe51 kD2 = {{0x69b9426b2f159ULL, 0x35050762add7aULL, 0x3cf44c0038052ULL,
+                       0x6738cc7407977ULL, 0x2406d9dc56dffULL}};  // 2d
+constexpr Fe51 kSqrtM1 = {{0x61b274a0ea0b0ULL, 0xd5a5fc8f189dULL, 0x7ef5e9cbd0c60ULL,
+                           0x78595a6804c9eULL, 0x2b8324804fc1dULL}};  // sqrt(-1)
+
+// RFC 9496 SQRT_RATIO_M1: x = sqrt(u/v) or sqrt(i*u/v), non-negative.
+// Returns 1 when u/v was square.
+PSI_FE51_INLINE unsigned int sqrtRatioM1(Fe51& x, const Fe51& u, const Fe51& v) {
+    const Fe51 v3 = fe51Mul(fe51Sq(v), v);
+    x = fe51Mul(fe51Mul(fe51Sq(v3), u), v);  // u v^7
+    x = fe51Pow22523(x);
+    x = fe51Mul(fe51Mul(x, v3), u);          // u v^3 (u v^7)^((p-5)/8)
+
+    const Fe51 vxx = fe51Mul(fe51Sq(x), v);
+    const unsigned int hasMRoot = fe51IsZero(fe51Sub(vxx, u));
+    const unsigned int hasPRoot = fe51IsZero(fe51Add(vxx, u));
+    const unsigned int hasFRoot = fe51IsZero(fe51Add(vxx, fe51Mul(u, kSqrtM1)));
+
+    fe51Cmov(x, fe51Mul(x, kSqrtM1), hasPRoot | hasFRoot);
+    x = fe51Abs(x);
+    return hasMRoot | hasPRoot;
+}
+
+// Edwards points, a = -1, in the usual coordinate systems (ref10 naming):
+// extended (X:Y:Z:T) with XY = ZT, projective (X:Y:Z), completed
+// ((X:Z),(Y:T)), and the cached form used as the right operand of additions.
+using GeP3 = RistrettoElement;
+struct GeP2 {
+    Fe51 X, Y, Z;
+};
+struct GeP1P1 {
+    Fe51 X, Y, Z, T;
+};
+struct GeCached {
+    Fe51 YplusX, YminusX, Z, T2d;
+};
+
+PSI_FE51_INLINE GeP3 geIdentity() {
+    return GeP3{fe51Zero(), fe51One(), fe51One(), fe51Zero()};
+}
+
+PSI_FE51_INLINE GeCached geToCached(const GeP3& p) {
+    return GeCached{fe51Add(p.Y, p.X), fe51Sub(p.Y, p.X), p.Z, fe51Mul(p.T, kD2)};
+}
+
+PSI_FE51_INLINE GeP2 geToP2(const GeP1P1& p) {
+    return GeP2{fe51Mul(p.X, p.T), fe51Mul(p.Y, p.Z), fe51Mul(p.Z, p.T)};
+}
+
+PSI_FE51_INLINE GeP3 geToP3(const GeP1P1& p) {
+    return GeP3{fe51Mul(p.X, p.T), fe51Mul(p.Y, p.Z), fe51Mul(p.Z, p.T), fe51Mul(p.X, p.Y)};
+}
+
+PSI_FE51_INLINE GeP1P1 geDbl(const GeP2& p) {
+    const Fe51 xx = fe51Sq(p.X);
+    const Fe51 yy = fe51Sq(p.Y);
+    const Fe51 zz2 = fe51Add(fe51Sq(p.Z), fe51Sq(p.Z));
+    const Fe51 xy2 = fe51Sq(fe51Add(p.X, p.Y));
+    GeP1P1 r;
+    r.Y = fe51Add(yy, xx);
+    r.Z = fe51Sub(yy, xx);
+    r.X = fe51Sub(xy2, r.Y);
+    r.T = fe51Sub(zz2, r.Z);
+    return r;
+}
+
+PSI_FE51_INLINE GeP1P1 geDbl(const GeP3& p) {
+    return geDbl(GeP2{p.X, p.Y, p.Z});
+}
+
+PSI_FE51_INLINE GeP1P1 geAdd(const GeP3& p, const GeCached& q) {
+    const Fe51 a = fe51Mul(fe51Add(p.Y, p.X), q.YplusX);
+    const Fe51 b = fe51Mul(fe51Sub(p.Y, p.X), q.YminusX);
+    const Fe51 c = fe51Mul(q.T2d, p.T);
+    const Fe51 zz = fe51Mul(p.Z, q.Z);
+    const Fe51 d = fe51Add(zz, zz);
+    return GeP1P1{fe51Sub(a, b), fe51Add(a, b), fe51Add(d, c), fe51Sub(d, c)};
+}
+
+PSI_FE51_INLINE void geCmovCached(GeCached& t, const GeCached& u, unsigned int flag) {
+    fe51Cmov(t.YplusX, u.YplusX, flag);
+    fe51Cmov(t.YminusX, u.YminusX, flag);
+    fe51Cmov(t.Z, u.Z, flag);
+    fe51Cmov(t.T2d, u.T2d, flag);
+}
+
+PSI_FE51_INLINE unsigned int ctEqual(unsigned int a, unsigned int b) {
+    return ((a ^ b) - 1U) >> 31;
+}
+
+// table[j] = (j+1) * P. Selects digit * P for digit in [-8, 8] without
+// branching or indexing on the digit.
+PSI_FE51_INLINE GeCached geSelect(const GeCached table[8], signed char digit) {
+    const unsigned int negative = static_cast<unsigned char>(digit) >> 7;
+    const auto value = static_cast<unsigned int>(digit);
+    const unsigned int magnitude = value - ((0U - negative) & (value << 1));
+
+    GeCached t{fe51One(), fe51One(), fe51One(), fe51Zero()};
+    for (unsigned int j = 0; j < 8; ++j) {
+        geCmovCached(t, table[j], ctEqual(magnitude & 0xff, j + 1));
+    }
+    const GeCached minus{t.YminusX, t.YplusX, t.Z, fe51Neg(t.T2d)};
+    geCmovCached(t, minus, negative);
+    return t;
+}
+
+// digits * P with the table-driven fixed window of libsodium's
+// ge25519_scalarmult: 4 doublings and one masked addition per digit.
+PSI_FE51_INLINE GeP3 geScalarMult(const std::array<signed char, 64>& digits, const GeP3& p) {
+    GeCached table[8];
+    table[0] = geToCached(p);
+    const GeP3 p2 = geToP3(geDbl(p));
+    table[1] = geToCached(p2);
+    const GeP3 p3 = geToP3(geAdd(p, table[1]));
+    table[2] = geToCached(p3);
+    const GeP3 p4 = geToP3(geDbl(p2));
+    table[3] = geToCached(p4);
+    table[4] = geToCached(geToP3(geAdd(p, table[3])));
+    table[5] = geToCached(geToP3(geDbl(p3)));
+    table[6] = geToCached(geToP3(geAdd(p, table[5])));
+    table[7] = geToCached(geToP3(geDbl(p4)));
+
+    GeP3 h = geIdentity();
+    for (int i = 63; i > 0; --i) {
+        GeP1P1 r = geAdd(h, geSelect(table, digits[i]));
+        r = geDbl(geToP2(r));
+        r = geDbl(geToP2(r));
+        r = geDbl(geToP2(r));
+        r = geDbl(geToP2(r));
+        h = geToP3(r);
+    }
+    return geToP3(geAdd(h, geSelect(table, digits[0])));
+}
+
+}  // namespace ristretto_detail
+
+#endif  // PSI_HAVE_FE51
+
+#endif // RISTRETTO_LADDER_H
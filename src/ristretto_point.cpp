@@ -0,0 +1,268 @@
+#include "ristretto_point.h"
+
+#include <algorithm>
+
+#include "curve25519_backend.h"
+#include "ristretto_ladder.h"
+
+extern "C" {
+#include <sodium.h>
+}
+
+namespace {
+
+#if defined(PSI_HAVE_FE51)
+
+using namespace ristretto_detail;
+
+// Curve constants in radix 2^51 (same values as libsodium's fe_51 tables).
+constexpr Fe51 kD = {{0x34dca135978a3ULL, 0x1a8283b156ebdULL, 0x5e7a26001c029ULL,
+                      0x739c663a03cbbULL, 0x52036cee2b6ffULL}};
+constexpr Fe51 kInvSqrtAMinusD = {{0xfdaa805d40eaULL, 0x2eb482e57d339ULL, 0x7610274bc58ULL,
+                                   0x6510b613dc8ffULL, 0x786c8905cfaffULL}};  // 1/sqrt(a-d)
+constexpr Fe51 kSqrtADMinusOne = {{0x7f6a0497b2e1bULL, 0x1836f0a97afd2ULL, 0x7d747f6be7638ULL,
+                                   0x456079e7e6498ULL, 0x376931bf2b834ULL}};  // sqrt(ad-1)
+constexpr Fe51 kOneMinusDSq = {{0x409c1945fc176ULL, 0x719abc6a1fc4fULL, 0x1c37f90b20684ULL,
+                                0x6bccca55eedfULL, 0x29072a8b2b3eULL}};  // 1-d^2
+constexpr Fe51 kDMinusOneSq = {{0x55aaa44ed4d20ULL, 0x59603c3332635ULL, 0x26d3baf4a7928ULL,
+                                0x120a66e6997a9ULL, 0x5968b37af66c2ULL}};  // (d-1)^2
+
+// libsodium 1.0.18 ignores bit 255 of a ristretto255 encoding; later
+// releases reject it, as RFC 9496 requires. Follow whichever is linked, so
+// accept/reject decisions match crypto_scalarmult_ristretto255 exactly.
+bool libsodiumIgnoresHighBit() {
+    static const bool ignores = []() {
+        unsigned char one[crypto_core_ristretto255_SCALARBYTES] = {1};
+        unsigned char base[crypto_core_ristretto255_BYTES];
+        if (crypto_scalarmult_ristretto255_base(base, one) != 0) {
+            return false;
+        }
+        base[31] |= 0x80;
+        return crypto_core_ristretto255_is_valid_point(base) == 1;
+    }();
+    return ignores;
+}
+
+// Canonical iff below p (after dropping bit 255), even, and, unless the linked
+// libsodium ignores it, bit 255 clear. Same bit tricks as libsodium.
+unsigned int ristrettoIsCanonical(const unsigned char* s) {
+    unsigned char c = static_cast<unsigned char>((s[31] & 0x7f) ^ 0x7f);
+    for (int i = 30; i > 0; --i) {
+        c |= static_cast<unsigned char>(s[i] ^ 0xff);
+    }
+    c = static_cast<unsigned char>((static_cast<unsigned int>(c) - 1U) >> 8);
+    const unsigned char d = static_cast<unsigned char>((0xedU - 1U - s[0]) >> 8);
+    const unsigned char e =
+        libsodiumIgnoresHighBit() ? 0 : static_cast<unsigned char>(s[31] >> 7);
+    return 1U - (((c & d) | e | s[0]) & 1U);
+}
+
+bool decodeElement(GeP3& h, const unsigned char* s) {
+    if (ristrettoIsCanonical(s) == 0) {
+        return false;
+    }
+    const Fe51 s_ = fe51FromBytes(s);
+    const Fe51 ss = fe51Sq(s_);
+    const Fe51 u1 = fe51Sub(fe51One(), ss);
+    const Fe51 u2 = fe51Add(fe51One(), ss);
+    const Fe51 u2u2 = fe51Sq(u2);
+    const Fe51 v = fe51Sub(fe51Neg(fe51Mul(kD, fe51Sq(u1))), u2u2);  // -d u1^2 - u2^2
+
+    Fe51 invSqrt;
+    const unsigned int wasSquare = sqrtRatioM1(invSqrt, fe51One(), fe51Mul(v, u2u2));
+
+    const Fe51 denX = fe51Mul(invSqrt, u2);
+    const Fe51 denY = fe51Mul(fe51Mul(invSqrt, denX), v);
+    const Fe51 x2 = fe51Mul(denX, s_);
+    h.X = fe51Abs(fe51Add(x2, x2));
+    h.Y = fe51Mul(u1, denY);
+    h.Z = fe51One();
+    h.T = fe51Mul(h.X, h.Y);
+
+    return ((1U - wasSquare) | fe51IsNegative(h.T) | fe51IsZero(h.Y)) == 0;
+}
+
+void encodeElement(unsigned char* out, const GeP3& h) {
+    const Fe51 u1 = fe51Mul(fe51Add(h.Z, h.Y), fe51Sub(h.Z, h.Y));
+    const Fe51 u2 = fe51Mul(h.X, h.Y);
+
+    Fe51 invSqrt;
+    (void)sqrtRatioM1(invSqrt, fe51One(), fe51Mul(u1, fe51Sq(u2)));
+
+    const Fe51 den1 = fe51Mul(invSqrt, u1);
+    const Fe51 den2 = fe51Mul(invSqrt, u2);
+    const Fe51 zInv = fe51Mul(fe51Mul(den1, den2), h.T);
+    const Fe51 ix = fe51Mul(h.X, kSqrtM1);
+    const Fe51 iy = fe51Mul(h.Y, kSqrtM1);
+    const Fe51 eden = fe51Mul(den1, kInvSqrtAMinusD);
+    const unsigned int rotate = fe51IsNegative(fe51Mul(h.T, zInv));
+
+    Fe51 x = h.X;
+    Fe51 y = h.Y;
+    Fe51 denInv = den2;
+    fe51Cmov(x, iy, rotate);
+    fe51Cmov(y, ix, rotate);
+    fe51Cmov(denInv, eden, rotate);
+
+    y = fe51CondNeg(y, fe51IsNegative(fe51Mul(x, zInv)));
+    fe51ToBytes(out, fe51Abs(fe51Mul(denInv, fe51Sub(h.Z, y))));
+}
+
+// RFC 9496 MAP (libsodium's ristretto255_elligator).
+GeP3 elligator(const Fe51& t) {
+    const Fe51 one = fe51One();
+    const Fe51 r = fe51Mul(kSqrtM1, fe51Sq(t));
+    const Fe51 u = fe51Mul(fe51Add(r, one), kOneMinusDSq);
+    Fe51 c = fe51Neg(one);
+    const Fe51 rpd = fe51Add(r, kD);
+    const Fe51 v = fe51Mul(fe51Sub(c, fe51Mul(r, kD)), rpd);
+
+    Fe51 s;
+    const unsigned int wasntSquare = 1U - sqrtRatioM1(s, u, v);
+    const Fe51 sPrime = fe51Neg(fe51Abs(fe51Mul(s, t)));
+    fe51Cmov(s, sPrime, wasntSquare);
+    fe51Cmov(c, r, wasntSquare);
+
+    const Fe51 n = fe51Sub(fe51Mul(fe51Mul(fe51Sub(r, one), c), kDMinusOneSq), v);
+    const Fe51 w0 = fe51Mul(fe51Add(s, s), v);
+    const Fe51 w1 = fe51Mul(n, kSqrtADMinusOne);
+    const Fe51 ss = fe51Sq(s);
+    const Fe51 w2 = fe51Sub(one, ss);
+    const Fe51 w3 = fe51Add(one, ss);
+    return GeP3{fe51Mul(w0, w3), fe51Mul(w2, w1), fe51Mul(w1, w3), fe51Mul(w0, w2)};
+}
+
+// One multiplication on the active backend. AVX2 only pays off four points
+// at a time, so single multiplications under it take the mulx ladder.
+RistrettoElement scalarMultOne(FieldBackend backend, const RecodedScalar& scalar,
+                               const RistrettoElement& element) {
+#if defined(PSI_HAVE_X86_BACKENDS)
+    if (backend != FieldBackend::Portable && fieldBackendSupported(FieldBackend::Mulx)) {
+        return ristrettoScalarMultMulx(scalar, element);
+    }
+#else
+    (void)backend;
+#endif
+    return geScalarMult(scalar.digits, element);
+}
+
+// out[i] = scalars[i * scalarStride] * in[i]; a stride of 0 repeats one scalar.
+void scalarMultMany(const RecodedScalar* scalars, std::size_t scalarStride,
+                    const RistrettoElement* in, std::size_t count, RistrettoElement* out) {
+    const FieldBackend backend = activeFieldBackend();
+    std::size_t i = 0;
+#if defined(PSI_HAVE_X86_BACKENDS)
+    if (backend == FieldBackend::Avx2) {
+        for (; i + 4 <= count; i += 4) {
+            const RecodedScalar* const lanes[4] = {
+                &scalars[i * scalarStride], &scalars[(i + 1) * scalarStride],
+                &scalars[(i + 2) * scalarStride], &scalars[(i + 3) * scalarStride]};
+            ristrettoScalarMult4Avx2(lanes, in + i, out + i);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = scalarMultOne(backend, scalars[i * scalarStride], in[i]);
+    }
+}
+
+#endif  // PSI_HAVE_FE51
+
+}  // namespace
+
+RecodedScalar::RecodedScalar(const unsigned char scalar[32]) {
+    std::copy(scalar, scalar + 32, clamped.begin());
+    // Same clamping as crypto_scalarmult_ristretto255.
+    clamped[31] &= 127;
+
+    for (int i = 0; i < 32; ++i) {
+        digits[2 * i] = static_cast<signed char>(clamped[i] & 15);
+        digits[2 * i + 1] = static_cast<signed char>((clamped[i] >> 4) & 15);
+    }
+    signed char carry = 0;
+    for (int i = 0; i < 63; ++i) {
+        digits[i] = static_cast<signed char>(digits[i] + carry);
+        carry = static_cast<signed char>((digits[i] + 8) >> 4);
+        digits[i] = static_cast<signed char>(digits[i] - carry * 16);
+    }
+    digits[63] = static_cast<signed char>(digits[63] + carry);
+}
+
+RecodedScalar::~RecodedScalar() {
+    sodium_memzero(clamped.data(), clamped.size());
+    sodium_memzero(digits.data(), digits.size());
+}
+
+#if defined(PSI_HAVE_FE51)
+
+bool ristrettoDecode(RistrettoElement& out, const unsigned char in[32]) {
+    return decodeElement(out, in);
+}
+
+void ristrettoEncode(unsigned char out[32], const RistrettoElement& element) {
+    encodeElement(out, element);
+}
+
+RistrettoElement ristrettoFromHash(const unsigned char hash[64]) {
+    const GeP3 p0 = elligator(fe51FromBytes(hash));
+    const GeP3 p1 = elligator(fe51FromBytes(hash + 32));
+    return geToP3(geAdd(p0, geToCached(p1)));
+}
+
+RistrettoElement ristrettoScalarMult(const RecodedScalar& scalar, const RistrettoElement& element) {
+    return scalarMultOne(activeFieldBackend(), scalar, element);
+}
+
+void ristrettoScalarMultBatch(const RecodedScalar& scalar, const RistrettoElement* in,
+                              std::size_t count, RistrettoElement* out) {
+    scalarMultMany(&scalar, 0, in, count, out);
+}
+
+void ristrettoScalarMultBatch(const RecodedScalar* scalars, const RistrettoElement* in,
+                              std::size_t count, RistrettoElement* out) {
+    scalarMultMany(scalars, 1, in, count, out);
+}
+
+#else
+
+bool ristrettoDecode(RistrettoElement& out, const unsigned char in[32]) {
+    std::copy(in, in + 32, out.encoded.begin());
+    return crypto_core_ristretto255_is_valid_point(in) == 1;
+}
+
+void ristrettoEncode(unsigned char out[32], const RistrettoElement& element) {
+    std::copy(element.encoded.begin(), element.encoded.end(), out);
+}
+
+RistrettoElement ristrettoFromHash(const unsigned char hash[64]) {
+    RistrettoElement element{};
+    crypto_core_ristretto255_from_hash(element.encoded.data(), hash);
+    return element;
+}
+
+RistrettoElement ristrettoScalarMult(const RecodedScalar& scalar, const RistrettoElement& element) {
+    // On failure (identity result) libsodium leaves no defined output; zero
+    // bytes are the identity's encoding, which callers treat as the error.
+    RistrettoElement product{};
+    if (crypto_scalarmult_ristretto255(product.encoded.data(), scalar.clamped.data(),
+                                       element.encoded.data()) != 0) {
+        product.encoded.fill(0);
+    }
+    return product;
+}
+
+void ristrettoScalarMultBatch(const RecodedScalar& scalar, const RistrettoElement* in,
+                              std::size_t count, RistrettoElement* out) {
+    for (std::size_t i = 0; i < count; ++i) {
+        out[i] = ristrettoScalarMult(scalar, in[i]);
+    }
+}
+
+void ristrettoScalarMultBatch(const RecodedScalar* scalars, const RistrettoElement* in,
+                              std::size_t count, RistrettoElement* out) {
+    for (std::size_t i = 0; i < count; ++i) {
+        out[i] = ristrettoScalarMult(scalars[i], in[i]);
+    }
+}
+
+#endif  // PSI_HAVE_FE51
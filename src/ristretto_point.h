@@ -0,0 +1,70 @@
+#ifndef RISTRETTO_POINT_H
+#define RISTRETTO_POINT_H
+
+// Internal ristretto255 group elements.
+//
+// The 32-byte encoding is what goes on the wire and into key derivation, but
+// producing or parsing it costs an inverse square root each way. The protocol
+// paths used to pay that on every hop: hashToGroup encoded its result,
+// scalar multiplication decoded it again, multiplied, and encoded once more.
+// RistrettoElement keeps a point in extended Edwards coordinates (X:Y:Z:T)
+// between operations, so it is decoded once where it enters from the wire and
+// encoded once where bytes are really needed.
+//
+// Every function here matches libsodium byte for byte: ristrettoFromHash is
+// crypto_core_ristretto255_from_hash without the final encoding, decode
+// accepts exactly the encodings libsodium accepts, and multiplication clears
+// scalar bit 255 like crypto_scalarmult_ristretto255. An identity result
+// encodes to 32 zero bytes, which is where libsodium reports failure; callers
+// check for it (see ristretto_batch.h).
+//
+// Constant-time in scalars and points. Scalar multiplication runs on the
+// field backend picked at startup (curve25519_backend.h). Without 128-bit
+// integer support the element holds its encoding and every operation goes
+// through libsodium.
+
+#include <array>
+#include <cstddef>
+
+#include "curve25519_fe51.h"
+
+#if defined(PSI_HAVE_FE51)
+struct RistrettoElement {
+    Fe51 X, Y, Z, T;
+};
+#else
+struct RistrettoElement {
+    std::array<unsigned char, 32> encoded;
+};
+#endif
+
+// A scalar prepared for repeated multiplication: bit 255 cleared, then
+// recoded into 64 signed radix-16 digits in [-8, 8].
+struct RecodedScalar {
+    std::array<unsigned char, 32> clamped;
+    std::array<signed char, 64> digits;
+
+    explicit RecodedScalar(const unsigned char scalar[32]);
+    ~RecodedScalar();
+};
+
+// False exactly where crypto_core_ristretto255_is_valid_point is false.
+bool ristrettoDecode(RistrettoElement& out, const unsigned char in[32]);
+
+void ristrettoEncode(unsigned char out[32], const RistrettoElement& element);
+
+// Elligator map of a 64-byte uniform string, as crypto_core_ristretto255_from_hash.
+RistrettoElement ristrettoFromHash(const unsigned char hash[64]);
+
+RistrettoElement ristrettoScalarMult(const RecodedScalar& scalar, const RistrettoElement& element);
+
+// out[i] = scalar * in[i] (or scalars[i] * in[i]) for i in [0, count). Runs
+// on the active field backend (curve25519_backend.h); the AVX2 backend
+// multiplies four elements per ladder, so prefer these over a loop of single
+// calls. in and out may be the same array.
+void ristrettoScalarMultBatch(const RecodedScalar& scalar, const RistrettoElement* in,
+                              std::size_t count, RistrettoElement* out);
+void ristrettoScalarMultBatch(const RecodedScalar* scalars, const RistrettoElement* in,
+                              std::size_t count, RistrettoElement* out);
+
+#endif // RISTRETTO_POINT_H
@@ -0,0 +1,387 @@
+// Four-way AVX2 ladder: the fixed-window scalar multiplication of
+// ristretto_ladder.h run on four points at once, field elements in radix
+// 2^25.5 (ten limbs of alternately 26 and 25 bits, ref10's layout), one
+// 64-bit lane per point. Products use vpmuludq (32x32->64 per lane).
+//
+// Every function that touches 256-bit registers carries the avx2 target
+// attribute instead of the file being built with -mavx2, so nothing else in
+// this translation unit (inline library code in particular) can leak AVX2
+// instructions into the rest of the program.
+//
+// Limb bounds: fe4Carry leaves even limbs below 2^26 and odd limbs below
+// 2^25 + 2^16. Multiplication, squaring and subtraction carry their result;
+// fe4AddLazy does not, so its limbs are below 2^27, and its result is used
+// only as a multiplication input or a minuend. With both factors below 2^27,
+// 19 * g stays below 2^32 as vpmuludq needs, and every product is below
+// 2^59.3, so the ten summed per output limb cannot overflow 64 bits.
+
+#include "curve25519_backend.h"
+
+#if defined(PSI_HAVE_X86_BACKENDS)
+
+#include <immintrin.h>
+
+#include <cstdint>
+
+#include "ristretto_ladder.h"
+
+#define PSI_AVX2 __attribute__((target("avx2")))
+
+namespace {
+
+using ristretto_detail::kD2;
+
+struct Fe4 {
+    __m256i v[10];
+};
+
+template <int Bits>
+PSI_AVX2 inline void carryLimb(__m256i& limb, __m256i& next) {
+    const __m256i mask = _mm256_set1_epi64x((std::int64_t{1} << Bits) - 1);
+    next = _mm256_add_epi64(next, _mm256_srli_epi64(limb, Bits));
+    limb = _mm256_and_si256(limb, mask);
+}
+
+// Two interleaved carry chains, in ref10's order, to halve the dependency
+// depth.
+PSI_AVX2 inline Fe4 fe4Carry(Fe4 h) {
+    carryLimb<26>(h.v[0], h.v[1]);
+    carryLimb<26>(h.v[4], h.v[5]);
+    carryLimb<25>(h.v[1], h.v[2]);
+    carryLimb<25>(h.v[5], h.v[6]);
+    carryLimb<26>(h.v[2], h.v[3]);
+    carryLimb<26>(h.v[6], h.v[7]);
+    carryLimb<25>(h.v[3], h.v[4]);
+    carryLimb<25>(h.v[7], h.v[8]);
+    carryLimb<26>(h.v[4], h.v[5]);
+    carryLimb<26>(h.v[8], h.v[9]);
+    // 2^255 = 19: fold the top carry back into limb 0 (c up to 2^38, so
+    // 19 * c is formed with shifts; vpmuludq would drop its high half).
+    const __m256i c = _mm256_srli_epi64(h.v[9], 25);
+    h.v[9] = _mm256_and_si256(h.v[9], _mm256_set1_epi64x((std::int64_t{1} << 25) - 1));
+    const __m256i c19 = _mm256_add_epi64(
+        _mm256_add_epi64(c, _mm256_slli_epi64(c, 1)), _mm256_slli_epi64(c, 4));
+    h.v[0] = _mm256_add_epi64(h.v[0], c19);
+    carryLimb<26>(h.v[0], h.v[1]);
+    return h;
+}
+
+// Sum without carrying: limbs below 2^27. Only valid as a multiplication
+// input or as the minuend of fe4Sub (see the bounds at the top).
+PSI_AVX2 inline Fe4 fe4AddLazy(const Fe4& f, const Fe4& g) {
+    Fe4 h;
+    for (int i = 0; i < 10; ++i) {
+        h.v[i] = _mm256_add_epi64(f.v[i], g.v[i]);
+    }
+    return h;
+}
+
+PSI_AVX2 inline Fe4 fe4Add(const Fe4& f, const Fe4& g) {
+    return fe4Carry(fe4AddLazy(f, g));
+}
+
+// f + 2p - g, so limbs stay non-negative; g must be carried.
+PSI_AVX2 inline Fe4 fe4Sub(const Fe4& f, const Fe4& g) {
+    const __m256i twoP0 = _mm256_set1_epi64x((std::int64_t{1} << 27) - 38);
+    const __m256i twoPEven = _mm256_set1_epi64x((std::int64_t{1} << 27) - 2);
+    const __m256i twoPOdd = _mm256_set1_epi64x((std::int64_t{1} << 26) - 2);
+    Fe4 h;
+    h.v[0] = _mm256_sub_epi64(_mm256_add_epi64(f.v[0], twoP0), g.v[0]);
+    for (int i = 1; i < 10; ++i) {
+        const __m256i twoP = (i & 1) != 0 ? twoPOdd : twoPEven;
+        h.v[i] = _mm256_sub_epi64(_mm256_add_epi64(f.v[i], twoP), g.v[i]);
+    }
+    return fe4Carry(h);
+}
+
+PSI_AVX2 inline Fe4 fe4Zero() {
+    Fe4 h;
+    for (auto& limb : h.v) {
+        limb = _mm256_setzero_si256();
+    }
+    return h;
+}
+
+PSI_AVX2 inline Fe4 fe4One() {
+    Fe4 h = fe4Zero();
+    h.v[0] = _mm256_set1_epi64x(1);
+    return h;
+}
+
+PSI_AVX2 inline Fe4 fe4Neg(const Fe4& f) {
+    return fe4Sub(fe4Zero(), f);
+}
+
+PSI_AVX2 inline __m256i mul(__m256i a, __m256i b) {
+    return _mm256_mul_epu32(a, b);
+}
+
+template <typename... Rest>
+PSI_AVX2 inline __m256i sum(__m256i first, Rest... rest) {
+    ((first = _mm256_add_epi64(first, rest)), ...);
+    return first;
+}
+
+// ref10's fe_mul with one lane per point: f_i g_j lands in limb i + j, times
+// 19 past limb 9, times 2 when both i and j are odd (their weights round up
+// twice).
+PSI_AVX2 Fe4 fe4Mul(const Fe4& f, const Fe4& g) {
+    const __m256i nineteen = _mm256_set1_epi64x(19);
+    __m256i g19[10];
+    __m256i f2[10];
+    for (int i = 0; i < 10; ++i) {
+        g19[i] = _mm256_mul_epu32(g.v[i], nineteen);
+        f2[i] = _mm256_add_epi64(f.v[i], f.v[i]);
+    }
+
+    Fe4 h;
+    h.v[0] = sum(mul(f.v[0], g.v[0]), mul(f2[1], g19[9]), mul(f.v[2], g19[8]), mul(f2[3], g19[7]),
+                 mul(f.v[4], g19[6]), mul(f2[5], g19[5]), mul(f.v[6], g19[4]), mul(f2[7], g19[3]),
+                 mul(f.v[8], g19[2]), mul(f2[9], g19[1]));
+    h.v[1] = sum(mul(f.v[0], g.v[1]), mul(f.v[1], g.v[0]), mul(f.v[2], g19[9]), mul(f.v[3], g19[8]),
+                 mul(f.v[4], g19[7]), mul(f.v[5], g19[6]), mul(f.v[6], g19[5]), mul(f.v[7], g19[4]),
+                 mul(f.v[8], g19[3]), mul(f.v[9], g19[2]));
+    h.v[2] = sum(mul(f.v[0], g.v[2]), mul(f2[1], g.v[1]), mul(f.v[2], g.v[0]), mul(f2[3], g19[9]),
+                 mul(f.v[4], g19[8]), mul(f2[5], g19[7]), mul(f.v[6], g19[6]), mul(f2[7], g19[5]),
+                 mul(f.v[8], g19[4]), mul(f2[9], g19[3]));
+    h.v[3] = sum(mul(f.v[0], g.v[3]), mul(f.v[1], g.v[2]), mul(f.v[2], g.v[1]), mul(f.v[3], g.v[0]),
+                 mul(f.v[4], g19[9]), mul(f.v[5], g19[8]), mul(f.v[6], g19[7]), mul(f.v[7], g19[6]),
+                 mul(f.v[8], g19[5]), mul(f.v[9], g19[4]));
+    h.v[4] = sum(mul(f.v[0], g.v[4]), mul(f2[1], g.v[3]), mul(f.v[2], g.v[2]), mul(f2[3], g.v[1]),
+                 mul(f.v[4], g.v[0]), mul(f2[5], g19[9]), mul(f.v[6], g19[8]), mul(f2[7], g19[7]),
+                 mul(f.v[8], g19[6]), mul(f2[9], g19[5]));
+    h.v[5] = sum(mul(f.v[0], g.v[5]), mul(f.v[1], g.v[4]), mul(f.v[2], g.v[3]), mul(f.v[3], g.v[2]),
+                 mul(f.v[4], g.v[1]), mul(f.v[5], g.v[0]), mul(f.v[6], g19[9]), mul(f.v[7], g19[8]),
+                 mul(f.v[8], g19[7]), mul(f.v[9], g19[6]));
+    h.v[6] = sum(mul(f.v[0], g.v[6]), mul(f2[1], g.v[5]), mul(f.v[2], g.v[4]), mul(f2[3], g.v[3]),
+                 mul(f.v[4], g.v[2]), mul(f2[5], g.v[1]), mul(f.v[6], g.v[0]), mul(f2[7], g19[9]),
+                 mul(f.v[8], g19[8]), mul(f2[9], g19[7]));
+    h.v[7] = sum(mul(f.v[0], g.v[7]), mul(f.v[1], g.v[6]), mul(f.v[2], g.v[5]), mul(f.v[3], g.v[4]),
+                 mul(f.v[4], g.v[3]), mul(f.v[5], g.v[2]), mul(f.v[6], g.v[1]), mul(f.v[7], g.v[0]),
+                 mul(f.v[8], g19[9]), mul(f.v[9], g19[8]));
+    h.v[8] = sum(mul(f.v[0], g.v[8]), mul(f2[1], g.v[7]), mul(f.v[2], g.v[6]), mul(f2[3], g.v[5]),
+                 mul(f.v[4], g.v[4]), mul(f2[5], g.v[3]), mul(f.v[6], g.v[2]), mul(f2[7], g.v[1]),
+                 mul(f.v[8], g.v[0]), mul(f2[9], g19[9]));
+    h.v[9] = sum(mul(f.v[0], g.v[9]), mul(f.v[1], g.v[8]), mul(f.v[2], g.v[7]), mul(f.v[3], g.v[6]),
+                 mul(f.v[4], g.v[5]), mul(f.v[5], g.v[4]), mul(f.v[6], g.v[3]), mul(f.v[7], g.v[2]),
+                 mul(f.v[8], g.v[1]), mul(f.v[9], g.v[0]));
+    return fe4Carry(h);
+}
+
+// fe4Mul(f, f) with the symmetric products merged: 55 multiplications.
+PSI_AVX2 Fe4 fe4Sq(const Fe4& f) {
+    const __m256i nineteen = _mm256_set1_epi64x(19);
+    __m256i f19[10];
+    __m256i f2[10];
+    __m256i f4[10];
+    for (int i = 0; i < 10; ++i) {
+        f19[i] = _mm256_mul_epu32(f.v[i], nineteen);
+        f2[i] = _mm256_add_epi64(f.v[i], f.v[i]);
+        f4[i] = _mm256_add_epi64(f2[i], f2[i]);
+    }
+
+    Fe4 h;
+    h.v[0] = sum(mul(f.v[0], f.v[0]), mul(f4[1], f19[9]), mul(f2[2], f19[8]), mul(f4[3], f19[7]),
+                 mul(f2[4], f19[6]), mul(f2[5], f19[5]));
+    h.v[1] = sum(mul(f2[0], f.v[1]), mul(f2[2], f19[9]), mul(f2[3], f19[8]), mul(f2[4], f19[7]),
+                 mul(f2[5], f19[6]));
+    h.v[2] = sum(mul(f2[0], f.v[2]), mul(f2[1], f.v[1]), mul(f4[3], f19[9]), mul(f2[4], f19[8]),
+                 mul(f4[5], f19[7]), mul(f.v[6], f19[6]));
+    h.v[3] = sum(mul(f2[0], f.v[3]), mul(f2[1], f.v[2]), mul(f2[4], f19[9]), mul(f2[5], f19[8]),
+                 mul(f2[6], f19[7]));
+    h.v[4] = sum(mul(f2[0], f.v[4]), mul(f4[1], f.v[3]), mul(f.v[2], f.v[2]), mul(f4[5], f19[9]),
+                 mul(f2[6], f19[8]), mul(f2[7], f19[7]));
+    h.v[5] = sum(mul(f2[0], f.v[5]), mul(f2[1], f.v[4]), mul(f2[2], f.v[3]), mul(f2[6], f19[9]),
+                 mul(f2[7], f19[8]));
+    h.v[6] = sum(mul(f2[0], f.v[6]), mul(f4[1], f.v[5]), mul(f2[2], f.v[4]), mul(f2[3], f.v[3]),
+                 mul(f4[7], f19[9]), mul(f.v[8], f19[8]));
+    h.v[7] = sum(mul(f2[0], f.v[7]), mul(f2[1], f.v[6]), mul(f2[2], f.v[5]), mul(f2[3], f.v[4]),
+                 mul(f2[8], f19[9]));
+    h.v[8] = sum(mul(f2[0], f.v[8]), mul(f4[1], f.v[7]), mul(f2[2], f.v[6]), mul(f4[3], f.v[5]),
+                 mul(f.v[4], f.v[4]), mul(f2[9], f19[9]));
+    h.v[9] = sum(mul(f2[0], f.v[9]), mul(f2[1], f.v[8]), mul(f2[2], f.v[7]), mul(f2[3], f.v[6]),
+                 mul(f2[4], f.v[5]));
+    return fe4Carry(h);
+}
+
+// Lanes where mask is all ones take g, the others keep f.
+PSI_AVX2 inline Fe4 fe4Select(const Fe4& f, const Fe4& g, __m256i mask) {
+    Fe4 h;
+    for (int i = 0; i < 10; ++i) {
+        h.v[i] = _mm256_blendv_epi8(f.v[i], g.v[i], mask);
+    }
+    return h;
+}
+
+// Four radix-2^51 elements into the lanes of one radix-2^25.5 element.
+PSI_AVX2 inline Fe4 fe4FromFe51(const Fe51& a, const Fe51& b, const Fe51& c, const Fe51& d) {
+    const Fe51* in[4] = {&a, &b, &c, &d};
+    alignas(32) std::uint64_t limbs[10][4];
+    for (int lane = 0; lane < 4; ++lane) {
+        std::uint64_t r[5] = {in[lane]->v[0], in[lane]->v[1], in[lane]->v[2], in[lane]->v[3],
+                              in[lane]->v[4]};
+        fe51_detail::carry(r[0], r[1], r[2], r[3], r[4]);
+        for (int i = 0; i < 5; ++i) {
+            limbs[2 * i][lane] = r[i] & ((std::uint64_t{1} << 26) - 1);
+            limbs[2 * i + 1][lane] = r[i] >> 26;
+        }
+    }
+    Fe4 h;
+    for (int i = 0; i < 10; ++i) {
+        h.v[i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(limbs[i]));
+    }
+    return fe4Carry(h);
+}
+
+PSI_AVX2 inline void fe4ToFe51(const Fe4& f, Fe51* out[4]) {
+    alignas(32) std::uint64_t limbs[10][4];
+    for (int i = 0; i < 10; ++i) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(limbs[i]), f.v[i]);
+    }
+    for (int lane = 0; lane < 4; ++lane) {
+        for (int i = 0; i < 5; ++i) {
+            out[lane]->v[i] = limbs[2 * i][lane] + (limbs[2 * i + 1][lane] << 26);
+        }
+    }
+}
+
+struct P3x4 {
+    Fe4 X, Y, Z, T;
+};
+struct P2x4 {
+    Fe4 X, Y, Z;
+};
+struct P1P1x4 {
+    Fe4 X, Y, Z, T;
+};
+struct Cachedx4 {
+    Fe4 YplusX, YminusX, Z, T2d;
+};
+
+PSI_AVX2 inline Cachedx4 toCached(const P3x4& p, const Fe4& d2) {
+    return Cachedx4{fe4AddLazy(p.Y, p.X), fe4Sub(p.Y, p.X), p.Z, fe4Mul(p.T, d2)};
+}
+
+PSI_AVX2 inline P2x4 toP2(const P1P1x4& p) {
+    return P2x4{fe4Mul(p.X, p.T), fe4Mul(p.Y, p.Z), fe4Mul(p.Z, p.T)};
+}
+
+PSI_AVX2 inline P3x4 toP3(const P1P1x4& p) {
+    return P3x4{fe4Mul(p.X, p.T), fe4Mul(p.Y, p.Z), fe4Mul(p.Z, p.T), fe4Mul(p.X, p.Y)};
+}
+
+PSI_AVX2 inline P1P1x4 dbl(const P2x4& p) {
+    const Fe4 xx = fe4Sq(p.X);
+    const Fe4 yy = fe4Sq(p.Y);
+    const Fe4 zz = fe4Sq(p.Z);
+    const Fe4 zz2 = fe4AddLazy(zz, zz);
+    const Fe4 xy2 = fe4Sq(fe4AddLazy(p.X, p.Y));
+    P1P1x4 r;
+    r.Y = fe4Add(yy, xx);
+    r.Z = fe4Sub(yy, xx);
+    r.X = fe4Sub(xy2, r.Y);
+    r.T = fe4Sub(zz2, r.Z);
+    return r;
+}
+
+PSI_AVX2 inline P1P1x4 dbl(const P3x4& p) {
+    return dbl(P2x4{p.X, p.Y, p.Z});
+}
+
+PSI_AVX2 inline P1P1x4 add(const P3x4& p, const Cachedx4& q) {
+    const Fe4 a = fe4Mul(fe4AddLazy(p.Y, p.X), q.YplusX);
+    const Fe4 b = fe4Mul(fe4Sub(p.Y, p.X), q.YminusX);
+    const Fe4 c = fe4Mul(q.T2d, p.T);
+    const Fe4 zz = fe4Mul(p.Z, q.Z);
+    const Fe4 d = fe4AddLazy(zz, zz);
+    return P1P1x4{fe4Sub(a, b), fe4Add(a, b), fe4Add(d, c), fe4Sub(d, c)};
+}
+
+PSI_AVX2 inline Cachedx4 selectCached(const Cachedx4& f, const Cachedx4& g, __m256i mask) {
+    return Cachedx4{fe4Select(f.YplusX, g.YplusX, mask), fe4Select(f.YminusX, g.YminusX, mask),
+                    fe4Select(f.Z, g.Z, mask), fe4Select(f.T2d, g.T2d, mask)};
+}
+
+// Per lane, digit * P from table[j] = (j+1) * P, digit in [-8, 8]. Every
+// entry is read and blended; lanes differ only in the masks.
+PSI_AVX2 inline Cachedx4 select(const Cachedx4 table[8], const signed char digits[4]) {
+    alignas(32) std::int64_t magnitudes[4];
+    alignas(32) std::int64_t negatives[4];
+    for (int lane = 0; lane < 4; ++lane) {
+        const unsigned int negative = static_cast<unsigned char>(digits[lane]) >> 7;
+        const auto value = static_cast<unsigned int>(digits[lane]);
+        magnitudes[lane] = (value - ((0U - negative) & (value << 1))) & 0xff;
+        negatives[lane] = -static_cast<std::int64_t>(negative);
+    }
+    const __m256i magnitude = _mm256_load_si256(reinterpret_cast<const __m256i*>(magnitudes));
+    const __m256i negative = _mm256_load_si256(reinterpret_cast<const __m256i*>(negatives));
+
+    const Fe4 one = fe4One();
+    Cachedx4 t{one, one, one, fe4Zero()};
+    for (int j = 0; j < 8; ++j) {
+        const __m256i match = _mm256_cmpeq_epi64(magnitude, _mm256_set1_epi64x(j + 1));
+        t = selectCached(t, table[j], match);
+    }
+    const Cachedx4 minus{t.YminusX, t.YplusX, t.Z, fe4Neg(t.T2d)};
+    return selectCached(t, minus, negative);
+}
+
+PSI_AVX2 void scalarMult4(const RecodedScalar* const scalars[4], const RistrettoElement* in,
+                          RistrettoElement* out) {
+    const Fe4 d2 = fe4FromFe51(kD2, kD2, kD2, kD2);
+    const P3x4 p{fe4FromFe51(in[0].X, in[1].X, in[2].X, in[3].X),
+                 fe4FromFe51(in[0].Y, in[1].Y, in[2].Y, in[3].Y),
+                 fe4FromFe51(in[0].Z, in[1].Z, in[2].Z, in[3].Z),
+                 fe4FromFe51(in[0].T, in[1].T, in[2].T, in[3].T)};
+
+    Cachedx4 table[8];
+    table[0] = toCached(p, d2);
+    const P3x4 p2 = toP3(dbl(p));
+    table[1] = toCached(p2, d2);
+    const P3x4 p3 = toP3(add(p, table[1]));
+    table[2] = toCached(p3, d2);
+    const P3x4 p4 = toP3(dbl(p2));
+    table[3] = toCached(p4, d2);
+    table[4] = toCached(toP3(add(p, table[3])), d2);
+    table[5] = toCached(toP3(dbl(p3)), d2);
+    table[6] = toCached(toP3(add(p, table[5])), d2);
+    table[7] = toCached(toP3(dbl(p4)), d2);
+
+    signed char digits[4];
+    const auto digitsAt = [&](int i) {
+        for (int lane = 0; lane < 4; ++lane) {
+            digits[lane] = scalars[lane]->digits[static_cast<std::size_t>(i)];
+        }
+        return digits;
+    };
+
+    const Fe4 one = fe4One();
+    P3x4 h{fe4Zero(), one, one, fe4Zero()};
+    for (int i = 63; i > 0; --i) {
+        P1P1x4 r = add(h, select(table, digitsAt(i)));
+        r = dbl(toP2(r));
+        r = dbl(toP2(r));
+        r = dbl(toP2(r));
+        r = dbl(toP2(r));
+        h = toP3(r);
+    }
+    h = toP3(add(h, select(table, digitsAt(0))));
+
+    Fe51* xs[4] = {&out[0].X, &out[1].X, &out[2].X, &out[3].X};
+    Fe51* ys[4] = {&out[0].Y, &out[1].Y, &out[2].Y, &out[3].Y};
+    Fe51* zs[4] = {&out[0].Z, &out[1].Z, &out[2].Z, &out[3].Z};
+    Fe51* ts[4] = {&out[0].T, &out[1].T, &out[2].T, &out[3].T};
+    fe4ToFe51(h.X, xs);
+    fe4ToFe51(h.Y, ys);
+    fe4ToFe51(h.Z, zs);
+    fe4ToFe51(h.T, ts);
+}
+
+}  // namespace
+
+void ristrettoScalarMult4Avx2(const RecodedScalar* const scalars[4], const RistrettoElement* in,
+                              RistrettoElement* out) {
+    scalarMult4(scalars, in, out);
+}
+
+#endif  // PSI_HAVE_X86_BACKENDS
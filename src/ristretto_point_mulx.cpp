@@ -0,0 +1,26 @@
+// The radix-2^51 ladders of ristretto_ladder.h and montgomery_ladder.h
+// compiled for BMI2/ADX. The
+// macro must come before any header that pulls in curve25519_fe51.h, so every
+// field and point function in this file gets the target attribute (and, with
+// internal linkage, stays a separate copy from the portable build).
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PSI_FE51_INLINE static inline __attribute__((target("bmi2,adx")))
+#endif
+
+#include "curve25519_backend.h"
+
+#if defined(PSI_HAVE_X86_BACKENDS)
+
+#include "montgomery_ladder.h"
+#include "ristretto_ladder.h"
+
+RistrettoElement ristrettoScalarMultMulx(const RecodedScalar& scalar,
+                                         const RistrettoElement& element) {
+    return ristretto_detail::geScalarMult(scalar.digits, element);
+}
+
+void x25519LadderMulx(const unsigned char scalar[32], const Fe51& u, Fe51& outU, Fe51& outW) {
+    montgomery_detail::montgomeryLadder(scalar, u, outU, outW);
+}
+
+#endif  // PSI_HAVE_X86_BACKENDS
@@ -6,6 +6,11 @@
 #include <limits>
 #include <sstream>
 #include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "base64_batch.h"
 
 extern "C" {
 #include <sodium.h>
@@ -26,37 +31,260 @@ void ensureSodiumInitLocal() {
 }  // namespace
 
 std::string base64Encode(const unsigned char* data, std::size_t size) {
-    ensureSodiumInitLocal();
-    if (size == 0) {
-        return {};
-    }
-    std::string encoded;
-    encoded.resize(sodium_base64_encoded_len(size, sodium_base64_VARIANT_URLSAFE_NO_PADDING));
-    sodium_bin2base64(encoded.data(), encoded.size(), data, size, sodium_base64_VARIANT_URLSAFE_NO_PADDING);
-    encoded.resize(std::strlen(encoded.c_str()));
+    std::string encoded(base64EncodedLength(size), '\0');
+    base64EncodeTo(data, size, encoded.data());
     return encoded;
 }
 
 std::string base64Encode(const std::vector<unsigned char>& data) {
-    ensureSodiumInitLocal();
     return base64Encode(data.data(), data.size());
 }
 
-std::vector<unsigned char> base64DecodeVector(const std::string& encoded) {
-    ensureSodiumInitLocal();
-    if (encoded.empty()) {
-        return {};
-    }
-    std::vector<unsigned char> decoded(encoded.size());  // upper bound
+namespace {
+
+// Decodes length characters into out, replacing its contents. False on
+// anything that is not canonical unpadded URL-safe base64.
+bool base64DecodeInto(const char* encoded, std::size_t length, std::vector<unsigned char>& out) {
+    out.resize(length);  // upper bound
     std::size_t actualSize = 0;
-    if (sodium_base642bin(decoded.data(), decoded.size(), encoded.c_str(), encoded.size(), nullptr, &actualSize, nullptr,
+    if (length != 0 &&
+        sodium_base642bin(out.data(), out.size(), encoded, length, nullptr, &actualSize, nullptr,
                           sodium_base64_VARIANT_URLSAFE_NO_PADDING) != 0) {
+        return false;
+    }
+    out.resize(actualSize);
+    return true;
+}
+
+}  // namespace
+
+std::vector<unsigned char> base64DecodeVector(const std::string& encoded) {
+    ensureSodiumInitLocal();
+    std::vector<unsigned char> decoded;
+    if (!base64DecodeInto(encoded.data(), encoded.size(), decoded)) {
         throw std::runtime_error("Failed to decode base64 data");
     }
-    decoded.resize(actualSize);
     return decoded;
 }
 
+const char* wireFormatName(WireFormat format) {
+    return format == WireFormat::Binary ? "binary" : "text";
+}
+
+WireFormat parseWireFormat(const std::string& name) {
+    for (const auto format : {WireFormat::Text, WireFormat::Binary}) {
+        if (name == wireFormatName(format)) {
+            return format;
+        }
+    }
+    throw std::runtime_error("Unknown wire format: " + name);
+}
+
+WireFormat messageWireFormat(const std::string& data) {
+    return !data.empty() && static_cast<unsigned char>(data[0]) == kBinaryWireMagic
+               ? WireFormat::Binary
+               : WireFormat::Text;
+}
+
+namespace {
+
+constexpr std::size_t kBinaryValueBytes = 32;
+// Text flights shorter than this many entries decode on the caller.
+constexpr std::size_t kParallelTextDecodeThreshold = 4096;
+// A text entry line: unpadded base64 of 32 bytes, then a newline.
+constexpr std::size_t kTextEntryChars = kBase64ValueChars;
+constexpr std::size_t kTextEntryLineBytes = kTextEntryChars + 1;
+
+std::size_t varintSize(std::uint64_t value) {
+    std::size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+unsigned char* writeVarint(unsigned char* out, std::uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = static_cast<unsigned char>(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<unsigned char>(value);
+    return out;
+}
+
+std::size_t binaryHeaderSize(bool withSuite, std::size_t count) {
+    return 2 + (withSuite ? 1 : 0) + varintSize(count);
+}
+
+unsigned char* writeBinaryHeader(unsigned char* out, char type, const CipherSuite* suite,
+                                 std::size_t count) {
+    *out++ = kBinaryWireMagic;
+    *out++ = static_cast<unsigned char>(type);
+    if (suite != nullptr) {
+        *out++ = static_cast<unsigned char>(*suite);
+    }
+    return writeVarint(out, count);
+}
+
+// Bounds-checked cursor over a binary flight.
+class BinaryReader {
+public:
+    explicit BinaryReader(const std::string& data)
+        : next_(reinterpret_cast<const unsigned char*>(data.data())), end_(next_ + data.size()) {}
+
+    std::size_t remaining() const { return static_cast<std::size_t>(end_ - next_); }
+
+    const unsigned char* take(std::size_t size) {
+        if (remaining() < size) {
+            throw std::runtime_error("Unexpected end of message");
+        }
+        const unsigned char* taken = next_;
+        next_ += size;
+        return taken;
+    }
+
+    unsigned char byte() { return *take(1); }
+
+    // Shortest-form LEB128 only, so every value has one encoding.
+    std::uint64_t varint(const char* what) {
+        std::uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            const unsigned char b = byte();
+            const std::uint64_t bits = b & 0x7f;
+            if (shift == 63 && bits > 1) {
+                break;
+            }
+            value |= bits << shift;
+            if ((b & 0x80) == 0) {
+                if (b == 0 && shift != 0) {
+                    break;
+                }
+                return value;
+            }
+        }
+        throw std::runtime_error(std::string("Invalid ") + what + " in binary message");
+    }
+
+    void expectEnd() const {
+        if (next_ != end_) {
+            throw std::runtime_error("Trailing bytes after binary message");
+        }
+    }
+
+private:
+    const unsigned char* next_;
+    const unsigned char* end_;
+};
+
+CipherSuite readBinarySuite(BinaryReader& reader) {
+    const unsigned char id = reader.byte();
+    for (const auto suite : kCipherSuites) {
+        if (id == static_cast<unsigned char>(suite)) {
+            return suite;
+        }
+    }
+    throw std::runtime_error("Unsupported ciphersuite in message header: id " +
+                             std::to_string(id));
+}
+
+// Reads magic, type and (for flights that open an exchange) the suite, and
+// returns the count. minEntryBytes bounds the count by the bytes left, so a
+// forged count cannot force a large allocation.
+std::size_t readBinaryHeader(BinaryReader& reader, char expected, CipherSuite* suite,
+                             bool withSuite, std::size_t minEntryBytes) {
+    if (reader.byte() != kBinaryWireMagic || reader.byte() != static_cast<unsigned char>(expected)) {
+        throw std::runtime_error("Invalid message header");
+    }
+    CipherSuite parsed = CipherSuite::V1;
+    if (withSuite) {
+        parsed = readBinarySuite(reader);
+    }
+    const std::uint64_t count = reader.varint("message count");
+    if (count > reader.remaining() / minEntryBytes) {
+        throw std::runtime_error("Binary message is shorter than its count");
+    }
+    if (suite != nullptr) {
+        *suite = parsed;
+    }
+    return static_cast<std::size_t>(count);
+}
+
+// A binary T, A or R flight: the header, then the batch's buffer as is.
+std::string serializeBinaryFixed(char type, const CipherSuite* suite, const PointBatch& batch) {
+    std::string out(binaryHeaderSize(suite != nullptr, batch.size()) + batch.byteSize(), '\0');
+    auto* cursor = reinterpret_cast<unsigned char*>(out.data());
+    cursor = writeBinaryHeader(cursor, type, suite, batch.size());
+    if (!batch.empty()) {
+        std::memcpy(cursor, batch.bytes(), batch.byteSize());
+    }
+    return out;
+}
+
+// B and I flights differ only in I's per-element locator, which leads each
+// entry; these templates write and read both.
+template <typename UnitT>
+inline constexpr bool kIndexedUnit = std::is_same_v<UnitT, IndexedEncryptedUnit>;
+
+template <typename UnitT>
+inline constexpr char kEncryptedFlightType = kIndexedUnit<UnitT> ? 'I' : 'B';
+
+template <typename UnitT>
+std::string serializeEncryptedBinary(const std::vector<UnitT>& units, CipherSuite suite) {
+    std::size_t size = binaryHeaderSize(true, units.size());
+    for (const auto& unit : units) {
+        size += unit.ciphertext.nonce.size() + varintSize(unit.ciphertext.ciphertext.size()) +
+                unit.ciphertext.ciphertext.size();
+        if constexpr (kIndexedUnit<UnitT>) {
+            size += kLocatorBytes;
+        }
+    }
+    std::string out(size, '\0');
+    auto* cursor = reinterpret_cast<unsigned char*>(out.data());
+    cursor = writeBinaryHeader(cursor, kEncryptedFlightType<UnitT>, &suite, units.size());
+    for (const auto& unit : units) {
+        if constexpr (kIndexedUnit<UnitT>) {
+            std::memcpy(cursor, unit.locator.data(), kLocatorBytes);
+            cursor += kLocatorBytes;
+        }
+        const auto& payload = unit.ciphertext;
+        std::memcpy(cursor, payload.nonce.data(), payload.nonce.size());
+        cursor = writeVarint(cursor + payload.nonce.size(), payload.ciphertext.size());
+        if (!payload.ciphertext.empty()) {
+            std::memcpy(cursor, payload.ciphertext.data(), payload.ciphertext.size());
+            cursor += payload.ciphertext.size();
+        }
+    }
+    return out;
+}
+
+template <typename UnitT>
+std::vector<UnitT> deserializeEncryptedBinary(const std::string& data, CipherSuite* suite) {
+    constexpr std::size_t locatorBytes = kIndexedUnit<UnitT> ? kLocatorBytes : 0;
+    BinaryReader reader(data);
+    const std::size_t count = readBinaryHeader(reader, kEncryptedFlightType<UnitT>, suite, true,
+                                               locatorBytes + crypto_secretbox_NONCEBYTES + 1);
+    std::vector<UnitT> units(count);
+    for (auto& unit : units) {
+        if constexpr (kIndexedUnit<UnitT>) {
+            const unsigned char* locator = reader.take(kLocatorBytes);
+            std::copy(locator, locator + kLocatorBytes, unit.locator.begin());
+        }
+        const unsigned char* nonce = reader.take(crypto_secretbox_NONCEBYTES);
+        std::copy(nonce, nonce + crypto_secretbox_NONCEBYTES, unit.ciphertext.nonce.begin());
+        const std::uint64_t length = reader.varint("ciphertext length");
+        if (length > reader.remaining()) {
+            throw std::runtime_error("Unexpected end of message");
+        }
+        const unsigned char* ciphertext = reader.take(static_cast<std::size_t>(length));
+        unit.ciphertext.ciphertext.assign(ciphertext, ciphertext + length);
+    }
+    reader.expectEnd();
+    return units;
+}
+
+}  // namespace
+
 void expectHeader(std::istringstream& stream, char expected) {
     char header;
     if (!(stream >> header) || header != expected) {
@@ -73,161 +301,467 @@ std::size_t readCount(std::istringstream& stream) {
     return count;
 }
 
-std::string readLine(std::istringstream& stream) {
-    std::string line;
-    if (!std::getline(stream, line)) {
+// The rest of the header line of a flight that opens an exchange: the
+// optional ciphersuite token, absent for v1.
+void readSuiteToken(std::istringstream& stream, CipherSuite* suite) {
+    std::string rest;
+    std::getline(stream, rest);
+    std::istringstream tokens(rest);
+    std::string token;
+    std::string extra;
+    CipherSuite parsed = CipherSuite::V1;
+    if (tokens >> token) {
+        if (tokens >> extra) {
+            throw std::runtime_error("Invalid message header");
+        }
+        try {
+            parsed = parseCipherSuite(token);
+        } catch (const std::runtime_error&) {
+            throw std::runtime_error("Unsupported ciphersuite in message header: " + token);
+        }
+    }
+    if (suite != nullptr) {
+        *suite = parsed;
+    }
+}
+
+// readCount for flights that open an exchange.
+std::size_t readCountAndSuite(std::istringstream& stream, CipherSuite* suite) {
+    std::size_t count = 0;
+    if (!(stream >> count)) {
+        throw std::runtime_error("Invalid message count");
+    }
+    readSuiteToken(stream, suite);
+    return count;
+}
+
+namespace {
+
+// Parses a text flight's header line, stores the count (and suite, for
+// flights that open an exchange) and returns the offset of the first body
+// line.
+std::size_t readTextHeader(const std::string& data, char type, CipherSuite* suite,
+                           bool withSuite, std::size_t& count) {
+    const std::size_t headerEnd = data.find('\n');
+    if (headerEnd == std::string::npos) {
         throw std::runtime_error("Unexpected end of message");
     }
-    return line;
+    std::istringstream header(data.substr(0, headerEnd + 1));
+    expectHeader(header, type);
+    count = withSuite ? readCountAndSuite(header, suite) : readCount(header);
+    return headerEnd + 1;
+}
+
+[[noreturn]] void throwMalformedLine(std::size_t line, const char* what) {
+    throw std::runtime_error("Malformed line " + std::to_string(line) + " of message: " + what);
+}
+
+// Text decoding costs tens of nanoseconds per line, far less than the group
+// operations the policy's serial cutoffs are tuned for, so short flights
+// stay on the caller.
+ExecutionPolicy textDecodePolicy(const ExecutionPolicy* policy) {
+    ExecutionPolicy decode = resolveExecutionPolicy(policy);
+    decode.serialThreshold = std::max(decode.serialThreshold, kParallelTextDecodeThreshold);
+    return decode;
+}
+
+}  // namespace
+
+// v1 headers carry no suite token, so v1 flights are byte-identical to the
+// ones written before ciphersuites existed.
+std::string textHeader(char header, std::size_t count, CipherSuite suite) {
+    std::string line = std::string(1, header) + " " + std::to_string(count);
+    if (suite != CipherSuite::V1) {
+        line += std::string(" ") + cipherSuiteName(suite);
+    }
+    return line + "\n";
 }
 
 template <typename Writer>
-std::string serializeGeneric(char header, const Writer& writer, std::size_t count) {
+std::string serializeGeneric(char header, const Writer& writer, std::size_t count,
+                             CipherSuite suite = CipherSuite::V1) {
     std::ostringstream oss;
-    oss << header << " " << count << "\n";
+    oss << textHeader(header, count, suite);
     writer(oss);
     return oss.str();
 }
 
-std::string serializeBobEncryptedMessage(const std::vector<EncryptedUnit>& units) {
+namespace {
+
+template <typename UnitT>
+std::string serializeEncrypted(const std::vector<UnitT>& units, CipherSuite suite,
+                               WireFormat format) {
+    if (format == WireFormat::Binary) {
+        return serializeEncryptedBinary(units, suite);
+    }
     ensureSodiumInitLocal();
     auto writer = [&units](std::ostringstream& oss) {
         for (const auto& unit : units) {
+            if constexpr (kIndexedUnit<UnitT>) {
+                oss << base64Encode(unit.locator) << "\n";
+            }
             oss << base64Encode(unit.ciphertext.ciphertext) << "\n";
             oss << base64Encode(unit.ciphertext.nonce) << "\n";
         }
     };
-    return serializeGeneric('B', writer, units.size());
+    return serializeGeneric(kEncryptedFlightType<UnitT>, writer, units.size(), suite);
 }
 
-std::vector<EncryptedUnit> deserializeBobEncryptedMessage(const std::string& data) {
+template <typename UnitT>
+std::vector<UnitT> deserializeEncrypted(const std::string& data, CipherSuite* suite,
+                                        const ExecutionPolicy* policy) {
+    if (messageWireFormat(data) == WireFormat::Binary) {
+        return deserializeEncryptedBinary<UnitT>(data, suite);
+    }
     ensureSodiumInitLocal();
-    std::istringstream stream(data);
-    expectHeader(stream, 'B');
-    const std::size_t count = readCount(stream);
-    std::vector<EncryptedUnit> units;
-    units.reserve(count);
-    for (std::size_t i = 0; i < count; ++i) {
-        const std::string ciphertextB64 = readLine(stream);
-        const std::string nonceB64 = readLine(stream);
+    std::size_t count = 0;
+    const std::size_t bodyOffset =
+        readTextHeader(data, kEncryptedFlightType<UnitT>, suite, true, count);
 
-        SecretBoxCiphertext payload;
-        payload.ciphertext = base64DecodeVector(ciphertextB64);
-        auto nonceVec = base64DecodeVector(nonceB64);
-        if (nonceVec.size() != crypto_secretbox_NONCEBYTES) {
-            throw std::runtime_error("Invalid nonce length in message");
+    // Split the body into lines once: unit i is lines k*i + 1 .. k*i + k,
+    // its locator (I only), ciphertext and nonce. Each line holds at least
+    // its newline, which bounds the count before anything is allocated for
+    // it.
+    constexpr std::size_t linesPerUnit = kIndexedUnit<UnitT> ? 3 : 2;
+    if (count > (data.size() - bodyOffset) / linesPerUnit) {
+        throw std::runtime_error("Unexpected end of message");
+    }
+    std::vector<std::size_t> lineStarts(linesPerUnit * count + 1);
+    lineStarts[0] = bodyOffset;
+    for (std::size_t line = 0; line < linesPerUnit * count; ++line) {
+        const std::size_t newline = data.find('\n', lineStarts[line]);
+        if (newline == std::string::npos) {
+            throw std::runtime_error("Unexpected end of message");
         }
-        std::copy(nonceVec.begin(), nonceVec.end(), payload.nonce.begin());
-        units.push_back({std::move(payload)});
+        lineStarts[line + 1] = newline + 1;
     }
+    if (lineStarts.back() != data.size()) {
+        throw std::runtime_error("Trailing data after message");
+    }
+
+    std::vector<UnitT> units(count);
+    parallelForChunks(textDecodePolicy(policy), count, [&](std::size_t begin, std::size_t end) {
+        std::vector<unsigned char> field;
+        auto decodeLine = [&](std::size_t line, std::vector<unsigned char>& out) {
+            const char* text = data.data() + lineStarts[line];
+            return base64DecodeInto(text, lineStarts[line + 1] - lineStarts[line] - 1, out);
+        };
+        for (std::size_t i = begin; i < end; ++i) {
+            std::size_t line = linesPerUnit * i;
+            if constexpr (kIndexedUnit<UnitT>) {
+                if (!decodeLine(line, field) || field.size() != kLocatorBytes) {
+                    throwMalformedLine(line + 1, "invalid locator");
+                }
+                std::copy(field.begin(), field.end(), units[i].locator.begin());
+                ++line;
+            }
+            if (!decodeLine(line, units[i].ciphertext.ciphertext)) {
+                throwMalformedLine(line + 1, "invalid base64");
+            }
+            if (!decodeLine(line + 1, field) || field.size() != crypto_secretbox_NONCEBYTES) {
+                throwMalformedLine(line + 2, "invalid nonce");
+            }
+            std::copy(field.begin(), field.end(), units[i].ciphertext.nonce.begin());
+        }
+    });
     return units;
 }
 
-std::string serializeAliceBlindedMessage(const std::vector<AliceSentValue>& values) {
-    ensureSodiumInitLocal();
-    auto writer = [&values](std::ostringstream& oss) {
-        for (const auto& value : values) {
-            oss << base64Encode(value.blindedPointEncoded) << "\n";
-        }
-    };
-    return serializeGeneric('A', writer, values.size());
+}  // namespace
+
+std::string serializeBobEncryptedMessage(const std::vector<EncryptedUnit>& units,
+                                        CipherSuite suite, WireFormat format) {
+    return serializeEncrypted(units, suite, format);
 }
 
-std::vector<AliceSentValue> deserializeAliceBlindedMessage(const std::string& data) {
-    ensureSodiumInitLocal();
-    std::istringstream stream(data);
-    expectHeader(stream, 'A');
-    const std::size_t count = readCount(stream);
-    std::vector<AliceSentValue> values;
-    values.reserve(count);
-    for (std::size_t i = 0; i < count; ++i) {
-        AliceSentValue value;
-        const std::string encodedPoint = readLine(stream);
-        value.blindedPointEncoded = base64DecodeVector(encodedPoint);
-        values.push_back(std::move(value));
+std::vector<EncryptedUnit> deserializeBobEncryptedMessage(const std::string& data,
+                                                          CipherSuite* suite,
+                                                          const ExecutionPolicy* policy) {
+    return deserializeEncrypted<EncryptedUnit>(data, suite, policy);
+}
+
+std::string serializeBobIndexedMessage(const std::vector<IndexedEncryptedUnit>& units,
+                                       CipherSuite suite, WireFormat format) {
+    return serializeEncrypted(units, suite, format);
+}
+
+std::vector<IndexedEncryptedUnit> deserializeBobIndexedMessage(const std::string& data,
+                                                               CipherSuite* suite,
+                                                               const ExecutionPolicy* policy) {
+    return deserializeEncrypted<IndexedEncryptedUnit>(data, suite, policy);
+}
+
+namespace {
+
+// Text A, R and T flights: one base64 line per 32-byte entry.
+// The whole flight is sized up front and the entries are encoded straight
+// into it (base64_batch.h).
+std::string serializeTextBatch(char header, const PointBatch& batch,
+                               CipherSuite suite = CipherSuite::V1) {
+    std::string out = textHeader(header, batch.size(), suite);
+    const std::size_t bodyOffset = out.size();
+    out.resize(bodyOffset + batch.size() * kTextEntryLineBytes, '\n');
+    base64EncodeBatch32(batch.bytes(), batch.size(), out.data() + bodyOffset,
+                        kTextEntryLineBytes);
+    return out;
+}
+
+}  // namespace
+
+std::string serializeAliceBlindedMessage(const PointBatch& points, WireFormat format) {
+    if (format == WireFormat::Binary) {
+        return serializeBinaryFixed('A', nullptr, points);
     }
-    return values;
+    return serializeTextBatch('A', points);
 }
 
-std::string serializeBobTransformedMessage(const std::vector<BobTransformedValue>& values) {
-    ensureSodiumInitLocal();
-    auto writer = [&values](std::ostringstream& oss) {
-        for (const auto& value : values) {
-            oss << base64Encode(value.transformedPointEncoded) << "\n";
-        }
-    };
-    return serializeGeneric('R', writer, values.size());
+PointBatch deserializeAliceBlindedMessage(const std::string& data,
+                                          const ExecutionPolicy* policy) {
+    return viewAliceBlindedMessage(data).toBatch(policy);
 }
 
-std::vector<BobTransformedValue> deserializeBobTransformedMessage(const std::string& data) {
-    ensureSodiumInitLocal();
-    std::istringstream stream(data);
-    expectHeader(stream, 'R');
-    const std::size_t count = readCount(stream);
-    std::vector<BobTransformedValue> values;
-    values.reserve(count);
-    for (std::size_t i = 0; i < count; ++i) {
-        BobTransformedValue value;
-        const std::string encodedPoint = readLine(stream);
-        value.transformedPointEncoded = base64DecodeVector(encodedPoint);
-        values.push_back(std::move(value));
+std::string serializeBobTransformedMessage(const PointBatch& points, WireFormat format) {
+    if (format == WireFormat::Binary) {
+        return serializeBinaryFixed('R', nullptr, points);
     }
-    return values;
+    return serializeTextBatch('R', points);
 }
 
-std::string serializeBobTagMessage(const std::vector<std::array<unsigned char, 32>>& tags) {
-    ensureSodiumInitLocal();
-    auto writer = [&tags](std::ostringstream& oss) {
-        for (const auto& tag : tags) {
-            oss << base64Encode(tag) << "\n";
+PointBatch deserializeBobTransformedMessage(const std::string& data,
+                                            const ExecutionPolicy* policy) {
+    return viewBobTransformedMessage(data).toBatch(policy);
+}
+
+char messageType(const std::string& data) {
+    const std::size_t at = messageWireFormat(data) == WireFormat::Binary ? 1 : 0;
+    if (data.size() <= at) {
+        throw std::runtime_error("Unexpected end of message");
+    }
+    return data[at];
+}
+
+namespace {
+
+// The header line of a text F flight, "F <count> <bits> <buckets>[ <suite>]";
+// returns the offset of the table line.
+std::size_t readTagFilterTextHeader(const std::string& data, CipherSuite* suite,
+                                    std::size_t& count, std::size_t& fingerprintBits,
+                                    std::size_t& buckets) {
+    const std::size_t headerEnd = data.find('\n');
+    if (headerEnd == std::string::npos) {
+        throw std::runtime_error("Unexpected end of message");
+    }
+    std::istringstream header(data.substr(0, headerEnd + 1));
+    expectHeader(header, 'F');
+    if (!(header >> count >> fingerprintBits >> buckets)) {
+        throw std::runtime_error("Invalid tag filter header");
+    }
+    readSuiteToken(header, suite);
+    return headerEnd + 1;
+}
+
+std::size_t tagFilterFingerprintBytesFromBits(std::size_t bits) {
+    if (bits % 8 != 0 || bits == 0 || bits > 8 * kTagFilterMaxFingerprintBytes) {
+        throw std::runtime_error("Invalid tag filter fingerprint width");
+    }
+    return bits / 8;
+}
+
+}  // namespace
+
+CipherSuite messageCipherSuite(const std::string& data) {
+    if (messageWireFormat(data) == WireFormat::Binary) {
+        BinaryReader reader(data);
+        reader.byte();
+        const unsigned char type = reader.byte();
+        if (type != 'B' && type != 'I' && type != 'T' && type != 'F') {
+            throw std::runtime_error("Invalid message header");
         }
-    };
-    return serializeGeneric('T', writer, tags.size());
+        return readBinarySuite(reader);
+    }
+    CipherSuite suite = CipherSuite::V1;
+    if (!data.empty() && data[0] == 'F') {
+        std::size_t count, bits, buckets;
+        readTagFilterTextHeader(data, &suite, count, bits, buckets);
+        return suite;
+    }
+    std::istringstream stream(data);
+    char header;
+    if (!(stream >> header) || (header != 'B' && header != 'I' && header != 'T')) {
+        throw std::runtime_error("Invalid message header");
+    }
+    readCountAndSuite(stream, &suite);
+    return suite;
 }
 
-std::vector<std::array<unsigned char, 32>> deserializeBobTagMessage(const std::string& data) {
+std::string serializeBobTagMessage(const TagBatch& tags, CipherSuite suite, WireFormat format) {
+    if (format == WireFormat::Binary) {
+        return serializeBinaryFixed('T', &suite, tags);
+    }
+    return serializeTextBatch('T', tags, suite);
+}
+
+TagBatch deserializeBobTagMessage(const std::string& data, CipherSuite* suite,
+                                  const ExecutionPolicy* policy) {
+    const FlightView view = viewBobTagMessage(data);
+    if (suite != nullptr) {
+        *suite = view.suite();
+    }
+    return view.toBatch(policy);
+}
+
+std::string serializeBobTagFilterMessage(const TagFilter& filter, std::size_t count,
+                                         CipherSuite suite, WireFormat format) {
+    const std::size_t bits = 8 * filter.fingerprintBytes();
+    const auto& table = filter.table();
+    if (format == WireFormat::Binary) {
+        std::string out(binaryHeaderSize(true, count) + 1 + varintSize(filter.bucketCount()) +
+                            table.size(),
+                        '\0');
+        auto* cursor = reinterpret_cast<unsigned char*>(out.data());
+        cursor = writeBinaryHeader(cursor, 'F', &suite, count);
+        *cursor++ = static_cast<unsigned char>(bits);
+        cursor = writeVarint(cursor, filter.bucketCount());
+        std::memcpy(cursor, table.data(), table.size());
+        return out;
+    }
+    std::string header = "F " + std::to_string(count) + " " + std::to_string(bits) + " " +
+                         std::to_string(filter.bucketCount());
+    if (suite != CipherSuite::V1) {
+        header += std::string(" ") + cipherSuiteName(suite);
+    }
+    return header + "\n" + base64Encode(table) + "\n";
+}
+
+// Either encoding: the table must be exactly bucketCount buckets of the
+// stated width.
+TagFilter deserializeBobTagFilterMessage(const std::string& data, CipherSuite* suite,
+                                         std::size_t* count) {
     ensureSodiumInitLocal();
-    std::istringstream stream(data);
-    expectHeader(stream, 'T');
-    const std::size_t count = readCount(stream);
-    std::vector<std::array<unsigned char, 32>> tags;
-    tags.reserve(count);
-    for (std::size_t i = 0; i < count; ++i) {
-        tags.push_back(base64DecodeArray<32>(readLine(stream)));
+    std::size_t tags = 0;
+    std::size_t fingerprintBytes = 0;
+    std::size_t buckets = 0;
+    std::vector<unsigned char> table;
+    if (messageWireFormat(data) == WireFormat::Binary) {
+        BinaryReader reader(data);
+        if (reader.byte() != kBinaryWireMagic || reader.byte() != 'F') {
+            throw std::runtime_error("Invalid message header");
+        }
+        const CipherSuite parsed = readBinarySuite(reader);
+        tags = static_cast<std::size_t>(reader.varint("message count"));
+        fingerprintBytes = tagFilterFingerprintBytesFromBits(reader.byte());
+        const std::uint64_t bucketCount = reader.varint("bucket count");
+        if (bucketCount > reader.remaining() / (kTagFilterBucketSlots * fingerprintBytes)) {
+            throw std::runtime_error("Binary message is shorter than its bucket count");
+        }
+        buckets = static_cast<std::size_t>(bucketCount);
+        const unsigned char* bytes = reader.take(buckets * kTagFilterBucketSlots * fingerprintBytes);
+        reader.expectEnd();
+        table.assign(bytes, bytes + buckets * kTagFilterBucketSlots * fingerprintBytes);
+        if (suite != nullptr) {
+            *suite = parsed;
+        }
+    } else {
+        std::size_t bits = 0;
+        const std::size_t bodyOffset = readTagFilterTextHeader(data, suite, tags, bits, buckets);
+        fingerprintBytes = tagFilterFingerprintBytesFromBits(bits);
+        if (data.size() == bodyOffset || data.back() != '\n' ||
+            data.find('\n', bodyOffset) != data.size() - 1) {
+            throw std::runtime_error("Tag filter table must be one line");
+        }
+        if (!base64DecodeInto(data.data() + bodyOffset, data.size() - bodyOffset - 1, table)) {
+            throwMalformedLine(1, "invalid base64");
+        }
     }
-    return tags;
+    if (count != nullptr) {
+        *count = tags;
+    }
+    return TagFilter(fingerprintBytes, buckets, std::move(table));
 }
 
-namespace {
+// Text framing: a header line, then exactly one 43-character line per entry,
+// each ending in a newline, and nothing after the last one.
+FlightView::FlightView(const std::string& data, char type) {
+    const bool withSuite = type == 'T';
+    format_ = messageWireFormat(data);
+    if (format_ == WireFormat::Binary) {
+        BinaryReader reader(data);
+        count_ = readBinaryHeader(reader, type, &suite_, withSuite, kBinaryValueBytes);
+        body_ = reinterpret_cast<const char*>(reader.take(count_ * kBinaryValueBytes));
+        reader.expectEnd();
+        return;
+    }
 
-std::string escapeJson(const std::string& input) {
-    std::string output;
-    output.reserve(input.size());
-    for (char c : input) {
-        switch (c) {
-            case '"':
-                output += "\\\"";
-                break;
-            case '\\':
-                output += "\\\\";
-                break;
-            case '\n':
-                output += "\\n";
-                break;
-            case '\r':
-                output += "\\r";
-                break;
-            case '\t':
-                output += "\\t";
-                break;
-            default:
-                output += c;
-                break;
+    const std::size_t bodyOffset = readTextHeader(data, type, &suite_, withSuite, count_);
+    const std::size_t bodySize = data.size() - bodyOffset;
+    if (count_ > bodySize / kTextEntryLineBytes) {
+        throw std::runtime_error("Unexpected end of message");
+    }
+    body_ = data.data() + bodyOffset;
+    for (std::size_t i = 0; i < count_; ++i) {
+        if (body_[i * kTextEntryLineBytes + kTextEntryChars] != '\n') {
+            throwMalformedLine(i + 1, "not a 32-byte entry");
         }
     }
-    return output;
+    if (bodySize != count_ * kTextEntryLineBytes) {
+        throw std::runtime_error("Trailing data after message");
+    }
+}
+
+const FlightView::Entry* FlightView::entries(std::size_t begin, std::size_t end,
+                                             std::vector<Entry>& scratch) const {
+    static_assert(sizeof(Entry) == kBinaryValueBytes && alignof(Entry) == 1,
+                  "binary entries are read in place");
+    if (format_ == WireFormat::Binary) {
+        return reinterpret_cast<const Entry*>(body_) + begin;
+    }
+    scratch.resize(end - begin);
+    decodeText(begin, end, scratch.data());
+    return scratch.data();
+}
+
+PointBatch FlightView::toBatch(const ExecutionPolicy* policy) const {
+    PointBatch batch(count_);
+    if (count_ == 0) {
+        return batch;
+    }
+    if (format_ == WireFormat::Binary) {
+        std::memcpy(batch.bytes(), body_, batch.byteSize());
+    } else {
+        parallelForChunks(textDecodePolicy(policy), count_,
+                          [&](std::size_t begin, std::size_t end) {
+                              decodeText(begin, end, batch.data() + begin);
+                          });
+    }
+    return batch;
+}
+
+void FlightView::decodeText(std::size_t begin, std::size_t end, Entry* out) const {
+    const std::size_t decoded =
+        base64DecodeBatch32(body_ + begin * kTextEntryLineBytes, kTextEntryLineBytes,
+                            end - begin, out->data());
+    if (decoded != end - begin) {
+        throwMalformedLine(begin + decoded + 1, "not a 32-byte entry");
+    }
+}
+
+FlightView viewAliceBlindedMessage(const std::string& data) {
+    ensureSodiumInitLocal();
+    return FlightView(data, 'A');
+}
+
+FlightView viewBobTransformedMessage(const std::string& data) {
+    ensureSodiumInitLocal();
+    return FlightView(data, 'R');
+}
+
+FlightView viewBobTagMessage(const std::string& data) {
+    ensureSodiumInitLocal();
+    return FlightView(data, 'T');
 }
 
+namespace {
+
 std::string trim(const std::string& input) {
     std::size_t start = 0;
     while (start < input.size() && std::isspace(static_cast<unsigned char>(input[start]))) {
@@ -300,23 +834,18 @@ std::string extractJsonValue(const std::string& object, const std::string& key)
     throw std::runtime_error("Unterminated JSON string value");
 }
 
-std::string wrapJsonArray(const std::vector<std::string>& objects) {
-    std::ostringstream oss;
-    oss << "{\"items\":[";
-    for (std::size_t i = 0; i < objects.size(); ++i) {
-        if (i > 0) {
-            oss << ',';
-        }
-        oss << objects[i];
-    }
-    oss << "]}";
-    return oss.str();
+constexpr std::string_view kJsonItemsOpen = "{\"items\":[";
+constexpr std::string_view kJsonItemsClose = "]}";
+
+// The {"items":[...]} wrapper and the commas between count items.
+std::size_t jsonItemsSize(std::size_t count) {
+    return kJsonItemsOpen.size() + (count > 0 ? count - 1 : 0) + kJsonItemsClose.size();
 }
 
 std::vector<std::string> unwrapJsonArray(const std::string& json) {
     auto trimmed = trim(json);
-    const std::string prefix = "{\"items\":[";
-    const std::string suffix = "]}";
+    const std::string_view prefix = kJsonItemsOpen;
+    const std::string_view suffix = kJsonItemsClose;
     if (trimmed.rfind(prefix, 0) != 0 || trimmed.size() < prefix.size() + suffix.size()) {
         throw std::runtime_error("Invalid JSON message format");
     }
@@ -328,18 +857,50 @@ std::vector<std::string> unwrapJsonArray(const std::string& json) {
     return splitJsonObjects(inner);
 }
 
+// {"ciphertext":"<base64>","nonce":"<base64>"}; base64 never needs escaping.
+constexpr std::string_view kJsonCiphertextOpen = "{\"ciphertext\":\"";
+constexpr std::string_view kJsonNonceOpen = "\",\"nonce\":\"";
+constexpr std::string_view kJsonStringItemClose = "\"}";
+
+std::size_t encryptedUnitJsonSize(const EncryptedUnit& unit) {
+    return kJsonCiphertextOpen.size() + base64EncodedLength(unit.ciphertext.ciphertext.size()) +
+           kJsonNonceOpen.size() + base64EncodedLength(unit.ciphertext.nonce.size()) +
+           kJsonStringItemClose.size();
+}
+
 }  // namespace
 
-std::string serializeBobEncryptedMessageJson(const std::vector<EncryptedUnit>& units) {
-    std::vector<std::string> objects;
-    objects.reserve(units.size());
+std::size_t bobEncryptedMessageJsonSize(const std::vector<EncryptedUnit>& units) {
+    std::size_t size = jsonItemsSize(units.size());
     for (const auto& unit : units) {
-        std::ostringstream oss;
-        oss << "{\"ciphertext\":\"" << escapeJson(base64Encode(unit.ciphertext.ciphertext))
-            << "\",\"nonce\":\"" << escapeJson(base64Encode(unit.ciphertext.nonce)) << "\"}";
-        objects.push_back(oss.str());
+        size += encryptedUnitJsonSize(unit);
+    }
+    return size;
+}
+
+void writeBobEncryptedMessageJson(JsonWriter& writer, const std::vector<EncryptedUnit>& units) {
+    writer.raw(kJsonItemsOpen);
+    for (std::size_t i = 0; i < units.size(); ++i) {
+        const auto& ciphertext = units[i].ciphertext;
+        char* out = writer.extend((i > 0 ? 1 : 0) + encryptedUnitJsonSize(units[i]));
+        if (i > 0) {
+            *out++ = ',';
+        }
+        out = std::copy(kJsonCiphertextOpen.begin(), kJsonCiphertextOpen.end(), out);
+        base64EncodeTo(ciphertext.ciphertext.data(), ciphertext.ciphertext.size(), out);
+        out += base64EncodedLength(ciphertext.ciphertext.size());
+        out = std::copy(kJsonNonceOpen.begin(), kJsonNonceOpen.end(), out);
+        base64EncodeTo(ciphertext.nonce.data(), ciphertext.nonce.size(), out);
+        out += base64EncodedLength(ciphertext.nonce.size());
+        std::copy(kJsonStringItemClose.begin(), kJsonStringItemClose.end(), out);
     }
-    return wrapJsonArray(objects);
+    writer.raw(kJsonItemsClose);
+}
+
+std::string serializeBobEncryptedMessageJson(const std::vector<EncryptedUnit>& units) {
+    JsonWriter writer(bobEncryptedMessageJsonSize(units));
+    writeBobEncryptedMessageJson(writer, units);
+    return writer.take();
 }
 
 std::vector<EncryptedUnit> deserializeBobEncryptedMessageJson(const std::string& json) {
@@ -361,71 +922,113 @@ std::vector<EncryptedUnit> deserializeBobEncryptedMessageJson(const std::string&
     return units;
 }
 
-std::string serializeAliceBlindedMessageJson(const std::vector<AliceSentValue>& values) {
-    std::vector<std::string> objects;
-    objects.reserve(values.size());
-    for (const auto& value : values) {
-        std::ostringstream oss;
-        oss << "{\"blindedPoint\":\"" << escapeJson(base64Encode(value.blindedPointEncoded)) << "\"}";
-        objects.push_back(oss.str());
-    }
-    return wrapJsonArray(objects);
+namespace {
+
+// {"<field>":"<base64>"} for one batch entry.
+std::size_t batchItemJsonSize(std::string_view field) {
+    return 2 + field.size() + 3 + kBase64ValueChars + kJsonStringItemClose.size();
 }
 
-std::vector<AliceSentValue> deserializeAliceBlindedMessageJson(const std::string& json) {
-    auto objects = unwrapJsonArray(json);
-    std::vector<AliceSentValue> values;
-    values.reserve(objects.size());
-    for (const auto& obj : objects) {
-        AliceSentValue value;
-        auto encoded = extractJsonValue(obj, "blindedPoint");
-        value.blindedPointEncoded = base64DecodeVector(encoded);
-        values.push_back(std::move(value));
-    }
-    return values;
+std::size_t batchJsonSize(const PointBatch& batch, std::string_view field) {
+    return jsonItemsSize(batch.size()) + batch.size() * batchItemJsonSize(field);
 }
 
-std::string serializeBobTagMessageJson(const std::vector<std::array<unsigned char, 32>>& tags) {
-    std::vector<std::string> objects;
-    objects.reserve(tags.size());
-    for (const auto& tag : tags) {
-        std::ostringstream oss;
-        oss << "{\"tag\":\"" << escapeJson(base64Encode(tag)) << "\"}";
-        objects.push_back(oss.str());
+// A JSON array of {"<field>":"<base64>"} objects, one per batch entry. Every
+// item is laid out around a blank value first, then all values are encoded in
+// one batched pass straight into the writer.
+void writeBatchJson(JsonWriter& writer, const PointBatch& batch, std::string_view field) {
+    writer.raw(kJsonItemsOpen);
+    if (!batch.empty()) {
+        const std::size_t stride = batchItemJsonSize(field) + 1;
+        const std::size_t valueOffset = 2 + field.size() + 3;
+        char* items = writer.extend(batch.size() * stride - 1);
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            char* out = items + i * stride;
+            if (i > 0) {
+                out[-1] = ',';
+            }
+            *out++ = '{';
+            *out++ = '"';
+            out = std::copy(field.begin(), field.end(), out);
+            *out++ = '"';
+            *out++ = ':';
+            *out++ = '"';
+            out += kBase64ValueChars;
+            std::copy(kJsonStringItemClose.begin(), kJsonStringItemClose.end(), out);
+        }
+        base64EncodeBatch32(batch.bytes(), batch.size(), items + valueOffset, stride);
     }
-    return wrapJsonArray(objects);
+    writer.raw(kJsonItemsClose);
+}
+
+std::string serializeBatchJson(const PointBatch& batch, std::string_view field) {
+    JsonWriter writer(batchJsonSize(batch, field));
+    writeBatchJson(writer, batch, field);
+    return writer.take();
 }
 
-std::vector<std::array<unsigned char, 32>> deserializeBobTagMessageJson(const std::string& json) {
+PointBatch deserializeBatchJson(const std::string& json, const char* field) {
     auto objects = unwrapJsonArray(json);
-    std::vector<std::array<unsigned char, 32>> tags;
-    tags.reserve(objects.size());
+    PointBatch batch;
+    batch.reserve(objects.size());
     for (const auto& obj : objects) {
-        tags.push_back(base64DecodeArray<32>(extractJsonValue(obj, "tag")));
+        const std::string encoded = extractJsonValue(obj, field);
+        PointBatch::Entry entry;
+        if (encoded.size() != kBase64ValueChars ||
+            base64DecodeBatch32(encoded.data(), 0, 1, entry.data()) != 1) {
+            throw std::runtime_error(std::string("Invalid ") + field + " in JSON message");
+        }
+        batch.push_back(entry);
     }
-    return tags;
+    return batch;
 }
 
-std::string serializeBobTransformedMessageJson(const std::vector<BobTransformedValue>& values) {
-    std::vector<std::string> objects;
-    objects.reserve(values.size());
-    for (const auto& value : values) {
-        std::ostringstream oss;
-        oss << "{\"transformedPoint\":\"" << escapeJson(base64Encode(value.transformedPointEncoded)) << "\"}";
-        objects.push_back(oss.str());
-    }
-    return wrapJsonArray(objects);
+}  // namespace
+
+std::size_t aliceBlindedMessageJsonSize(const PointBatch& points) {
+    return batchJsonSize(points, "blindedPoint");
 }
 
-std::vector<BobTransformedValue> deserializeBobTransformedMessageJson(const std::string& json) {
-    auto objects = unwrapJsonArray(json);
-    std::vector<BobTransformedValue> values;
-    values.reserve(objects.size());
-    for (const auto& obj : objects) {
-        BobTransformedValue value;
-        auto encoded = extractJsonValue(obj, "transformedPoint");
-        value.transformedPointEncoded = base64DecodeVector(encoded);
-        values.push_back(std::move(value));
-    }
-    return values;
+void writeAliceBlindedMessageJson(JsonWriter& writer, const PointBatch& points) {
+    writeBatchJson(writer, points, "blindedPoint");
+}
+
+std::string serializeAliceBlindedMessageJson(const PointBatch& points) {
+    return serializeBatchJson(points, "blindedPoint");
+}
+
+PointBatch deserializeAliceBlindedMessageJson(const std::string& json) {
+    return deserializeBatchJson(json, "blindedPoint");
+}
+
+std::size_t bobTagMessageJsonSize(const TagBatch& tags) {
+    return batchJsonSize(tags, "tag");
+}
+
+void writeBobTagMessageJson(JsonWriter& writer, const TagBatch& tags) {
+    writeBatchJson(writer, tags, "tag");
+}
+
+std::string serializeBobTagMessageJson(const TagBatch& tags) {
+    return serializeBatchJson(tags, "tag");
+}
+
+TagBatch deserializeBobTagMessageJson(const std::string& json) {
+    return deserializeBatchJson(json, "tag");
+}
+
+std::size_t bobTransformedMessageJsonSize(const PointBatch& points) {
+    return batchJsonSize(points, "transformedPoint");
+}
+
+void writeBobTransformedMessageJson(JsonWriter& writer, const PointBatch& points) {
+    writeBatchJson(writer, points, "transformedPoint");
+}
+
+std::string serializeBobTransformedMessageJson(const PointBatch& points) {
+    return serializeBatchJson(points, "transformedPoint");
+}
+
+PointBatch deserializeBobTransformedMessageJson(const std::string& json) {
+    return deserializeBatchJson(json, "transformedPoint");
 }
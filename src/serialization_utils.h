@@ -3,26 +3,162 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "ciphersuite.h"
+#include "execution_policy.h"
+#include "json_writer.h"
 #include "psi_types.h"
+#include "tag_filter.h"
 
-std::string serializeBobEncryptedMessage(const std::vector<EncryptedUnit>& units);
-std::vector<EncryptedUnit> deserializeBobEncryptedMessage(const std::string& data);
+// Flights have two encodings carrying the same content.
+//
+// Text: a header line "<type> <count>" followed by one base64 line per
+// field. Bob's first flight (B, I, T or F) opens the exchange and names its
+// ciphersuite (ciphersuite.h) as a last header token, "T 100 v2"; v1 writes
+// no token, and a header without one reads as v1. F, the compact form of T,
+// states its filter's fingerprint width in bits (which fixes its
+// false-positive rate, tag_filter.h) and bucket count before the suite,
+// "F 100 16 27 v2", and its body is the filter table as one base64 line.
+//
+// Binary: one packed buffer, 32 bytes per point or tag where text spends 44.
+//   byte 0    kBinaryWireMagic, the framing version; never a text header byte
+//   byte 1    the flight type, 'B', 'I', 'T', 'F', 'A' or 'R' as in the text
+//             header
+//   byte 2    the ciphersuite id (B, I, T and F only; v1 is 1)
+//   varint    the element count, unsigned LEB128 in its shortest form
+//   entries   T, A, R: count packed 32-byte values
+//             B: per element the 24-byte nonce, a varint ciphertext length
+//             and the ciphertext
+//             I: as B, each element led by its 8-byte locator (text: a
+//             locator line before the ciphertext and nonce lines)
+//             F: a byte for the fingerprint width in bits, a varint bucket
+//             count and the filter table
+// Nothing may follow the last entry. Every byte is fixed by the content, so
+// binary flights can be signed and audited byte for byte like text ones.
+//
+// Deserializers accept either encoding (the first byte tells them apart),
+// store the suite through the optional pointer and reject unknown suites.
+// Text bodies are split into lines once and decoded in parallel chunks under
+// the optional ExecutionPolicy (execution_policy.h; nullptr is the process
+// default); a malformed text flight throws naming its first malformed line,
+// counting the header as line 0, whatever the scheduling.
+// Bob chooses the encoding when he opens an exchange and every reply uses
+// the encoding of the flight it answers. JSON (below) is for debugging only.
+enum class WireFormat : std::uint8_t {
+    Text,
+    Binary,
+};
 
-std::string serializeAliceBlindedMessage(const std::vector<AliceSentValue>& values);
-std::vector<AliceSentValue> deserializeAliceBlindedMessage(const std::string& data);
+inline constexpr WireFormat kDefaultWireFormat = WireFormat::Text;
+inline constexpr unsigned char kBinaryWireMagic = 0xF1;
 
-std::string serializeBobTransformedMessage(const std::vector<BobTransformedValue>& values);
-std::vector<BobTransformedValue> deserializeBobTransformedMessage(const std::string& data);
+// "text" or "binary", for command lines; parseWireFormat throws
+// std::runtime_error on anything else.
+const char* wireFormatName(WireFormat format);
+WireFormat parseWireFormat(const std::string& name);
 
-std::string serializeBobTagMessage(const std::vector<std::array<unsigned char, 32>>& tags);
-std::vector<std::array<unsigned char, 32>> deserializeBobTagMessage(const std::string& data);
+// The encoding of a serialized flight, from its first byte.
+WireFormat messageWireFormat(const std::string& data);
 
-std::string serializeBobTagMessageJson(const std::vector<std::array<unsigned char, 32>>& tags);
-std::vector<std::array<unsigned char, 32>> deserializeBobTagMessageJson(const std::string& json);
+std::string serializeBobEncryptedMessage(const std::vector<EncryptedUnit>& units,
+                                         CipherSuite suite = CipherSuite::V1,
+                                         WireFormat format = WireFormat::Text);
+std::vector<EncryptedUnit> deserializeBobEncryptedMessage(const std::string& data,
+                                                          CipherSuite* suite = nullptr,
+                                                          const ExecutionPolicy* policy = nullptr);
+
+// Indexed secretbox mode's first flight (I).
+std::string serializeBobIndexedMessage(const std::vector<IndexedEncryptedUnit>& units,
+                                       CipherSuite suite = CipherSuite::V1,
+                                       WireFormat format = WireFormat::Text);
+std::vector<IndexedEncryptedUnit> deserializeBobIndexedMessage(
+    const std::string& data, CipherSuite* suite = nullptr,
+    const ExecutionPolicy* policy = nullptr);
+
+// A and R flights carry 32-byte points; entries of any other length throw.
+std::string serializeAliceBlindedMessage(const PointBatch& points,
+                                         WireFormat format = WireFormat::Text);
+PointBatch deserializeAliceBlindedMessage(const std::string& data,
+                                          const ExecutionPolicy* policy = nullptr);
+
+std::string serializeBobTransformedMessage(const PointBatch& points,
+                                           WireFormat format = WireFormat::Text);
+PointBatch deserializeBobTransformedMessage(const std::string& data,
+                                            const ExecutionPolicy* policy = nullptr);
+
+std::string serializeBobTagMessage(const TagBatch& tags, CipherSuite suite = CipherSuite::V1,
+                                   WireFormat format = WireFormat::Text);
+TagBatch deserializeBobTagMessage(const std::string& data, CipherSuite* suite = nullptr,
+                                  const ExecutionPolicy* policy = nullptr);
+
+// Bob's compact tag flight: a filter of his tags in place of the tags, for
+// count elements. The deserializer checks the table against the header and
+// stores the suite and count through the optional pointers.
+std::string serializeBobTagFilterMessage(const TagFilter& filter, std::size_t count,
+                                         CipherSuite suite = CipherSuite::V1,
+                                         WireFormat format = WireFormat::Text);
+TagFilter deserializeBobTagFilterMessage(const std::string& data, CipherSuite* suite = nullptr,
+                                         std::size_t* count = nullptr);
+
+// A read-only view of a received A, R or T flight. The view* functions check
+// the framing once (header, count, and that every entry sits where it
+// should: 32 bytes each in binary, one 43-character base64 line each in
+// text) and keep pointers into the caller's buffer, which must outlive the
+// view. Binary entries are then read in place; text entries are decoded only
+// when a range is asked for, so callers can decode in their parallel chunks.
+// The deserialize* functions above are view*(data).toBatch().
+class FlightView {
+public:
+    using Entry = PointBatch::Entry;
+
+    // Checks the framing of a flight of the given type ('A', 'R' or 'T';
+    // only T names a suite) and throws std::runtime_error if it is wrong.
+    FlightView(const std::string& data, char type);
+
+    std::size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    WireFormat format() const { return format_; }
+    // The suite named in the header (T flights; v1 for A and R).
+    CipherSuite suite() const { return suite_; }
+
+    // Entries [begin, end) as one array: the buffer itself for binary
+    // flights, otherwise decoded into scratch (resized to end - begin).
+    // Throws std::runtime_error naming the first line in the range that is
+    // not canonical base64 of 32 bytes.
+    const Entry* entries(std::size_t begin, std::size_t end, std::vector<Entry>& scratch) const;
+
+    // Every entry, copied or decoded (in parallel chunks under policy) into a
+    // batch of its own.
+    PointBatch toBatch(const ExecutionPolicy* policy = nullptr) const;
+
+private:
+    // Text flights: decodes entries [begin, end) into out.
+    void decodeText(std::size_t begin, std::size_t end, Entry* out) const;
+
+    const char* body_{nullptr};
+    std::size_t count_{0};
+    WireFormat format_{WireFormat::Text};
+    CipherSuite suite_{CipherSuite::V1};
+};
+
+FlightView viewAliceBlindedMessage(const std::string& data);
+FlightView viewBobTransformedMessage(const std::string& data);
+FlightView viewBobTagMessage(const std::string& data);
+
+// The suite named by a B, I, T or F flight's header, without decoding the body.
+// Throws std::runtime_error on a malformed header or unknown suite.
+CipherSuite messageCipherSuite(const std::string& data);
+
+// The type byte of a flight in either encoding ('B', 'I', 'T', 'F', 'A' or 'R'),
+// unchecked beyond its presence.
+char messageType(const std::string& data);
+
+std::string serializeBobTagMessageJson(const TagBatch& tags);
+TagBatch deserializeBobTagMessageJson(const std::string& json);
 
 std::string base64Encode(const unsigned char* data, std::size_t size);
 std::string base64Encode(const std::vector<unsigned char>& data);
@@ -34,11 +170,27 @@ std::string base64Encode(const std::array<unsigned char, N>& data) {
 std::string serializeBobEncryptedMessageJson(const std::vector<EncryptedUnit>& units);
 std::vector<EncryptedUnit> deserializeBobEncryptedMessageJson(const std::string& json);
 
-std::string serializeAliceBlindedMessageJson(const std::vector<AliceSentValue>& values);
-std::vector<AliceSentValue> deserializeAliceBlindedMessageJson(const std::string& json);
+std::string serializeAliceBlindedMessageJson(const PointBatch& points);
+PointBatch deserializeAliceBlindedMessageJson(const std::string& json);
+
+std::string serializeBobTransformedMessageJson(const PointBatch& points);
+PointBatch deserializeBobTransformedMessageJson(const std::string& json);
+
+// The JSON flights above, appended to a writer so that a larger document can
+// embed them without a copy. Each *Size function returns exactly the bytes
+// the matching write appends; serialize*Json is one write into a writer
+// reserved to that size.
+std::size_t bobTagMessageJsonSize(const TagBatch& tags);
+void writeBobTagMessageJson(JsonWriter& writer, const TagBatch& tags);
+
+std::size_t bobEncryptedMessageJsonSize(const std::vector<EncryptedUnit>& units);
+void writeBobEncryptedMessageJson(JsonWriter& writer, const std::vector<EncryptedUnit>& units);
+
+std::size_t aliceBlindedMessageJsonSize(const PointBatch& points);
+void writeAliceBlindedMessageJson(JsonWriter& writer, const PointBatch& points);
 
-std::string serializeBobTransformedMessageJson(const std::vector<BobTransformedValue>& values);
-std::vector<BobTransformedValue> deserializeBobTransformedMessageJson(const std::string& json);
+std::size_t bobTransformedMessageJsonSize(const PointBatch& points);
+void writeBobTransformedMessageJson(JsonWriter& writer, const PointBatch& points);
 
 std::vector<unsigned char> base64DecodeVector(const std::string& encoded);
 template <std::size_t N>
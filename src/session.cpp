@@ -1,9 +1,14 @@
 #include "session.h"
 
+#include <exception>
+#include <functional>
+#include <memory>
 #include <stdexcept>
+#include <utility>
 
 #include "derivation.h"
 #include "psi_protocol.h"
+#include "thread_pool.h"
 
 namespace {
 
@@ -15,6 +20,104 @@ bool isDummy(const std::string& element) {
     return element.rfind("D:", 0) == 0;
 }
 
+// Phase 1 records a single level.
+constexpr std::uint32_t kSessionLevel = 0;
+
+// Fields shared by every record of one turn.
+struct RecordContext {
+    const GameId& gameId;
+    std::uint64_t turn;
+};
+
+TranscriptRecord makeRecord(const RecordContext& context, std::uint8_t dir,
+                            std::uint8_t msgType, const Commitment& cSelf,
+                            const Commitment& cPeer, const std::string& body) {
+    TranscriptRecord record;
+    record.gameId = context.gameId;
+    record.turn = context.turn;
+    record.level = kSessionLevel;
+    record.dir = dir;
+    record.msgType = msgType;
+    record.cSelf = cSelf;
+    record.cPeer = cPeer;
+    record.body = toBytes(body);
+    return record;
+}
+
+std::vector<std::string> realMatches(const std::vector<MatchedUnit>& matches) {
+    std::vector<std::string> real;
+    for (const auto& match : matches) {
+        // Dummies come from each party's own secret subseed and the "D:"
+        // namespace, so they never match across parties; filtering here
+        // is belt and braces plus keeps demo output clean.
+        if (!isDummy(match.element)) {
+            real.push_back(match.element);
+        }
+    }
+    return real;
+}
+
+// Runs every job at once, all but the last as BackgroundTasks on the shared
+// pool and the last on the caller. The first failure in job order is
+// rethrown once every job has finished.
+void runConcurrently(const std::vector<std::function<void()>>& jobs) {
+    std::vector<std::shared_ptr<BackgroundTask>> tasks;
+    for (std::size_t i = 0; i + 1 < jobs.size(); ++i) {
+        tasks.push_back(BackgroundTask::start(ThreadPool::shared(), jobs[i]));
+    }
+    std::exception_ptr callerError;
+    try {
+        jobs.back()();
+    } catch (...) {
+        callerError = std::current_exception();
+    }
+    std::exception_ptr firstError;
+    for (const auto& task : tasks) {
+        try {
+            task->wait();
+        } catch (...) {
+            if (!firstError) {
+                firstError = std::current_exception();
+            }
+        }
+    }
+    if (!firstError) {
+        firstError = callerError;
+    }
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+}
+
+// One party's half of a mutual turn: Bob towards the peer in bobDir, Alice
+// in the other direction. Both roles hash through the same cache, so each
+// real element goes to the group once per turn (the padding dummies differ
+// per direction and are hashed once each).
+struct MutualParty {
+    MutualParty(const std::array<unsigned char, 32>& seed,
+                const std::vector<std::string>& elements, const Commitment& commitment,
+                const SessionKeys& keys, std::uint8_t bobDir)
+        : seed(seed),
+          elements(elements),
+          commitment(commitment),
+          keys(keys),
+          bobDir(bobDir),
+          aliceDir(static_cast<std::uint8_t>(1 - bobDir)) {}
+
+    const std::array<unsigned char, 32>& seed;
+    const std::vector<std::string>& elements;
+    const Commitment& commitment;
+    const SessionKeys& keys;
+    std::uint8_t bobDir;
+    std::uint8_t aliceDir;
+
+    HashToGroupCache hashCache;
+    BobInitialTagMessage bobMessage;
+    AliceResponseMessage aliceMessage;
+    BobResponseMessage bobResponse;
+    std::vector<std::string> intersection;
+};
+
 }  // namespace
 
 SessionKeys generateSessionKeys() {
@@ -38,7 +141,9 @@ RecordedExchangeResult runRecordedExchange(
     const SessionKeys& keysQ,
     const std::string& transcriptPath,
     const std::vector<std::string>* psiElementsP,
-    const std::vector<std::string>* psiElementsQ) {
+    const std::vector<std::string>* psiElementsQ,
+    CipherSuite suite,
+    WireFormat format) {
     const auto seedP = turnSeed(masterKeyP, turn);
     const auto seedQ = turnSeed(masterKeyQ, turn);
 
@@ -55,10 +160,11 @@ RecordedExchangeResult runRecordedExchange(
         (psiElementsQ != nullptr) ? *psiElementsQ : elementsQ;
 
     TranscriptWriter writer(transcriptPath);
+    const RecordContext context{gameId, turn};
 
     // Runs one direction: `alice` learns the intersection from `bob`.
     // Records three signed flights at level 0.
-    const std::uint32_t level = 0;
+    const std::uint32_t level = kSessionLevel;
     auto runDirection = [&](std::uint8_t dir,
                             const std::array<unsigned char, 32>& bobSeed,
                             const std::vector<std::string>& bobElements,
@@ -76,48 +182,25 @@ RecordedExchangeResult runRecordedExchange(
         const auto bobPadded = padElements(bobElements, nMax, subseed(bobSeed, level, dir, 2));
         const auto alicePadded = padElements(aliceElements, nMax, subseed(aliceSeed, level, dir, 2));
 
-        auto makeRecord = [&](std::uint8_t msgType, const Commitment& cSelf,
-                              const Commitment& cPeer, const std::string& body) {
-            TranscriptRecord record;
-            record.gameId = gameId;
-            record.turn = turn;
-            record.level = level;
-            record.dir = dir;
-            record.msgType = msgType;
-            record.cSelf = cSelf;
-            record.cPeer = cPeer;
-            record.body = toBytes(body);
-            return record;
-        };
-
-        auto bobMessage = bobCreateInitialTagMessageFromElements(bobPadded, nullptr, &bobRng);
-        writer.append(makeRecord(kMsgTypeTags, bobCommitment, aliceCommitment,
+        auto bobMessage = bobCreateInitialTagMessageFromElements(bobPadded, nullptr, &bobRng,
+                                                                 nullptr, suite, format);
+        writer.append(makeRecord(context, dir, kMsgTypeTags, bobCommitment, aliceCommitment,
                                  bobMessage.serialized),
                       bobKeys.secretKey);
 
         auto aliceMessage = aliceProcessBobTagMessageFromElements(bobMessage.serialized,
                                                                   alicePadded, nullptr, &aliceRng);
-        writer.append(makeRecord(kMsgTypeBlinded, aliceCommitment, bobCommitment,
+        writer.append(makeRecord(context, dir, kMsgTypeBlinded, aliceCommitment, bobCommitment,
                                  aliceMessage.serialized),
                       aliceKeys.secretKey);
 
         auto bobResponse = bobProcessAliceMessage(aliceMessage.serialized, bobMessage.state);
-        writer.append(makeRecord(kMsgTypeTransformed, bobCommitment, aliceCommitment,
-                                 bobResponse.serialized),
+        writer.append(makeRecord(context, dir, kMsgTypeTransformed, bobCommitment,
+                                 aliceCommitment, bobResponse.serialized),
                       bobKeys.secretKey);
 
-        const auto matches = aliceFinalizeIntersectionTags(bobResponse.serialized,
-                                                           aliceMessage.state);
-        std::vector<std::string> realMatches;
-        for (const auto& match : matches) {
-            // Dummies come from each party's own secret subseed and the "D:"
-            // namespace, so they never match across parties; filtering here
-            // is belt and braces plus keeps demo output clean.
-            if (!isDummy(match.element)) {
-                realMatches.push_back(match.element);
-            }
-        }
-        return realMatches;
+        return realMatches(aliceFinalizeIntersectionTags(bobResponse.serialized,
+                                                         aliceMessage.state));
     };
 
     // dir 0: P queries Q (Q takes the Bob role, P the Alice role).
@@ -130,3 +213,96 @@ RecordedExchangeResult runRecordedExchange(
                                               keysQ);
     return result;
 }
+
+RecordedExchangeResult runMutualRecordedExchange(
+    const std::array<unsigned char, 32>& masterKeyP,
+    const std::array<unsigned char, 32>& masterKeyQ,
+    const std::vector<std::string>& elementsP,
+    const std::vector<std::string>& elementsQ,
+    std::uint64_t turn,
+    std::size_t nMax,
+    const GameId& gameId,
+    const SessionKeys& keysP,
+    const SessionKeys& keysQ,
+    const std::string& transcriptPath,
+    const std::vector<std::string>* psiElementsP,
+    const std::vector<std::string>* psiElementsQ,
+    CipherSuite suite,
+    WireFormat format) {
+    const auto seedP = turnSeed(masterKeyP, turn);
+    const auto seedQ = turnSeed(masterKeyQ, turn);
+
+    RecordedExchangeResult result;
+    result.commitmentP = computeCommitment(elementsP, seedP);
+    result.commitmentQ = computeCommitment(elementsQ, seedQ);
+
+    // P is Alice in dir 0 and Bob in dir 1; Q the other way round.
+    MutualParty p(seedP, (psiElementsP != nullptr) ? *psiElementsP : elementsP,
+                  result.commitmentP, keysP, 1);
+    MutualParty q(seedQ, (psiElementsQ != nullptr) ? *psiElementsQ : elementsQ,
+                  result.commitmentQ, keysQ, 0);
+
+    TranscriptWriter writer(transcriptPath);
+    const RecordContext context{gameId, turn};
+
+    // Each role draws from the DeterministicRng and padding subseed of its
+    // own (level, dir), exactly as runRecordedExchange does, so every flight
+    // is byte for byte the sequential one.
+    auto bobJob = [&](MutualParty& party) {
+        return [&party, nMax, suite, format]() {
+            DeterministicRng rng(party.seed, kSessionLevel, party.bobDir);
+            const auto padded = padElements(party.elements, nMax,
+                                            subseed(party.seed, kSessionLevel, party.bobDir, 2));
+            party.bobMessage = bobCreateInitialTagMessageFromElements(
+                padded, &party.hashCache, &rng, nullptr, suite, format);
+        };
+    };
+    auto aliceJob = [&](MutualParty& party) {
+        return [&party, nMax, suite, format]() {
+            DeterministicRng rng(party.seed, kSessionLevel, party.aliceDir);
+            const auto padded = padElements(party.elements, nMax,
+                                            subseed(party.seed, kSessionLevel, party.aliceDir, 2));
+            party.aliceMessage = alicePrepareBlinded(padded, &party.hashCache, &rng, nullptr,
+                                                     suite, format);
+        };
+    };
+
+    // Round trip 1: each party sends (my tags, my blinded points), all four
+    // computed at once.
+    runConcurrently({bobJob(p), aliceJob(p), bobJob(q), aliceJob(q)});
+    for (MutualParty* party : {&p, &q}) {
+        const MutualParty& peer = (party == &p) ? q : p;
+        writer.append(makeRecord(context, party->bobDir, kMsgTypeTags, party->commitment,
+                                 peer.commitment, party->bobMessage.serialized),
+                      party->keys.secretKey);
+        writer.append(makeRecord(context, party->aliceDir, kMsgTypeBlinded, party->commitment,
+                                 peer.commitment, party->aliceMessage.serialized),
+                      party->keys.secretKey);
+    }
+    aliceAttachBobTags(q.bobMessage.serialized, p.aliceMessage.state);
+    aliceAttachBobTags(p.bobMessage.serialized, q.aliceMessage.state);
+
+    // Round trip 2: each party answers the peer's blinded points.
+    runConcurrently({
+        [&]() { p.bobResponse = bobProcessAliceMessage(q.aliceMessage.serialized,
+                                                       p.bobMessage.state); },
+        [&]() { q.bobResponse = bobProcessAliceMessage(p.aliceMessage.serialized,
+                                                       q.bobMessage.state); },
+    });
+    writer.append(makeRecord(context, p.bobDir, kMsgTypeTransformed, p.commitment,
+                             q.commitment, p.bobResponse.serialized),
+                  p.keys.secretKey);
+    writer.append(makeRecord(context, q.bobDir, kMsgTypeTransformed, q.commitment,
+                             p.commitment, q.bobResponse.serialized),
+                  q.keys.secretKey);
+
+    runConcurrently({
+        [&]() { p.intersection = realMatches(aliceFinalizeIntersectionTags(
+                    q.bobResponse.serialized, p.aliceMessage.state)); },
+        [&]() { q.intersection = realMatches(aliceFinalizeIntersectionTags(
+                    p.bobResponse.serialized, q.aliceMessage.state)); },
+    });
+    result.intersectionSeenByP = std::move(p.intersection);
+    result.intersectionSeenByQ = std::move(q.intersection);
+    return result;
+}
@@ -6,6 +6,8 @@
 // committed, deterministic tag-mode exchange in BOTH directions for one turn
 // and writes every flight into a signed transcript, so tests, demos and the
 // psi_audit CLI have end-to-end material without any chain integration.
+// runRecordedExchange runs the directions one after the other;
+// runMutualRecordedExchange runs them together in two round trips.
 //
 // Phase 1 records a single level (level = 0); the record header already
 // carries a level field, so the mesh cascade's multiple levels fit later
@@ -16,6 +18,8 @@
 #include <string>
 #include <vector>
 
+#include "ciphersuite.h"
+#include "serialization_utils.h"
 #include "transcript.h"
 
 struct SessionKeys {
@@ -46,6 +50,9 @@ struct RecordedExchangeResult {
 // elementsQ. This models a cheater probing with inputs that differ from the
 // committed state; tests use it to produce transcripts that psi_audit must
 // flag as FRAUD. Honest callers leave them null.
+//
+// suite is the ciphersuite (ciphersuite.h) both Bob-role flights announce,
+// format the wire format (serialization_utils.h) every flight body uses.
 RecordedExchangeResult runRecordedExchange(
     const std::array<unsigned char, 32>& masterKeyP,
     const std::array<unsigned char, 32>& masterKeyQ,
@@ -58,6 +65,34 @@ RecordedExchangeResult runRecordedExchange(
     const SessionKeys& keysQ,
     const std::string& transcriptPath,
     const std::vector<std::string>* psiElementsP = nullptr,
-    const std::vector<std::string>* psiElementsQ = nullptr);
+    const std::vector<std::string>* psiElementsQ = nullptr,
+    CipherSuite suite = kDefaultCipherSuite,
+    WireFormat format = kDefaultWireFormat);
+
+// The same turn as a mutual exchange (spec section 5): each party's first
+// flight carries (my tags, my blinded points), its second the peer's points
+// transformed, so the turn takes two round trips instead of six flights.
+// Within each round both parties' computations run concurrently on
+// ThreadPool::shared(), and each party hashes to the group through one
+// cache shared by its Bob and Alice roles. Every flight, signature and
+// result is identical to runRecordedExchange's; only the record order
+// differs (P's tags for dir 1 and blinded points for dir 0, Q's tags for
+// dir 0 and blinded points for dir 1, then P's and Q's transformed points),
+// and the audit checks each (level, dir) the same either way.
+RecordedExchangeResult runMutualRecordedExchange(
+    const std::array<unsigned char, 32>& masterKeyP,
+    const std::array<unsigned char, 32>& masterKeyQ,
+    const std::vector<std::string>& elementsP,
+    const std::vector<std::string>& elementsQ,
+    std::uint64_t turn,
+    std::size_t nMax,
+    const GameId& gameId,
+    const SessionKeys& keysP,
+    const SessionKeys& keysQ,
+    const std::string& transcriptPath,
+    const std::vector<std::string>* psiElementsP = nullptr,
+    const std::vector<std::string>* psiElementsQ = nullptr,
+    CipherSuite suite = kDefaultCipherSuite,
+    WireFormat format = kDefaultWireFormat);
 
 #endif  // SESSION_H
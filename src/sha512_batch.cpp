@@ -0,0 +1,162 @@
+#include "sha512_batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <sodium.h>
+}
+
+namespace {
+
+constexpr std::uint64_t kInitialState[8] = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL};
+
+Sha512Backend bestSupportedBackend() {
+    if (sha512BackendSupported(Sha512Backend::Avx512)) {
+        return Sha512Backend::Avx512;
+    }
+    if (sha512BackendSupported(Sha512Backend::Avx2)) {
+        return Sha512Backend::Avx2;
+    }
+    return Sha512Backend::Portable;
+}
+
+// -1 until first use, then the Sha512Backend value.
+std::atomic<int> activeBackend{-1};
+
+void storeBigEndian(unsigned char* out, std::uint64_t word) {
+    for (int i = 7; i >= 0; --i) {
+        out[i] = static_cast<unsigned char>(word);
+        word >>= 8;
+    }
+}
+
+// Pads one group of Lanes messages into scratch (message, 0x80, zeros, 128-bit
+// big-endian bit length) and runs the compression kernel over all of them.
+template <std::size_t Lanes, typename Compress>
+void hashGroup(const unsigned char* const* messages, const std::size_t* lengths,
+               Sha512Digest* digests, std::vector<unsigned char>& scratch, Compress compress) {
+    std::size_t blocks[Lanes];
+    std::size_t offsets[Lanes];
+    std::size_t total = 0;
+    std::size_t maxBlocks = 0;
+    for (std::size_t lane = 0; lane < Lanes; ++lane) {
+        blocks[lane] = (lengths[lane] + 16 + 1 + 127) / 128;
+        offsets[lane] = total;
+        total += blocks[lane] * 128;
+        maxBlocks = std::max(maxBlocks, blocks[lane]);
+    }
+    scratch.assign(total, 0);
+
+    const unsigned char* data[Lanes];
+    for (std::size_t lane = 0; lane < Lanes; ++lane) {
+        unsigned char* padded = scratch.data() + offsets[lane];
+        const std::size_t length = lengths[lane];
+        if (length != 0) {
+            std::memcpy(padded, messages[lane], length);
+        }
+        padded[length] = 0x80;
+        unsigned char* lengthField = padded + blocks[lane] * 128 - 16;
+        storeBigEndian(lengthField, static_cast<std::uint64_t>(length) >> 61);
+        storeBigEndian(lengthField + 8, static_cast<std::uint64_t>(length) << 3);
+        data[lane] = padded;
+    }
+
+    std::uint64_t state[8][Lanes];
+    for (std::size_t word = 0; word < 8; ++word) {
+        std::fill(state[word], state[word] + Lanes, kInitialState[word]);
+    }
+    compress(state, data, blocks, maxBlocks);
+
+    for (std::size_t lane = 0; lane < Lanes; ++lane) {
+        for (std::size_t word = 0; word < 8; ++word) {
+            storeBigEndian(digests[lane].data() + 8 * word, state[word][lane]);
+        }
+    }
+    sodium_memzero(scratch.data(), scratch.size());
+    sodium_memzero(state, sizeof state);
+}
+
+}  // namespace
+
+const char* sha512BackendName(Sha512Backend backend) {
+    switch (backend) {
+        case Sha512Backend::Portable:
+            return "portable";
+        case Sha512Backend::Avx2:
+            return "avx2";
+        case Sha512Backend::Avx512:
+            return "avx512";
+    }
+    return "unknown";
+}
+
+Sha512Backend parseSha512Backend(const std::string& name) {
+    for (const auto backend :
+         {Sha512Backend::Portable, Sha512Backend::Avx2, Sha512Backend::Avx512}) {
+        if (name == sha512BackendName(backend)) {
+            return backend;
+        }
+    }
+    throw std::runtime_error("Unknown SHA-512 backend: " + name);
+}
+
+bool sha512BackendSupported(Sha512Backend backend) {
+    switch (backend) {
+        case Sha512Backend::Portable:
+            return true;
+        case Sha512Backend::Avx2:
+            return cpuFeatures().avx2;
+        case Sha512Backend::Avx512:
+            return cpuFeatures().avx512f;
+    }
+    return false;
+}
+
+Sha512Backend activeSha512Backend() {
+    int backend = activeBackend.load(std::memory_order_relaxed);
+    if (backend < 0) {
+        backend = static_cast<int>(bestSupportedBackend());
+        activeBackend.store(backend, std::memory_order_relaxed);
+    }
+    return static_cast<Sha512Backend>(backend);
+}
+
+void setSha512Backend(Sha512Backend backend) {
+    if (!sha512BackendSupported(backend)) {
+        throw std::runtime_error(std::string("SHA-512 backend not supported on this CPU: ") +
+                                 sha512BackendName(backend));
+    }
+    activeBackend.store(static_cast<int>(backend), std::memory_order_relaxed);
+}
+
+void sha512Batch(const unsigned char* const* messages, const std::size_t* lengths,
+                 std::size_t count, Sha512Digest* digests) {
+    std::size_t i = 0;
+#if defined(PSI_HAVE_X86_CPUID)
+    const Sha512Backend backend = activeSha512Backend();
+    std::vector<unsigned char> scratch;
+    if (backend == Sha512Backend::Avx512) {
+        for (; i + 8 <= count; i += 8) {
+            hashGroup<8>(messages + i, lengths + i, digests + i, scratch, sha512Compress8Avx512);
+        }
+    }
+    // The AVX-512 backend finishes its tail four lanes at a time as well.
+    if (backend != Sha512Backend::Portable && sha512BackendSupported(Sha512Backend::Avx2)) {
+        for (; i + 4 <= count; i += 4) {
+            hashGroup<4>(messages + i, lengths + i, digests + i, scratch, sha512Compress4Avx2);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        if (crypto_hash_sha512(digests[i].data(), messages[i], lengths[i]) != 0) {
+            throw std::runtime_error("libsodium SHA-512 hashing failed");
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef SHA512_BATCH_H
+#define SHA512_BATCH_H
+
+// Multi-buffer SHA-512: many independent messages hashed side by side, one
+// message per 64-bit SIMD lane (four on AVX2, eight on AVX-512F). Every
+// per-element hash in the protocol (hash-to-group, key derivation) is a short
+// independent message, so lanes rarely idle: messages shorter than their
+// group's longest simply stop updating their lane after their last block.
+//
+// Output is standard SHA-512, byte-identical to crypto_hash_sha512 (the
+// portable backend is crypto_hash_sha512 itself). The backend is picked from
+// CPUID like the field backend (curve25519_backend.h) and can be pinned for
+// tests and benchmarks.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "cpu_features.h"
+
+using Sha512Digest = std::array<unsigned char, 64>;
+
+enum class Sha512Backend {
+    Portable,
+    Avx2,
+    Avx512,
+};
+
+const char* sha512BackendName(Sha512Backend backend);
+
+// Inverse of sha512BackendName; throws std::runtime_error on unknown names.
+Sha512Backend parseSha512Backend(const std::string& name);
+
+bool sha512BackendSupported(Sha512Backend backend);
+
+// The widest supported backend unless setSha512Backend chose another.
+Sha512Backend activeSha512Backend();
+
+// Throws std::runtime_error if the backend is not supported here.
+void setSha512Backend(Sha512Backend backend);
+
+// digests[i] = SHA-512(messages[i][0..lengths[i])) for i in [0, count).
+void sha512Batch(const unsigned char* const* messages, const std::size_t* lengths,
+                 std::size_t count, Sha512Digest* digests);
+
+#if defined(PSI_HAVE_X86_CPUID)
+
+// Compression kernels (sha512_batch_x86.cpp). state[word][lane] holds each
+// lane's chaining value; lane l absorbs blocks[l] 128-byte blocks from
+// data[l], and keeps its state unchanged for the rest of the maxBlocks
+// rounds.
+void sha512Compress4Avx2(std::uint64_t state[8][4], const unsigned char* const data[4],
+                         const std::size_t blocks[4], std::size_t maxBlocks);
+void sha512Compress8Avx512(std::uint64_t state[8][8], const unsigned char* const data[8],
+                           const std::size_t blocks[8], std::size_t maxBlocks);
+
+#endif  // PSI_HAVE_X86_CPUID
+
+#endif // SHA512_BATCH_H
@@ -0,0 +1,235 @@
+// SHA-512 compression across SIMD lanes, one message per 64-bit lane: four on
+// AVX2, eight on AVX-512F. The rounds are FIPS 180-4 verbatim; only the
+// registers are wider. Like ristretto_point_avx2.cpp, the vector code carries
+// target attributes instead of the file being built with -mavx2/-mavx512f.
+
+#include "sha512_batch.h"
+
+#if defined(PSI_HAVE_X86_CPUID)
+
+#include <immintrin.h>
+
+#include <cstring>
+
+#define PSI_AVX2 __attribute__((target("avx2")))
+#define PSI_AVX512 __attribute__((target("avx512f")))
+
+namespace {
+
+constexpr std::uint64_t kRoundConstants[80] = {
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+    0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+    0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+    0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+    0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+    0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+    0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+    0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+    0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+    0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+    0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+    0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+    0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+    0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL};
+
+constexpr unsigned char kZeroBlock[128] = {};
+
+std::uint64_t loadBigEndian(const unsigned char* in) {
+    std::uint64_t word = 0;
+    for (int i = 0; i < 8; ++i) {
+        word = (word << 8) | in[i];
+    }
+    return word;
+}
+
+// Block b of each lane, or a zero block for lanes already finished (their
+// result is discarded by the lane mask).
+template <std::size_t Lanes>
+void blockPointers(const unsigned char* const data[Lanes], const std::size_t blocks[Lanes],
+                   std::size_t b, const unsigned char* out[Lanes]) {
+    for (std::size_t lane = 0; lane < Lanes; ++lane) {
+        out[lane] = b < blocks[lane] ? data[lane] + 128 * b : kZeroBlock;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// AVX2, four lanes.
+
+template <int N>
+PSI_AVX2 inline __m256i rotr4(__m256i x) {
+    return _mm256_or_si256(_mm256_srli_epi64(x, N), _mm256_slli_epi64(x, 64 - N));
+}
+
+PSI_AVX2 inline __m256i add4(__m256i a, __m256i b) {
+    return _mm256_add_epi64(a, b);
+}
+
+PSI_AVX2 inline __m256i xor3(__m256i a, __m256i b, __m256i c) {
+    return _mm256_xor_si256(_mm256_xor_si256(a, b), c);
+}
+
+PSI_AVX2 void compressBlock4(__m256i s[8], const unsigned char* const block[4]) {
+    __m256i w[16];
+    for (int t = 0; t < 16; ++t) {
+        w[t] = _mm256_set_epi64x(static_cast<long long>(loadBigEndian(block[3] + 8 * t)),
+                                 static_cast<long long>(loadBigEndian(block[2] + 8 * t)),
+                                 static_cast<long long>(loadBigEndian(block[1] + 8 * t)),
+                                 static_cast<long long>(loadBigEndian(block[0] + 8 * t)));
+    }
+
+    __m256i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+    for (int t = 0; t < 80; ++t) {
+        if (t >= 16) {
+            const __m256i w15 = w[(t - 15) & 15];
+            const __m256i w2 = w[(t - 2) & 15];
+            const __m256i sigma0 = xor3(rotr4<1>(w15), rotr4<8>(w15), _mm256_srli_epi64(w15, 7));
+            const __m256i sigma1 = xor3(rotr4<19>(w2), rotr4<61>(w2), _mm256_srli_epi64(w2, 6));
+            w[t & 15] = add4(add4(w[t & 15], sigma0), add4(sigma1, w[(t - 7) & 15]));
+        }
+        const __m256i bigSigma1 = xor3(rotr4<14>(e), rotr4<18>(e), rotr4<41>(e));
+        const __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        const __m256i k = _mm256_set1_epi64x(static_cast<long long>(kRoundConstants[t]));
+        const __m256i t1 = add4(add4(h, bigSigma1), add4(add4(ch, k), w[t & 15]));
+        const __m256i bigSigma0 = xor3(rotr4<28>(a), rotr4<34>(a), rotr4<39>(a));
+        const __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b),
+                                            _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        const __m256i t2 = add4(bigSigma0, maj);
+        h = g;
+        g = f;
+        f = e;
+        e = add4(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = add4(t1, t2);
+    }
+
+    const __m256i next[8] = {a, b, c, d, e, f, g, h};
+    for (int i = 0; i < 8; ++i) {
+        s[i] = add4(s[i], next[i]);
+    }
+}
+
+PSI_AVX2 void compress4(std::uint64_t state[8][4], const unsigned char* const data[4],
+                        const std::size_t blocks[4], std::size_t maxBlocks) {
+    __m256i s[8];
+    for (int i = 0; i < 8; ++i) {
+        s[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state[i]));
+    }
+    for (std::size_t b = 0; b < maxBlocks; ++b) {
+        const unsigned char* block[4];
+        blockPointers<4>(data, blocks, b, block);
+        __m256i updated[8];
+        std::memcpy(updated, s, sizeof updated);
+        compressBlock4(updated, block);
+        const __m256i active = _mm256_set_epi64x(
+            b < blocks[3] ? -1 : 0, b < blocks[2] ? -1 : 0, b < blocks[1] ? -1 : 0,
+            b < blocks[0] ? -1 : 0);
+        for (int i = 0; i < 8; ++i) {
+            s[i] = _mm256_blendv_epi8(s[i], updated[i], active);
+        }
+    }
+    for (int i = 0; i < 8; ++i) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(state[i]), s[i]);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// AVX-512F, eight lanes: native 64-bit rotates, and ternary logic for Ch/Maj.
+
+PSI_AVX512 inline __m512i add8(__m512i a, __m512i b) {
+    return _mm512_add_epi64(a, b);
+}
+
+PSI_AVX512 void compressBlock8(__m512i s[8], const unsigned char* const block[8]) {
+    __m512i w[16];
+    for (int t = 0; t < 16; ++t) {
+        long long words[8];
+        for (int lane = 0; lane < 8; ++lane) {
+            words[lane] = static_cast<long long>(loadBigEndian(block[lane] + 8 * t));
+        }
+        w[t] = _mm512_loadu_si512(words);
+    }
+
+    __m512i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+    for (int t = 0; t < 80; ++t) {
+        if (t >= 16) {
+            const __m512i w15 = w[(t - 15) & 15];
+            const __m512i w2 = w[(t - 2) & 15];
+            const __m512i sigma0 = _mm512_ternarylogic_epi64(
+                _mm512_ror_epi64(w15, 1), _mm512_ror_epi64(w15, 8), _mm512_srli_epi64(w15, 7),
+                0x96);
+            const __m512i sigma1 = _mm512_ternarylogic_epi64(
+                _mm512_ror_epi64(w2, 19), _mm512_ror_epi64(w2, 61), _mm512_srli_epi64(w2, 6),
+                0x96);
+            w[t & 15] = add8(add8(w[t & 15], sigma0), add8(sigma1, w[(t - 7) & 15]));
+        }
+        const __m512i bigSigma1 = _mm512_ternarylogic_epi64(
+            _mm512_ror_epi64(e, 14), _mm512_ror_epi64(e, 18), _mm512_ror_epi64(e, 41), 0x96);
+        const __m512i ch = _mm512_ternarylogic_epi64(e, f, g, 0xca);
+        const __m512i k = _mm512_set1_epi64(static_cast<long long>(kRoundConstants[t]));
+        const __m512i t1 = add8(add8(h, bigSigma1), add8(add8(ch, k), w[t & 15]));
+        const __m512i bigSigma0 = _mm512_ternarylogic_epi64(
+            _mm512_ror_epi64(a, 28), _mm512_ror_epi64(a, 34), _mm512_ror_epi64(a, 39), 0x96);
+        const __m512i maj = _mm512_ternarylogic_epi64(a, b, c, 0xe8);
+        const __m512i t2 = add8(bigSigma0, maj);
+        h = g;
+        g = f;
+        f = e;
+        e = add8(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = add8(t1, t2);
+    }
+
+    const __m512i next[8] = {a, b, c, d, e, f, g, h};
+    for (int i = 0; i < 8; ++i) {
+        s[i] = add8(s[i], next[i]);
+    }
+}
+
+PSI_AVX512 void compress8(std::uint64_t state[8][8], const unsigned char* const data[8],
+                          const std::size_t blocks[8], std::size_t maxBlocks) {
+    __m512i s[8];
+    for (int i = 0; i < 8; ++i) {
+        s[i] = _mm512_loadu_si512(state[i]);
+    }
+    for (std::size_t b = 0; b < maxBlocks; ++b) {
+        const unsigned char* block[8];
+        blockPointers<8>(data, blocks, b, block);
+        __m512i updated[8];
+        std::memcpy(updated, s, sizeof updated);
+        compressBlock8(updated, block);
+        __mmask8 active = 0;
+        for (int lane = 0; lane < 8; ++lane) {
+            active = static_cast<__mmask8>(active | ((b < blocks[lane] ? 1U : 0U) << lane));
+        }
+        for (int i = 0; i < 8; ++i) {
+            s[i] = _mm512_mask_blend_epi64(active, s[i], updated[i]);
+        }
+    }
+    for (int i = 0; i < 8; ++i) {
+        _mm512_storeu_si512(state[i], s[i]);
+    }
+}
+
+}  // namespace
+
+void sha512Compress4Avx2(std::uint64_t state[8][4], const unsigned char* const data[4],
+                         const std::size_t blocks[4], std::size_t maxBlocks) {
+    compress4(state, data, blocks, maxBlocks);
+}
+
+void sha512Compress8Avx512(std::uint64_t state[8][8], const unsigned char* const data[8],
+                           const std::size_t blocks[8], std::size_t maxBlocks) {
+    compress8(state, data, blocks, maxBlocks);
+}
+
+#endif  // PSI_HAVE_X86_CPUID
@@ -0,0 +1,184 @@
+#include "tag_filter.h"
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace {
+
+// Evictions before an insert gives up and the table is rebuilt larger.
+constexpr std::size_t kMaxEvictions = 500;
+constexpr double kTargetLoad = 0.95;
+
+void checkFingerprintBytes(std::size_t fingerprintBytes) {
+    if (fingerprintBytes == 0 || fingerprintBytes > kTagFilterMaxFingerprintBytes) {
+        throw std::runtime_error("Tag filter fingerprints must be 1 to 4 bytes, not " +
+                                 std::to_string(fingerprintBytes));
+    }
+}
+
+std::uint64_t nextEviction(std::uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+}  // namespace
+
+double tagFilterFalsePositiveRate(std::size_t fingerprintBytes) {
+    checkFingerprintBytes(fingerprintBytes);
+    return 2.0 * kTagFilterBucketSlots /
+           (std::ldexp(1.0, static_cast<int>(8 * fingerprintBytes)) - 1.0);
+}
+
+std::size_t tagFilterFingerprintBytes(double falsePositiveRate) {
+    if (!(falsePositiveRate > 0.0 && falsePositiveRate < 1.0)) {
+        throw std::runtime_error("Tag filter false-positive rate must be in (0, 1)");
+    }
+    for (std::size_t bytes = 1; bytes <= kTagFilterMaxFingerprintBytes; ++bytes) {
+        if (tagFilterFalsePositiveRate(bytes) <= falsePositiveRate) {
+            return bytes;
+        }
+    }
+    throw std::runtime_error("Tag filter cannot reach a false-positive rate of " +
+                             std::to_string(falsePositiveRate));
+}
+
+TagFilter::TagFilter(std::size_t fingerprintBytes, std::size_t bucketCount)
+    : fingerprintBytes_(fingerprintBytes),
+      bucketCount_(bucketCount),
+      table_(bucketCount * kTagFilterBucketSlots * fingerprintBytes) {}
+
+TagFilter::TagFilter(std::size_t fingerprintBytes, std::size_t bucketCount,
+                     std::vector<unsigned char> table)
+    : fingerprintBytes_(fingerprintBytes), bucketCount_(bucketCount), table_(std::move(table)) {
+    checkFingerprintBytes(fingerprintBytes);
+    if (bucketCount == 0 ||
+        table_.size() / kTagFilterBucketSlots / fingerprintBytes != bucketCount ||
+        table_.size() % (kTagFilterBucketSlots * fingerprintBytes) != 0) {
+        throw std::runtime_error("Tag filter table does not match its bucket count");
+    }
+}
+
+TagFilter TagFilter::build(const TagBatch& tags, std::size_t fingerprintBytes) {
+    checkFingerprintBytes(fingerprintBytes);
+    std::size_t buckets = static_cast<std::size_t>(std::ceil(
+        static_cast<double>(tags.size()) / (kTagFilterBucketSlots * kTargetLoad)));
+    buckets = std::max<std::size_t>(buckets, 1);
+    while (true) {
+        TagFilter filter(fingerprintBytes, buckets);
+        std::uint64_t evictionState = 0x9e3779b97f4a7c15ULL;
+        bool complete = true;
+        for (const auto& tag : tags) {
+            if (!filter.insert(tag, evictionState)) {
+                complete = false;
+                break;
+            }
+        }
+        if (complete) {
+            return filter;
+        }
+        buckets += buckets / 20 + 1;
+    }
+}
+
+// The first nonzero fingerprint-wide window of bytes 8..31, so every nonzero
+// value is equally likely (zero marks an empty slot). All windows are zero
+// with probability 2^-192; such a tag gets fingerprint 1.
+std::uint32_t TagFilter::fingerprintOf(const Tag& tag) const {
+    for (std::size_t offset = 8; offset + fingerprintBytes_ <= tag.size();
+         offset += fingerprintBytes_) {
+        std::uint32_t fingerprint = 0;
+        for (std::size_t i = 0; i < fingerprintBytes_; ++i) {
+            fingerprint |= static_cast<std::uint32_t>(tag[offset + i]) << (8 * i);
+        }
+        if (fingerprint != 0) {
+            return fingerprint;
+        }
+    }
+    return 1;
+}
+
+std::size_t TagFilter::firstBucket(const Tag& tag) const {
+    std::uint64_t prefix;
+    std::memcpy(&prefix, tag.data(), sizeof prefix);
+    return static_cast<std::size_t>(prefix % bucketCount_);
+}
+
+std::size_t TagFilter::otherBucket(std::size_t bucket, std::uint32_t fingerprint) const {
+    const std::size_t offset = static_cast<std::size_t>(
+        (fingerprint * 0x9e3779b97f4a7c15ULL >> 32) % bucketCount_);
+    return (offset + bucketCount_ - bucket) % bucketCount_;
+}
+
+std::uint32_t TagFilter::slot(std::size_t bucket, std::size_t index) const {
+    const unsigned char* at =
+        table_.data() + (bucket * kTagFilterBucketSlots + index) * fingerprintBytes_;
+    std::uint32_t fingerprint = 0;
+    for (std::size_t i = 0; i < fingerprintBytes_; ++i) {
+        fingerprint |= static_cast<std::uint32_t>(at[i]) << (8 * i);
+    }
+    return fingerprint;
+}
+
+void TagFilter::setSlot(std::size_t bucket, std::size_t index, std::uint32_t fingerprint) {
+    unsigned char* at = table_.data() + (bucket * kTagFilterBucketSlots + index) * fingerprintBytes_;
+    for (std::size_t i = 0; i < fingerprintBytes_; ++i) {
+        at[i] = static_cast<unsigned char>(fingerprint >> (8 * i));
+    }
+}
+
+bool TagFilter::bucketHas(std::size_t bucket, std::uint32_t fingerprint) const {
+    for (std::size_t i = 0; i < kTagFilterBucketSlots; ++i) {
+        if (slot(bucket, i) == fingerprint) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TagFilter::tryPlace(std::size_t bucket, std::uint32_t fingerprint) {
+    for (std::size_t i = 0; i < kTagFilterBucketSlots; ++i) {
+        if (slot(bucket, i) == 0) {
+            setSlot(bucket, i, fingerprint);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Repeated tags (and tags that already test positive) are not stored twice.
+bool TagFilter::insert(const Tag& tag, std::uint64_t& evictionState) {
+    std::uint32_t fingerprint = fingerprintOf(tag);
+    std::size_t bucket = firstBucket(tag);
+    const std::size_t alternate = otherBucket(bucket, fingerprint);
+    if (bucketHas(bucket, fingerprint) || bucketHas(alternate, fingerprint)) {
+        return true;
+    }
+    if (tryPlace(bucket, fingerprint) || tryPlace(alternate, fingerprint)) {
+        return true;
+    }
+    if (nextEviction(evictionState) & 1) {
+        bucket = alternate;
+    }
+    for (std::size_t eviction = 0; eviction < kMaxEvictions; ++eviction) {
+        const std::size_t victim = nextEviction(evictionState) % kTagFilterBucketSlots;
+        const std::uint32_t evicted = slot(bucket, victim);
+        setSlot(bucket, victim, fingerprint);
+        fingerprint = evicted;
+        bucket = otherBucket(bucket, fingerprint);
+        if (tryPlace(bucket, fingerprint)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TagFilter::mayContain(const Tag& tag) const {
+    const std::uint32_t fingerprint = fingerprintOf(tag);
+    const std::size_t bucket = firstBucket(tag);
+    return bucketHas(bucket, fingerprint) || bucketHas(otherBucket(bucket, fingerprint), fingerprint);
+}
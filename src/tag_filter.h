@@ -0,0 +1,77 @@
+#ifndef TAG_FILTER_H
+#define TAG_FILTER_H
+
+// Cuckoo filter of membership tags, for Bob's compact tag flight (F). Each
+// tag is reduced to a short fingerprint held in one of two buckets of four
+// slots, so the flight costs about fingerprintBytes / 0.95 bytes per element
+// instead of 32. Alice probes her own tags against it; a tag Bob does not
+// hold still matches with probability at most 8 / (2^bits - 1), bits being
+// 8 * fingerprintBytes (two buckets of four slots, each holding one of the
+// 2^bits - 1 nonzero fingerprints), which is the rate the flight header
+// commits to by naming the fingerprint width.
+//
+// Tags are uniformly random, so no hashing is needed to place them: bytes
+// 0..7 pick the first bucket and the first nonzero fingerprintBytes-wide
+// window after them is the fingerprint. The second bucket is (h(fingerprint) - first) mod buckets, an
+// involution, so either bucket leads to the other without the tag and the
+// table can have any number of buckets, sized to about 95% load.
+// Construction is deterministic (evictions follow a fixed sequence), so the
+// same tags always give the same flight bytes.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "point_batch.h"
+
+inline constexpr std::size_t kTagFilterBucketSlots = 4;
+inline constexpr std::size_t kTagFilterMaxFingerprintBytes = 4;
+
+// Upper bound on the false-positive rate of a filter with this fingerprint
+// width (1 to 4 bytes): 8 / (2^(8 * fingerprintBytes) - 1).
+double tagFilterFalsePositiveRate(std::size_t fingerprintBytes);
+
+// The narrowest fingerprint whose rate is at most falsePositiveRate. Throws
+// std::runtime_error if no width up to 4 bytes reaches it or the rate is not
+// in (0, 1).
+std::size_t tagFilterFingerprintBytes(double falsePositiveRate);
+
+class TagFilter {
+public:
+    using Tag = TagBatch::Entry;
+
+    // Throws std::runtime_error on a fingerprint width outside 1..4.
+    static TagFilter build(const TagBatch& tags, std::size_t fingerprintBytes);
+
+    // A received filter. Throws std::runtime_error if the table is not
+    // bucketCount buckets of fingerprintBytes-wide slots.
+    TagFilter(std::size_t fingerprintBytes, std::size_t bucketCount,
+              std::vector<unsigned char> table);
+
+    bool mayContain(const Tag& tag) const;
+
+    std::size_t fingerprintBytes() const { return fingerprintBytes_; }
+    std::size_t bucketCount() const { return bucketCount_; }
+    double falsePositiveRate() const { return tagFilterFalsePositiveRate(fingerprintBytes_); }
+    // Bucket after bucket, slot after slot, each fingerprint little-endian;
+    // zero is an empty slot.
+    const std::vector<unsigned char>& table() const { return table_; }
+
+private:
+    TagFilter(std::size_t fingerprintBytes, std::size_t bucketCount);
+
+    std::uint32_t fingerprintOf(const Tag& tag) const;
+    std::size_t firstBucket(const Tag& tag) const;
+    std::size_t otherBucket(std::size_t bucket, std::uint32_t fingerprint) const;
+    std::uint32_t slot(std::size_t bucket, std::size_t index) const;
+    void setSlot(std::size_t bucket, std::size_t index, std::uint32_t fingerprint);
+    bool bucketHas(std::size_t bucket, std::uint32_t fingerprint) const;
+    bool tryPlace(std::size_t bucket, std::uint32_t fingerprint);
+    bool insert(const Tag& tag, std::uint64_t& evictionState);
+
+    std::size_t fingerprintBytes_;
+    std::size_t bucketCount_;
+    std::vector<unsigned char> table_;
+};
+
+#endif // TAG_FILTER_H
@@ -0,0 +1,131 @@
+#include "tag_set.h"
+
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Inserts are a few nanoseconds each; below this many tags the build stays
+// on the caller.
+constexpr std::size_t kParallelTagSetThreshold = 16384;
+constexpr std::size_t kMinSlots = 16;
+constexpr std::uint32_t kNoOwner = std::numeric_limits<std::uint32_t>::max();
+
+}  // namespace
+
+std::uint64_t TagSet::prefixOf(const Tag& tag) {
+    std::uint64_t prefix;
+    std::memcpy(&prefix, tag.data(), sizeof prefix);
+    return prefix;
+}
+
+TagSet::TagSet(const TagBatch& tags, const ExecutionPolicy* policy) {
+    std::size_t slots = kMinSlots;
+    while (slots < 2 * tags.size()) {
+        slots *= 2;
+    }
+    if (tags.size() >= kNoOwner) {
+        throw std::runtime_error("Tag flight too large to index");
+    }
+    slots_.resize(slots);
+    mask_ = slots - 1;
+
+    ExecutionPolicy execution = resolveExecutionPolicy(policy);
+    if (execution.serialThreshold < kParallelTagSetThreshold) {
+        execution.serialThreshold = kParallelTagSetThreshold;
+    }
+    std::vector<std::uint32_t> owners(slots, kNoOwner);
+    std::atomic<std::size_t> inserted{0};
+    parallelForChunks(execution, tags.size(), [&](std::size_t begin, std::size_t end) {
+        inserted.fetch_add(insertRange(tags, begin, end, owners.data()),
+                           std::memory_order_relaxed);
+    });
+    size_ = inserted.load(std::memory_order_relaxed);
+
+    // Each claimed slot takes the tail of the first tag in flight order with
+    // its prefix, so a forged tail wins or loses the same way however the
+    // build was split.
+    parallelForChunks(execution, slots, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t slot = begin; slot < end; ++slot) {
+            if (owners[slot] != kNoOwner) {
+                const Tag& owner = tags[owners[slot]];
+                std::memcpy(slots_[slot].data() + sizeof(std::uint64_t),
+                            owner.data() + sizeof(std::uint64_t),
+                            owner.size() - sizeof(std::uint64_t));
+            }
+        }
+    });
+
+    // The first zero-prefix tag in flight order, so the result does not
+    // depend on how the build was split.
+    for (const auto& tag : tags) {
+        if (prefixOf(tag) == 0) {
+            hasZeroPrefix_ = true;
+            zeroPrefixTag_ = tag;
+            break;
+        }
+    }
+    size_ += hasZeroPrefix_ ? 1 : 0;
+}
+
+// Slots are claimed by compare-and-swap on their prefix word. Every tag with
+// that prefix, the claimant included, then lowers the slot's owner to its
+// own flight index; the constructor copies the owner's other 24 bytes in
+// once the build has joined. Returns the number of slots claimed.
+std::size_t TagSet::insertRange(const TagBatch& tags, std::size_t begin, std::size_t end,
+                                std::uint32_t* owners) {
+    std::size_t inserted = 0;
+    for (std::size_t i = begin; i < end; ++i) {
+        const Tag& tag = tags[i];
+        const std::uint64_t prefix = prefixOf(tag);
+        if (prefix == 0) {
+            continue;
+        }
+        std::size_t slot = prefix & mask_;
+        for (std::size_t probe = 0;; ++probe, slot = (slot + 1) & mask_) {
+            if (probe == kMaxProbe) {
+                throw std::runtime_error("Tags are too clustered to be uniformly random");
+            }
+            auto* word = reinterpret_cast<std::uint64_t*>(slots_[slot].data());
+            std::uint64_t stored = __atomic_load_n(word, __ATOMIC_RELAXED);
+            if (stored == 0 &&
+                __atomic_compare_exchange_n(word, &stored, prefix, false, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                ++inserted;
+                stored = prefix;
+            }
+            if (stored == prefix) {
+                const auto index = static_cast<std::uint32_t>(i);
+                std::uint32_t owner = __atomic_load_n(&owners[slot], __ATOMIC_RELAXED);
+                while (index < owner &&
+                       !__atomic_compare_exchange_n(&owners[slot], &owner, index, true,
+                                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                }
+                break;
+            }
+        }
+    }
+    return inserted;
+}
+
+std::size_t TagSet::find(const Tag& tag) const {
+    const std::uint64_t prefix = prefixOf(tag);
+    if (prefix == 0) {
+        return hasZeroPrefix_ && zeroPrefixTag_ == tag ? slots_.size() : npos;
+    }
+    // No entry sits more than kMaxProbe slots past its home.
+    std::size_t slot = prefix & mask_;
+    for (std::size_t probe = 0; probe < kMaxProbe; ++probe, slot = (slot + 1) & mask_) {
+        const std::uint64_t stored = prefixOf(slots_[slot]);
+        if (stored == prefix) {
+            return slots_[slot] == tag ? slot : npos;
+        }
+        if (stored == 0) {
+            return npos;
+        }
+    }
+    return npos;
+}
@@ -0,0 +1,67 @@
+#ifndef TAG_SET_H
+#define TAG_SET_H
+
+// Flat open-addressing set of Bob's membership tags for tag-mode
+// finalisation. Tags are uniformly random 32-byte values, so their first 8
+// bytes are already a perfect hash: the home slot is the prefix masked to the
+// table size, there is no hash function to run, and a slot is one 32-byte
+// entry of a single cache-aligned allocation, probed linearly.
+//
+// The table is kept at most half full. Because the tags come from the peer,
+// an entry may sit at most kMaxProbe slots past its home; a flight that needs
+// more (prefixes chosen to collide) is rejected instead of degrading lookups
+// to a scan. Two tags with the same prefix are taken to be the same tag, the
+// first in flight order whichever way the build was split: for honest
+// flights that only happens for repeated elements, and a forged tail only
+// costs the forger matches.
+//
+// Slots are numbered below slotCount(), so callers can mark matches in a
+// bitmap indexed by the slot find() returns.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "execution_policy.h"
+#include "point_batch.h"
+
+class TagSet {
+public:
+    using Tag = TagBatch::Entry;
+    static constexpr std::size_t kMaxProbe = 512;
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    // Inserts in parallel chunks under policy for large flights. Throws
+    // std::runtime_error if the tags are too clustered to be genuine.
+    explicit TagSet(const TagBatch& tags, const ExecutionPolicy* policy = nullptr);
+
+    // The slot holding tag, or npos.
+    std::size_t find(const Tag& tag) const;
+    bool contains(const Tag& tag) const { return find(tag) != npos; }
+
+    // Starts loading tag's home slot, for callers that probe a batch.
+    void prefetch(const Tag& tag) const {
+#if defined(__GNUC__)
+        __builtin_prefetch(slots_.data() + (prefixOf(tag) & mask_));
+#else
+        (void)tag;
+#endif
+    }
+
+    std::size_t size() const { return size_; }
+    std::size_t slotCount() const { return slots_.size() + 1; }
+
+private:
+    static std::uint64_t prefixOf(const Tag& tag);
+    std::size_t insertRange(const TagBatch& tags, std::size_t begin, std::size_t end,
+                            std::uint32_t* owners);
+
+    // An all-zero prefix marks an empty slot, so the (never honest) tag with
+    // a zero prefix lives outside the table, as slot slots_.size().
+    TagBatch slots_;
+    std::size_t mask_{0};
+    std::size_t size_{0};
+    bool hasZeroPrefix_{false};
+    Tag zeroPrefixTag_{};
+};
+
+#endif // TAG_SET_H
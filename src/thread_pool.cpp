@@ -0,0 +1,262 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+namespace {
+
+// Identifies the pool worker running on this thread, so work submitted from
+// inside a task lands on that worker's own deque (LIFO, cache-warm) instead of
+// a round-robin victim.
+thread_local const ThreadPool* tlsPool = nullptr;
+thread_local std::size_t tlsWorkerIndex = 0;
+
+std::uint64_t elapsedNs(std::chrono::steady_clock::time_point from,
+                        std::chrono::steady_clock::time_point to) {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+}
+
+// Shared state of one parallelForRange call. Runners hold it by shared_ptr so
+// a runner that is dequeued after the caller returned still sees valid
+// counters; it then finds no chunk left and never touches `body`.
+struct RangeJob {
+    const std::function<void(std::size_t, std::size_t)>* body{nullptr};
+    std::size_t count{0};
+    std::size_t grain{1};
+    std::size_t chunkCount{0};
+    std::atomic<std::size_t> nextChunk{0};
+    std::atomic<std::size_t> completed{0};
+    std::vector<std::exception_ptr> errors;  // one slot per chunk
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+
+    void runChunks() {
+        while (true) {
+            const std::size_t chunk = nextChunk.fetch_add(1, std::memory_order_relaxed);
+            if (chunk >= chunkCount) {
+                return;
+            }
+            const std::size_t begin = chunk * grain;
+            const std::size_t end = std::min(begin + grain, count);
+            try {
+                (*body)(begin, end);
+            } catch (...) {
+                errors[chunk] = std::current_exception();
+            }
+            if (completed.fetch_add(1, std::memory_order_acq_rel) + 1 == chunkCount) {
+                std::lock_guard<std::mutex> lock(doneMutex);
+                doneCv.notify_all();
+            }
+        }
+    }
+};
+
+}  // namespace
+
+ThreadPool::ThreadPool(std::size_t workerCount) {
+    queues_.reserve(workerCount);
+    for (std::size_t i = 0; i < workerCount; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+    workers_.reserve(workerCount);
+    for (std::size_t i = 0; i < workerCount; ++i) {
+        workers_.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    sleepCv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool([]() -> std::size_t {
+        const unsigned hardware = std::thread::hardware_concurrency();
+        return hardware > 1 ? hardware - 1 : 1;
+    }());
+    return pool;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    if (workers_.empty()) {
+        // No workers: run inline so submitted work still completes.
+        Task inlineTask{std::move(task), std::chrono::steady_clock::now()};
+        runTask(inlineTask);
+        return;
+    }
+
+    const std::size_t target = (tlsPool == this)
+                                   ? tlsWorkerIndex
+                                   : nextQueue_.fetch_add(1, std::memory_order_relaxed) %
+                                         queues_.size();
+    {
+        std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+        queues_[target]->tasks.push_back({std::move(task), std::chrono::steady_clock::now()});
+    }
+    pending_.fetch_add(1, std::memory_order_release);
+    {
+        // Empty critical section: orders the pending_ increment against a
+        // worker that is between checking its wait predicate and sleeping.
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+    }
+    sleepCv_.notify_one();
+}
+
+bool ThreadPool::tryPop(std::size_t index, Task& task) {
+    {
+        auto& own = *queues_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            pending_.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+    for (std::size_t offset = 1; offset < queues_.size(); ++offset) {
+        auto& victim = *queues_[(index + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            pending_.fetch_sub(1, std::memory_order_acq_rel);
+            steals_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::runTask(Task& task) {
+    const auto start = std::chrono::steady_clock::now();
+    task.fn();
+    const auto finish = std::chrono::steady_clock::now();
+    tasksExecuted_.fetch_add(1, std::memory_order_relaxed);
+    queueWaitNs_.fetch_add(elapsedNs(task.enqueued, start), std::memory_order_relaxed);
+    computeNs_.fetch_add(elapsedNs(start, finish), std::memory_order_relaxed);
+}
+
+void ThreadPool::workerLoop(std::size_t index) {
+    tlsPool = this;
+    tlsWorkerIndex = index;
+    while (true) {
+        Task task;
+        if (tryPop(index, task)) {
+            runTask(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        sleepCv_.wait(lock, [this]() {
+            return stopping_ || pending_.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping_ && pending_.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+ThreadPoolStats ThreadPool::stats() const {
+    ThreadPoolStats out;
+    out.tasksExecuted = tasksExecuted_.load(std::memory_order_relaxed);
+    out.steals = steals_.load(std::memory_order_relaxed);
+    out.queueWaitNs = queueWaitNs_.load(std::memory_order_relaxed);
+    out.computeNs = computeNs_.load(std::memory_order_relaxed);
+    return out;
+}
+
+void ThreadPool::resetStats() {
+    tasksExecuted_.store(0, std::memory_order_relaxed);
+    steals_.store(0, std::memory_order_relaxed);
+    queueWaitNs_.store(0, std::memory_order_relaxed);
+    computeNs_.store(0, std::memory_order_relaxed);
+}
+
+void parallelForRange(ThreadPool& pool,
+                      std::size_t count,
+                      std::size_t grain,
+                      std::size_t maxParticipants,
+                      const std::function<void(std::size_t, std::size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+    grain = std::max<std::size_t>(grain, 1);
+
+    auto job = std::make_shared<RangeJob>();
+    job->body = &body;
+    job->count = count;
+    job->grain = grain;
+    job->chunkCount = (count + grain - 1) / grain;
+    job->errors.resize(job->chunkCount);
+
+    // One runner per helper thread; each keeps claiming chunks until none are
+    // left, so chunk count (load balance) and helper count are independent.
+    const std::size_t helpers =
+        std::min({maxParticipants > 0 ? maxParticipants - 1 : 0, pool.workerCount(),
+                  job->chunkCount - 1});
+    for (std::size_t h = 0; h < helpers; ++h) {
+        pool.submit([job]() { job->runChunks(); });
+    }
+
+    job->runChunks();
+
+    {
+        std::unique_lock<std::mutex> lock(job->doneMutex);
+        job->doneCv.wait(lock, [&]() {
+            return job->completed.load(std::memory_order_acquire) == job->chunkCount;
+        });
+    }
+
+    for (const auto& error : job->errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+BackgroundTask::BackgroundTask(std::function<void()> job) : job_(std::move(job)) {}
+
+std::shared_ptr<BackgroundTask> BackgroundTask::start(ThreadPool& pool,
+                                                      std::function<void()> job) {
+    std::shared_ptr<BackgroundTask> task(new BackgroundTask(std::move(job)));
+    // The queued closure keeps the task alive until a worker has looked at it,
+    // even if every other owner is gone by then.
+    pool.submit([task]() { task->runIfUnclaimed(); });
+    return task;
+}
+
+void BackgroundTask::runIfUnclaimed() {
+    if (claimed_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    std::exception_ptr error;
+    try {
+        job_();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    // Release whatever the job captured as soon as it has run.
+    job_ = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = error;
+        done_ = true;
+    }
+    doneCv_.notify_all();
+}
+
+void BackgroundTask::wait() {
+    runIfUnclaimed();
+    std::unique_lock<std::mutex> lock(mutex_);
+    doneCv_.wait(lock, [this]() { return done_; });
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
@@ -0,0 +1,137 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Persistent work-stealing pool behind the per-element protocol loops
+// (psi_protocol.cpp) and therefore every mesh cascade level (mesh_psi.cpp),
+// which runs its exchanges through the same entry points.
+//
+// Spawning and joining fresh std::threads on every protocol phase dominated
+// small exchanges (three to four phases per exchange, hundreds of exchanges
+// per second on a game server). The pool is started lazily on first use and
+// lives for the rest of the process; phases submit chunked index ranges to it
+// instead.
+//
+// Each worker owns a deque: it pops its own work LIFO and, when empty, steals
+// FIFO from the other workers. The thread that calls parallelForRange also
+// claims chunks itself until none are left, so nested calls (a pool task that
+// runs another parallel loop) cannot deadlock: a caller only ever waits for
+// chunks that another running thread has already claimed.
+//
+// The pool never changes results: chunks write by index into pre-sized
+// outputs, so wire transcripts stay byte-identical to the serial path (see
+// the SECURITY invariants in psi_protocol.cpp).
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Cumulative counters since construction (or the last resetStats()). A task
+// here is one pool-scheduled unit of work (one range runner or one submit()).
+// queueWaitNs much larger than computeNs means the pool is saturated: tasks
+// sit in deques longer than they take to run.
+struct ThreadPoolStats {
+    std::uint64_t tasksExecuted{0};
+    std::uint64_t steals{0};
+    std::uint64_t queueWaitNs{0};  // enqueue -> start, summed over tasks
+    std::uint64_t computeNs{0};    // start -> finish, summed over tasks
+};
+
+class ThreadPool {
+public:
+    // workerCount == 0 is allowed: every parallelForRange then runs entirely
+    // on the calling thread.
+    explicit ThreadPool(std::size_t workerCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t workerCount() const { return workers_.size(); }
+
+    // Queues a task. Tasks must not throw; parallelForRange captures worker
+    // exceptions itself and rethrows them on the caller.
+    void submit(std::function<void()> task);
+
+    ThreadPoolStats stats() const;
+    void resetStats();
+
+    // Process-wide pool, started on first call with one worker per hardware
+    // thread beyond the caller (at least one).
+    static ThreadPool& shared();
+
+private:
+    struct Task {
+        std::function<void()> fn;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(std::size_t index);
+    bool tryPop(std::size_t index, Task& task);
+    void runTask(Task& task);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::mutex sleepMutex_;
+    std::condition_variable sleepCv_;
+    std::atomic<std::size_t> pending_{0};
+    std::atomic<std::size_t> nextQueue_{0};
+    bool stopping_{false};
+
+    std::atomic<std::uint64_t> tasksExecuted_{0};
+    std::atomic<std::uint64_t> steals_{0};
+    std::atomic<std::uint64_t> queueWaitNs_{0};
+    std::atomic<std::uint64_t> computeNs_{0};
+};
+
+// Runs body(begin, end) over [0, count) split into chunks of `grain` indices,
+// on up to `maxParticipants` threads (the caller counts as one). body must
+// only touch state owned by its index range (or thread-safe state). The first
+// exception by chunk order is rethrown on the caller once every claimed chunk
+// has finished, so error reporting does not depend on scheduling.
+void parallelForRange(ThreadPool& pool,
+                      std::size_t count,
+                      std::size_t grain,
+                      std::size_t maxParticipants,
+                      const std::function<void(std::size_t, std::size_t)>& body);
+
+// One-shot job started on a pool ahead of when its result is needed (Alice's
+// unblinding inverses, computed while Bob's response is in flight). Whoever
+// gets to the job first runs it: a worker that picks up the queued task, or a
+// caller of wait() that finds it not yet started. wait() therefore never
+// depends on a worker being free, even on a saturated or worker-less pool.
+class BackgroundTask {
+public:
+    static std::shared_ptr<BackgroundTask> start(ThreadPool& pool, std::function<void()> job);
+
+    // Returns once the job has finished, running it on the caller if nobody
+    // has started it yet. Rethrows the job's exception on every call.
+    void wait();
+
+private:
+    explicit BackgroundTask(std::function<void()> job);
+    void runIfUnclaimed();
+
+    std::function<void()> job_;
+    std::atomic<bool> claimed_{false};
+    std::mutex mutex_;
+    std::condition_variable doneCv_;
+    bool done_{false};
+    std::exception_ptr error_;
+};
+
+#endif // THREAD_POOL_H
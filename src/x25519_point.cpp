@@ -0,0 +1,214 @@
+#include "x25519_point.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "curve25519_backend.h"
+#include "montgomery_ladder.h"
+#include "ristretto_ladder.h"
+
+namespace {
+
+#if defined(PSI_HAVE_FE51)
+
+using namespace ristretto_detail;
+
+constexpr Fe51 kA = {{486662, 0, 0, 0, 0}};
+constexpr Fe51 kTwo = {{2, 0, 0, 0, 0}};
+constexpr Fe51 kSqrtMinusAPlus2 = {{0x604aaff457e06ULL, 0x2296fa350598dULL, 0x7f13dfb16874fULL,
+                                    0x35de93d846e01ULL, 0xf26edf460a00ULL}};  // sqrt(-486664), even
+
+// RFC 9380 map_to_curve_elligator2 for Curve25519 (Z = 2), followed by the
+// rational map to edwards25519 of RFC 9380 appendix D. x = x1 = -A / (1 + 2t^2)
+// when g(x1) = x1^3 + A x1^2 + x1 is square, else x2 = 2t^2 * x1, where
+// g(x2) = 2t^2 * g(x1). One square-root ratio covers both cases: when g(x1)
+// is not square it returns sqrt(i * g(x1)), and t (i - 1) times that is a
+// root of g(x2). x stays a fraction xn / xd throughout, so the map needs no
+// inversion; the Edwards coordinates below are scaled by xd^2.
+GeP3 elligator2(const Fe51& t) {
+    const Fe51 one = fe51One();
+    const Fe51 twoTT = fe51Mul(fe51Sq(t), kTwo);
+    const Fe51 xd = fe51Add(one, twoTT);  // never zero: -1/2 is not a square
+    const Fe51 x1n = fe51Neg(kA);
+    const Fe51 x2n = fe51Mul(x1n, twoTT);
+
+    // g(x1) * xd^3 = x1n (x1n (x1n + A xd) + xd^2)
+    const Fe51 xd2 = fe51Sq(xd);
+    const Fe51 inner = fe51Mul(x1n, fe51Add(x1n, fe51Mul(kA, xd)));
+    const Fe51 gxn = fe51Mul(x1n, fe51Add(inner, xd2));
+    const Fe51 gxd = fe51Mul(xd2, xd);
+
+    Fe51 root;
+    const unsigned int notSquare = 1U - sqrtRatioM1(root, gxn, gxd);
+
+    // sgn0(y) = 1 for x1 and 0 for x2, as the RFC specifies.
+    Fe51 y = fe51Neg(root);
+    const Fe51 y2 = fe51Abs(fe51Mul(fe51Mul(t, fe51Sub(kSqrtM1, one)), root));
+    fe51Cmov(y, y2, notSquare);
+    Fe51 xn = x1n;
+    fe51Cmov(xn, x2n, notSquare);
+
+    // (v, w) = (sqrt(-486664) x / y, (x - 1) / (x + 1)); the exceptional
+    // inputs (y = 0 or x = -1) map to the identity.
+    const Fe51 xPlus = fe51Add(xn, xd);
+    const Fe51 xMinus = fe51Sub(xn, xd);
+    const Fe51 cx = fe51Mul(kSqrtMinusAPlus2, xn);
+    GeP3 p{fe51Mul(cx, xPlus), fe51Mul(fe51Mul(xMinus, y), xd), fe51Mul(fe51Mul(y, xPlus), xd),
+           fe51Mul(cx, xMinus)};
+    const unsigned int exceptional = fe51IsZero(p.Z);
+    const GeP3 identity = geIdentity();
+    fe51Cmov(p.X, identity.X, exceptional);
+    fe51Cmov(p.Y, identity.Y, exceptional);
+    fe51Cmov(p.Z, identity.Z, exceptional);
+    fe51Cmov(p.T, identity.T, exceptional);
+    return p;
+}
+
+// out[i] = u[i] / w[i], or zero where w[i] is zero (the point at infinity,
+// which X25519 also encodes as zero), with one inversion for the whole batch.
+void normalizeBatch(const Fe51* u, const Fe51* w, std::size_t count, Fe51* out) {
+    if (count == 0) {
+        return;
+    }
+    std::vector<Fe51> denominators(w, w + count);
+    std::vector<unsigned int> infinite(count);
+    std::vector<Fe51> prefix(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        infinite[i] = fe51IsZero(denominators[i]);
+        fe51Cmov(denominators[i], fe51One(), infinite[i]);
+        prefix[i] = i == 0 ? denominators[0] : fe51Mul(prefix[i - 1], denominators[i]);
+    }
+
+    Fe51 running = fe51Invert(prefix[count - 1]);
+    for (std::size_t i = count - 1; i > 0; --i) {
+        out[i] = fe51Mul(u[i], fe51Mul(running, prefix[i - 1]));
+        running = fe51Mul(running, denominators[i]);
+    }
+    out[0] = fe51Mul(u[0], running);
+    for (std::size_t i = 0; i < count; ++i) {
+        fe51Cmov(out[i], fe51Zero(), infinite[i]);
+    }
+}
+
+// One ladder on the active backend. There is no four-way ladder, so the
+// avx2 backend takes mulx here, as it does for single ristretto products.
+void ladderOne(FieldBackend backend, const unsigned char* scalar, const Fe51& u, Fe51& outU,
+               Fe51& outW) {
+#if defined(PSI_HAVE_X86_BACKENDS)
+    if (backend != FieldBackend::Portable && fieldBackendSupported(FieldBackend::Mulx)) {
+        x25519LadderMulx(scalar, u, outU, outW);
+        return;
+    }
+#else
+    (void)backend;
+#endif
+    montgomery_detail::montgomeryLadder(scalar, u, outU, outW);
+}
+
+// out[i] = encoding of scalars[i * scalarStride] * in[i]; a stride of 0
+// repeats one scalar.
+void scalarMultMany(const std::array<unsigned char, 32>* scalars, std::size_t scalarStride,
+                    const X25519Element* in, std::size_t count,
+                    std::array<unsigned char, 32>* out) {
+    const FieldBackend backend = activeFieldBackend();
+    std::vector<Fe51> u(count);
+    std::vector<Fe51> w(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        ladderOne(backend, scalars[i * scalarStride].data(), in[i].u, u[i], w[i]);
+    }
+    normalizeBatch(u.data(), w.data(), count, u.data());
+    for (std::size_t i = 0; i < count; ++i) {
+        fe51ToBytes(out[i].data(), u[i]);
+    }
+}
+
+#else
+
+[[noreturn]] void throwUnsupported() {
+    throw std::runtime_error("The x25519 group needs 128-bit integer arithmetic");
+}
+
+#endif  // PSI_HAVE_FE51
+
+}  // namespace
+
+#if defined(PSI_HAVE_FE51)
+
+bool x25519Decode(X25519Element& out, const unsigned char in[32]) {
+    out.u = fe51FromBytes(in);
+    unsigned char canonical[32];
+    fe51ToBytes(canonical, out.u);
+    return std::equal(canonical, canonical + 32, in);
+}
+
+void x25519Encode(unsigned char out[32], const X25519Element& element) {
+    fe51ToBytes(out, element.u);
+}
+
+void x25519FromHashBatch(const std::array<unsigned char, 64>* hashes, std::size_t count,
+                         X25519Element* out) {
+    std::vector<Fe51> u(count);
+    std::vector<Fe51> w(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const GeP3 p0 = elligator2(fe51FromBytes(hashes[i].data()));
+        const GeP3 p1 = elligator2(fe51FromBytes(hashes[i].data() + 32));
+        GeP1P1 r = geAdd(p0, geToCached(p1));
+        r = geDbl(geToP2(r));
+        r = geDbl(geToP2(r));
+        r = geDbl(geToP2(r));
+        // u = (1 + y) / (1 - y), projectively (Z + Y : Z - Y).
+        const GeP2 p = geToP2(r);
+        u[i] = fe51Add(p.Z, p.Y);
+        w[i] = fe51Sub(p.Z, p.Y);
+    }
+    std::vector<Fe51> affine(count);
+    normalizeBatch(u.data(), w.data(), count, affine.data());
+    for (std::size_t i = 0; i < count; ++i) {
+        out[i].u = affine[i];
+    }
+}
+
+void x25519ScalarMultBatch(const std::array<unsigned char, 32>& scalar, const X25519Element* in,
+                           std::size_t count, std::array<unsigned char, 32>* out) {
+    scalarMultMany(&scalar, 0, in, count, out);
+}
+
+void x25519ScalarMultBatch(const std::array<unsigned char, 32>* scalars, const X25519Element* in,
+                           std::size_t count, std::array<unsigned char, 32>* out) {
+    scalarMultMany(scalars, 1, in, count, out);
+}
+
+#else
+
+bool x25519Decode(X25519Element& out, const unsigned char in[32]) {
+    std::copy(in, in + 32, out.encoded.begin());
+    // Canonical: below 2^255 - 19 = 0x7fff...ffed, bit 255 clear.
+    if (in[31] > 0x7f) {
+        return false;
+    }
+    if (in[31] < 0x7f || in[0] < 0xed) {
+        return true;
+    }
+    return !std::all_of(in + 1, in + 31, [](unsigned char b) { return b == 0xff; });
+}
+
+void x25519Encode(unsigned char out[32], const X25519Element& element) {
+    std::copy(element.encoded.begin(), element.encoded.end(), out);
+}
+
+void x25519FromHashBatch(const std::array<unsigned char, 64>*, std::size_t, X25519Element*) {
+    throwUnsupported();
+}
+
+void x25519ScalarMultBatch(const std::array<unsigned char, 32>&, const X25519Element*,
+                           std::size_t, std::array<unsigned char, 32>*) {
+    throwUnsupported();
+}
+
+void x25519ScalarMultBatch(const std::array<unsigned char, 32>*, const X25519Element*,
+                           std::size_t, std::array<unsigned char, 32>*) {
+    throwUnsupported();
+}
+
+#endif  // PSI_HAVE_FE51
@@ -0,0 +1,67 @@
+#ifndef X25519_POINT_H
+#define X25519_POINT_H
+
+// Internal elements of the x25519 group of ciphersuite v3 (ciphersuite.h):
+// the subgroup of Curve25519 of prime order l, the order of ristretto255, so
+// protocol scalars carry over unchanged.
+//
+// A point is represented by its Montgomery u-coordinate alone, as in X25519:
+// 32 little-endian bytes on the wire, an affine field element internally.
+// u determines a point up to sign, which is all the x-only ladder needs, since
+// u(k * P) = u(k * -P) for every k.
+//
+// Cofactor. Curve25519 has order 8 * l, and a u-coordinate received from the
+// wire may also lie on the quadratic twist (order 4 * l'). Everything produced
+// here from hashes is in the order-l subgroup: x25519FromHashBatch multiplies by
+// the cofactor 8 before returning. Decoding does NOT check subgroup
+// membership, which would cost a full ladder per point; instead whoever
+// multiplies a counterparty's point by a secret reused across points scales
+// that secret by 8 first, which kills any small-order component
+// (group_backend.cpp). Twist points only ever meet scalars through the
+// ladder, which is twist-secure by design (RFC 7748, section 7).
+//
+// Multiplication runs on the field backend picked at startup
+// (curve25519_backend.h). Constant-time in scalars. Without 128-bit integer
+// support there is no field arithmetic here: decoding and encoding still
+// work on the bytes, the hash and the ladder throw std::runtime_error.
+
+#include <array>
+#include <cstddef>
+
+#include "curve25519_fe51.h"
+
+#if defined(PSI_HAVE_FE51)
+struct X25519Element {
+    Fe51 u;
+};
+#else
+struct X25519Element {
+    std::array<unsigned char, 32> encoded;
+};
+#endif
+
+// False unless `in` is a canonical u-coordinate: bit 255 clear and the value
+// below 2^255 - 19. Canonical bytes are the only encoding of each point, as
+// tags and keys are derived from them.
+bool x25519Decode(X25519Element& out, const unsigned char in[32]);
+
+void x25519Encode(unsigned char out[32], const X25519Element& element);
+
+// Hash-to-curve of a 64-byte uniform string, the random-oracle construction
+// of RFC 9380 over the same input ristrettoFromHash takes: each half (bit 255
+// ignored) goes through the Elligator 2 map to Curve25519 (Z = 2), both
+// points are added on edwards25519, and the sum is multiplied by 8. One field
+// inversion per batch, shared with Montgomery's trick.
+void x25519FromHashBatch(const std::array<unsigned char, 64>* hashes, std::size_t count,
+                         X25519Element* out);
+
+// out[i] = encoded u(scalar * in[i]) (or scalars[i] * in[i]) for i in
+// [0, count). The scalars are used as given, all 256 bits, with no clamping.
+// The point at infinity encodes to 32 zero bytes, which callers treat as
+// failure, as with ristretto255.
+void x25519ScalarMultBatch(const std::array<unsigned char, 32>& scalar, const X25519Element* in,
+                           std::size_t count, std::array<unsigned char, 32>* out);
+void x25519ScalarMultBatch(const std::array<unsigned char, 32>* scalars, const X25519Element* in,
+                           std::size_t count, std::array<unsigned char, 32>* out);
+
+#endif // X25519_POINT_H
@@ -10,10 +10,12 @@
 #include <fstream>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "audit.h"
 #include "derivation.h"
+#include "psi_protocol.h"
 #include "serialization_utils.h"
 #include "session.h"
 #include "transcript.h"
@@ -68,9 +70,21 @@ struct SessionFixture {
     SessionFixture() { gameId.fill(0x55); }
 
     RecordedExchangeResult run(const std::string& path,
-                               const std::vector<std::string>* psiElementsQ = nullptr) const {
+                               const std::vector<std::string>* psiElementsQ = nullptr,
+                               CipherSuite suite = CipherSuite::V1,
+                               WireFormat format = WireFormat::Text) const {
         return runRecordedExchange(masterKeyP, masterKeyQ, elementsP, elementsQ, turn, nMax,
-                                   gameId, keysP, keysQ, path, nullptr, psiElementsQ);
+                                   gameId, keysP, keysQ, path, nullptr, psiElementsQ, suite,
+                                   format);
+    }
+
+    RecordedExchangeResult runMutual(const std::string& path,
+                                     const std::vector<std::string>* psiElementsQ = nullptr,
+                                     CipherSuite suite = CipherSuite::V1,
+                                     WireFormat format = WireFormat::Text) const {
+        return runMutualRecordedExchange(masterKeyP, masterKeyQ, elementsP, elementsQ, turn,
+                                         nMax, gameId, keysP, keysQ, path, nullptr,
+                                         psiElementsQ, suite, format);
     }
 
     AuditOpening openingForQ() const {
@@ -217,6 +231,221 @@ TEST(AuditTest, ProbeForgeryIsFraudWithPlausibleLocation) {
     EXPECT_EQ(verdictExitCode(verdict), 2);
 }
 
+// The auditor takes the suite from each recorded tag flight's header, so a
+// v2 or v3 turn audits like a v1 one and a forgery is still caught at the
+// tags. v3 also recomputes in the x25519 group.
+TEST(AuditTest, AuditRecomputesUnderTheSuiteTheTagFlightNames) {
+    for (const auto suite : {CipherSuite::V2, CipherSuite::V3}) {
+#if !defined(PSI_HAVE_FE51)
+        if (cipherSuiteGroup(suite) == Group::X25519) {
+            continue;
+        }
+#endif
+        SCOPED_TRACE(cipherSuiteName(suite));
+        SessionFixture fixture;
+        const std::string name = cipherSuiteName(suite);
+        const auto honestPath = fixture.tempPath("honest_" + name + ".transcript");
+        const auto result = fixture.run(honestPath, nullptr, suite);
+        EXPECT_EQ(std::set<std::string>(result.intersectionSeenByP.begin(),
+                                        result.intersectionSeenByP.end()),
+                  (std::set<std::string>{"L1:10 12", "L1:40 41"}));
+
+        const auto records = readTranscript(honestPath);
+        for (const auto& record : records) {
+            if (record.msgType == kMsgTypeTags) {
+                EXPECT_EQ(suite, messageCipherSuite(
+                                     std::string(record.body.begin(), record.body.end())));
+            }
+        }
+        EXPECT_EQ(auditTranscript(records, fixture.openingForQ(), fixture.keysP.publicKey,
+                                  fixture.keysQ.publicKey)
+                      .verdict,
+                  AuditResult::Verdict::Honest);
+
+        std::vector<std::string> probeQ = fixture.elementsQ;
+        probeQ[1] = "L1:99 99";
+        const auto forgedPath = fixture.tempPath("forged_" + name + ".transcript");
+        fixture.run(forgedPath, &probeQ, suite);
+        const auto verdict = auditTranscript(readTranscript(forgedPath), fixture.openingForQ(),
+                                             fixture.keysP.publicKey, fixture.keysQ.publicKey);
+        ASSERT_EQ(verdict.verdict, AuditResult::Verdict::Fraud);
+        EXPECT_EQ(verdict.dir, 0);
+        EXPECT_EQ(verdict.msgType, kMsgTypeTags);
+    }
+}
+
+// Binary flight bodies audit like text ones: the recomputation follows the
+// format the recorded tag flight uses, and a fraud offset is a byte offset
+// into the binary body.
+TEST(AuditTest, BinaryTranscriptsAuditByteForByte) {
+    SessionFixture fixture;
+    const auto honestPath = fixture.tempPath("honest_binary.transcript");
+    fixture.run(honestPath, nullptr, CipherSuite::V2, WireFormat::Binary);
+    const auto records = readTranscript(honestPath);
+    for (const auto& record : records) {
+        EXPECT_EQ(kBinaryWireMagic, record.body.at(0));
+    }
+    EXPECT_EQ(auditTranscript(records, fixture.openingForQ(), fixture.keysP.publicKey,
+                              fixture.keysQ.publicKey)
+                  .verdict,
+              AuditResult::Verdict::Honest);
+
+    std::vector<std::string> probeQ = fixture.elementsQ;
+    probeQ[1] = "L1:99 99";
+    const auto forgedPath = fixture.tempPath("forged_binary.transcript");
+    fixture.run(forgedPath, &probeQ, CipherSuite::V2, WireFormat::Binary);
+    const auto verdict = auditTranscript(readTranscript(forgedPath), fixture.openingForQ(),
+                                         fixture.keysP.publicKey, fixture.keysQ.publicKey);
+    ASSERT_EQ(verdict.verdict, AuditResult::Verdict::Fraud);
+    EXPECT_EQ(verdict.msgType, kMsgTypeTags);
+    EXPECT_GE(verdict.byteOffset, 4u);  // past magic, type, suite and count
+}
+
+// Tag flights list tags in padded element order (spec section 5). A flight
+// built that way one element at a time, as every transcript recorded before
+// any re-sorting was, audits HONEST; the same tags sorted are FRAUD.
+TEST(AuditTest, TagFlightInElementOrderAudits) {
+    SessionFixture fixture;
+    const auto path = fixture.tempPath("element_order.transcript");
+    fixture.run(path);
+    auto records = readTranscript(path);
+    ASSERT_EQ(kMsgTypeTags, records[0].msgType);
+    ASSERT_EQ(0, records[0].dir);
+
+    // Q is Bob in dir 0: one fresh DeterministicRng per element yields the
+    // same scalar each time, so each tag is computed on its own.
+    const auto seedQ = turnSeed(fixture.masterKeyQ, fixture.turn);
+    const auto padded =
+        padElements(fixture.elementsQ, fixture.nMax, subseed(seedQ, 0, 0, 2));
+    TagBatch tags(padded.size());
+    for (std::size_t i = 0; i < padded.size(); ++i) {
+        DeterministicRng rng(seedQ, 0, 0);
+        tags[i] = bobCreateInitialTagMessageFromElements({padded[i]}, nullptr, &rng).tags[0];
+    }
+    auto resignTags = [&](const TagBatch& flight) {
+        const auto body = serializeBobTagMessage(flight, CipherSuite::V1, WireFormat::Text);
+        records[0].body.assign(body.begin(), body.end());
+        signRecord(records[0], fixture.keysQ.secretKey);
+        return auditTranscript(records, fixture.openingForQ(), fixture.keysP.publicKey,
+                               fixture.keysQ.publicKey);
+    };
+
+    EXPECT_EQ(resignTags(tags).verdict, AuditResult::Verdict::Honest);
+
+    TagBatch sorted = tags;
+    std::sort(sorted.begin(), sorted.end());
+    ASSERT_NE(sorted, tags);
+    const auto verdict = resignTags(sorted);
+    EXPECT_EQ(verdict.verdict, AuditResult::Verdict::Fraud);
+    EXPECT_EQ(verdict.msgType, kMsgTypeTags);
+}
+
+// Alice's blinded flight can be sent before Bob's tag flight arrives
+// (alicePrepareBlinded), so a transcript recording it first audits the same.
+TEST(AuditTest, BlindedFlightMayPrecedeTagFlight) {
+    SessionFixture fixture;
+    auto swapFirstFlights = [](std::vector<TranscriptRecord> records) {
+        for (std::size_t i = 0; i + 1 < records.size(); ++i) {
+            if (records[i].msgType == kMsgTypeTags &&
+                records[i + 1].msgType == kMsgTypeBlinded) {
+                std::swap(records[i], records[i + 1]);
+            }
+        }
+        return records;
+    };
+
+    const auto honestPath = fixture.tempPath("blinded_first.transcript");
+    fixture.run(honestPath);
+    const auto records = swapFirstFlights(readTranscript(honestPath));
+    ASSERT_EQ(kMsgTypeBlinded, records[0].msgType);
+    ASSERT_EQ(kMsgTypeBlinded, records[3].msgType);
+    EXPECT_EQ(auditTranscript(records, fixture.openingForQ(), fixture.keysP.publicKey,
+                              fixture.keysQ.publicKey)
+                  .verdict,
+              AuditResult::Verdict::Honest);
+    AuditOpening openingP = fixture.openingForQ();
+    openingP.accused = 'P';
+    openingP.key = fixture.masterKeyP;
+    openingP.elements = fixture.elementsP;
+    EXPECT_EQ(auditTranscript(records, openingP, fixture.keysP.publicKey,
+                              fixture.keysQ.publicKey)
+                  .verdict,
+              AuditResult::Verdict::Honest);
+
+    std::vector<std::string> probeQ = fixture.elementsQ;
+    probeQ[1] = "L1:99 99";
+    const auto forgedPath = fixture.tempPath("blinded_first_forged.transcript");
+    fixture.run(forgedPath, &probeQ);
+    const auto verdict =
+        auditTranscript(swapFirstFlights(readTranscript(forgedPath)), fixture.openingForQ(),
+                        fixture.keysP.publicKey, fixture.keysQ.publicKey);
+    ASSERT_EQ(verdict.verdict, AuditResult::Verdict::Fraud);
+    EXPECT_EQ(verdict.dir, 0);
+    EXPECT_EQ(verdict.msgType, kMsgTypeTags);
+}
+
+// A mutual turn sends the same six signed flights in two round trips, each
+// party's tags and blinded points together, and audits per (level, dir) as
+// the sequential turn does.
+TEST(AuditTest, MutualTurnRecordsTheSequentialFlights) {
+    SessionFixture fixture;
+    for (const auto format : {WireFormat::Text, WireFormat::Binary}) {
+        SCOPED_TRACE(wireFormatName(format));
+        const std::string name = wireFormatName(format);
+        const auto sequentialPath = fixture.tempPath("sequential_" + name + ".transcript");
+        const auto sequential = fixture.run(sequentialPath, nullptr, CipherSuite::V2, format);
+        const auto mutualPath = fixture.tempPath("mutual_" + name + ".transcript");
+        const auto mutual = fixture.runMutual(mutualPath, nullptr, CipherSuite::V2, format);
+        EXPECT_EQ(mutual.commitmentP, sequential.commitmentP);
+        EXPECT_EQ(mutual.commitmentQ, sequential.commitmentQ);
+        EXPECT_EQ(mutual.intersectionSeenByP, sequential.intersectionSeenByP);
+        EXPECT_EQ(mutual.intersectionSeenByQ, sequential.intersectionSeenByQ);
+
+        const auto records = readTranscript(mutualPath);
+        const auto sequentialRecords = readTranscript(sequentialPath);
+        ASSERT_EQ(records.size(), 6u);
+        const std::vector<std::pair<int, int>> expectedOrder = {
+            {1, kMsgTypeTags},        {0, kMsgTypeBlinded},     {0, kMsgTypeTags},
+            {1, kMsgTypeBlinded},     {1, kMsgTypeTransformed}, {0, kMsgTypeTransformed},
+        };
+        for (std::size_t i = 0; i < records.size(); ++i) {
+            EXPECT_EQ(expectedOrder[i], std::make_pair(int(records[i].dir),
+                                                       int(records[i].msgType)));
+            const auto same = std::find_if(
+                sequentialRecords.begin(), sequentialRecords.end(), [&](const auto& record) {
+                    return record.dir == records[i].dir &&
+                           record.msgType == records[i].msgType;
+                });
+            ASSERT_NE(same, sequentialRecords.end());
+            EXPECT_EQ(same->body, records[i].body);
+            EXPECT_EQ(same->signature, records[i].signature);
+        }
+
+        EXPECT_EQ(auditTranscript(records, fixture.openingForQ(), fixture.keysP.publicKey,
+                                  fixture.keysQ.publicKey)
+                      .verdict,
+                  AuditResult::Verdict::Honest);
+        AuditOpening openingP = fixture.openingForQ();
+        openingP.accused = 'P';
+        openingP.key = fixture.masterKeyP;
+        openingP.elements = fixture.elementsP;
+        EXPECT_EQ(auditTranscript(records, openingP, fixture.keysP.publicKey,
+                                  fixture.keysQ.publicKey)
+                      .verdict,
+                  AuditResult::Verdict::Honest);
+    }
+
+    std::vector<std::string> probeQ = fixture.elementsQ;
+    probeQ[1] = "L1:99 99";
+    const auto forgedPath = fixture.tempPath("mutual_forged.transcript");
+    fixture.runMutual(forgedPath, &probeQ);
+    const auto verdict = auditTranscript(readTranscript(forgedPath), fixture.openingForQ(),
+                                         fixture.keysP.publicKey, fixture.keysQ.publicKey);
+    ASSERT_EQ(verdict.verdict, AuditResult::Verdict::Fraud);
+    EXPECT_EQ(verdict.dir, 0);
+    EXPECT_EQ(verdict.msgType, kMsgTypeTags);
+}
+
 TEST(AuditTest, TamperedBodyFailsSignatureVerification) {
     SessionFixture fixture;
     const auto path = fixture.tempPath("tampered.transcript");
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "base64_batch.h"
+#include "serialization_utils.h"
+#include "test_helpers.h"
+
+namespace {
+
+class Base64BackendGuard {
+public:
+    explicit Base64BackendGuard(Base64Backend backend) : previous_(activeBase64Backend()) {
+        setBase64Backend(backend);
+    }
+    ~Base64BackendGuard() { setBase64Backend(previous_); }
+
+    Base64BackendGuard(const Base64BackendGuard&) = delete;
+    Base64BackendGuard& operator=(const Base64BackendGuard&) = delete;
+
+private:
+    Base64Backend previous_;
+};
+
+std::vector<Base64Backend> supportedBackends() {
+    std::vector<Base64Backend> backends;
+    for (const auto backend : {Base64Backend::Portable, Base64Backend::Avx2}) {
+        if (base64BackendSupported(backend)) {
+            backends.push_back(backend);
+        }
+    }
+    return backends;
+}
+
+std::string sodiumEncode(const unsigned char* data, std::size_t size) {
+    std::string encoded(
+        sodium_base64_encoded_len(size, sodium_base64_VARIANT_URLSAFE_NO_PADDING), '\0');
+    sodium_bin2base64(encoded.data(), encoded.size(), data, size,
+                      sodium_base64_VARIANT_URLSAFE_NO_PADDING);
+    encoded.pop_back();
+    return encoded;
+}
+
+bool sodiumDecodes(const std::string& encoded) {
+    unsigned char out[64];
+    std::size_t size = 0;
+    return sodium_base642bin(out, sizeof out, encoded.data(), encoded.size(), nullptr, &size,
+                             nullptr, sodium_base64_VARIANT_URLSAFE_NO_PADDING) == 0 &&
+           size == kBase64ValueBytes;
+}
+
+}  // namespace
+
+// Random values plus the edge bytes that exercise every alphabet range,
+// encoded with a stride and decoded back, against libsodium.
+TEST(Base64BatchTest, EveryBackendMatchesLibsodium) {
+    ensureSodiumInit();
+    constexpr std::size_t kCount = 67;
+    constexpr std::size_t kStride = kBase64ValueChars + 2;
+    std::vector<unsigned char> values(kCount * kBase64ValueBytes);
+    randombytes_buf(values.data(), values.size());
+    for (std::size_t i = 0; i < kBase64ValueBytes; ++i) {
+        values[i] = 0x00;
+        values[kBase64ValueBytes + i] = 0xff;
+        values[2 * kBase64ValueBytes + i] = static_cast<unsigned char>(i * 8);
+    }
+
+    for (const auto backend : supportedBackends()) {
+        SCOPED_TRACE(base64BackendName(backend));
+        const Base64BackendGuard guard(backend);
+
+        std::string encoded(kCount * kStride, '|');
+        base64EncodeBatch32(values.data(), kCount, encoded.data(), kStride);
+        for (std::size_t i = 0; i < kCount; ++i) {
+            EXPECT_EQ(sodiumEncode(values.data() + i * kBase64ValueBytes, kBase64ValueBytes),
+                      encoded.substr(i * kStride, kBase64ValueChars))
+                << "index " << i;
+            EXPECT_EQ("||", encoded.substr(i * kStride + kBase64ValueChars, 2));
+        }
+
+        std::vector<unsigned char> decoded(values.size());
+        EXPECT_EQ(kCount, base64DecodeBatch32(encoded.data(), kStride, kCount, decoded.data()));
+        EXPECT_EQ(values, decoded);
+    }
+}
+
+// The decoders reject what libsodium rejects: a wrong character in either the
+// vector or the scalar part, and nonzero unused bits at the end. Bytes from
+// 0x80 up are rejected too, although libsodium may read them as '_'.
+TEST(Base64BatchTest, DecodersRejectWhatLibsodiumRejects) {
+    ensureSodiumInit();
+    std::vector<unsigned char> value(kBase64ValueBytes);
+    randombytes_buf(value.data(), value.size());
+    const std::string canonical = sodiumEncode(value.data(), value.size());
+
+    std::vector<std::string> cases;
+    for (const std::size_t position : {0u, 13u, 31u, 32u, 40u, 42u}) {
+        for (const char bad : {'+', '/', '=', ' ', '\0', '\x80', '\xff', '@', '[', '`', '{'}) {
+            std::string mutated = canonical;
+            mutated[position] = bad;
+            cases.push_back(mutated);
+        }
+    }
+    // The last character carries two unused bits: 'A' leaves them clear,
+    // 'B', 'C' and 'D' do not.
+    for (const char last : {'A', 'B', 'C', 'D', 'E', 'Q', '_'}) {
+        std::string mutated = canonical;
+        mutated[42] = last;
+        cases.push_back(mutated);
+    }
+
+    for (const auto backend : supportedBackends()) {
+        SCOPED_TRACE(base64BackendName(backend));
+        const Base64BackendGuard guard(backend);
+        for (const auto& encoded : cases) {
+            unsigned char out[kBase64ValueBytes];
+            const bool accepted = base64DecodeBatch32(encoded.data(), 0, 1, out) == 1;
+            const bool highByte = std::any_of(encoded.begin(), encoded.end(),
+                                              [](char c) { return (c & 0x80) != 0; });
+            EXPECT_EQ(sodiumDecodes(encoded) && !highByte, accepted) << encoded;
+        }
+
+        // The first failing value is reported.
+        std::string flight = canonical + canonical + cases[3] + cases[0];
+        std::vector<unsigned char> decoded(4 * kBase64ValueBytes);
+        EXPECT_EQ(2u, base64DecodeBatch32(flight.data(), kBase64ValueChars, 4, decoded.data()));
+    }
+}
+
+TEST(Base64BatchTest, AnyLengthEncodingMatchesLibsodium) {
+    ensureSodiumInit();
+    std::vector<unsigned char> data(100);
+    randombytes_buf(data.data(), data.size());
+    for (std::size_t size = 0; size <= data.size(); ++size) {
+        std::string encoded(base64EncodedLength(size), '\0');
+        base64EncodeTo(data.data(), size, encoded.data());
+        EXPECT_EQ(sodiumEncode(data.data(), size), encoded) << "size " << size;
+        EXPECT_EQ(encoded, base64Encode(data.data(), size));
+    }
+    EXPECT_EQ(Base64Backend::Portable, parseBase64Backend("portable"));
+    EXPECT_THROW(parseBase64Backend("neon"), std::runtime_error);
+}
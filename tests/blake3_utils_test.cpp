@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "blake3_utils.h"
+
+namespace {
+
+template <std::size_t N>
+std::string toHex(const std::array<unsigned char, N>& digest) {
+    static const char* const kDigits = "0123456789abcdef";
+    std::string hex;
+    for (const auto byte : digest) {
+        hex.push_back(kDigits[byte >> 4]);
+        hex.push_back(kDigits[byte & 0x0f]);
+    }
+    return hex;
+}
+
+// The official BLAKE3 test-vector input: byte i is i mod 251.
+std::vector<unsigned char> vectorInput(std::size_t length) {
+    std::vector<unsigned char> input(length);
+    for (std::size_t i = 0; i < length; ++i) {
+        input[i] = static_cast<unsigned char>(i % 251);
+    }
+    return input;
+}
+
+}  // namespace
+
+// Multi-chunk lengths go through blake3_hash_many, i.e. the SIMD kernels the
+// dispatcher picks on this CPU; short ones through the single-block compress.
+TEST(Blake3UtilsTest, MatchesOfficialTestVectors) {
+    const std::vector<std::pair<std::size_t, std::string>> vectors = {
+        {0, "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262"},
+        {1, "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213"},
+        {1023, "10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11"},
+        {1024, "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7"},
+        {1025, "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444"},
+        {2049, "5f4d72f40d7a5f82b15ca2b2e44b1de3c2ef86c426c95c1af0b6879522563030"},
+        {8193, "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b"},
+        {102400, "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085"},
+    };
+    for (const auto& [length, expected] : vectors) {
+        EXPECT_EQ(expected, toHex(blake3Hash(vectorInput(length)))) << "length " << length;
+    }
+
+    const auto input = vectorInput(4097);
+    EXPECT_EQ("aae52286dda707ab7a180837334b2768e0540e0fe035b8b2f8991598b9eb4644",
+              toHex(blake3DeriveKey("PSI-test-vectors", input.data(), input.size())));
+}
+
+// 31 inputs: three eight-lane groups and a seven-input tail, at every length
+// class a single block allows.
+TEST(Blake3UtilsTest, ManyMatchesPerInputCalls) {
+    constexpr std::size_t kCount = 31;
+    for (const std::size_t length : {std::size_t{0}, std::size_t{1}, std::size_t{32},
+                                     std::size_t{36}, std::size_t{63}, std::size_t{64}}) {
+        SCOPED_TRACE("length " + std::to_string(length));
+        std::vector<std::vector<unsigned char>> inputs(kCount);
+        std::vector<const unsigned char*> pointers(kCount);
+        for (std::size_t i = 0; i < kCount; ++i) {
+            inputs[i].resize(length);
+            for (std::size_t j = 0; j < length; ++j) {
+                inputs[i][j] = static_cast<unsigned char>(i * 13 + j);
+            }
+            pointers[i] = inputs[i].data();
+        }
+
+        std::vector<std::array<unsigned char, 32>> hashed(kCount);
+        std::vector<std::array<unsigned char, 32>> derived(kCount);
+        blake3HashMany(pointers.data(), length, kCount, hashed.data());
+        blake3DeriveKeyMany("PSI-test-context", pointers.data(), length, kCount, derived.data());
+        for (std::size_t i = 0; i < kCount; ++i) {
+            EXPECT_EQ(blake3Hash(inputs[i]), hashed[i]) << "index " << i;
+            EXPECT_EQ(blake3DeriveKey("PSI-test-context", inputs[i].data(), length), derived[i])
+                << "index " << i;
+        }
+    }
+
+    std::vector<std::array<unsigned char, 32>> keys(kCount);
+    for (std::size_t i = 0; i < kCount; ++i) {
+        keys[i].fill(static_cast<unsigned char>(i));
+    }
+    std::vector<std::array<unsigned char, 32>> derived(kCount);
+    blake3DeriveKeyMany("PSI-membership-tag-v1", keys.data(), kCount, derived.data());
+    for (std::size_t i = 0; i < kCount; ++i) {
+        EXPECT_EQ(blake3DeriveKey("PSI-membership-tag-v1", keys[i]), derived[i]) << "index " << i;
+    }
+}
+
+TEST(Blake3UtilsTest, ManyRejectsMultiBlockInputs) {
+    std::vector<unsigned char> input(65);
+    const unsigned char* pointer = input.data();
+    std::array<unsigned char, 32> out{};
+    EXPECT_THROW(blake3HashMany(&pointer, input.size(), 1, &out), std::invalid_argument);
+    EXPECT_THROW(blake3DeriveKeyMany("ctx", &pointer, input.size(), 1, &out),
+                 std::invalid_argument);
+}
+
+TEST(Blake3UtilsTest, DeriveKeyXofMatchesReferenceAndManyMatchesPerInput) {
+    const auto longInput = vectorInput(100);
+    EXPECT_EQ("8efd13d956302f0126c47435cf72a530a2bd2b96b36f56bf6b1da1382ddaffdc"
+              "2f163e5341f1ee767aff5422e01725a6ef7eb4227dd9a2aad97105976f6392b9",
+              toHex(blake3DeriveKeyXof64("PSI-test-vectors", longInput.data(),
+                                         longInput.size())));
+
+    // Lengths differ per input and a few exceed one block, so lanes mix
+    // lengths and the long inputs take the streaming path in between.
+    constexpr std::size_t kCount = 40;
+    std::vector<std::vector<unsigned char>> inputs(kCount);
+    std::vector<const unsigned char*> pointers(kCount);
+    std::vector<std::size_t> lengths(kCount);
+    for (std::size_t i = 0; i < kCount; ++i) {
+        lengths[i] = (i % 7 == 3) ? 64 + i : (i * 5) % 65;
+        inputs[i].resize(lengths[i]);
+        for (std::size_t j = 0; j < lengths[i]; ++j) {
+            inputs[i][j] = static_cast<unsigned char>(i * 7 + j);
+        }
+        pointers[i] = inputs[i].data();
+    }
+    std::vector<Blake3Xof64> outputs(kCount);
+    blake3DeriveKeyXof64Many("PSI-test-context", pointers.data(), lengths.data(), kCount,
+                             outputs.data());
+    for (std::size_t i = 0; i < kCount; ++i) {
+        const auto expected =
+            blake3DeriveKeyXof64("PSI-test-context", inputs[i].data(), lengths[i]);
+        EXPECT_EQ(expected, outputs[i]) << "index " << i;
+        const auto prefix = blake3DeriveKey("PSI-test-context", inputs[i].data(), lengths[i]);
+        EXPECT_TRUE(std::equal(prefix.begin(), prefix.end(), expected.begin()))
+            << "index " << i;
+    }
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "calibration.h"
+#include "test_helpers.h"
+
+namespace {
+
+std::string tempPath(const std::string& name) {
+    return ::testing::TempDir() + name;
+}
+
+}  // namespace
+
+TEST(CalibrationTest, DerivesAThresholdPerPhase) {
+    ensureSodiumInit();
+
+    ThreadPool pool(3);
+    ExecutionPolicy base;
+    base.pool = &pool;
+    const auto profile = calibrateExecutionPolicy(base);
+
+    EXPECT_EQ(4u, profile.threads);
+    EXPECT_GE(profile.dispatchOverheadUs, 0.0);
+    EXPECT_GE(profile.effectiveThreads, 1.0);
+    for (std::size_t phase = 0; phase < kProtocolPhaseCount; ++phase) {
+        EXPECT_GT(profile.perElementUs[phase], 0.0) << "phase " << phase;
+        EXPECT_GE(profile.thresholds[phase], 2 * profile.threads) << "phase " << phase;
+    }
+
+    ExecutionPolicy applied;
+    applyCalibrationProfile(profile, applied);
+    const auto tagging = applied.forPhase(ProtocolPhase::BobTagging);
+    EXPECT_EQ(profile.thresholds[0], tagging.serialThreshold);
+}
+
+// One thread can never win by parallelising, so every phase stays serial.
+TEST(CalibrationTest, SingleThreadPolicyNeverGoesParallel) {
+    ensureSodiumInit();
+
+    ExecutionPolicy base;
+    base.threadCount = 1;
+    const auto profile = calibrateExecutionPolicy(base);
+    for (const auto threshold : profile.thresholds) {
+        EXPECT_EQ(std::numeric_limits<std::size_t>::max(), threshold);
+    }
+}
+
+TEST(CalibrationTest, ProfileRoundTripsThroughFile) {
+    CalibrationProfile profile;
+    profile.threads = 12;
+    profile.effectiveThreads = 10.5;
+    profile.dispatchOverheadUs = 17.5;
+    profile.perElementUs = {61.25, 58.5, 40.75, 95.0};
+    profile.thresholds = {3, 4, 5, 2};
+
+    const std::string path = tempPath("psi_calibration_roundtrip.profile");
+    saveCalibrationProfile(profile, path);
+    const auto loaded = loadCalibrationProfile(path);
+    std::remove(path.c_str());
+
+    EXPECT_EQ(profile.threads, loaded.threads);
+    EXPECT_DOUBLE_EQ(profile.effectiveThreads, loaded.effectiveThreads);
+    EXPECT_DOUBLE_EQ(profile.dispatchOverheadUs, loaded.dispatchOverheadUs);
+    EXPECT_EQ(profile.perElementUs, loaded.perElementUs);
+    EXPECT_EQ(profile.thresholds, loaded.thresholds);
+}
+
+TEST(CalibrationTest, RejectsMalformedProfiles) {
+    const std::string path = tempPath("psi_calibration_bad.profile");
+
+    {
+        std::ofstream out(path);
+        out << "not-a-profile\nthreads 4\n";
+    }
+    EXPECT_THROW(loadCalibrationProfile(path), std::runtime_error);
+
+    {
+        std::ofstream out(path);
+        out << "psi-calibration-v1\nthreads 4\neffective_threads 3.5\ndispatch_overhead_us 3\n";
+    }
+    EXPECT_THROW(loadCalibrationProfile(path), std::runtime_error);  // missing phases
+
+    {
+        std::ofstream out(path);
+        out << "psi-calibration-v1\nthreads 4\nwarp_factor 9\n";
+    }
+    EXPECT_THROW(loadCalibrationProfile(path), std::runtime_error);  // unknown key
+
+    std::remove(path.c_str());
+    EXPECT_THROW(loadCalibrationProfile(path), std::runtime_error);  // missing file
+}
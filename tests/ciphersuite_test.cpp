@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "blake3_utils.h"
+#include "ciphersuite.h"
+#include "crypto_utils.h"
+#include "psi_protocol.h"
+#include "serialization_utils.h"
+#include "test_helpers.h"
+
+namespace {
+
+std::string toHex(const std::array<unsigned char, 32>& bytes) {
+    static const char* const kDigits = "0123456789abcdef";
+    std::string hex;
+    for (const auto byte : bytes) {
+        hex.push_back(kDigits[byte >> 4]);
+        hex.push_back(kDigits[byte & 0x0f]);
+    }
+    return hex;
+}
+
+std::vector<Unit> sampleBob() {
+    return {{"b1", 1.2, 3.4}, {"b2", -4.6, 7.8}, {"b3", 40.0, 41.0}, {"b4", 9.0, 9.0}};
+}
+
+std::vector<Unit> sampleAlice() {
+    return {{"a1", 1.9, 3.1}, {"a2", 4.2, 8.6}, {"a3", -4.5, 7.0}, {"a4", 40.5, 41.5}};
+}
+
+std::set<std::string> resultElements(const std::vector<MatchedUnit>& results) {
+    std::set<std::string> elements;
+    for (const auto& match : results) {
+        elements.insert(match.element);
+    }
+    return elements;
+}
+
+}  // namespace
+
+TEST(CipherSuiteTest, NamesRoundTrip) {
+    for (const auto suite : kCipherSuites) {
+        EXPECT_EQ(suite, parseCipherSuite(cipherSuiteName(suite)));
+    }
+    EXPECT_EQ(kDefaultCipherSuite, CipherSuite::V1);
+    EXPECT_THROW(parseCipherSuite("v4"), std::runtime_error);
+}
+
+// Pinned outputs for a fixed 32-byte point encoding. The v1 values must never
+// change: recorded v1 transcripts are audited by recomputing them.
+TEST(CipherSuiteTest, KeyAndTagDerivationIsPinnedPerSuite) {
+    RistrettoPoint point{};
+    for (std::size_t i = 0; i < point.size(); ++i) {
+        point[i] = static_cast<unsigned char>(i);
+    }
+
+    std::array<unsigned char, 32> key{};
+    MembershipTag tag{};
+    pointsToKeysAndTags(&point, 1, &key, &tag, CipherSuite::V1);
+    EXPECT_EQ("3d94eea49c580aef816935762be049559d6d1440dede12e6a125f1841fff8e6f", toHex(key));
+    EXPECT_EQ("2a28b57b74c5aeb48574768fba1c2dd0e6241c1674bd9d9b88ebc23d04455d82", toHex(tag));
+    EXPECT_EQ(hashPointToKey(point), key);
+    EXPECT_EQ(keyToMembershipTag(key), tag);
+
+    pointsToKeysAndTags(&point, 1, &key, &tag, CipherSuite::V2);
+    EXPECT_EQ("6cae59eb52efaa10bdddf4b747bf62ae6c6c8291be2fd567635025e2296f93d6", toHex(key));
+    EXPECT_EQ("cb60dcae456cadeb83615eeeac01680df836816befd97b3ef1401bac4ca40dc8", toHex(tag));
+
+    std::array<unsigned char, 32> keyOnly{};
+    hashPointToKeyBatch(&point, 1, &keyOnly, CipherSuite::V2);
+    EXPECT_EQ(key, keyOnly);
+
+    pointsToKeysAndTags(&point, 1, &key, &tag, CipherSuite::V3);
+    EXPECT_EQ("ebf329b695c41ae9cfe1e49a279818b78cb5642f99a8f2636fd896672258735f", toHex(key));
+    EXPECT_EQ("4f4527cb8934e83b4c1cc25d0335ebd40a816e98b1ccdc0f7ea2eb9cd283d1bd", toHex(tag));
+    hashPointToKeyBatch(&point, 1, &keyOnly, CipherSuite::V3);
+    EXPECT_EQ(key, keyOnly);
+}
+
+// Enough elements to fill SIMD lane groups plus a tail, with a shared cache
+// that must keep the two suites' mappings apart.
+TEST(CipherSuiteTest, HashToGroupPerSuiteAndCacheKeepsSuitesApart) {
+    ensureSodiumInit();
+    std::vector<std::string> messages;
+    for (int i = 0; i < 37; ++i) {
+        messages.push_back(std::to_string(i * 7919) + " " + std::to_string(i));
+    }
+    messages.push_back(std::string(100, 'x'));  // longer than one BLAKE3 block
+
+    std::vector<RistrettoElement> v1(messages.size());
+    std::vector<RistrettoElement> v2(messages.size());
+    hashToGroupElementBatch(messages.data(), messages.size(), v1.data(), nullptr,
+                            CipherSuite::V1);
+    hashToGroupElementBatch(messages.data(), messages.size(), v2.data(), nullptr,
+                            CipherSuite::V2);
+
+    HashToGroupCache cache;
+    std::vector<RistrettoElement> cachedV1(messages.size());
+    std::vector<RistrettoElement> cachedV2(messages.size());
+    hashToGroupElementBatch(messages.data(), messages.size(), cachedV1.data(), &cache,
+                            CipherSuite::V1);
+    hashToGroupElementBatch(messages.data(), messages.size(), cachedV2.data(), &cache,
+                            CipherSuite::V2);
+
+    for (std::size_t i = 0; i < messages.size(); ++i) {
+        RistrettoPoint encodedV1{};
+        RistrettoPoint encodedV2{};
+        RistrettoPoint encodedCachedV1{};
+        RistrettoPoint encodedCachedV2{};
+        ristrettoEncode(encodedV1.data(), v1[i]);
+        ristrettoEncode(encodedV2.data(), v2[i]);
+        ristrettoEncode(encodedCachedV1.data(), cachedV1[i]);
+        ristrettoEncode(encodedCachedV2.data(), cachedV2[i]);
+        EXPECT_EQ(hashToGroup(messages[i]), encodedV1) << "index " << i;
+        EXPECT_NE(encodedV1, encodedV2) << "index " << i;
+        EXPECT_EQ(encodedV1, encodedCachedV1) << "index " << i;
+        EXPECT_EQ(encodedV2, encodedCachedV2) << "index " << i;
+
+        const auto uniform = blake3DeriveKeyXof64(
+            "PSI-hash-to-group-v2", reinterpret_cast<const unsigned char*>(messages[i].data()),
+            messages[i].size());
+        RistrettoPoint reference{};
+        ASSERT_EQ(0, crypto_core_ristretto255_from_hash(reference.data(), uniform.data()));
+        EXPECT_EQ(reference, encodedV2) << "index " << i;
+    }
+}
+
+TEST(CipherSuiteTest, HeaderNamesSuiteAndV1StaysUnmarked) {
+    ensureSodiumInit();
+    const TagBatch tags(2);
+    const auto v1 = serializeBobTagMessage(tags);
+    const auto v2 = serializeBobTagMessage(tags, CipherSuite::V2);
+    EXPECT_EQ(0u, v1.rfind("T 2\n", 0));
+    EXPECT_EQ(0u, v2.rfind("T 2 v2\n", 0));
+    EXPECT_EQ(v1.substr(4), v2.substr(7));
+
+    CipherSuite suite = CipherSuite::V2;
+    EXPECT_EQ(tags, deserializeBobTagMessage(v1, &suite));
+    EXPECT_EQ(CipherSuite::V1, suite);
+    EXPECT_EQ(tags, deserializeBobTagMessage(v2, &suite));
+    EXPECT_EQ(CipherSuite::V2, suite);
+    EXPECT_EQ(CipherSuite::V2, messageCipherSuite(v2));
+
+    const auto unknown = "T 2 v9\n" + v1.substr(4);
+    EXPECT_THROW(deserializeBobTagMessage(unknown), std::runtime_error);
+    EXPECT_THROW(messageCipherSuite(unknown), std::runtime_error);
+    EXPECT_THROW(messageCipherSuite("A 2\n"), std::runtime_error);
+}
+
+// v3 also switches the group to x25519 (group_backend.h).
+TEST(CipherSuiteTest, BothModesIntersectUnderEveryNewSuite) {
+    ensureSodiumInit();
+    const auto bobUnits = sampleBob();
+    const auto aliceUnits = sampleAlice();
+    const std::set<std::string> expected = {"1 3", "-5 7", "40 41"};
+
+    for (const auto suite : {CipherSuite::V2, CipherSuite::V3}) {
+#if !defined(PSI_HAVE_FE51)
+        if (cipherSuiteGroup(suite) == Group::X25519) {
+            continue;
+        }
+#endif
+        SCOPED_TRACE(cipherSuiteName(suite));
+        const auto bobTags = bobCreateInitialTagMessage(bobUnits, nullptr, nullptr, nullptr,
+                                                        suite);
+        EXPECT_EQ(suite, messageCipherSuite(bobTags.serialized));
+        EXPECT_EQ(suite, bobTags.state.suite);
+        const auto alice = aliceProcessBobTagMessage(bobTags.serialized, aliceUnits);
+        EXPECT_EQ(suite, alice.state.suite);
+        const auto response = bobProcessAliceMessage(alice.serialized, bobTags.state);
+        EXPECT_EQ(expected, resultElements(aliceFinalizeIntersectionTags(response.serialized,
+                                                                         alice.state)));
+
+        EXPECT_EQ(expected, resultElements(runPSIProtocol(bobUnits, aliceUnits, nullptr, nullptr,
+                                                          nullptr, suite)));
+        EXPECT_EQ(expected, resultElements(runPSIProtocolTags(bobUnits, aliceUnits, nullptr,
+                                                              nullptr, nullptr, suite)));
+    }
+}
+
+// Same randomness, different suite: every wire value after the header
+// differs, so a party cannot mix suites within one exchange by accident.
+TEST(CipherSuiteTest, SuitesProduceDifferentTagsFromSameRandomness) {
+    ensureSodiumInit();
+    std::array<unsigned char, 32> seed{};
+    seed.fill(0x5a);
+    const std::vector<std::string> elements = {"L1:10 12", "L1:11 12", "L1:40 41"};
+
+    DeterministicRng rngV1(seed, 0, 0);
+    DeterministicRng rngV2(seed, 0, 0);
+    const auto v1 = bobCreateInitialTagMessageFromElements(elements, nullptr, &rngV1);
+    const auto v2 = bobCreateInitialTagMessageFromElements(elements, nullptr, &rngV2, nullptr,
+                                                           CipherSuite::V2);
+    EXPECT_EQ(v1.state.privateScalar, v2.state.privateScalar);
+    for (std::size_t i = 0; i < elements.size(); ++i) {
+        EXPECT_NE(v1.tags[i], v2.tags[i]) << "index " << i;
+    }
+}
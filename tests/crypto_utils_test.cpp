@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 
 #include <cstring>
+#include <stdexcept>
+#include <vector>
 
 #include "blake3_utils.h"
 #include "crypto_utils.h"
@@ -117,3 +119,34 @@ TEST(CryptoUtilsTest, KeyToMembershipTagIsDeterministicAndDomainSeparated) {
     EXPECT_NE(tag1, key);
     EXPECT_NE(tag1, hashPointToKey(point));
 }
+
+TEST(CryptoUtilsTest, InvertScalarsBatchMatchesPerElementInversion) {
+    ensureSodiumInit();
+
+    for (const std::size_t count : {1u, 2u, 7u, 129u}) {
+        std::vector<RistrettoScalar> scalars(count);
+        for (auto& scalar : scalars) {
+            crypto_core_ristretto255_scalar_random(scalar.data());
+        }
+        std::vector<RistrettoScalar> inverses(count);
+        invertScalarsBatch(scalars.data(), count, inverses.data());
+
+        for (std::size_t i = 0; i < count; ++i) {
+            RistrettoScalar expected{};
+            ASSERT_EQ(0, crypto_core_ristretto255_scalar_invert(expected.data(),
+                                                                scalars[i].data()));
+            EXPECT_EQ(expected, inverses[i]) << "count " << count << " index " << i;
+        }
+    }
+}
+
+TEST(CryptoUtilsTest, InvertScalarsBatchRejectsZero) {
+    ensureSodiumInit();
+
+    std::vector<RistrettoScalar> scalars(3);
+    crypto_core_ristretto255_scalar_random(scalars[0].data());
+    crypto_core_ristretto255_scalar_random(scalars[2].data());
+    std::vector<RistrettoScalar> inverses(3);
+    EXPECT_THROW(invertScalarsBatch(scalars.data(), scalars.size(), inverses.data()),
+                 std::runtime_error);
+}
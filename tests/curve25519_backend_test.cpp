@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "crypto_utils.h"
+#include "curve25519_backend.h"
+#include "ristretto_batch.h"
+#include "ristretto_point.h"
+#include "test_helpers.h"
+
+namespace {
+
+// Selects a backend for the lifetime of the guard, then restores the previous
+// one so later tests run on the default.
+class BackendGuard {
+public:
+    explicit BackendGuard(FieldBackend backend) : previous_(activeFieldBackend()) {
+        setFieldBackend(backend);
+    }
+    ~BackendGuard() { setFieldBackend(previous_); }
+
+    BackendGuard(const BackendGuard&) = delete;
+    BackendGuard& operator=(const BackendGuard&) = delete;
+
+private:
+    FieldBackend previous_;
+};
+
+std::vector<FieldBackend> supportedBackends() {
+    std::vector<FieldBackend> backends;
+    for (const auto backend : {FieldBackend::Portable, FieldBackend::Mulx, FieldBackend::Avx2}) {
+        if (fieldBackendSupported(backend)) {
+            backends.push_back(backend);
+        }
+    }
+    return backends;
+}
+
+}  // namespace
+
+TEST(Curve25519BackendTest, PortableIsAlwaysSupportedAndNamesRoundTrip) {
+    EXPECT_TRUE(fieldBackendSupported(FieldBackend::Portable));
+    EXPECT_TRUE(fieldBackendSupported(activeFieldBackend()));
+    for (const auto backend : {FieldBackend::Portable, FieldBackend::Mulx, FieldBackend::Avx2}) {
+        EXPECT_EQ(backend, parseFieldBackend(fieldBackendName(backend)));
+    }
+    EXPECT_THROW(parseFieldBackend("sse9"), std::runtime_error);
+}
+
+// Each backend, batch and single paths, against crypto_scalarmult_ristretto255.
+// 23 elements: five full AVX2 groups plus a three-element tail.
+TEST(Curve25519BackendTest, EveryBackendMatchesLibsodium) {
+    ensureSodiumInit();
+
+    constexpr std::size_t kCount = 23;
+    std::vector<RistrettoPoint> points(kCount);
+    std::vector<RistrettoElement> elements(kCount);
+    std::vector<RistrettoScalar> scalars(kCount);
+    for (std::size_t i = 0; i < kCount; ++i) {
+        points[i] = hashToGroup("backend " + std::to_string(i));
+        ASSERT_TRUE(ristrettoDecode(elements[i], points[i].data()));
+        crypto_core_ristretto255_scalar_random(scalars[i].data());
+    }
+    scalars[5].fill(0xff);  // top bit set: libsodium clears it
+    scalars[6].fill(0);
+    scalars[6][0] = 1;
+
+    for (const auto backend : supportedBackends()) {
+        SCOPED_TRACE(fieldBackendName(backend));
+        const BackendGuard guard(backend);
+
+        std::vector<RistrettoPoint> each(kCount);
+        multiplyElements(scalars.data(), elements.data(), kCount, each.data(), "test");
+        const FixedScalarMultiplier fixed(scalars[0]);
+        std::vector<RistrettoPoint> shared(kCount);
+        fixed.multiplyBatch(elements.data(), kCount, shared.data(), "test");
+
+        for (std::size_t i = 0; i < kCount; ++i) {
+            RistrettoPoint expected{};
+            ASSERT_EQ(crypto_scalarmult_ristretto255(expected.data(), scalars[i].data(),
+                                                     points[i].data()),
+                      0);
+            EXPECT_EQ(expected, each[i]) << "index " << i;
+            EXPECT_EQ(expected, multiplyElement(scalars[i], elements[i], "test")) << "index " << i;
+
+            ASSERT_EQ(crypto_scalarmult_ristretto255(expected.data(), scalars[0].data(),
+                                                     points[i].data()),
+                      0);
+            EXPECT_EQ(expected, shared[i]) << "index " << i;
+        }
+    }
+}
+
+TEST(Curve25519BackendTest, EveryBackendRejectsIdentityResults) {
+    ensureSodiumInit();
+
+    std::vector<RistrettoElement> elements(4, hashToGroupElement("identity"));
+    std::vector<RistrettoScalar> scalars(4);
+    for (auto& scalar : scalars) {
+        crypto_core_ristretto255_scalar_random(scalar.data());
+    }
+    scalars[2].fill(0);  // zero scalar in one lane of a four-way group
+    std::vector<RistrettoPoint> out(4);
+
+    for (const auto backend : supportedBackends()) {
+        SCOPED_TRACE(fieldBackendName(backend));
+        const BackendGuard guard(backend);
+        EXPECT_THROW(multiplyElements(scalars.data(), elements.data(), 4, out.data(), "test"),
+                     std::runtime_error);
+    }
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json_reader.h"
+
+namespace {
+
+// The message fail() produced for text, or "" if it parsed.
+std::string errorFor(std::string_view text, const JsonLimits& limits = {}) {
+    try {
+        JsonReader reader(text, limits);
+        reader.skipValue();
+        reader.end();
+    } catch (const std::runtime_error& ex) {
+        return ex.what();
+    }
+    return "";
+}
+
+}  // namespace
+
+TEST(JsonReaderTest, ReadsNestedDocumentInOnePass) {
+    const std::string text =
+        "{ \"units\": [ {\"id\": \"u1\", \"x\": -1.5e2, \"extra\": [1, {\"a\": null}]},\n"
+        "  {\"id\": \"q\\\"\\u00e9\\ud83d\\ude00\", \"x\": 0} ], \"flag\": true }";
+    JsonReader reader(text);
+    std::vector<std::string> ids;
+    std::vector<double> xs;
+    std::string_view key;
+    reader.beginObject();
+    while (reader.nextMember(key)) {
+        if (key != "units") {
+            reader.skipValue();
+            continue;
+        }
+        reader.beginArray();
+        while (reader.nextItem()) {
+            reader.beginObject();
+            while (reader.nextMember(key)) {
+                if (key == "id") {
+                    ids.emplace_back(reader.string());
+                } else if (key == "x") {
+                    xs.push_back(reader.number());
+                } else {
+                    reader.skipValue();
+                }
+            }
+        }
+    }
+    reader.end();
+
+    EXPECT_EQ((std::vector<std::string>{"u1", "q\"\xc3\xa9\xf0\x9f\x98\x80"}), ids);
+    EXPECT_EQ((std::vector<double>{-150.0, 0.0}), xs);
+}
+
+TEST(JsonReaderTest, UnescapedStringsPointIntoTheText) {
+    const std::string text = "[\"plain\"]";
+    JsonReader reader(text);
+    reader.beginArray();
+    ASSERT_TRUE(reader.nextItem());
+    const auto value = reader.string();
+    EXPECT_EQ(text.data() + 2, value.data());
+    EXPECT_FALSE(reader.nextItem());
+    reader.end();
+}
+
+TEST(JsonReaderTest, ErrorsNameTheirPosition) {
+    EXPECT_EQ("", errorFor(" [1, 2.5, -0, 3e-2] "));
+    EXPECT_EQ("JSON error at byte 3 (line 1, column 4): expected a value", errorFor("[1,]"));
+    EXPECT_EQ("JSON error at byte 9 (line 2, column 3): expected ',' or '}'",
+              errorFor("{\"a\":1\n  \"b\":2}"));
+    EXPECT_EQ("JSON error at byte 2 (line 1, column 3): expected a digit", errorFor("[-]"));
+    EXPECT_EQ("JSON error at byte 1 (line 1, column 2): number out of range", errorFor("[1e999]"));
+    EXPECT_EQ("JSON error at byte 3 (line 1, column 4): unexpected data after the document",
+              errorFor("{} x"));
+    EXPECT_NE("", errorFor("[01]"));
+    EXPECT_NE("", errorFor("[inf]"));
+    EXPECT_NE("", errorFor("[\"a\\x\"]"));
+    EXPECT_NE("", errorFor("[\"\\ud800\"]"));
+    EXPECT_NE("", errorFor("[\"tab\there\"]"));
+    EXPECT_NE("", errorFor("{\"a\" 1}"));
+    EXPECT_NE("", errorFor("[\"open"));
+    EXPECT_NE("", errorFor(""));
+}
+
+TEST(JsonReaderTest, EnforcesLimits) {
+    JsonLimits limits;
+    limits.maxBytes = 16;
+    limits.maxDepth = 2;
+    limits.maxStringBytes = 4;
+    limits.maxArrayItems = 3;
+
+    EXPECT_EQ("", errorFor("[[1],\"abcd\"]", limits));
+    EXPECT_NE(std::string::npos,
+              errorFor("[1,2,3,4]", limits).find("more than 3 items"));
+    EXPECT_NE(std::string::npos, errorFor("[[[1]]]", limits).find("nesting deeper than 2"));
+    EXPECT_NE(std::string::npos,
+              errorFor("[\"abcde\"]", limits).find("string longer than 4 bytes"));
+    EXPECT_NE(std::string::npos,
+              errorFor("[1, 2, 3        ]", limits).find("exceeds the limit of 16"));
+}
@@ -146,6 +146,70 @@ TEST(PSIProtocolTest, RunPSIProtocolEndToEnd) {
     EXPECT_EQ(flooredPosition(450.0, 450.0), decrypted[0].element);
 }
 
+TEST(PSIProtocolTest, IndexedSecretboxMatchesTrialDecryption) {
+    ensureSodiumInit();
+
+    std::vector<Unit> bobUnits;
+    std::vector<Unit> aliceUnits;
+    makeLargeSets(300, 90, bobUnits, aliceUnits);
+    bobUnits.push_back(bobUnits[5]);
+    aliceUnits.push_back(aliceUnits[7]);
+    aliceUnits.insert(aliceUnits.begin(), aliceUnits[40]);
+
+    for (const auto format : {WireFormat::Text, WireFormat::Binary}) {
+        const auto bobMessage = bobCreateInitialIndexedMessage(bobUnits, nullptr, nullptr,
+                                                               kDefaultCipherSuite, format);
+        EXPECT_TRUE(std::is_sorted(bobMessage.units.begin(), bobMessage.units.end(),
+                                   [](const IndexedEncryptedUnit& a,
+                                      const IndexedEncryptedUnit& b) {
+                                       return a.locator < b.locator;
+                                   }));
+        auto aliceMessage = aliceProcessBobIndexedMessage(bobMessage.serialized, aliceUnits);
+        EXPECT_EQ(format, aliceMessage.state.format);
+        const auto bobResponse = bobProcessAliceMessage(aliceMessage.serialized, bobMessage.state);
+        const auto indexed =
+            aliceFinalizeIntersectionIndexed(bobResponse.serialized, aliceMessage.state);
+        ASSERT_EQ(90u, indexed.size());
+        EXPECT_EQ(bruteForceIntersection(bobUnits, aliceUnits), resultElements(indexed));
+
+        // Same matches, in the same order, as trial decryption of the same
+        // ciphertexts.
+        for (const auto& unit : aliceMessage.state.bobIndexedUnits) {
+            aliceMessage.state.bobEncryptedUnits.push_back({unit.ciphertext});
+        }
+        const auto trial = aliceFinalizeIntersection(bobResponse.serialized, aliceMessage.state);
+        ASSERT_EQ(trial.size(), indexed.size());
+        for (std::size_t i = 0; i < trial.size(); ++i) {
+            EXPECT_EQ(trial[i].element, indexed[i].element);
+            EXPECT_EQ(trial[i].symmetricKey, indexed[i].symmetricKey);
+        }
+
+        // A locator Alice does not hold hides its ciphertext; a unit under a
+        // matching locator that does not open is no match.
+        aliceMessage.state.bobIndexedUnits[0].ciphertext.ciphertext[0] ^= 1;
+        aliceMessage.state.bobIndexedUnits[1].locator[7] ^= 1;
+        const auto tampered =
+            aliceFinalizeIntersectionIndexed(bobResponse.serialized, aliceMessage.state);
+        EXPECT_LE(indexed.size() - 2, tampered.size());
+        EXPECT_GE(indexed.size(), tampered.size());
+    }
+
+    // Locators that differ only in their high bytes all land in one slot.
+    const auto bobMessage = bobCreateInitialIndexedMessage(bobUnits);
+    auto aliceMessage = aliceProcessBobIndexedMessage(bobMessage.serialized, aliceUnits);
+    auto& flood = aliceMessage.state.bobIndexedUnits;
+    const IndexedEncryptedUnit first = flood[0];
+    flood.resize(1000, first);
+    for (std::size_t i = 0; i < flood.size(); ++i) {
+        flood[i].locator[6] = static_cast<unsigned char>(i >> 8);
+        flood[i].locator[7] = static_cast<unsigned char>(i);
+    }
+    const auto bobResponse = bobProcessAliceMessage(aliceMessage.serialized, bobMessage.state);
+    EXPECT_THROW(aliceFinalizeIntersectionIndexed(bobResponse.serialized, aliceMessage.state),
+                 std::runtime_error);
+    EXPECT_EQ(90u, runPSIProtocolIndexed(bobUnits, aliceUnits).size());
+}
+
 // Wire messages must not leak either party's inputs: the transcript may only
 // contain blinded points and authenticated ciphertexts
 // (docs/security_hardening.md, issue 1).
@@ -257,6 +321,126 @@ TEST(PSIProtocolTagModeTest, TagsAreFixedSize) {
     EXPECT_EQ(shortMessage.serialized.size(), longMessage.serialized.size());
 }
 
+// Every finalisation strategy finds the same matches in the same order,
+// repeated elements on both sides included.
+TEST(PSIProtocolTagModeTest, MatchStrategiesAgree) {
+    ensureSodiumInit();
+
+    std::vector<Unit> bobUnits;
+    std::vector<Unit> aliceUnits;
+    makeLargeSets(300, 90, bobUnits, aliceUnits);
+    bobUnits.push_back(bobUnits[5]);
+    aliceUnits.push_back(aliceUnits[7]);
+    aliceUnits.insert(aliceUnits.begin(), aliceUnits[40]);
+
+    for (const auto format : {WireFormat::Text, WireFormat::Binary}) {
+        const auto bobMessage = bobCreateInitialTagMessage(bobUnits, nullptr, nullptr, nullptr,
+                                                           kDefaultCipherSuite, format);
+        const auto aliceMessage = aliceProcessBobTagMessage(bobMessage.serialized, aliceUnits);
+        const auto bobResponse = bobProcessAliceMessage(aliceMessage.serialized, bobMessage.state);
+
+        const auto expected = aliceFinalizeIntersectionTags(
+            bobResponse.serialized, aliceMessage.state, nullptr, TagMatchStrategy::HashBob);
+        ASSERT_EQ(90u, expected.size());
+        EXPECT_EQ(bruteForceIntersection(bobUnits, aliceUnits), resultElements(expected));
+
+        auto sameMatches = [&expected](const std::vector<MatchedUnit>& results) {
+            ASSERT_EQ(expected.size(), results.size());
+            for (std::size_t i = 0; i < results.size(); ++i) {
+                EXPECT_EQ(expected[i].element, results[i].element);
+                EXPECT_EQ(expected[i].symmetricKey, results[i].symmetricKey);
+            }
+        };
+        for (const auto strategy : {TagMatchStrategy::Auto, TagMatchStrategy::IndexAlice}) {
+            SCOPED_TRACE(tagMatchStrategyName(strategy));
+            sameMatches(aliceFinalizeIntersectionTags(bobResponse.serialized, aliceMessage.state,
+                                                      nullptr, strategy));
+        }
+    }
+
+    EXPECT_EQ(TagMatchStrategy::IndexAlice, chooseTagMatchStrategy(200, 1000000));
+    EXPECT_EQ(TagMatchStrategy::HashBob, chooseTagMatchStrategy(100000, 100000));
+}
+
+// Alice blinds before Bob's tags exist, Bob answers her flight, and only then
+// are his tags attached: same flight bytes and the same matches as the
+// sequential exchange.
+TEST(PSIProtocolTagModeTest, BlindingDoesNotWaitForBobsTags) {
+    ensureSodiumInit();
+
+    std::vector<Unit> bobUnits;
+    std::vector<Unit> aliceUnits;
+    makeLargeSets(200, 60, bobUnits, aliceUnits);
+    const auto aliceElements = convertToFlooredStrings(aliceUnits);
+    std::array<unsigned char, 32> seed{};
+    seed.fill(0x42);
+
+    for (const auto format : {WireFormat::Text, WireFormat::Binary}) {
+        DeterministicRng earlyRng(seed, 0, 0);
+        auto early = alicePrepareBlinded(aliceElements, nullptr, &earlyRng, nullptr,
+                                         CipherSuite::V2, format);
+        EXPECT_TRUE(early.state.bobTagFlight.empty());
+
+        const auto bobMessage = bobCreateInitialTagMessage(bobUnits, nullptr, nullptr, nullptr,
+                                                           CipherSuite::V2, format);
+        const auto bobResponse = bobProcessAliceMessage(early.serialized, bobMessage.state);
+        aliceAttachBobTags(bobMessage.serialized, early.state);
+
+        DeterministicRng lateRng(seed, 0, 0);
+        const auto late = aliceProcessBobTagMessageFromElements(bobMessage.serialized,
+                                                                 aliceElements, nullptr, &lateRng);
+        EXPECT_EQ(late.serialized, early.serialized);
+        EXPECT_EQ(late.state.bobTagFlight, early.state.bobTagFlight);
+
+        const auto results = aliceFinalizeIntersectionTags(bobResponse.serialized, early.state);
+        ASSERT_EQ(60u, results.size());
+        EXPECT_EQ(bruteForceIntersection(bobUnits, aliceUnits), resultElements(results));
+
+        // Bob opened under another suite or format than Alice blinded for.
+        auto wrongSuite = alicePrepareBlinded(aliceElements, nullptr, nullptr, nullptr,
+                                              CipherSuite::V1, format);
+        EXPECT_THROW(aliceAttachBobTags(bobMessage.serialized, wrongSuite.state),
+                     std::runtime_error);
+        auto wrongFormat = alicePrepareBlinded(
+            aliceElements, nullptr, nullptr, nullptr, CipherSuite::V2,
+            format == WireFormat::Text ? WireFormat::Binary : WireFormat::Text);
+        EXPECT_THROW(aliceAttachBobTags(bobMessage.serialized, wrongFormat.state),
+                     std::runtime_error);
+    }
+
+    EXPECT_EQ(bruteForceIntersection(bobUnits, aliceUnits),
+              resultElements(runPSIProtocolTags(bobUnits, aliceUnits)));
+}
+
+TEST(PSIProtocolTagModeTest, CompactTagFlightMatchesFullTags) {
+    ensureSodiumInit();
+
+    std::vector<Unit> bobUnits;
+    std::vector<Unit> aliceUnits;
+    makeLargeSets(300, 90, bobUnits, aliceUnits);
+    aliceUnits.push_back(aliceUnits[7]);
+
+    for (const auto format : {WireFormat::Text, WireFormat::Binary}) {
+        const auto full = bobCreateInitialTagMessage(bobUnits, nullptr, nullptr, nullptr,
+                                                     CipherSuite::V2, format);
+        // 3-byte fingerprints: a stray match among 301 probes is ~1e-4 likely.
+        const auto compact = bobCreateInitialTagMessage(bobUnits, nullptr, nullptr, nullptr,
+                                                        CipherSuite::V2, format, 1e-6);
+        EXPECT_EQ('F', messageType(compact.serialized));
+        EXPECT_LT(compact.serialized.size() * 8, full.serialized.size());
+
+        auto aliceMessage = aliceProcessBobTagMessage(compact.serialized, aliceUnits);
+        EXPECT_EQ(CipherSuite::V2, aliceMessage.state.suite);
+        EXPECT_EQ(format, aliceMessage.state.format);
+        EXPECT_EQ(format, messageWireFormat(aliceMessage.serialized));
+        const auto bobResponse = bobProcessAliceMessage(aliceMessage.serialized, compact.state);
+        const auto results = aliceFinalizeIntersectionTags(bobResponse.serialized,
+                                                           aliceMessage.state);
+        ASSERT_EQ(90u, results.size());
+        EXPECT_EQ(bruteForceIntersection(bobUnits, aliceUnits), resultElements(results));
+    }
+}
+
 TEST(PSIProtocolTest, RejectsMalformedPointOnWire) {
     ensureSodiumInit();
 
@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "crypto_utils.h"
+#include "ristretto_batch.h"
+#include "test_helpers.h"
+
+namespace {
+
+// libsodium's answer: true and the product, or false where it refuses.
+bool libsodiumMultiply(const RistrettoScalar& scalar, const unsigned char* point,
+                       RistrettoPoint& out) {
+    return crypto_scalarmult_ristretto255(out.data(), scalar.data(), point) == 0;
+}
+
+bool engineMultiply(const FixedScalarMultiplier& multiplier, const unsigned char* point,
+                    RistrettoPoint& out) {
+    try {
+        out = multiplier.multiply(point, "test");
+        return true;
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+}
+
+std::vector<RistrettoScalar> edgeScalars() {
+    std::vector<RistrettoScalar> scalars;
+    RistrettoScalar s{};
+    scalars.push_back(s);  // zero: identity result, both must refuse
+    s[0] = 1;
+    scalars.push_back(s);
+    s.fill(0xff);  // top bit set: libsodium clears it
+    scalars.push_back(s);
+    // The group order L: also an identity result.
+    const unsigned char order[32] = {0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58,
+                                     0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14,
+                                     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10};
+    std::copy(order, order + 32, s.begin());
+    scalars.push_back(s);
+    for (int i = 0; i < 12; ++i) {
+        crypto_core_ristretto255_scalar_random(s.data());
+        scalars.push_back(s);
+    }
+    return scalars;
+}
+
+}  // namespace
+
+TEST(RistrettoBatchTest, MatchesLibsodiumOnValidPoints) {
+    ensureSodiumInit();
+
+    std::vector<RistrettoPoint> points;
+    for (int i = 0; i < 24; ++i) {
+        points.push_back(hashToGroup("differential " + std::to_string(i)));
+    }
+    RistrettoPoint random{};
+    crypto_core_ristretto255_random(random.data());
+    points.push_back(random);
+
+    for (const auto& scalar : edgeScalars()) {
+        const FixedScalarMultiplier multiplier(scalar);
+        for (const auto& point : points) {
+            RistrettoPoint expected{};
+            RistrettoPoint actual{};
+            const bool expectedOk = libsodiumMultiply(scalar, point.data(), expected);
+            ASSERT_EQ(expectedOk, engineMultiply(multiplier, point.data(), actual));
+            if (expectedOk) {
+                EXPECT_EQ(expected, actual);
+            }
+        }
+    }
+}
+
+// Random bytes are mostly not valid encodings; the engine must refuse exactly
+// the ones libsodium refuses (non-canonical, negative, non-square, ...).
+TEST(RistrettoBatchTest, RejectsExactlyWhatLibsodiumRejects) {
+    ensureSodiumInit();
+
+    RistrettoScalar scalar{};
+    crypto_core_ristretto255_scalar_random(scalar.data());
+    const FixedScalarMultiplier multiplier(scalar);
+
+    std::vector<RistrettoPoint> inputs;
+    for (int i = 0; i < 400; ++i) {
+        RistrettoPoint bytes{};
+        randombytes_buf(bytes.data(), bytes.size());
+        bytes[31] &= (i % 2 == 0) ? 0x7f : 0xff;
+        inputs.push_back(bytes);
+    }
+    RistrettoPoint edge{};
+    inputs.push_back(edge);  // identity encoding: valid input, identity result
+    edge.fill(0xff);
+    edge[31] = 0x7f;
+    edge[0] = 0xec;  // p - 1: canonical, even
+    inputs.push_back(edge);
+    edge[0] = 0xee;  // p + 1: non-canonical
+    inputs.push_back(edge);
+
+    std::size_t accepted = 0;
+    for (const auto& input : inputs) {
+        RistrettoPoint expected{};
+        RistrettoPoint actual{};
+        const bool expectedOk = libsodiumMultiply(scalar, input.data(), expected);
+        ASSERT_EQ(expectedOk, engineMultiply(multiplier, input.data(), actual))
+            << "input " << (&input - inputs.data());
+        if (expectedOk) {
+            ++accepted;
+            EXPECT_EQ(expected, actual);
+        }
+    }
+    EXPECT_GT(accepted, 0u);
+}
+
+TEST(RistrettoBatchTest, BatchMatchesSingleAndReportsFailures) {
+    ensureSodiumInit();
+
+    RistrettoScalar scalar{};
+    crypto_core_ristretto255_scalar_random(scalar.data());
+    const FixedScalarMultiplier multiplier(scalar);
+
+    std::vector<RistrettoPoint> points;
+    for (int i = 0; i < 37; ++i) {
+        points.push_back(hashToGroup("batch " + std::to_string(i)));
+    }
+    std::vector<RistrettoPoint> out(points.size());
+    multiplier.multiplyBatch(points.data(), points.size(), out.data(), "test");
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        RistrettoPoint expected{};
+        ASSERT_TRUE(libsodiumMultiply(scalar, points[i].data(), expected));
+        EXPECT_EQ(expected, out[i]) << "index " << i;
+    }
+
+    points[20].fill(0xff);  // not a canonical encoding
+    EXPECT_THROW(multiplier.multiplyBatch(points.data(), points.size(), out.data(), "test"),
+                 std::runtime_error);
+}
+
+TEST(RistrettoBatchTest, FromHashMatchesLibsodium) {
+    ensureSodiumInit();
+
+    for (int i = 0; i < 200; ++i) {
+        unsigned char hash[64];
+        randombytes_buf(hash, sizeof hash);
+        RistrettoPoint expected{};
+        ASSERT_EQ(crypto_core_ristretto255_from_hash(expected.data(), hash), 0);
+        RistrettoPoint actual{};
+        ristrettoEncode(actual.data(), ristrettoFromHash(hash));
+        EXPECT_EQ(expected, actual) << "hash " << i;
+    }
+}
+
+TEST(RistrettoBatchTest, ElementPipelineMatchesEncodedPath) {
+    ensureSodiumInit();
+
+    HashToGroupCache cache;
+    for (int i = 0; i < 32; ++i) {
+        const std::string message = "element " + std::to_string(i);
+        const auto encoded = hashToGroup(message);
+
+        RistrettoPoint roundTrip{};
+        ristrettoEncode(roundTrip.data(), hashToGroupElement(message));
+        EXPECT_EQ(encoded, roundTrip);
+        ristrettoEncode(roundTrip.data(), decodeElement(encoded.data(), "test"));
+        EXPECT_EQ(encoded, roundTrip);
+        ristrettoEncode(roundTrip.data(), hashToGroupElementCached(message, &cache));
+        EXPECT_EQ(encoded, roundTrip);
+
+        RistrettoScalar scalar{};
+        crypto_core_ristretto255_scalar_random(scalar.data());
+        RistrettoPoint expected{};
+        ASSERT_TRUE(libsodiumMultiply(scalar, encoded.data(), expected));
+        EXPECT_EQ(expected, multiplyElement(scalar, hashToGroupElementCached(message, &cache),
+                                            "test"));
+        EXPECT_EQ(expected, FixedScalarMultiplier(scalar).multiply(hashToGroupElement(message),
+                                                                   "test"));
+    }
+
+    const RistrettoScalar zero{};
+    EXPECT_THROW(multiplyElement(zero, hashToGroupElement("identity"), "test"),
+                 std::runtime_error);
+    RistrettoPoint invalid{};
+    invalid.fill(0xff);
+    EXPECT_THROW(decodeElement(invalid.data(), "test"), std::runtime_error);
+}
@@ -1,9 +1,12 @@
 #include <gtest/gtest.h>
 
+#include "json_writer.h"
 #include "psi_protocol.h"
+#include "point_batch.h"
 #include "serialization_utils.h"
 #include "test_helpers.h"
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <stdexcept>
@@ -45,7 +48,7 @@ TEST(SerializationUtilsTest, AliceBlindedRoundTrip) {
 
     ASSERT_EQ(aliceMessage.values.size(), decoded.size());
     for (std::size_t i = 0; i < decoded.size(); ++i) {
-        EXPECT_EQ(aliceMessage.values[i].blindedPointEncoded, decoded[i].blindedPointEncoded);
+        EXPECT_EQ(aliceMessage.values[i], decoded[i]);
     }
 }
 
@@ -67,7 +70,7 @@ TEST(SerializationUtilsTest, BobTransformedRoundTrip) {
 
     ASSERT_EQ(bobResponse.values.size(), decoded.size());
     for (std::size_t i = 0; i < decoded.size(); ++i) {
-        EXPECT_EQ(bobResponse.values[i].transformedPointEncoded, decoded[i].transformedPointEncoded);
+        EXPECT_EQ(bobResponse.values[i], decoded[i]);
     }
 }
 
@@ -109,7 +112,7 @@ TEST(SerializationUtilsTest, AliceBlindedJsonRoundTrip) {
 
     ASSERT_EQ(aliceMessage.values.size(), decoded.size());
     for (std::size_t i = 0; i < decoded.size(); ++i) {
-        EXPECT_EQ(aliceMessage.values[i].blindedPointEncoded, decoded[i].blindedPointEncoded);
+        EXPECT_EQ(aliceMessage.values[i], decoded[i]);
     }
 }
 
@@ -132,10 +135,67 @@ TEST(SerializationUtilsTest, BobTransformedJsonRoundTrip) {
 
     ASSERT_EQ(bobResponse.values.size(), decoded.size());
     for (std::size_t i = 0; i < decoded.size(); ++i) {
-        EXPECT_EQ(bobResponse.values[i].transformedPointEncoded, decoded[i].transformedPointEncoded);
+        EXPECT_EQ(bobResponse.values[i], decoded[i]);
     }
 }
 
+// The JSON flights keep their item-by-item layout when written through one
+// writer, and the *Size functions are exact, so a reserved writer never grows.
+TEST(SerializationUtilsTest, JsonWriterFlightsAreExactAndEmbeddable) {
+    ensureSodiumInit();
+
+    std::vector<Unit> bobUnits = {{"b1", 1.0, 2.0}, {"b2", 3.0, 4.0}, {"b3", 5.0, 6.0}};
+    const auto bobMessage = bobCreateInitialMessage(bobUnits);
+    const auto tagMessage = bobCreateInitialTagMessage(bobUnits);
+
+    std::string expectedTags = "{\"items\":[";
+    for (std::size_t i = 0; i < tagMessage.tags.size(); ++i) {
+        expectedTags += (i > 0 ? ",{\"tag\":\"" : "{\"tag\":\"") +
+                        base64Encode(tagMessage.tags[i]) + "\"}";
+    }
+    expectedTags += "]}";
+    EXPECT_EQ(expectedTags, serializeBobTagMessageJson(tagMessage.tags));
+    EXPECT_EQ("{\"items\":[]}", serializeBobTagMessageJson(TagBatch{}));
+
+    const auto encrypted = serializeBobEncryptedMessageJson(bobMessage.units);
+    EXPECT_EQ(bobEncryptedMessageJsonSize(bobMessage.units), encrypted.size());
+    EXPECT_NE(std::string::npos,
+              encrypted.find("{\"ciphertext\":\"" +
+                             base64Encode(bobMessage.units[1].ciphertext.ciphertext) +
+                             "\",\"nonce\":\"" + base64Encode(bobMessage.units[1].ciphertext.nonce) +
+                             "\"}"));
+
+    const std::size_t expectedSize = 1 + bobTagMessageJsonSize(tagMessage.tags) + 1 +
+                                     bobEncryptedMessageJsonSize(bobMessage.units) + 1;
+    JsonWriter writer(expectedSize);
+    const std::size_t capacity = writer.capacity();
+    writer.raw('[');
+    writeBobTagMessageJson(writer, tagMessage.tags);
+    writer.raw(',');
+    writeBobEncryptedMessageJson(writer, bobMessage.units);
+    writer.raw(']');
+    EXPECT_EQ(expectedSize, writer.size());
+    EXPECT_EQ(capacity, writer.capacity());
+    EXPECT_EQ("[" + expectedTags + "," + encrypted + "]", writer.take());
+}
+
+TEST(SerializationUtilsTest, JsonWriterEscapesStringsAndFormatsNumbers) {
+    const std::string text = std::string("a\"b\\c\nd\te\x01") + "\xc3\xa9";
+    JsonWriter writer;
+    writer.string(text);
+    writer.raw(' ');
+    writer.number(12.5);
+    writer.raw(' ');
+    writer.number(0.000123456789);
+    writer.raw(' ');
+    writer.number(1234567.0);
+    writer.raw(' ');
+    writer.number(1.0 / 0.0);
+    EXPECT_EQ("\"a\\\"b\\\\c\\nd\\te\\u0001\xc3\xa9\" 12.5 0.000123457 1.23457e+06 null",
+              writer.take());
+    EXPECT_EQ(std::string("\"a\\\"b\\\\c\\nd\\te\\u0001\xc3\xa9\"").size(), jsonStringSize(text));
+}
+
 TEST(SerializationUtilsTest, JsonPayloadsContainNoPositionField) {
     ensureSodiumInit();
 
@@ -203,6 +263,29 @@ TEST(SerializationUtilsTest, BobTagDeserialiseRejectsWrongLength) {
     EXPECT_THROW(deserializeBobTagMessage("T 1\nAAAA\n"), std::runtime_error);
 }
 
+TEST(SerializationUtilsTest, PointDeserialiseRejectsWrongLength) {
+    ensureSodiumInit();
+    EXPECT_THROW(deserializeAliceBlindedMessage("A 1\nAAAA\n"), std::runtime_error);
+    EXPECT_THROW(deserializeBobTransformedMessageJson(R"({"items":[{"transformedPoint":"AAAA"}]})"),
+                 std::runtime_error);
+}
+
+// Entries sit back to back in one cache-line-aligned buffer, so the binary
+// codec copies a flight in one block.
+TEST(SerializationUtilsTest, PointBatchIsContiguousAndAligned) {
+    PointBatch batch(5);
+    EXPECT_EQ(5u * 32u, batch.byteSize());
+    EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(batch.bytes()) % PointBatch::kAlignment);
+    batch[3].fill(0x5a);
+    EXPECT_EQ(0x5a, batch.bytes()[3 * 32]);
+    EXPECT_EQ(0x5a, batch.bytes()[4 * 32 - 1]);
+    EXPECT_EQ(0x00, batch.bytes()[4 * 32]);
+    batch.push_back(batch[3]);
+    EXPECT_EQ(6u, batch.size());
+    EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(batch.bytes()) % PointBatch::kAlignment);
+    EXPECT_EQ(batch[3], batch[5]);
+}
+
 TEST(SerializationUtilsTest, BobEncryptedDeserialiseRejectsBadHeader) {
     ensureSodiumInit();
     EXPECT_THROW(deserializeBobEncryptedMessage("X 0\n"), std::runtime_error);
@@ -230,3 +313,276 @@ TEST(SerializationUtilsTest, BobTransformedJsonRejectsInvalidStructure) {
     std::string json = R"({"wrong":[{}]})";
     EXPECT_THROW(deserializeBobTransformedMessageJson(json), std::runtime_error);
 }
+
+TEST(SerializationUtilsTest, BinaryTagLayoutIsPinnedAndRoundTrips) {
+    ensureSodiumInit();
+    TagBatch tags(130);
+    for (std::size_t i = 0; i < tags.size(); ++i) {
+        tags[i].fill(static_cast<unsigned char>(i));
+    }
+
+    const auto binary = serializeBobTagMessage(tags, CipherSuite::V2, WireFormat::Binary);
+    // magic, type, suite id, count 130 as LEB128 (0x82 0x01), packed tags.
+    ASSERT_EQ(5 + 130 * 32u, binary.size());
+    EXPECT_EQ(std::string("\xF1T\x02\x82\x01", 5), binary.substr(0, 5));
+    EXPECT_EQ(std::string(32, '\x01'), binary.substr(5 + 32, 32));
+    EXPECT_EQ(WireFormat::Binary, messageWireFormat(binary));
+    EXPECT_EQ(CipherSuite::V2, messageCipherSuite(binary));
+
+    CipherSuite suite = CipherSuite::V1;
+    EXPECT_EQ(tags, deserializeBobTagMessage(binary, &suite));
+    EXPECT_EQ(CipherSuite::V2, suite);
+
+    const auto text = serializeBobTagMessage(tags, CipherSuite::V2);
+    EXPECT_EQ(WireFormat::Text, messageWireFormat(text));
+    EXPECT_LT(binary.size() * 4, text.size() * 3);
+
+    const auto empty = serializeBobTagMessage({}, CipherSuite::V1, WireFormat::Binary);
+    EXPECT_EQ(std::string("\xF1T\x01\x00", 4), empty);
+    EXPECT_TRUE(deserializeBobTagMessage(empty).empty());
+}
+
+TEST(SerializationUtilsTest, BinaryPointAndSecretboxFlightsRoundTrip) {
+    ensureSodiumInit();
+    PointBatch blinded(3);
+    PointBatch transformed(3);
+    for (std::size_t i = 0; i < 3; ++i) {
+        blinded[i].fill(static_cast<unsigned char>(i + 1));
+        transformed[i].fill(static_cast<unsigned char>(i + 9));
+    }
+    const auto a = serializeAliceBlindedMessage(blinded, WireFormat::Binary);
+    EXPECT_EQ(std::string("\xF1" "A\x03", 3), a.substr(0, 3));
+    EXPECT_EQ(blinded, deserializeAliceBlindedMessage(a));
+    const auto r = serializeBobTransformedMessage(transformed, WireFormat::Binary);
+    EXPECT_EQ(transformed, deserializeBobTransformedMessage(r));
+
+    const std::vector<Unit> bobUnits = {{"b1", 1.2, 3.4}, {"b2", 5.6, 7.8}};
+    const auto bobMessage = bobCreateInitialMessage(bobUnits, nullptr, nullptr, CipherSuite::V2,
+                                                    WireFormat::Binary);
+    EXPECT_EQ(WireFormat::Binary, messageWireFormat(bobMessage.serialized));
+    CipherSuite suite = CipherSuite::V1;
+    const auto decoded = deserializeBobEncryptedMessage(bobMessage.serialized, &suite);
+    EXPECT_EQ(CipherSuite::V2, suite);
+    ASSERT_EQ(bobMessage.units.size(), decoded.size());
+    for (std::size_t i = 0; i < decoded.size(); ++i) {
+        EXPECT_EQ(bobMessage.units[i].ciphertext.ciphertext, decoded[i].ciphertext.ciphertext);
+        EXPECT_EQ(bobMessage.units[i].ciphertext.nonce, decoded[i].ciphertext.nonce);
+    }
+}
+
+TEST(SerializationUtilsTest, IndexedSecretboxFlightsRoundTrip) {
+    ensureSodiumInit();
+    const std::vector<Unit> bobUnits = {{"b1", 1.2, 3.4}, {"b2", 5.6, 7.8}, {"b3", 9.0, 1.0}};
+    for (const auto format : {WireFormat::Text, WireFormat::Binary}) {
+        const auto bobMessage = bobCreateInitialIndexedMessage(bobUnits, nullptr, nullptr,
+                                                               CipherSuite::V2, format);
+        EXPECT_EQ('I', messageType(bobMessage.serialized));
+        EXPECT_EQ(CipherSuite::V2, messageCipherSuite(bobMessage.serialized));
+        EXPECT_EQ(bobMessage.serialized,
+                  serializeBobIndexedMessage(bobMessage.units, CipherSuite::V2, format));
+
+        CipherSuite suite = CipherSuite::V1;
+        const auto decoded = deserializeBobIndexedMessage(bobMessage.serialized, &suite);
+        EXPECT_EQ(CipherSuite::V2, suite);
+        ASSERT_EQ(bobMessage.units.size(), decoded.size());
+        for (std::size_t i = 0; i < decoded.size(); ++i) {
+            EXPECT_EQ(bobMessage.units[i].locator, decoded[i].locator);
+            EXPECT_EQ(bobMessage.units[i].ciphertext.ciphertext,
+                      decoded[i].ciphertext.ciphertext);
+            EXPECT_EQ(bobMessage.units[i].ciphertext.nonce, decoded[i].ciphertext.nonce);
+        }
+        EXPECT_THROW(deserializeBobEncryptedMessage(bobMessage.serialized), std::runtime_error);
+    }
+
+    // Binary: magic, type, suite, count, then the locator leads the entry.
+    IndexedEncryptedUnit unit;
+    unit.locator.fill(0x5a);
+    unit.ciphertext.nonce.fill(0x11);
+    unit.ciphertext.ciphertext = {1, 2, 3};
+    const auto binary = serializeBobIndexedMessage({unit}, CipherSuite::V1, WireFormat::Binary);
+    ASSERT_EQ(4 + kLocatorBytes + crypto_secretbox_NONCEBYTES + 1 + 3, binary.size());
+    EXPECT_EQ(std::string("\xF1I\x01\x01", 4), binary.substr(0, 4));
+    EXPECT_EQ(std::string(kLocatorBytes, '\x5a'), binary.substr(4, kLocatorBytes));
+    EXPECT_THROW(deserializeBobIndexedMessage(binary.substr(0, binary.size() - 1)),
+                 std::runtime_error);
+
+    const std::string text = serializeBobIndexedMessage({unit});
+    EXPECT_EQ(0u, text.find("I 1\nWlpaWlpaWlo\n"));
+    EXPECT_THROW(deserializeBobIndexedMessage("I 1\nWlpa\nAQID\n" +
+                                              base64Encode(unit.ciphertext.nonce) + "\n"),
+                 std::runtime_error);
+}
+
+// Binary entries are read from the received buffer itself; text entries are
+// decoded per requested range, and only once the framing has been checked.
+TEST(SerializationUtilsTest, FlightViewsReadEntriesInPlace) {
+    ensureSodiumInit();
+    PointBatch points(4);
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        points[i].fill(static_cast<unsigned char>(0x30 + i));
+    }
+
+    const auto binary = serializeAliceBlindedMessage(points, WireFormat::Binary);
+    const FlightView binaryView = viewAliceBlindedMessage(binary);
+    ASSERT_EQ(4u, binaryView.size());
+    EXPECT_EQ(WireFormat::Binary, binaryView.format());
+    std::vector<FlightView::Entry> scratch;
+    const auto* inPlace = binaryView.entries(1, 3, scratch);
+    EXPECT_EQ(reinterpret_cast<const void*>(binary.data() + 3 + 32),
+              reinterpret_cast<const void*>(inPlace));
+    EXPECT_TRUE(scratch.empty());
+    EXPECT_EQ(points[2], inPlace[1]);
+
+    const auto text = serializeBobTransformedMessage(points);
+    const FlightView textView = viewBobTransformedMessage(text);
+    EXPECT_EQ(WireFormat::Text, textView.format());
+    const auto* decoded = textView.entries(2, 4, scratch);
+    EXPECT_EQ(2u, scratch.size());
+    EXPECT_EQ(points[2], decoded[0]);
+    EXPECT_EQ(points[3], decoded[1]);
+    EXPECT_EQ(points, textView.toBatch());
+
+    const auto tags = serializeBobTagMessage(points, CipherSuite::V2);
+    EXPECT_EQ(CipherSuite::V2, viewBobTagMessage(tags).suite());
+    EXPECT_THROW(viewAliceBlindedMessage(tags), std::runtime_error);
+
+    // Framing: trailing data and a short line are caught before decoding.
+    EXPECT_THROW(viewBobTransformedMessage(text + "x"), std::runtime_error);
+    auto shortLine = text;
+    shortLine.erase(4 + 44 + 10, 1);
+    EXPECT_THROW(viewBobTransformedMessage(shortLine), std::runtime_error);
+
+    // A bad character fails only the range that contains it, naming the entry.
+    auto badEntry = text;
+    badEntry[4 + 44 * 3 + 5] = '$';
+    const FlightView badView = viewBobTransformedMessage(badEntry);
+    EXPECT_NO_THROW(badView.entries(0, 3, scratch));
+    try {
+        badView.entries(1, 4, scratch);
+        FAIL() << "expected a decode error";
+    } catch (const std::runtime_error& error) {
+        EXPECT_NE(std::string::npos, std::string(error.what()).find("line 4"));
+    }
+}
+
+// Large text flights decode in parallel chunks into one pre-sized batch. The
+// error names the first malformed line whatever the chunking, and every
+// policy decodes the same content.
+TEST(SerializationUtilsTest, ParallelTextDecodingIsDeterministic) {
+    ensureSodiumInit();
+    constexpr std::size_t kCount = 20000;
+    TagBatch tags(kCount);
+    randombytes_buf(tags.bytes(), tags.byteSize());
+    const auto text = serializeBobTagMessage(tags, CipherSuite::V2);
+
+    ExecutionPolicy serial;
+    serial.threadCount = 1;
+    ExecutionPolicy chunked;
+    chunked.grainSize = 97;
+    chunked.serialThreshold = 1;
+    for (const auto* policy : {&serial, &chunked}) {
+        CipherSuite suite = CipherSuite::V1;
+        EXPECT_EQ(tags, deserializeBobTagMessage(text, &suite, policy));
+        EXPECT_EQ(CipherSuite::V2, suite);
+    }
+
+    // Header "T 20000 v2\n" is line 0; entry i is line i + 1.
+    const std::size_t headerBytes = text.find('\n') + 1;
+    auto corrupted = text;
+    for (const std::size_t entry : {15000u, 7001u, 19999u}) {
+        corrupted[headerBytes + entry * 44 + 7] = '*';
+    }
+    for (const auto* policy : {&serial, &chunked}) {
+        try {
+            deserializeBobTagMessage(corrupted, nullptr, policy);
+            FAIL() << "expected a decode error";
+        } catch (const std::runtime_error& error) {
+            EXPECT_NE(std::string::npos, std::string(error.what()).find("line 7002 "))
+                << error.what();
+        }
+    }
+
+    const std::vector<Unit> bobUnits = {{"b1", 1.2, 3.4}, {"b2", 5.6, 7.8}, {"b3", 0.0, 1.0}};
+    const auto bobMessage = bobCreateInitialMessage(bobUnits);
+    const auto units = deserializeBobEncryptedMessage(bobMessage.serialized, nullptr, &chunked);
+    ASSERT_EQ(bobMessage.units.size(), units.size());
+    for (std::size_t i = 0; i < units.size(); ++i) {
+        EXPECT_EQ(bobMessage.units[i].ciphertext.ciphertext, units[i].ciphertext.ciphertext);
+        EXPECT_EQ(bobMessage.units[i].ciphertext.nonce, units[i].ciphertext.nonce);
+    }
+    // Lines 1 and 2 are unit 0's ciphertext and nonce; line 4 is unit 1's nonce.
+    auto badNonce = bobMessage.serialized;
+    const std::size_t line4 = [&]() {
+        std::size_t offset = 0;
+        for (int line = 0; line < 4; ++line) {
+            offset = badNonce.find('\n', offset) + 1;
+        }
+        return offset;
+    }();
+    badNonce.insert(line4, "AAAA");
+    try {
+        deserializeBobEncryptedMessage(badNonce, nullptr, &chunked);
+        FAIL() << "expected a decode error";
+    } catch (const std::runtime_error& error) {
+        EXPECT_NE(std::string::npos, std::string(error.what()).find("line 4 "))
+            << error.what();
+    }
+    EXPECT_THROW(deserializeBobEncryptedMessage(bobMessage.serialized + "\n"),
+                 std::runtime_error);
+}
+
+// Every binary flight has exactly one valid encoding: truncation, trailing
+// bytes, overlong varints, forged counts, a wrong type byte and unknown
+// suites are all rejected.
+TEST(SerializationUtilsTest, BinaryDeserialiseRejectsMalformedFlights) {
+    ensureSodiumInit();
+    const TagBatch tags(2);
+    const auto valid = serializeBobTagMessage(tags, CipherSuite::V1, WireFormat::Binary);
+    ASSERT_NO_THROW(deserializeBobTagMessage(valid));
+
+    EXPECT_THROW(deserializeBobTagMessage(valid.substr(0, valid.size() - 1)), std::runtime_error);
+    EXPECT_THROW(deserializeBobTagMessage(valid + '\0'), std::runtime_error);
+    EXPECT_THROW(deserializeAliceBlindedMessage(valid), std::runtime_error);
+
+    auto unknownSuite = valid;
+    unknownSuite[2] = '\x09';
+    EXPECT_THROW(deserializeBobTagMessage(unknownSuite), std::runtime_error);
+    EXPECT_THROW(messageCipherSuite(unknownSuite), std::runtime_error);
+
+    const std::string overlong = std::string("\xF1T\x01\x82\x00", 5) + std::string(64, '\0');
+    EXPECT_THROW(deserializeBobTagMessage(overlong), std::runtime_error);
+    const std::string forgedCount = std::string("\xF1T\x01\xff\xff\xff\xff\x0f", 8);
+    EXPECT_THROW(deserializeBobTagMessage(forgedCount), std::runtime_error);
+    const std::string tooLong = std::string("\xF1T\x01", 3) + std::string(10, '\xff') + '\x01';
+    EXPECT_THROW(deserializeBobTagMessage(tooLong), std::runtime_error);
+
+    EXPECT_THROW(deserializeBobEncryptedMessage(std::string("\xF1" "B\x01\x01", 4) +
+                                                std::string(24, '\0') + "\x05" "abc"),
+                 std::runtime_error);
+    EXPECT_EQ(WireFormat::Binary, parseWireFormat("binary"));
+    EXPECT_THROW(parseWireFormat("cbor"), std::runtime_error);
+}
+
+// Bob picks binary for his first flight; Alice's and Bob's replies follow it.
+TEST(SerializationUtilsTest, BinaryExchangeRepliesInTheFormatItWasOpenedIn) {
+    ensureSodiumInit();
+    const std::vector<Unit> bobUnits = {{"b1", 1.2, 3.4}, {"b2", 5.6, 7.8}, {"b3", 9.0, 9.0}};
+    const std::vector<Unit> aliceUnits = {{"a1", 1.9, 3.1}, {"a2", 9.5, 9.5}};
+
+    const auto bobTags = bobCreateInitialTagMessage(bobUnits, nullptr, nullptr, nullptr,
+                                                    CipherSuite::V2, WireFormat::Binary);
+    const auto alice = aliceProcessBobTagMessage(bobTags.serialized, aliceUnits);
+    EXPECT_EQ(WireFormat::Binary, alice.state.format);
+    EXPECT_EQ(WireFormat::Binary, messageWireFormat(alice.serialized));
+    EXPECT_EQ(3 + 2 * 32u, alice.serialized.size());
+    const auto response = bobProcessAliceMessage(alice.serialized, bobTags.state);
+    EXPECT_EQ(WireFormat::Binary, messageWireFormat(response.serialized));
+    EXPECT_EQ(2u, aliceFinalizeIntersectionTags(response.serialized, alice.state).size());
+
+    EXPECT_EQ(2u, runPSIProtocol(bobUnits, aliceUnits, nullptr, nullptr, nullptr,
+                                 CipherSuite::V1, WireFormat::Binary)
+                      .size());
+    EXPECT_EQ(2u, runPSIProtocolTags(bobUnits, aliceUnits, nullptr, nullptr, nullptr,
+                                     CipherSuite::V1, WireFormat::Binary)
+                      .size());
+}
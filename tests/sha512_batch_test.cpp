@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "crypto_utils.h"
+#include "sha512_batch.h"
+#include "test_helpers.h"
+
+namespace {
+
+class Sha512BackendGuard {
+public:
+    explicit Sha512BackendGuard(Sha512Backend backend) : previous_(activeSha512Backend()) {
+        setSha512Backend(backend);
+    }
+    ~Sha512BackendGuard() { setSha512Backend(previous_); }
+
+    Sha512BackendGuard(const Sha512BackendGuard&) = delete;
+    Sha512BackendGuard& operator=(const Sha512BackendGuard&) = delete;
+
+private:
+    Sha512Backend previous_;
+};
+
+std::vector<Sha512Backend> supportedBackends() {
+    std::vector<Sha512Backend> backends;
+    for (const auto backend :
+         {Sha512Backend::Portable, Sha512Backend::Avx2, Sha512Backend::Avx512}) {
+        if (sha512BackendSupported(backend)) {
+            backends.push_back(backend);
+        }
+    }
+    return backends;
+}
+
+}  // namespace
+
+// Lengths straddle the one/two-block padding boundary (111/112 bytes) and mix
+// block counts within a lane group; 19 messages leave tails for both the
+// eight- and four-lane kernels.
+TEST(Sha512BatchTest, EveryBackendMatchesLibsodium) {
+    ensureSodiumInit();
+
+    const std::vector<std::size_t> lengths = {0,   1,   111, 112, 127, 128, 200, 300, 32, 7,
+                                              240, 256, 33,  64,  1000, 5,  111, 112, 129};
+    std::vector<std::vector<unsigned char>> messages;
+    for (std::size_t i = 0; i < lengths.size(); ++i) {
+        std::vector<unsigned char> message(lengths[i]);
+        for (std::size_t j = 0; j < message.size(); ++j) {
+            message[j] = static_cast<unsigned char>(i * 31 + j * 7);
+        }
+        messages.push_back(std::move(message));
+    }
+    std::vector<const unsigned char*> inputs;
+    for (const auto& message : messages) {
+        inputs.push_back(message.data());
+    }
+
+    for (const auto backend : supportedBackends()) {
+        SCOPED_TRACE(sha512BackendName(backend));
+        const Sha512BackendGuard guard(backend);
+
+        std::vector<Sha512Digest> digests(lengths.size());
+        sha512Batch(inputs.data(), lengths.data(), lengths.size(), digests.data());
+        for (std::size_t i = 0; i < lengths.size(); ++i) {
+            Sha512Digest expected{};
+            ASSERT_EQ(crypto_hash_sha512(expected.data(), messages[i].data(), lengths[i]), 0);
+            EXPECT_EQ(expected, digests[i]) << "length " << lengths[i];
+        }
+    }
+}
+
+TEST(Sha512BatchTest, BatchHashesMatchPerElementFunctions) {
+    ensureSodiumInit();
+
+    std::vector<std::string> messages;
+    for (int i = 0; i < 21; ++i) {
+        messages.push_back("element " + std::string(static_cast<std::size_t>(i * 9), 'x'));
+    }
+
+    for (const auto backend : supportedBackends()) {
+        SCOPED_TRACE(sha512BackendName(backend));
+        const Sha512BackendGuard guard(backend);
+
+        std::vector<RistrettoPoint> points(messages.size());
+        hashToGroupBatch(messages.data(), messages.size(), points.data());
+        std::vector<std::array<unsigned char, 32>> keys(points.size());
+        hashPointToKeyBatch(points.data(), points.size(), keys.data());
+
+        HashToGroupCache cache;
+        cache.getElement(messages[3]);  // one warm entry among misses
+        std::vector<RistrettoElement> cached(messages.size());
+        hashToGroupElementBatch(messages.data(), messages.size(), cached.data(), &cache);
+
+        for (std::size_t i = 0; i < messages.size(); ++i) {
+            EXPECT_EQ(hashToGroup(messages[i]), points[i]) << "index " << i;
+            EXPECT_EQ(hashPointToKey(points[i]), keys[i]) << "index " << i;
+            RistrettoPoint encoded{};
+            ristrettoEncode(encoded.data(), cached[i]);
+            EXPECT_EQ(points[i], encoded) << "index " << i;
+            EXPECT_EQ(points[i], cache.get(messages[i])) << "index " << i;
+        }
+    }
+}
+
+TEST(Sha512BatchTest, UnsupportedBackendIsRejected) {
+    EXPECT_TRUE(sha512BackendSupported(Sha512Backend::Portable));
+    EXPECT_TRUE(sha512BackendSupported(activeSha512Backend()));
+    for (const auto backend : {Sha512Backend::Avx2, Sha512Backend::Avx512}) {
+        if (!sha512BackendSupported(backend)) {
+            EXPECT_THROW(setSha512Backend(backend), std::runtime_error);
+        }
+    }
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "point_batch.h"
+#include "serialization_utils.h"
+#include "tag_filter.h"
+#include "test_helpers.h"
+
+namespace {
+
+TagBatch randomTags(std::size_t count) {
+    TagBatch tags(count);
+    randombytes_buf(tags.bytes(), tags.byteSize());
+    return tags;
+}
+
+}  // namespace
+
+TEST(TagFilterTest, FingerprintWidthFollowsTheRate) {
+    EXPECT_DOUBLE_EQ(8.0 / 255, tagFilterFalsePositiveRate(1));
+    EXPECT_EQ(1u, tagFilterFingerprintBytes(0.05));
+    EXPECT_EQ(1u, tagFilterFingerprintBytes(8.0 / 255));
+    EXPECT_EQ(2u, tagFilterFingerprintBytes(8.0 / 256));
+    EXPECT_EQ(2u, tagFilterFingerprintBytes(0.001));
+    EXPECT_EQ(3u, tagFilterFingerprintBytes(1e-6));
+    EXPECT_EQ(4u, tagFilterFingerprintBytes(1e-8));
+    EXPECT_THROW(tagFilterFingerprintBytes(1e-9), std::runtime_error);
+    EXPECT_THROW(tagFilterFingerprintBytes(0.0), std::runtime_error);
+    EXPECT_THROW(tagFilterFingerprintBytes(1.0), std::runtime_error);
+    EXPECT_THROW(tagFilterFalsePositiveRate(5), std::runtime_error);
+}
+
+TEST(TagFilterTest, HoldsEveryTagAndStaysUnderItsRate) {
+    ensureSodiumInit();
+    const TagBatch tags = randomTags(20000);
+    const TagBatch others = randomTags(200000);
+    for (std::size_t bytes = 1; bytes <= 2; ++bytes) {
+        SCOPED_TRACE(bytes);
+        const TagFilter filter = TagFilter::build(tags, bytes);
+        EXPECT_LE(filter.table().size(), tags.size() * bytes * 11 / 10);
+        for (const auto& tag : tags) {
+            ASSERT_TRUE(filter.mayContain(tag));
+        }
+        std::size_t falsePositives = 0;
+        for (const auto& tag : others) {
+            falsePositives += filter.mayContain(tag) ? 1 : 0;
+        }
+        EXPECT_LE(static_cast<double>(falsePositives) / others.size(),
+                  2 * filter.falsePositiveRate());
+    }
+
+    const TagFilter empty = TagFilter::build(TagBatch{}, 2);
+    EXPECT_EQ(1u, empty.bucketCount());
+    EXPECT_FALSE(empty.mayContain(tags[0]));
+}
+
+// A zero fingerprint window gives way to the next one rather than to a fixed
+// value, so no fingerprint is likelier than the rest.
+TEST(TagFilterTest, ZeroFingerprintWindowTakesTheNext) {
+    TagBatch tags(1);
+    tags[0][8] = 0;
+    tags[0][9] = 0x77;
+    const TagFilter filter = TagFilter::build(tags, 1);
+
+    TagFilter::Tag next = tags[0];
+    next[8] = 0x77;
+    EXPECT_TRUE(filter.mayContain(next));
+    TagFilter::Tag one = tags[0];
+    one[8] = 1;
+    EXPECT_FALSE(filter.mayContain(one));
+}
+
+TEST(TagFilterTest, RepeatedTagsAndRebuildsAreStable) {
+    ensureSodiumInit();
+    TagBatch tags = randomTags(500);
+    const TagFilter filter = TagFilter::build(tags, 2);
+    EXPECT_EQ(filter.table(), TagFilter::build(tags, 2).table());
+
+    TagBatch repeated = tags;
+    for (std::size_t i = 0; i < 100; ++i) {
+        repeated.push_back(tags[i]);
+    }
+    const TagFilter withRepeats = TagFilter::build(repeated, 2);
+    for (const auto& tag : tags) {
+        EXPECT_TRUE(withRepeats.mayContain(tag));
+    }
+}
+
+TEST(TagFilterTest, FlightRoundTripsInBothEncodings) {
+    ensureSodiumInit();
+    const TagBatch tags = randomTags(100);
+    const TagFilter filter = TagFilter::build(tags, 2);
+
+    const std::string text = serializeBobTagFilterMessage(filter, tags.size(), CipherSuite::V2);
+    EXPECT_EQ(0u, text.find("F 100 16 " + std::to_string(filter.bucketCount()) + " v2\n"));
+    EXPECT_EQ(CipherSuite::V2, messageCipherSuite(text));
+    EXPECT_EQ('F', messageType(text));
+
+    const std::string binary =
+        serializeBobTagFilterMessage(filter, tags.size(), CipherSuite::V2, WireFormat::Binary);
+    EXPECT_EQ(CipherSuite::V2, messageCipherSuite(binary));
+    EXPECT_EQ('F', messageType(binary));
+    EXPECT_LT(binary.size(), tags.size() * 3);
+
+    for (const auto& flight : {text, binary}) {
+        CipherSuite suite = CipherSuite::V1;
+        std::size_t count = 0;
+        const TagFilter received = deserializeBobTagFilterMessage(flight, &suite, &count);
+        EXPECT_EQ(CipherSuite::V2, suite);
+        EXPECT_EQ(tags.size(), count);
+        EXPECT_EQ(filter.fingerprintBytes(), received.fingerprintBytes());
+        EXPECT_EQ(filter.bucketCount(), received.bucketCount());
+        EXPECT_EQ(filter.table(), received.table());
+    }
+
+    const std::string v1 = serializeBobTagFilterMessage(filter, tags.size());
+    EXPECT_EQ(0u, v1.find("F 100 16 " + std::to_string(filter.bucketCount()) + "\n"));
+    EXPECT_EQ(CipherSuite::V1, messageCipherSuite(v1));
+}
+
+TEST(TagFilterTest, RejectsMalformedFlights) {
+    ensureSodiumInit();
+    const TagFilter filter = TagFilter::build(randomTags(50), 1);
+    const std::string text = serializeBobTagFilterMessage(filter, 50);
+    const std::string binary =
+        serializeBobTagFilterMessage(filter, 50, CipherSuite::V1, WireFormat::Binary);
+
+    EXPECT_THROW(deserializeBobTagFilterMessage(text + "AAAA\n"), std::runtime_error);
+    EXPECT_THROW(deserializeBobTagFilterMessage(binary + std::string(1, '\0')),
+                 std::runtime_error);
+    EXPECT_THROW(deserializeBobTagFilterMessage(binary.substr(0, binary.size() - 1)),
+                 std::runtime_error);
+
+    std::string wrongWidth = binary;
+    wrongWidth[4] = 12;  // magic, type, suite, count 50, width
+    EXPECT_THROW(deserializeBobTagFilterMessage(wrongWidth), std::runtime_error);
+
+    std::string wrongBuckets = "F 50 8 " + std::to_string(filter.bucketCount() + 1) +
+                               text.substr(text.find('\n'));
+    EXPECT_THROW(deserializeBobTagFilterMessage(wrongBuckets), std::runtime_error);
+    EXPECT_THROW(deserializeBobTagFilterMessage(serializeBobTagMessage(randomTags(2))),
+                 std::runtime_error);
+    EXPECT_THROW(TagFilter(2, 3, std::vector<unsigned char>(23)), std::runtime_error);
+}
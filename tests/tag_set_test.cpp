@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "execution_policy.h"
+#include "point_batch.h"
+#include "tag_set.h"
+#include "test_helpers.h"
+#include "thread_pool.h"
+
+namespace {
+
+TagBatch randomTags(std::size_t count) {
+    TagBatch tags(count);
+    randombytes_buf(tags.bytes(), tags.byteSize());
+    return tags;
+}
+
+}  // namespace
+
+TEST(TagSetTest, FindsEveryTagAndNothingElse) {
+    ensureSodiumInit();
+    const TagBatch tags = randomTags(1000);
+    const TagSet set(tags);
+    EXPECT_EQ(tags.size(), set.size());
+
+    std::vector<bool> slotSeen(set.slotCount());
+    for (const auto& tag : tags) {
+        const std::size_t slot = set.find(tag);
+        ASSERT_NE(TagSet::npos, slot);
+        ASSERT_LT(slot, set.slotCount());
+        EXPECT_FALSE(slotSeen[slot]);
+        slotSeen[slot] = true;
+    }
+
+    for (const auto& tag : randomTags(1000)) {
+        EXPECT_FALSE(set.contains(tag));
+    }
+    // Same prefix, different tail.
+    auto forged = tags[7];
+    forged[31] ^= 1;
+    EXPECT_FALSE(set.contains(forged));
+    EXPECT_FALSE(TagSet(TagBatch{}).contains(tags[0]));
+}
+
+TEST(TagSetTest, RepeatedAndZeroPrefixTagsShareOneSlot) {
+    ensureSodiumInit();
+    TagBatch tags = randomTags(6);
+    tags[3] = tags[1];
+    std::memset(tags[4].data(), 0, 8);
+    tags[5] = tags[4];
+    const TagSet set(tags);
+
+    EXPECT_EQ(4u, set.size());
+    EXPECT_EQ(set.find(tags[1]), set.find(tags[3]));
+    EXPECT_EQ(set.slotCount() - 1, set.find(tags[4]));
+    auto otherZero = tags[4];
+    otherZero[20] ^= 1;
+    EXPECT_FALSE(set.contains(otherZero));
+}
+
+TEST(TagSetTest, ParallelBuildMatchesSerial) {
+    ensureSodiumInit();
+    const TagBatch tags = randomTags(50000);
+    ExecutionPolicy serial;
+    serial.threadCount = 1;
+    ExecutionPolicy parallel;
+    parallel.serialThreshold = 0;
+    const TagSet serialSet(tags, &serial);
+    const TagSet parallelSet(tags, &parallel);
+
+    EXPECT_EQ(serialSet.size(), parallelSet.size());
+    for (std::size_t i = 0; i < tags.size(); ++i) {
+        ASSERT_TRUE(parallelSet.contains(tags[i])) << i;
+    }
+}
+
+// Tags sharing a prefix with different tails: the first in flight order is
+// kept, on one thread or several.
+TEST(TagSetTest, SamePrefixKeepsTheFirstTagOnAnyThreadCount) {
+    ensureSodiumInit();
+    TagBatch tags = randomTags(50000);
+    for (std::size_t i = 1000; i < tags.size(); i += 1000) {
+        std::memcpy(tags[i].data(), tags[i - 997].data(), 8);
+    }
+    ThreadPool pool(4);
+    ExecutionPolicy serial;
+    serial.threadCount = 1;
+    ExecutionPolicy parallel;
+    parallel.pool = &pool;
+    parallel.serialThreshold = 0;
+    parallel.grainSize = 64;
+    const TagSet serialSet(tags, &serial);
+    for (int run = 0; run < 4; ++run) {
+        const TagSet parallelSet(tags, &parallel);
+        ASSERT_EQ(serialSet.size(), parallelSet.size());
+        for (std::size_t i = 0; i < tags.size(); ++i) {
+            ASSERT_EQ(serialSet.contains(tags[i]), parallelSet.contains(tags[i])) << i;
+        }
+    }
+    EXPECT_TRUE(serialSet.contains(tags[3]));
+    EXPECT_FALSE(serialSet.contains(tags[1000]));
+}
+
+// Prefixes that all share a home slot would make every lookup a scan.
+TEST(TagSetTest, RejectsClusteredFlights) {
+    ensureSodiumInit();
+    TagBatch tags = randomTags(TagSet::kMaxProbe + 1);
+    for (std::size_t i = 0; i < tags.size(); ++i) {
+        const std::uint64_t prefix = (static_cast<std::uint64_t>(i) + 1) << 40;
+        std::memcpy(tags[i].data(), &prefix, sizeof prefix);
+    }
+    EXPECT_THROW(TagSet{tags}, std::runtime_error);
+}
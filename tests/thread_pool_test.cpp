@@ -0,0 +1,245 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "derivation.h"
+#include "execution_policy.h"
+#include "psi_protocol.h"
+#include "test_helpers.h"
+#include "thread_pool.h"
+
+TEST(ThreadPoolTest, CoversEveryIndexExactlyOnce) {
+    ThreadPool pool(3);
+    constexpr std::size_t kCount = 10007;  // not a multiple of the grain
+    std::vector<int> hits(kCount, 0);
+
+    parallelForRange(pool, kCount, 64, 4, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            ++hits[i];
+        }
+    });
+
+    for (std::size_t i = 0; i < kCount; ++i) {
+        ASSERT_EQ(1, hits[i]) << "index " << i;
+    }
+}
+
+TEST(ThreadPoolTest, ZeroWorkersRunsOnCaller) {
+    ThreadPool pool(0);
+    std::vector<std::size_t> out(500, 0);
+    parallelForRange(pool, out.size(), 7, 8, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            out[i] = i * i;
+        }
+    });
+    for (std::size_t i = 0; i < out.size(); ++i) {
+        EXPECT_EQ(i * i, out[i]);
+    }
+}
+
+// The first failing chunk (by index, not by completion time) is the one
+// reported, so the error a caller sees does not depend on scheduling.
+TEST(ThreadPoolTest, RethrowsFirstChunkErrorOnCaller) {
+    ThreadPool pool(4);
+    for (int attempt = 0; attempt < 20; ++attempt) {
+        try {
+            parallelForRange(pool, 1000, 10, 5, [](std::size_t begin, std::size_t) {
+                if (begin == 300 || begin == 700) {
+                    throw std::runtime_error("chunk " + std::to_string(begin));
+                }
+            });
+            FAIL() << "expected an exception";
+        } catch (const std::runtime_error& ex) {
+            EXPECT_EQ(std::string("chunk 300"), ex.what());
+        }
+    }
+}
+
+// A range body that itself runs a parallel loop on the same pool must not
+// deadlock, even when every worker is busy with outer chunks.
+TEST(ThreadPoolTest, NestedRangesComplete) {
+    ThreadPool pool(2);
+    std::atomic<std::size_t> total{0};
+    parallelForRange(pool, 16, 1, 3, [&](std::size_t, std::size_t) {
+        parallelForRange(pool, 100, 10, 3, [&](std::size_t begin, std::size_t end) {
+            total.fetch_add(end - begin);
+        });
+    });
+    EXPECT_EQ(1600u, total.load());
+}
+
+TEST(ThreadPoolTest, StatsCountQueueWaitAndCompute) {
+    ThreadPool pool(2);
+    pool.resetStats();
+    std::atomic<int> done{0};
+    for (int i = 0; i < 8; ++i) {
+        pool.submit([&done]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            done.fetch_add(1);
+        });
+    }
+    // Counters are published after each task returns; poll briefly.
+    for (int spin = 0; spin < 2000 && pool.stats().tasksExecuted < 8; ++spin) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const auto stats = pool.stats();
+    EXPECT_EQ(8, done.load());
+    EXPECT_EQ(8u, stats.tasksExecuted);
+    EXPECT_GE(stats.computeNs, 8u * 1000000u);
+    EXPECT_GT(stats.queueWaitNs, 0u);  // 8 tasks on 2 workers must queue
+}
+
+// Same seeds in, same bytes out: running the phases on the pool must not
+// change any wire message. 400 elements is above the parallel threshold.
+TEST(ThreadPoolTest, PooledExchangeIsByteIdenticalAcrossRuns) {
+    ensureSodiumInit();
+
+    std::vector<std::string> bobElements;
+    std::vector<std::string> aliceElements;
+    for (int i = 0; i < 400; ++i) {
+        bobElements.push_back("b" + std::to_string(i));
+        aliceElements.push_back((i % 3 == 0 ? "b" : "a") + std::to_string(i));
+    }
+    std::array<unsigned char, 32> seed{};
+    seed.fill(0x5A);
+
+    std::string first;
+    for (int run = 0; run < 3; ++run) {
+        DeterministicRng bobRng(seed, 0, 0);
+        DeterministicRng aliceRng(seed, 0, 1);
+        const auto bobMessage = bobCreateInitialTagMessageFromElements(bobElements, nullptr, &bobRng);
+        const auto aliceMessage = aliceProcessBobTagMessageFromElements(
+            bobMessage.serialized, aliceElements, nullptr, &aliceRng);
+        const auto bobResponse = bobProcessAliceMessage(aliceMessage.serialized, bobMessage.state);
+        const std::string transcript =
+            bobMessage.serialized + aliceMessage.serialized + bobResponse.serialized;
+        if (run == 0) {
+            first = transcript;
+        } else {
+            EXPECT_EQ(first, transcript);
+        }
+        EXPECT_EQ(134u, aliceFinalizeIntersectionTags(bobResponse.serialized, aliceMessage.state)
+                            .size());
+    }
+}
+
+// The policy only changes scheduling: fully serial, two threads with tiny
+// chunks, and a private pool must all put the same bytes on the wire.
+TEST(BackgroundTaskTest, WaitRunsAnUnstartedJobOnTheCaller) {
+    // Declared before the pool so they outlive its workers.
+    std::mutex gate;
+    std::atomic<bool> blockerStarted{false};
+    ThreadPool pool(1);
+    std::unique_lock<std::mutex> hold(gate);
+    // Occupy the only worker so the background job cannot start there.
+    pool.submit([&]() {
+        blockerStarted = true;
+        std::lock_guard<std::mutex> wait(gate);
+    });
+    while (!blockerStarted) {
+        std::this_thread::yield();
+    }
+
+    std::thread::id ranOn;
+    int runs = 0;
+    auto task = BackgroundTask::start(pool, [&]() {
+        ranOn = std::this_thread::get_id();
+        ++runs;
+    });
+    task->wait();
+    EXPECT_EQ(std::this_thread::get_id(), ranOn);
+
+    hold.unlock();
+    task->wait();
+    EXPECT_EQ(1, runs);
+}
+
+TEST(BackgroundTaskTest, WaitRethrowsTheJobsError) {
+    ThreadPool pool(2);
+    auto task = BackgroundTask::start(pool, []() { throw std::runtime_error("job failed"); });
+    EXPECT_THROW(task->wait(), std::runtime_error);
+    EXPECT_THROW(task->wait(), std::runtime_error);
+}
+
+TEST(ExecutionPolicyTest, EveryPolicyProducesTheSameTranscript) {
+    ensureSodiumInit();
+
+    std::vector<std::string> bobElements;
+    std::vector<std::string> aliceElements;
+    for (int i = 0; i < 300; ++i) {
+        bobElements.push_back("b" + std::to_string(i));
+        aliceElements.push_back((i % 4 == 0 ? "b" : "a") + std::to_string(i));
+    }
+    std::array<unsigned char, 32> seed{};
+    seed.fill(0x3C);
+
+    ThreadPool privatePool(3);
+    ExecutionPolicy serial;
+    serial.threadCount = 1;
+    ExecutionPolicy smallChunks;
+    smallChunks.threadCount = 2;
+    smallChunks.grainSize = 3;
+    smallChunks.serialThreshold = 0;
+    ExecutionPolicy ownPool;
+    ownPool.pool = &privatePool;
+    ownPool.serialThreshold = 16;
+    // Finalisation inverts the scalars itself unless the policy asks for
+    // them to be precomputed in the background.
+    ExecutionPolicy eagerInverses = ownPool;
+    eagerInverses.precomputeInverses = true;
+
+    std::vector<std::string> transcripts;
+    for (const ExecutionPolicy* policy : {&serial, &smallChunks, &ownPool, &eagerInverses}) {
+        DeterministicRng bobRng(seed, 2, 0);
+        DeterministicRng aliceRng(seed, 2, 1);
+        const auto bobMessage =
+            bobCreateInitialTagMessageFromElements(bobElements, nullptr, &bobRng, policy);
+        const auto aliceMessage = aliceProcessBobTagMessageFromElements(
+            bobMessage.serialized, aliceElements, nullptr, &aliceRng, policy);
+        EXPECT_EQ(policy == &eagerInverses, aliceMessage.state.precomputedInverses != nullptr);
+        const auto bobResponse =
+            bobProcessAliceMessage(aliceMessage.serialized, bobMessage.state, policy);
+        const auto matched =
+            aliceFinalizeIntersectionTags(bobResponse.serialized, aliceMessage.state, policy);
+        EXPECT_EQ(75u, matched.size());
+        // Unblinding inverts per chunk, so the chunking must not show in the
+        // derived keys either.
+        std::string keys;
+        for (const auto& unit : matched) {
+            keys.append(unit.element);
+            keys.append(reinterpret_cast<const char*>(unit.symmetricKey.data()),
+                        unit.symmetricKey.size());
+        }
+        transcripts.push_back(bobMessage.serialized + aliceMessage.serialized +
+                              bobResponse.serialized + keys);
+    }
+    EXPECT_EQ(transcripts[0], transcripts[1]);
+    EXPECT_EQ(transcripts[0], transcripts[2]);
+    EXPECT_EQ(transcripts[0], transcripts[3]);
+}
+
+TEST(ExecutionPolicyTest, ProcessDefaultIsUsedForNullPolicy) {
+    const ExecutionPolicy original = defaultExecutionPolicy();
+
+    ExecutionPolicy custom;
+    custom.threadCount = 4;
+    custom.grainSize = 32;
+    custom.serialThreshold = 1000;
+    setDefaultExecutionPolicy(custom);
+    const ExecutionPolicy resolved = resolveExecutionPolicy(nullptr);
+    EXPECT_EQ(4u, resolved.threadCount);
+    EXPECT_EQ(32u, resolved.grainSize);
+    EXPECT_EQ(1000u, resolved.serialThreshold);
+
+    ExecutionPolicy explicitPolicy;
+    explicitPolicy.threadCount = 7;
+    EXPECT_EQ(7u, resolveExecutionPolicy(&explicitPolicy).threadCount);
+
+    setDefaultExecutionPolicy(original);
+}
@@ -0,0 +1,258 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "crypto_utils.h"
+#include "curve25519_backend.h"
+#include "group_backend.h"
+#include "test_helpers.h"
+#include "x25519_point.h"
+
+#if defined(PSI_HAVE_FE51)
+
+namespace {
+
+using Bytes32 = std::array<unsigned char, 32>;
+
+// Selects a backend for the lifetime of the guard, then restores the previous
+// one so later tests run on the default.
+class BackendGuard {
+public:
+    explicit BackendGuard(FieldBackend backend) : previous_(activeFieldBackend()) {
+        setFieldBackend(backend);
+    }
+    ~BackendGuard() { setFieldBackend(previous_); }
+
+    BackendGuard(const BackendGuard&) = delete;
+    BackendGuard& operator=(const BackendGuard&) = delete;
+
+private:
+    FieldBackend previous_;
+};
+
+std::string toHex(const Bytes32& bytes) {
+    static const char* const kDigits = "0123456789abcdef";
+    std::string hex;
+    for (const auto byte : bytes) {
+        hex.push_back(kDigits[byte >> 4]);
+        hex.push_back(kDigits[byte & 0x0f]);
+    }
+    return hex;
+}
+
+Bytes32 fromHex(const std::string& hex) {
+    Bytes32 bytes{};
+    for (std::size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = static_cast<unsigned char>(std::stoi(hex.substr(2 * i, 2), nullptr, 16));
+    }
+    return bytes;
+}
+
+Bytes32 encode(const X25519Element& element) {
+    Bytes32 out{};
+    x25519Encode(out.data(), element);
+    return out;
+}
+
+}  // namespace
+
+// The unclamped ladder, fed clamped scalars, against libsodium's X25519 on
+// random u-coordinates: about half of them lie on the twist.
+TEST(X25519PointTest, LadderMatchesLibsodiumOnEveryBackend) {
+    ensureSodiumInit();
+
+    constexpr std::size_t kCount = 16;
+    std::vector<X25519Element> points(kCount);
+    std::vector<Bytes32> encoded(kCount);
+    std::vector<Bytes32> scalars(kCount);
+    for (std::size_t i = 0; i < kCount; ++i) {
+        do {
+            randombytes_buf(encoded[i].data(), encoded[i].size());
+            encoded[i][31] &= 0x7f;
+        } while (!x25519Decode(points[i], encoded[i].data()));
+        randombytes_buf(scalars[i].data(), scalars[i].size());
+        scalars[i][0] &= 248;
+        scalars[i][31] &= 127;
+        scalars[i][31] |= 64;
+    }
+
+    std::vector<Bytes32> reference(kCount);
+    for (std::size_t i = 0; i < kCount; ++i) {
+        ASSERT_EQ(0, crypto_scalarmult_curve25519(reference[i].data(), scalars[i].data(),
+                                                  encoded[i].data()));
+    }
+    for (const auto backend : {FieldBackend::Portable, FieldBackend::Mulx, FieldBackend::Avx2}) {
+        if (!fieldBackendSupported(backend)) {
+            continue;
+        }
+        SCOPED_TRACE(fieldBackendName(backend));
+        const BackendGuard guard(backend);
+
+        std::vector<Bytes32> each(kCount);
+        x25519ScalarMultBatch(scalars.data(), points.data(), kCount, each.data());
+        std::vector<Bytes32> shared(kCount);
+        x25519ScalarMultBatch(scalars[0], points.data(), kCount, shared.data());
+        for (std::size_t i = 0; i < kCount; ++i) {
+            EXPECT_EQ(reference[i], each[i]) << "index " << i;
+            Bytes32 single{};
+            ASSERT_EQ(0, crypto_scalarmult_curve25519(single.data(), scalars[0].data(),
+                                                      encoded[i].data()));
+            EXPECT_EQ(single, shared[i]) << "index " << i;
+        }
+    }
+}
+
+// Pinned against an independent implementation of the RFC 9380 map. The
+// all-ones input has both halves above the field prime once bit 255 is
+// dropped, so it also checks the reduction.
+TEST(X25519PointTest, HashToCurveIsPinnedAndBatchMatchesSingles) {
+    std::vector<std::array<unsigned char, 64>> hashes(9);
+    for (std::size_t i = 0; i < 64; ++i) {
+        hashes[0][i] = static_cast<unsigned char>(i);
+    }
+    hashes[1].fill(0xff);
+    for (std::size_t i = 2; i < hashes.size(); ++i) {
+        randombytes_buf(hashes[i].data(), hashes[i].size());
+    }
+
+    std::vector<X25519Element> batch(hashes.size());
+    x25519FromHashBatch(hashes.data(), hashes.size(), batch.data());
+    EXPECT_EQ("5d69350a8551454b3cefd8611d902cfb83d74f64f2d2489951b06a5aa34cfe0a",
+              toHex(encode(batch[0])));
+    EXPECT_EQ("0f4818da3d12edcb046559dffd6c764f9fb87888e8e71f866df2252bf889d225",
+              toHex(encode(batch[1])));
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        X25519Element single{};
+        x25519FromHashBatch(&hashes[i], 1, &single);
+        EXPECT_EQ(encode(single), encode(batch[i])) << "index " << i;
+    }
+}
+
+TEST(X25519PointTest, DecodeAcceptsOnlyCanonicalCoordinates) {
+    X25519Element element{};
+    Bytes32 bytes{};
+    bytes.fill(0xff);
+    bytes[0] = 0xec;  // p - 1
+    bytes[31] = 0x7f;
+    EXPECT_TRUE(x25519Decode(element, bytes.data()));
+    EXPECT_EQ(bytes, encode(element));
+
+    bytes[0] = 0xed;  // p
+    EXPECT_FALSE(x25519Decode(element, bytes.data()));
+
+    Bytes32 high{};
+    high[0] = 9;
+    EXPECT_TRUE(x25519Decode(element, high.data()));
+    high[31] = 0x80;
+    EXPECT_FALSE(x25519Decode(element, high.data()));
+}
+
+// Alice's blinding and unblinding around Bob's multiplier, through the
+// backend: r^-1 * (8b * (r * H)) = 8b * H.
+TEST(X25519PointTest, BackendUnblindsToBobsProduct) {
+    ensureSodiumInit();
+    const GroupBackend& group = groupBackend(Group::X25519);
+    EXPECT_EQ(Group::X25519, group.group());
+    EXPECT_EQ(&group, &groupBackendFor(CipherSuite::V3));
+
+    const std::vector<std::string> messages = {"1 3", "-5 7", "40 41", "9 9", "L2:0 0"};
+    const std::size_t count = messages.size();
+    std::vector<GroupElement> hashed(count);
+    group.hashToGroup(messages.data(), count, hashed.data(), nullptr, CipherSuite::V3);
+
+    std::vector<RistrettoScalar> r(count);
+    for (auto& scalar : r) {
+        crypto_core_ristretto255_scalar_random(scalar.data());
+    }
+    RistrettoScalar b{};
+    crypto_core_ristretto255_scalar_random(b.data());
+    const auto bob = group.fixedMultiplier(b);
+
+    std::vector<RistrettoPoint> blinded(count);
+    group.multiply(r.data(), hashed.data(), count, blinded.data(), "test");
+    std::vector<RistrettoPoint> transformed(count);
+    bob->multiplyBatch(blinded.data(), count, transformed.data(), "test");
+
+    std::vector<RistrettoScalar> inverses(count);
+    group.invertScalars(r.data(), count, inverses.data());
+    std::vector<GroupElement> decoded(count);
+    group.decode(transformed.data(), count, decoded.data(), "test");
+    std::vector<RistrettoPoint> unblinded(count);
+    group.multiply(inverses.data(), decoded.data(), count, unblinded.data(), "test");
+
+    std::vector<RistrettoPoint> direct(count);
+    bob->multiplyBatch(hashed.data(), count, direct.data(), "test");
+    for (std::size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(direct[i], unblinded[i]) << "index " << i;
+        EXPECT_NE(blinded[i], transformed[i]) << "index " << i;
+    }
+}
+
+// Small-order points from a dishonest Alice land on the point at infinity
+// under Bob's cofactor-scaled scalar and are rejected, never answered.
+TEST(X25519PointTest, SmallOrderInputsAndZeroScalarsThrow) {
+    ensureSodiumInit();
+    const GroupBackend& group = groupBackend(Group::X25519);
+    RistrettoScalar b{};
+    crypto_core_ristretto255_scalar_random(b.data());
+    const auto bob = group.fixedMultiplier(b);
+
+    for (const auto& hex : {
+             std::string("0000000000000000000000000000000000000000000000000000000000000000"),
+             std::string("0100000000000000000000000000000000000000000000000000000000000000"),
+             std::string("e0eb7a7c3b41b8ae1656e3faf19fc46ada098deb9c32b1fd866205165f49b800"),
+         }) {
+        SCOPED_TRACE(hex);
+        const RistrettoPoint point = fromHex(hex);
+        RistrettoPoint out{};
+        EXPECT_THROW(bob->multiplyBatch(&point, 1, &out, "test"), std::runtime_error);
+    }
+
+    GroupElement hashed{};
+    const std::string message = "1 3";
+    group.hashToGroup(&message, 1, &hashed, nullptr, CipherSuite::V3);
+    const RistrettoScalar zero{};
+    RistrettoPoint out{};
+    EXPECT_THROW(group.multiply(&zero, &hashed, 1, &out, "test"), std::runtime_error);
+
+    RistrettoScalar unreduced{};
+    unreduced.fill(0xff);
+    EXPECT_THROW(group.fixedMultiplier(unreduced), std::runtime_error);
+}
+
+// The v3 hash through crypto_utils, pinned, and the cache agreeing with the
+// uncached path. Ristretto-typed calls under v3 are a programming error.
+TEST(X25519PointTest, HashToGroupUnderV3IsPinnedAndCached) {
+    ensureSodiumInit();
+    const std::vector<std::string> messages = {"1 3", "L1:40 41"};
+    std::vector<X25519Element> uncached(messages.size());
+    hashToGroupElementBatch(messages.data(), messages.size(), uncached.data(), nullptr,
+                            CipherSuite::V3);
+    EXPECT_EQ("ee7932df2837b29f47537587f880a187fd3dc28c18811fdcede71b6c1b62513c",
+              toHex(encode(uncached[0])));
+    EXPECT_EQ("c6893babcbbfb75628d02635db557f0255f8b8c76a626905b26a07a893dd091a",
+              toHex(encode(uncached[1])));
+
+    HashToGroupCache cache;
+    for (int pass = 0; pass < 2; ++pass) {
+        std::vector<X25519Element> cached(messages.size());
+        hashToGroupElementBatch(messages.data(), messages.size(), cached.data(), &cache,
+                                CipherSuite::V3);
+        for (std::size_t i = 0; i < messages.size(); ++i) {
+            EXPECT_EQ(encode(uncached[i]), encode(cached[i])) << "pass " << pass;
+        }
+    }
+
+    std::vector<RistrettoElement> wrongGroup(messages.size());
+    EXPECT_THROW(hashToGroupElementBatch(messages.data(), messages.size(), wrongGroup.data(),
+                                         nullptr, CipherSuite::V3),
+                 std::runtime_error);
+    EXPECT_THROW(hashToGroupElementBatch(messages.data(), messages.size(), uncached.data(),
+                                         nullptr, CipherSuite::V2),
+                 std::runtime_error);
+}
+
+#endif  // PSI_HAVE_FE51
@@ -1,20 +1,82 @@
 // Compares the two phase-1/finalize variants at increasing set sizes:
 //   secretbox mode: encrypted elements, finalize by trial decryption (O(A*B))
-//   tag mode:       membership tags, finalize by hash-set lookup (O(A))
-// Usage: psi_bench [size ...]   (default sizes: 100 500 1000 2000)
+//   indexed mode:   encrypted elements under one-way locators, finalize by
+//                   one lookup and at most one decryption per element
+//   tag mode:       membership tags, finalize by hash-set lookup (O(A)); the
+//                   tag-overlap row blinds Alice's flight while Bob tags
+//                   (alicePrepareBlinded), bob_setup timing both
+// Usage: psi_bench [--threads N] [--grain N] [--threshold N]
+//                  [--calibrate [PATH]] [--profile PATH] [--inversion]
+//                  [--precompute-inverses] [--scalarmult] [--blake3]
+//                  [--field-backend portable|mulx|avx2]
+//                  [--sha512-backend portable|avx2|avx512]
+//                  [--base64-backend portable|avx2]
+//                  [--suite v1|v2|v3] [--ciphersuite] [--group]
+//                  [--format text|binary] [--wire] [--unbalanced] [--filter]
+//                  [size ...]
+//        (default sizes: 100 500 1000 2000; the flags set the process-wide
+//        ExecutionPolicy before any exchange runs. --calibrate measures
+//        per-phase thresholds and writes them to PATH, default
+//        psi_calibration.profile, for psi_server --profile to load;
+//        --profile applies an existing profile. --inversion only times
+//        Alice's unblinding-scalar inversions, per element vs batched per
+//        chunk, default sizes 1000 10000 100000. --precompute-inverses turns
+//        on the background inversion started after Alice's blinded flight,
+//        so alice_final no longer includes the inversions. --scalarmult only times
+//        Bob's fixed-scalar multiplication, libsodium per element vs
+//        FixedScalarMultiplier, default sizes 1000 10000. --field-backend
+//        pins the scalar multiplication ladder to one backend instead of
+//        the fastest one CPUID reports; psi_field_bench compares them.
+//        --blake3 only times membership-tag derivation, per key vs
+//        keysToMembershipTags, and padElements' dummy generation, default
+//        sizes 10000 100000. --sha512-backend likewise pins the multi-buffer
+//        SHA-512 used by the batched hash-to-group and key derivation, and
+//        --base64-backend the batched base64 codec of text and JSON flights
+//        (base64_batch.h). --suite runs every exchange under that
+//        ciphersuite (ciphersuite.h), default v1. --ciphersuite
+//        only times the per-element hashing of each phase under every suite,
+//        default sizes 10000 100000. --group compares the two groups
+//        (group_backend.h), ristretto255 under v2 and x25519 under v3: the
+//        group operations alone, then tag-mode exchanges end to end, default
+//        sizes 1000 5000. --format opens every exchange in that wire format
+//        (serialization_utils.h), default text. --wire only times encoding
+//        and decoding each flight type in text, binary and JSON and reports
+//        the bytes, default sizes 10000 100000. --unbalanced times tag-mode
+//        finalisation under each matching strategy with Alice at 200, 2000
+//        and 20000 elements against Bob flights of the given sizes, default
+//        20000 200000 1000000. --filter compares Bob's full tag flight with
+//        the compact one (tag_filter.h) at each fingerprint width: bytes,
+//        filter build and probe times and the measured false-positive rate,
+//        default sizes 10000 100000 1000000.)
 
+#include <algorithm>
+#include <cctype>
 #include <chrono>
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <random>
 #include <stdexcept>
 #include <string>
-#include <thread>
 #include <unordered_set>
 #include <vector>
 
+#include "base64_batch.h"
+#include "calibration.h"
+#include "ciphersuite.h"
+#include "crypto_utils.h"
+#include "curve25519_backend.h"
+#include "derivation.h"
+#include "execution_policy.h"
+#include "group_backend.h"
+#include "position_utils.h"
 #include "psi_protocol.h"
+#include "ristretto_batch.h"
+#include "serialization_utils.h"
+#include "sha512_batch.h"
+#include "tag_filter.h"
+#include "thread_pool.h"
 
 extern "C" {
 #include <sodium.h>
@@ -24,6 +86,12 @@ namespace {
 
 constexpr double kOverlapFraction = 0.2;
 
+// Ciphersuite every exchange runs under (--suite).
+CipherSuite benchSuite = kDefaultCipherSuite;
+
+// Wire format Bob opens every exchange in (--format).
+WireFormat benchFormat = kDefaultWireFormat;
+
 struct PhaseTimes {
     double bobSetupMs{0.0};
     double aliceSetupMs{0.0};
@@ -88,7 +156,8 @@ void makeUnits(std::size_t count,
 
 PhaseTimes runSecretboxMode(const std::vector<Unit>& bobUnits, const std::vector<Unit>& aliceUnits) {
     PhaseTimes t;
-    const auto bobMessage = timed(t.bobSetupMs, [&]() { return bobCreateInitialMessage(bobUnits); });
+    const auto bobMessage = timed(
+        t.bobSetupMs, [&]() { return bobCreateInitialMessage(bobUnits, nullptr, nullptr, benchSuite, benchFormat); });
     const auto aliceMessage =
         timed(t.aliceSetupMs, [&]() { return aliceProcessBobMessage(bobMessage.serialized, aliceUnits); });
     const auto bobResponse = timed(t.bobResponseMs,
@@ -100,6 +169,24 @@ PhaseTimes runSecretboxMode(const std::vector<Unit>& bobUnits, const std::vector
     return t;
 }
 
+PhaseTimes runIndexedMode(const std::vector<Unit>& bobUnits, const std::vector<Unit>& aliceUnits) {
+    PhaseTimes t;
+    const auto bobMessage = timed(t.bobSetupMs, [&]() {
+        return bobCreateInitialIndexedMessage(bobUnits, nullptr, nullptr, benchSuite, benchFormat);
+    });
+    const auto aliceMessage = timed(t.aliceSetupMs, [&]() {
+        return aliceProcessBobIndexedMessage(bobMessage.serialized, aliceUnits);
+    });
+    const auto bobResponse = timed(t.bobResponseMs,
+                                   [&]() { return bobProcessAliceMessage(aliceMessage.serialized, bobMessage.state); });
+    const auto decrypted = timed(t.aliceFinalizeMs, [&]() {
+        return aliceFinalizeIntersectionIndexed(bobResponse.serialized, aliceMessage.state);
+    });
+    t.bobMessageBytes = bobMessage.serialized.size();
+    t.intersections = decrypted.size();
+    return t;
+}
+
 // Optional caches model each party's LOCAL hashToGroup cache. Bob's private
 // scalar is still generated fresh inside bobCreateInitialTagMessage on every
 // call: the cache never touches wire-visible values, as the security model
@@ -110,7 +197,10 @@ PhaseTimes runTagMode(const std::vector<Unit>& bobUnits,
                       HashToGroupCache* aliceCache = nullptr) {
     PhaseTimes t;
     const auto bobMessage =
-        timed(t.bobSetupMs, [&]() { return bobCreateInitialTagMessage(bobUnits, bobCache); });
+        timed(t.bobSetupMs, [&]() {
+            return bobCreateInitialTagMessage(bobUnits, bobCache, nullptr, nullptr, benchSuite,
+                                              benchFormat);
+        });
     const auto aliceMessage = timed(t.aliceSetupMs, [&]() {
         return aliceProcessBobTagMessage(bobMessage.serialized, aliceUnits, aliceCache);
     });
@@ -123,6 +213,46 @@ PhaseTimes runTagMode(const std::vector<Unit>& bobUnits,
     return t;
 }
 
+// Tag mode with Alice's blinding off the critical path: alicePrepareBlinded
+// runs on the pool while Bob tags on the caller, so bob_setup is the wall
+// time of both and alice_setup only attaches Bob's flight.
+PhaseTimes runTagModeOverlapped(const std::vector<Unit>& bobUnits,
+                                const std::vector<Unit>& aliceUnits) {
+    PhaseTimes t;
+    const auto aliceElements = convertToFlooredStrings(aliceUnits);
+    AliceResponseMessage aliceMessage;
+    const auto bobMessage = timed(t.bobSetupMs, [&]() {
+        const auto aliceTask = BackgroundTask::start(ThreadPool::shared(), [&]() {
+            aliceMessage = alicePrepareBlinded(aliceElements, nullptr, nullptr, nullptr,
+                                               benchSuite, benchFormat);
+        });
+        BobInitialTagMessage message;
+        try {
+            message = bobCreateInitialTagMessage(bobUnits, nullptr, nullptr, nullptr,
+                                                 benchSuite, benchFormat);
+        } catch (...) {
+            try {
+                aliceTask->wait();
+            } catch (...) {
+            }
+            throw;
+        }
+        aliceTask->wait();
+        return message;
+    });
+    const auto bobResponse = timed(t.bobResponseMs,
+                                   [&]() { return bobProcessAliceMessage(aliceMessage.serialized, bobMessage.state); });
+    timed(t.aliceSetupMs, [&]() {
+        aliceAttachBobTags(bobMessage.serialized, aliceMessage.state);
+        return true;
+    });
+    const auto matched = timed(t.aliceFinalizeMs,
+                               [&]() { return aliceFinalizeIntersectionTags(bobResponse.serialized, aliceMessage.state); });
+    t.bobMessageBytes = bobMessage.serialized.size();
+    t.intersections = matched.size();
+    return t;
+}
+
 void printRow(const std::string& mode, std::size_t size, const PhaseTimes& t, std::size_t expected) {
     std::cout << "| " << std::setw(12) << mode
               << " | " << std::setw(6) << size
@@ -180,6 +310,539 @@ void runPerMoveScenario(std::size_t size, const std::vector<std::size_t>& moveCo
     }
 }
 
+// Queue wait vs compute of the shared pool's tasks since the last reset. A
+// mean queue wait approaching the mean compute time means phases are waiting
+// for workers, i.e. the pool is saturated.
+void printPoolStats() {
+    ThreadPool& pool = ThreadPool::shared();
+    const auto stats = pool.stats();
+    const double tasks = stats.tasksExecuted != 0 ? static_cast<double>(stats.tasksExecuted) : 1.0;
+    std::cout << "\nPool: " << pool.workerCount() << " workers, " << stats.tasksExecuted
+              << " tasks, " << stats.steals << " steals, mean queue wait "
+              << std::setprecision(3) << static_cast<double>(stats.queueWaitNs) / tasks / 1e6
+              << " ms, mean compute " << static_cast<double>(stats.computeNs) / tasks / 1e6
+              << " ms\n";
+    pool.resetStats();
+}
+
+void printCalibration(const CalibrationProfile& profile) {
+    std::cout << "Calibration: " << profile.threads << " threads (measured speedup "
+              << std::fixed << std::setprecision(2) << profile.effectiveThreads
+              << "x), pool dispatch " << profile.dispatchOverheadUs << " us\n";
+    std::cout << "| phase            | per_elem_us | threshold  |\n";
+    std::cout << "|------------------|-------------|------------|\n";
+    for (std::size_t i = 0; i < kProtocolPhaseCount; ++i) {
+        std::cout << "| " << std::setw(16) << protocolPhaseName(static_cast<ProtocolPhase>(i))
+                  << " | " << std::setw(11) << profile.perElementUs[i]
+                  << " | " << std::setw(10)
+                  << (profile.thresholds[i] == std::numeric_limits<std::size_t>::max()
+                          ? std::string("serial")
+                          : std::to_string(profile.thresholds[i]))
+                  << " |\n";
+    }
+}
+
+// Alice's unblinding inversions alone: one crypto_core_ristretto255_scalar_invert
+// per element vs invertScalarsBatch per chunk, both under the process-wide
+// policy for the unblinding phase.
+void runInversionBenchmark(const std::vector<std::size_t>& sizes) {
+    const ExecutionPolicy policy =
+        defaultExecutionPolicy().forPhase(ProtocolPhase::AliceUnblinding);
+
+    std::cout << "Scalar inversion (Alice's unblinding), timings in ms\n\n";
+    std::cout << "| size   | per_element  | batched      | speedup  |\n";
+    std::cout << "|--------|--------------|--------------|----------|\n";
+    for (const auto size : sizes) {
+        std::vector<RistrettoScalar> scalars(size);
+        for (auto& scalar : scalars) {
+            crypto_core_ristretto255_scalar_random(scalar.data());
+        }
+
+        std::vector<RistrettoScalar> single(size);
+        double singleMs = 0.0;
+        timed(singleMs, [&]() {
+            parallelForIndex(policy, size, [&](std::size_t i) {
+                if (crypto_core_ristretto255_scalar_invert(single[i].data(),
+                                                           scalars[i].data()) != 0) {
+                    throw std::runtime_error("scalar inversion failed");
+                }
+            });
+            return 0;
+        });
+
+        std::vector<RistrettoScalar> batched(size);
+        double batchedMs = 0.0;
+        timed(batchedMs, [&]() {
+            parallelForChunks(policy, size, [&](std::size_t begin, std::size_t end) {
+                invertScalarsBatch(scalars.data() + begin, end - begin, batched.data() + begin);
+            });
+            return 0;
+        });
+
+        if (single != batched) {
+            throw std::runtime_error("batched inversion mismatch at size " +
+                                     std::to_string(size));
+        }
+        std::cout << "| " << std::setw(6) << size
+                  << " | " << std::setw(12) << std::fixed << std::setprecision(2) << singleMs
+                  << " | " << std::setw(12) << batchedMs
+                  << " | " << std::setw(7) << singleMs / std::max(batchedMs, 1e-9) << "x"
+                  << " |\n";
+    }
+}
+
+// Bob's multiplications alone, single-threaded: crypto_scalarmult_ristretto255
+// per element vs one FixedScalarMultiplier over the batch. Also checks that
+// both produce the same bytes.
+void runScalarMultBenchmark(const std::vector<std::size_t>& sizes) {
+    std::cout << "Fixed-scalar multiplication (Bob's phases), single thread, timings in ms\n\n";
+    std::cout << "| size   | libsodium    | batch engine | speedup  | us/elem (engine) |\n";
+    std::cout << "|--------|--------------|--------------|----------|------------------|\n";
+    for (const auto size : sizes) {
+        RistrettoScalar scalar{};
+        crypto_core_ristretto255_scalar_random(scalar.data());
+        std::vector<RistrettoPoint> points(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            points[i] = hashToGroup("scalarmult " + std::to_string(i));
+        }
+
+        std::vector<RistrettoPoint> reference(size);
+        double libsodiumMs = 0.0;
+        timed(libsodiumMs, [&]() {
+            for (std::size_t i = 0; i < size; ++i) {
+                if (crypto_scalarmult_ristretto255(reference[i].data(), scalar.data(),
+                                                   points[i].data()) != 0) {
+                    throw std::runtime_error("libsodium scalar multiplication failed");
+                }
+            }
+            return 0;
+        });
+
+        std::vector<RistrettoPoint> batched(size);
+        double engineMs = 0.0;
+        timed(engineMs, [&]() {
+            const FixedScalarMultiplier multiplier(scalar);
+            multiplier.multiplyBatch(points.data(), size, batched.data(), "benchmark");
+            return 0;
+        });
+
+        if (reference != batched) {
+            throw std::runtime_error("batch engine mismatch at size " + std::to_string(size));
+        }
+        std::cout << "| " << std::setw(6) << size
+                  << " | " << std::setw(12) << std::fixed << std::setprecision(2) << libsodiumMs
+                  << " | " << std::setw(12) << engineMs
+                  << " | " << std::setw(7) << libsodiumMs / std::max(engineMs, 1e-9) << "x"
+                  << " | " << std::setw(16) << engineMs * 1000.0 / static_cast<double>(size)
+                  << " |\n";
+    }
+}
+
+void runBlake3Benchmark(const std::vector<std::size_t>& sizes) {
+    std::cout << "BLAKE3 tag derivation and dummy padding, single thread, timings in ms\n\n";
+    std::cout << "| size   | tags per key | tags batched | speedup  | padElements  |\n";
+    std::cout << "|--------|--------------|--------------|----------|--------------|\n";
+    for (const auto size : sizes) {
+        std::vector<std::array<unsigned char, 32>> keys(size);
+        for (auto& key : keys) {
+            randombytes_buf(key.data(), key.size());
+        }
+
+        std::vector<MembershipTag> reference(size);
+        double perKeyMs = 0.0;
+        timed(perKeyMs, [&]() {
+            for (std::size_t i = 0; i < size; ++i) {
+                reference[i] = keyToMembershipTag(keys[i]);
+            }
+            return 0;
+        });
+
+        std::vector<MembershipTag> batched(size);
+        double batchedMs = 0.0;
+        timed(batchedMs, [&]() {
+            keysToMembershipTags(keys.data(), size, batched.data());
+            return 0;
+        });
+        if (reference != batched) {
+            throw std::runtime_error("batched tag mismatch at size " + std::to_string(size));
+        }
+
+        double paddingMs = 0.0;
+        timed(paddingMs, [&]() { return padElements({}, size, keys[0]).size(); });
+
+        std::cout << "| " << std::setw(6) << size
+                  << " | " << std::setw(12) << std::fixed << std::setprecision(2) << perKeyMs
+                  << " | " << std::setw(12) << batchedMs
+                  << " | " << std::setw(7) << perKeyMs / std::max(batchedMs, 1e-9) << "x"
+                  << " | " << std::setw(12) << paddingMs << " |\n";
+    }
+}
+
+// The hashing each phase does per element, without the group operations
+// (those depend only on the suite's group; --group compares them): bob_setup hashes his elements to from_hash input and derives a
+// tag per shared point, alice_setup hashes hers, alice_final derives key and
+// tag per unblinded point; bob_response hashes nothing. Inputs are the
+// benchmark's floored positions and random points, so every suite hashes
+// exactly what it would in an exchange.
+void runCipherSuiteBenchmark(const std::vector<std::size_t>& sizes) {
+    std::cout << "Per-element hashing by phase and ciphersuite, single thread, ns/element\n\n";
+    std::cout << "| suite | size   | bob_setup  | alice_setup | alice_final  | total      |\n";
+    std::cout << "|-------|--------|------------|-------------|--------------|------------|\n";
+    for (const auto size : sizes) {
+        std::vector<Unit> bobUnits;
+        std::vector<Unit> aliceUnits;
+        std::size_t expected = 0;
+        makeUnits(size, bobUnits, aliceUnits, expected);
+        const auto positions = convertToFlooredStrings(bobUnits);
+        std::vector<RistrettoPoint> points(size);
+        for (auto& point : points) {
+            crypto_core_ristretto255_random(point.data());
+        }
+
+        double totals[kCipherSuites.size()] = {};
+        for (const auto suite : kCipherSuites) {
+            std::vector<UniformBytes> uniform(size);
+            std::vector<std::array<unsigned char, 32>> keys(size);
+            std::vector<MembershipTag> tags(size);
+            double hashMs = 0.0;
+            timed(hashMs, [&]() {
+                hashToUniformBatch(positions.data(), size, uniform.data(), suite);
+                return 0;
+            });
+            double bobTagMs = 0.0;
+            timed(bobTagMs, [&]() {
+                pointsToKeysAndTags(points.data(), size, nullptr, tags.data(), suite);
+                return 0;
+            });
+            double aliceFinalMs = 0.0;
+            timed(aliceFinalMs, [&]() {
+                pointsToKeysAndTags(points.data(), size, keys.data(), tags.data(), suite);
+                return 0;
+            });
+
+            const double perElement = 1e6 / static_cast<double>(size);
+            const double bobSetup = (hashMs + bobTagMs) * perElement;
+            const double aliceSetup = hashMs * perElement;
+            const double aliceFinal = aliceFinalMs * perElement;
+            totals[cipherSuiteIndex(suite)] = bobSetup + aliceSetup + aliceFinal;
+            std::cout << "| " << std::setw(5) << cipherSuiteName(suite)
+                      << " | " << std::setw(6) << size
+                      << " | " << std::setw(10) << std::fixed << std::setprecision(1) << bobSetup
+                      << " | " << std::setw(11) << aliceSetup
+                      << " | " << std::setw(12) << aliceFinal
+                      << " | " << std::setw(10) << totals[cipherSuiteIndex(suite)] << " |\n";
+        }
+        const double v1 = totals[cipherSuiteIndex(CipherSuite::V1)];
+        const double v2 = totals[cipherSuiteIndex(CipherSuite::V2)];
+        std::cout << "| saved | " << std::setw(6) << size << " | v2 saves " << std::setprecision(1)
+                  << v1 - v2 << " ns/element over the three phases ("
+                  << std::setprecision(2) << v1 / std::max(v2, 1e-9) << "x)\n";
+    }
+}
+
+// The two groups side by side, v2 (ristretto255) against v3 (x25519), which
+// hash with the same BLAKE3 construction. First the group operations alone,
+// single-threaded, in us/element: hash-to-group of floored positions,
+// Alice's per-element-scalar multiplication, Bob's fixed-scalar one on
+// decoded elements and on wire points (his response phase). Then a tag-mode
+// exchange per group under the process-wide policy, checked against the
+// expected overlap.
+void runGroupBenchmark(const std::vector<std::size_t>& sizes) {
+    constexpr CipherSuite kSuites[] = {CipherSuite::V2, CipherSuite::V3};
+    std::cout << "Group operations by backend, single thread, us/element\n\n";
+    std::cout << "| group        | size   | hash_to_group | alice_mult | bob_fixed  | bob_wire   |\n";
+    std::cout << "|--------------|--------|---------------|------------|------------|------------|\n";
+    for (const auto size : sizes) {
+        std::vector<Unit> bobUnits;
+        std::vector<Unit> aliceUnits;
+        std::size_t expected = 0;
+        makeUnits(size, bobUnits, aliceUnits, expected);
+        const auto positions = convertToFlooredStrings(bobUnits);
+        std::vector<RistrettoScalar> scalars(size);
+        for (auto& scalar : scalars) {
+            crypto_core_ristretto255_scalar_random(scalar.data());
+        }
+
+        for (const auto suite : kSuites) {
+            const GroupBackend& group = groupBackendFor(suite);
+            std::vector<GroupElement> hashed(size);
+            std::vector<RistrettoPoint> blinded(size);
+            std::vector<RistrettoPoint> shared(size);
+            double hashMs = 0.0;
+            timed(hashMs, [&]() {
+                group.hashToGroup(positions.data(), size, hashed.data(), nullptr, suite);
+                return 0;
+            });
+            double aliceMs = 0.0;
+            timed(aliceMs, [&]() {
+                group.multiply(scalars.data(), hashed.data(), size, blinded.data(), "benchmark");
+                return 0;
+            });
+            const auto multiplier = group.fixedMultiplier(scalars[0]);
+            double bobMs = 0.0;
+            timed(bobMs, [&]() {
+                multiplier->multiplyBatch(hashed.data(), size, shared.data(), "benchmark");
+                return 0;
+            });
+            double wireMs = 0.0;
+            timed(wireMs, [&]() {
+                multiplier->multiplyBatch(blinded.data(), size, shared.data(), "benchmark");
+                return 0;
+            });
+
+            const double perElement = 1000.0 / static_cast<double>(size);
+            std::cout << "| " << std::setw(12) << groupName(group.group())
+                      << " | " << std::setw(6) << size
+                      << " | " << std::setw(13) << std::fixed << std::setprecision(2)
+                      << hashMs * perElement
+                      << " | " << std::setw(10) << aliceMs * perElement
+                      << " | " << std::setw(10) << bobMs * perElement
+                      << " | " << std::setw(10) << wireMs * perElement << " |\n";
+        }
+    }
+
+    std::cout << "\nTag-mode exchange by group, timings in ms\n\n";
+    std::cout << "| mode         | size   | bob_setup  | alice_setup | bob_response | alice_final  | total     | bob_msg_B   | matches |\n";
+    std::cout << "|--------------|--------|------------|-------------|--------------|--------------|-----------|-------------|---------|\n";
+    const CipherSuite previous = benchSuite;
+    for (const auto size : sizes) {
+        std::vector<Unit> bobUnits;
+        std::vector<Unit> aliceUnits;
+        std::size_t expected = 0;
+        makeUnits(size, bobUnits, aliceUnits, expected);
+        for (const auto suite : kSuites) {
+            benchSuite = suite;
+            const auto tag = runTagMode(bobUnits, aliceUnits);
+            printRow(groupName(cipherSuiteGroup(suite)), size, tag, expected);
+            if (tag.intersections != expected) {
+                benchSuite = previous;
+                throw std::runtime_error(std::string(groupName(cipherSuiteGroup(suite))) +
+                                         " mismatch at size " + std::to_string(size));
+            }
+        }
+    }
+    benchSuite = previous;
+}
+
+// Codec cost per flight type and encoding: bytes on the wire and
+// encode/decode time for Bob's tags (T), Alice's blinded points (A) and Bob's
+// transformed points (R), each flight holding `size` random 32-byte values.
+// Every codec runs on one thread except text/p, which decodes text flights in
+// parallel chunks under the default policy. Decoded flights are checked
+// against the input.
+void runWireBenchmark(const std::vector<std::size_t>& sizes) {
+    static const ExecutionPolicy serial = []() {
+        ExecutionPolicy policy;
+        policy.threadCount = 1;
+        return policy;
+    }();
+    struct Codec {
+        const char* name;
+        std::string (*encodeTags)(const TagBatch&);
+        TagBatch (*decodeTags)(const std::string&);
+        std::string (*encodePoints)(const PointBatch&);
+        PointBatch (*decodePoints)(const std::string&);
+        std::string (*encodeTransformed)(const PointBatch&);
+        PointBatch (*decodeTransformed)(const std::string&);
+    };
+    const Codec codecs[] = {
+        {"text",
+         [](const TagBatch& tags) { return serializeBobTagMessage(tags); },
+         [](const std::string& data) { return deserializeBobTagMessage(data, nullptr, &serial); },
+         [](const PointBatch& points) { return serializeAliceBlindedMessage(points); },
+         [](const std::string& data) { return deserializeAliceBlindedMessage(data, &serial); },
+         [](const PointBatch& points) { return serializeBobTransformedMessage(points); },
+         [](const std::string& data) { return deserializeBobTransformedMessage(data, &serial); }},
+        {"text/p",
+         [](const TagBatch& tags) { return serializeBobTagMessage(tags); },
+         [](const std::string& data) { return deserializeBobTagMessage(data); },
+         [](const PointBatch& points) { return serializeAliceBlindedMessage(points); },
+         [](const std::string& data) { return deserializeAliceBlindedMessage(data); },
+         [](const PointBatch& points) { return serializeBobTransformedMessage(points); },
+         [](const std::string& data) { return deserializeBobTransformedMessage(data); }},
+        {"binary",
+         [](const TagBatch& tags) {
+             return serializeBobTagMessage(tags, CipherSuite::V1, WireFormat::Binary);
+         },
+         [](const std::string& data) { return deserializeBobTagMessage(data); },
+         [](const PointBatch& points) {
+             return serializeAliceBlindedMessage(points, WireFormat::Binary);
+         },
+         [](const std::string& data) { return deserializeAliceBlindedMessage(data); },
+         [](const PointBatch& points) {
+             return serializeBobTransformedMessage(points, WireFormat::Binary);
+         },
+         [](const std::string& data) { return deserializeBobTransformedMessage(data); }},
+        {"json", serializeBobTagMessageJson, deserializeBobTagMessageJson,
+         serializeAliceBlindedMessageJson, deserializeAliceBlindedMessageJson,
+         serializeBobTransformedMessageJson, deserializeBobTransformedMessageJson},
+    };
+
+    std::cout << "Flight codecs, base64 backend " << base64BackendName(activeBase64Backend())
+              << ", timings in ms (text/p decodes in parallel)\n\n";
+    std::cout << "| format | flight | size   | bytes       | B/elem | encode     | decode     |\n";
+    std::cout << "|--------|--------|--------|-------------|--------|------------|------------|\n";
+    for (const auto size : sizes) {
+        TagBatch tags(size);
+        PointBatch blinded(size);
+        randombytes_buf(tags.bytes(), tags.byteSize());
+        randombytes_buf(blinded.bytes(), blinded.byteSize());
+        const PointBatch transformed = blinded;
+
+        for (const auto& codec : codecs) {
+            auto report = [&](const char* flight, std::size_t bytes, double encodeMs,
+                              double decodeMs, bool matches) {
+                if (!matches) {
+                    throw std::runtime_error(std::string(codec.name) + " " + flight +
+                                             " round trip mismatch at size " +
+                                             std::to_string(size));
+                }
+                std::cout << "| " << std::setw(6) << codec.name
+                          << " | " << std::setw(6) << flight
+                          << " | " << std::setw(6) << size
+                          << " | " << std::setw(11) << bytes
+                          << " | " << std::setw(6) << std::fixed << std::setprecision(1)
+                          << static_cast<double>(bytes) / static_cast<double>(size)
+                          << " | " << std::setw(10) << std::setprecision(2) << encodeMs
+                          << " | " << std::setw(10) << decodeMs << " |\n";
+            };
+
+            double encodeMs = 0.0;
+            double decodeMs = 0.0;
+            const auto t = timed(encodeMs, [&]() { return codec.encodeTags(tags); });
+            const auto decodedTags = timed(decodeMs, [&]() { return codec.decodeTags(t); });
+            report("T", t.size(), encodeMs, decodeMs, decodedTags == tags);
+
+            const auto a = timed(encodeMs, [&]() { return codec.encodePoints(blinded); });
+            const auto decodedA = timed(decodeMs, [&]() { return codec.decodePoints(a); });
+            report("A", a.size(), encodeMs, decodeMs, decodedA == blinded);
+
+            const auto r = timed(encodeMs, [&]() { return codec.encodeTransformed(transformed); });
+            const auto decodedR = timed(decodeMs, [&]() { return codec.decodeTransformed(r); });
+            report("R", r.size(), encodeMs, decodeMs, decodedR == transformed);
+        }
+    }
+}
+
+// Tag-mode finalisation when the sets differ in size: Alice holds 200, 2000
+// or 20000 elements and Bob's flight has `size` tags (at least Alice's
+// count). Bob's real tags come from an exchange over Alice's partner set and
+// the rest are random fillers, which is all his flight looks like to her.
+// alice_final (unblinding included, best of two) under each matching
+// strategy, and the one Auto picks.
+void runUnbalancedBenchmark(const std::vector<std::size_t>& sizes) {
+    std::cout << "Tag-mode alice_final by matching strategy, wire format "
+              << wireFormatName(benchFormat) << ", timings in ms\n\n";
+    std::cout << "| alice  | bob      | index-alice  | hash-bob     | auto picks   |\n";
+    std::cout << "|--------|----------|--------------|--------------|--------------|\n";
+    const TagMatchStrategy strategies[] = {TagMatchStrategy::IndexAlice,
+                                           TagMatchStrategy::HashBob};
+    for (const std::size_t aliceSize : {200, 2000, 20000}) {
+        std::vector<Unit> bobUnits;
+        std::vector<Unit> aliceUnits;
+        std::size_t expected = 0;
+        makeUnits(aliceSize, bobUnits, aliceUnits, expected);
+        const auto bobMessage = bobCreateInitialTagMessage(bobUnits, nullptr, nullptr, nullptr,
+                                                           benchSuite, benchFormat);
+        auto aliceMessage = aliceProcessBobTagMessage(bobMessage.serialized, aliceUnits);
+        const auto bobResponse = bobProcessAliceMessage(aliceMessage.serialized, bobMessage.state);
+
+        for (const auto size : sizes) {
+            if (size < aliceSize) {
+                continue;
+            }
+            TagBatch flight(size);
+            std::copy(bobMessage.tags.begin(), bobMessage.tags.end(), flight.begin());
+            randombytes_buf(flight.bytes() + bobMessage.tags.byteSize(),
+                            flight.byteSize() - bobMessage.tags.byteSize());
+            aliceMessage.state.bobTagFlight = serializeBobTagMessage(flight, benchSuite, benchFormat);
+
+            std::cout << "| " << std::setw(6) << aliceSize << " | " << std::setw(8) << size;
+            for (const auto strategy : strategies) {
+                double bestMs = std::numeric_limits<double>::max();
+                for (int run = 0; run < 2; ++run) {
+                    double ms = 0.0;
+                    const auto matches = timed(ms, [&]() {
+                        return aliceFinalizeIntersectionTags(bobResponse.serialized,
+                                                             aliceMessage.state, nullptr, strategy);
+                    });
+                    if (matches.size() != expected) {
+                        throw std::runtime_error(std::string(tagMatchStrategyName(strategy)) +
+                                                 " found " + std::to_string(matches.size()) +
+                                                 " matches, expected " +
+                                                 std::to_string(expected));
+                    }
+                    bestMs = std::min(bestMs, ms);
+                }
+                std::cout << " | " << std::setw(12) << std::fixed << std::setprecision(2)
+                          << bestMs;
+            }
+            std::cout << " | " << std::setw(12)
+                      << tagMatchStrategyName(chooseTagMatchStrategy(aliceSize, size)) << " |\n";
+        }
+    }
+}
+
+// Bob's compact tag flight (F) against the full one (T): for each
+// fingerprint width, the flight bytes in the bench wire format, the time to
+// build the filter, and the time for Alice to probe it with kFilterProbes
+// tags Bob does not hold, whose hit fraction is the measured false-positive
+// rate. Every one of Bob's own tags is checked as well, untimed.
+constexpr std::size_t kFilterProbes = std::size_t{1} << 20;
+
+void runFilterBenchmark(const std::vector<std::size_t>& sizes) {
+    std::cout << "Tag flight as a cuckoo filter (tag_filter.h), wire format "
+              << wireFormatName(benchFormat) << ", " << kFilterProbes
+              << " non-member probes, timings in ms\n\n";
+    std::cout << "| size    | flight | bytes       | B/elem | build      | probe      | fp measured | fp bound    |\n";
+    std::cout << "|---------|--------|-------------|--------|------------|------------|-------------|-------------|\n";
+    TagBatch probes(kFilterProbes);
+    randombytes_buf(probes.bytes(), probes.byteSize());
+    for (const auto size : sizes) {
+        TagBatch tags(size);
+        randombytes_buf(tags.bytes(), tags.byteSize());
+        const std::string full = serializeBobTagMessage(tags, benchSuite, benchFormat);
+        std::cout << "| " << std::setw(7) << size << " | " << std::setw(6) << "T"
+                  << " | " << std::setw(11) << full.size() << " | " << std::setw(6) << std::fixed
+                  << std::setprecision(2)
+                  << static_cast<double>(full.size()) / static_cast<double>(size)
+                  << " |            |            |             |             |\n";
+
+        for (std::size_t bytes = 1; bytes <= kTagFilterMaxFingerprintBytes; ++bytes) {
+            double buildMs = 0.0;
+            const std::string flight = timed(buildMs, [&]() {
+                return serializeBobTagFilterMessage(TagFilter::build(tags, bytes), size,
+                                                    benchSuite, benchFormat);
+            });
+            const TagFilter filter = deserializeBobTagFilterMessage(flight);
+            for (const auto& tag : tags) {
+                if (!filter.mayContain(tag)) {
+                    throw std::runtime_error("Tag filter lost one of Bob's tags at size " +
+                                             std::to_string(size));
+                }
+            }
+            double probeMs = 0.0;
+            const std::size_t hits = timed(probeMs, [&]() {
+                std::size_t count = 0;
+                for (const auto& probe : probes) {
+                    count += filter.mayContain(probe) ? 1 : 0;
+                }
+                return count;
+            });
+            std::cout << "| " << std::setw(7) << size << " | " << std::setw(6)
+                      << ("F/" + std::to_string(8 * bytes)) << " | " << std::setw(11)
+                      << flight.size() << " | " << std::setw(6) << std::fixed
+                      << std::setprecision(2)
+                      << static_cast<double>(flight.size()) / static_cast<double>(size)
+                      << " | " << std::setw(10) << buildMs << " | " << std::setw(10) << probeMs
+                      << " | " << std::setw(11) << std::scientific << std::setprecision(2)
+                      << static_cast<double>(hits) / static_cast<double>(kFilterProbes)
+                      << " | " << std::setw(11) << filter.falsePositiveRate() << " |\n"
+                      << std::defaultfloat;
+        }
+    }
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -188,18 +851,179 @@ int main(int argc, char** argv) {
         return EXIT_FAILURE;
     }
 
-    std::vector<std::size_t> sizes = {100, 500, 1000, 2000};
-    if (argc > 1) {
-        sizes.clear();
-        for (int i = 1; i < argc; ++i) {
-            sizes.push_back(static_cast<std::size_t>(std::stoul(argv[i])));
+    std::vector<std::size_t> sizes;
+    ExecutionPolicy policy = defaultExecutionPolicy();
+    bool calibrate = false;
+    bool inversionOnly = false;
+    bool scalarMultOnly = false;
+    bool blake3Only = false;
+    bool cipherSuiteOnly = false;
+    bool groupOnly = false;
+    bool wireOnly = false;
+    bool unbalancedOnly = false;
+    bool filterOnly = false;
+    std::string calibratePath = "psi_calibration.profile";
+    std::string profilePath;
+    std::string fieldBackend;
+    std::string sha512Backend;
+    std::string base64Backend;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--calibrate") {
+            calibrate = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-' &&
+                !std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                calibratePath = argv[++i];
+            }
+        } else if (arg == "--precompute-inverses") {
+            policy.precomputeInverses = true;
+        } else if (arg == "--scalarmult") {
+            scalarMultOnly = true;
+        } else if (arg == "--blake3") {
+            blake3Only = true;
+        } else if (arg == "--ciphersuite") {
+            cipherSuiteOnly = true;
+        } else if (arg == "--group") {
+            groupOnly = true;
+        } else if (arg == "--wire") {
+            wireOnly = true;
+        } else if (arg == "--unbalanced") {
+            unbalancedOnly = true;
+        } else if (arg == "--filter") {
+            filterOnly = true;
+        } else if (arg == "--format" && i + 1 < argc) {
+            try {
+                benchFormat = parseWireFormat(argv[++i]);
+            } catch (const std::exception& ex) {
+                std::cerr << ex.what() << "\n";
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--suite" && i + 1 < argc) {
+            try {
+                benchSuite = parseCipherSuite(argv[++i]);
+            } catch (const std::exception& ex) {
+                std::cerr << ex.what() << "\n";
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--inversion") {
+            inversionOnly = true;
+        } else if (arg == "--profile" && i + 1 < argc) {
+            profilePath = argv[++i];
+        } else if (arg == "--field-backend" && i + 1 < argc) {
+            fieldBackend = argv[++i];
+        } else if (arg == "--sha512-backend" && i + 1 < argc) {
+            sha512Backend = argv[++i];
+        } else if (arg == "--base64-backend" && i + 1 < argc) {
+            base64Backend = argv[++i];
+        } else if ((arg == "--threads" || arg == "--grain" || arg == "--threshold") &&
+                   i + 1 < argc) {
+            const auto value = static_cast<std::size_t>(std::stoul(argv[++i]));
+            if (arg == "--threads") {
+                policy.threadCount = value;
+            } else if (arg == "--grain") {
+                policy.grainSize = value;
+            } else {
+                policy.serialThreshold = value;
+            }
+        } else {
+            sizes.push_back(static_cast<std::size_t>(std::stoul(arg)));
         }
     }
+    if (sizes.empty()) {
+        sizes = inversionOnly    ? std::vector<std::size_t>{1000, 10000, 100000}
+                : scalarMultOnly ? std::vector<std::size_t>{1000, 10000}
+                : groupOnly      ? std::vector<std::size_t>{1000, 5000}
+                : unbalancedOnly ? std::vector<std::size_t>{20000, 200000, 1000000}
+                : filterOnly     ? std::vector<std::size_t>{10000, 100000, 1000000}
+                : blake3Only || cipherSuiteOnly || wireOnly
+                                 ? std::vector<std::size_t>{10000, 100000}
+                                 : std::vector<std::size_t>{100, 500, 1000, 2000};
+    }
+    if (!fieldBackend.empty()) {
+        try {
+            setFieldBackend(parseFieldBackend(fieldBackend));
+        } catch (const std::exception& ex) {
+            std::cerr << ex.what() << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+    if (!sha512Backend.empty()) {
+        try {
+            setSha512Backend(parseSha512Backend(sha512Backend));
+        } catch (const std::exception& ex) {
+            std::cerr << ex.what() << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+    if (!base64Backend.empty()) {
+        try {
+            setBase64Backend(parseBase64Backend(base64Backend));
+        } catch (const std::exception& ex) {
+            std::cerr << ex.what() << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+    try {
+        if (!profilePath.empty()) {
+            applyCalibrationProfile(loadCalibrationProfile(profilePath), policy);
+            std::cout << "Loaded calibration profile " << profilePath << "\n";
+        }
+        if (calibrate) {
+            const auto profile = calibrateExecutionPolicy(policy);
+            printCalibration(profile);
+            saveCalibrationProfile(profile, calibratePath);
+            applyCalibrationProfile(profile, policy);
+            std::cout << "Wrote " << calibratePath << "\n\n";
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Calibration failed: " << ex.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    setDefaultExecutionPolicy(policy);
+
+    if (inversionOnly || scalarMultOnly || blake3Only || cipherSuiteOnly || groupOnly ||
+        wireOnly || unbalancedOnly || filterOnly) {
+        try {
+            if (inversionOnly) {
+                runInversionBenchmark(sizes);
+            } else if (blake3Only) {
+                runBlake3Benchmark(sizes);
+            } else if (cipherSuiteOnly) {
+                runCipherSuiteBenchmark(sizes);
+            } else if (groupOnly) {
+                runGroupBenchmark(sizes);
+            } else if (wireOnly) {
+                runWireBenchmark(sizes);
+            } else if (unbalancedOnly) {
+                runUnbalancedBenchmark(sizes);
+            } else if (filterOnly) {
+                runFilterBenchmark(sizes);
+            } else {
+                runScalarMultBenchmark(sizes);
+            }
+        } catch (const std::exception& ex) {
+            std::cerr << "Benchmark failed: " << ex.what() << "\n";
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
 
-    const unsigned hardware = std::thread::hardware_concurrency();
-    std::cout << "PSI benchmark: secretbox (trial decryption) vs tag (hash-set lookup)\n";
+    const std::size_t available = ThreadPool::shared().workerCount() + 1;
+    const std::size_t threads =
+        policy.threadCount == 0 ? available : std::min(policy.threadCount, available);
+    std::cout << "PSI benchmark: secretbox (trial decryption) vs indexed secretbox (locator\n"
+                 "lookup) vs tag (hash-set lookup)\n";
     std::cout << "Overlap fraction: " << kOverlapFraction << ", timings in ms, threads: "
-              << (hardware != 0 ? hardware : 1) << "\n\n";
+              << threads << ", field backend: " << fieldBackendName(activeFieldBackend())
+              << ", SHA-512 backend: " << sha512BackendName(activeSha512Backend())
+              << ", base64 backend: " << base64BackendName(activeBase64Backend())
+              << ", ciphersuite: " << cipherSuiteName(benchSuite)
+              << ", wire format: " << wireFormatName(benchFormat)
+              << ", serial below: " << policy.serialThreshold
+              << (policy.phaseThresholds != decltype(policy.phaseThresholds){}
+                      ? " (per-phase overrides from profile)"
+                      : "")
+              << "\n\n";
     std::cout << "| mode         | size   | bob_setup  | alice_setup | bob_response | alice_final  | total     | bob_msg_B   | matches |\n";
     std::cout << "|--------------|--------|------------|-------------|--------------|--------------|-----------|-------------|---------|\n";
 
@@ -213,17 +1037,28 @@ int main(int argc, char** argv) {
             const auto secretbox = runSecretboxMode(bobUnits, aliceUnits);
             printRow("secretbox", size, secretbox, expected);
 
+            const auto indexed = runIndexedMode(bobUnits, aliceUnits);
+            printRow("indexed", size, indexed, expected);
+
             const auto tag = runTagMode(bobUnits, aliceUnits);
             printRow("tag", size, tag, expected);
 
-            if (secretbox.intersections != expected || tag.intersections != expected) {
+            const auto overlapped = runTagModeOverlapped(bobUnits, aliceUnits);
+            printRow("tag-overlap", size, overlapped, expected);
+
+            if (secretbox.intersections != expected || indexed.intersections != expected ||
+                tag.intersections != expected || overlapped.intersections != expected) {
                 std::cerr << "MISMATCH at size " << size << ": expected " << expected
                           << ", secretbox " << secretbox.intersections
-                          << ", tag " << tag.intersections << "\n";
+                          << ", indexed " << indexed.intersections
+                          << ", tag " << tag.intersections
+                          << ", tag-overlap " << overlapped.intersections << "\n";
                 return EXIT_FAILURE;
             }
         }
 
+        printPoolStats();
+
         std::cout << "\nPer-move scenario (tag mode): first exchange warms local HashToGroupCache,\n";
         std::cout << "then k Bob elements move and a fresh exchange runs (new scalar, full tag\n";
         std::cout << "recompute). warm rows reuse only the local hash cache; cold rows do not.\n\n";
@@ -117,16 +117,14 @@ int main() {
     printHeader("Alice -> Bob: Blinded Points");
     std::cout << "count: " << aliceMessage.values.size() << '\n';
     for (std::size_t i = 0; i < aliceMessage.values.size(); ++i) {
-        const auto& value = aliceMessage.values[i];
-        std::cout << "[" << i << "] point bytes: " << value.blindedPointEncoded.size() << '\n';
+        std::cout << "[" << i << "] point: " << base64Encode(aliceMessage.values[i]) << '\n';
     }
     std::cout << "JSON payload: \n" << serializeAliceBlindedMessageJson(aliceMessage.values) << "\n";
 
     printHeader("Bob -> Alice: Transformed Points");
     std::cout << "count: " << bobResponse.values.size() << '\n';
     for (std::size_t i = 0; i < bobResponse.values.size(); ++i) {
-        const auto& value = bobResponse.values[i];
-        std::cout << "[" << i << "] point bytes: " << value.transformedPointEncoded.size() << '\n';
+        std::cout << "[" << i << "] point: " << base64Encode(bobResponse.values[i]) << '\n';
     }
     std::cout << "JSON payload: \n" << serializeBobTransformedMessageJson(bobResponse.values) << "\n";
 
@@ -0,0 +1,135 @@
+// Micro-benchmark of the ristretto255 scalar multiplication ladder on each
+// field backend this CPU supports (curve25519_backend.h), against
+// crypto_scalarmult_ristretto255 per element. Two workloads, both
+// single-threaded over internal elements (decode/encode excluded except in
+// the libsodium column, which cannot skip them):
+//   fixed:   one scalar for the whole batch (Bob's tagging and response)
+//   each:    a scalar per element (Alice's blinding and unblinding)
+// Every backend's encoded output is checked byte-for-byte against libsodium.
+// Usage: psi_field_bench [size ...]   (default sizes: 1024 4096)
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "crypto_utils.h"
+#include "curve25519_backend.h"
+#include "ristretto_point.h"
+
+extern "C" {
+#include <sodium.h>
+}
+
+namespace {
+
+template <typename Func>
+double timedMs(Func&& func) {
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+std::vector<RistrettoPoint> encodeAll(const std::vector<RistrettoElement>& elements) {
+    std::vector<RistrettoPoint> encoded(elements.size());
+    for (std::size_t i = 0; i < elements.size(); ++i) {
+        ristrettoEncode(encoded[i].data(), elements[i]);
+    }
+    return encoded;
+}
+
+void printRow(const std::string& backend, std::size_t size, double fixedMs, double eachMs,
+              double libsodiumMs) {
+    const double perElement = 1000.0 / static_cast<double>(size);
+    std::cout << "| " << std::setw(9) << backend << " | " << std::setw(6) << size << " | "
+              << std::setw(12) << std::fixed << std::setprecision(2) << fixedMs * perElement
+              << " | " << std::setw(11) << eachMs * perElement << " | " << std::setw(11)
+              << libsodiumMs / std::max(fixedMs, 1e-9) << "x |\n";
+}
+
+void runSize(std::size_t size) {
+    std::vector<RistrettoPoint> points(size);
+    std::vector<RistrettoElement> elements(size);
+    std::vector<RistrettoScalar> scalars(size);
+    std::vector<RecodedScalar> recoded;
+    recoded.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        elements[i] = hashToGroupElement("field bench " + std::to_string(i));
+        ristrettoEncode(points[i].data(), elements[i]);
+        crypto_core_ristretto255_scalar_random(scalars[i].data());
+        recoded.emplace_back(scalars[i].data());
+    }
+
+    std::vector<RistrettoPoint> fixedReference(size);
+    const double libsodiumMs = timedMs([&]() {
+        for (std::size_t i = 0; i < size; ++i) {
+            if (crypto_scalarmult_ristretto255(fixedReference[i].data(), scalars[0].data(),
+                                               points[i].data()) != 0) {
+                throw std::runtime_error("libsodium scalar multiplication failed");
+            }
+        }
+    });
+    std::vector<RistrettoPoint> eachReference(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        if (crypto_scalarmult_ristretto255(eachReference[i].data(), scalars[i].data(),
+                                           points[i].data()) != 0) {
+            throw std::runtime_error("libsodium scalar multiplication failed");
+        }
+    }
+    printRow("libsodium", size, libsodiumMs, libsodiumMs, libsodiumMs);
+
+    const FieldBackend original = activeFieldBackend();
+    for (const auto backend : {FieldBackend::Portable, FieldBackend::Mulx, FieldBackend::Avx2}) {
+        if (!fieldBackendSupported(backend)) {
+            continue;
+        }
+        setFieldBackend(backend);
+        std::vector<RistrettoElement> products(size);
+        const double fixedMs = timedMs([&]() {
+            ristrettoScalarMultBatch(recoded[0], elements.data(), size, products.data());
+        });
+        if (encodeAll(products) != fixedReference) {
+            throw std::runtime_error(std::string("fixed-scalar mismatch on ") +
+                                     fieldBackendName(backend));
+        }
+        const double eachMs = timedMs([&]() {
+            ristrettoScalarMultBatch(recoded.data(), elements.data(), size, products.data());
+        });
+        if (encodeAll(products) != eachReference) {
+            throw std::runtime_error(std::string("per-element mismatch on ") +
+                                     fieldBackendName(backend));
+        }
+        printRow(fieldBackendName(backend), size, fixedMs, eachMs, libsodiumMs);
+    }
+    setFieldBackend(original);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (sodium_init() < 0) {
+        std::cerr << "libsodium initialisation failed\n";
+        return 1;
+    }
+
+    std::vector<std::size_t> sizes;
+    for (int i = 1; i < argc; ++i) {
+        sizes.push_back(static_cast<std::size_t>(std::stoul(argv[i])));
+    }
+    if (sizes.empty()) {
+        sizes = {1024, 4096};
+    }
+
+    std::cout << "Scalar multiplication per field backend, single thread, us/element\n"
+              << "(default backend here: " << fieldBackendName(activeFieldBackend()) << ")\n\n";
+    std::cout << "| backend   | size   | fixed scalar | each scalar | vs libsodium |\n";
+    std::cout << "|-----------|--------|--------------|-------------|--------------|\n";
+    for (const auto size : sizes) {
+        runSize(size);
+    }
+    return 0;
+}
@@ -1,16 +1,24 @@
+#include <algorithm>
 #include <arpa/inet.h>
+#include <array>
 #include <chrono>
 #include <cctype>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <netinet/in.h>
 #include <stdexcept>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <sys/socket.h>
 #include <unistd.h>
 #include <vector>
 
+#include "calibration.h"
+#include "json_reader.h"
+#include "json_writer.h"
 #include "psi_protocol.h"
 #include "serialization_utils.h"
 
@@ -42,146 +50,175 @@ std::string trim(const std::string& input) {
     return input.substr(start, end - start);
 }
 
-double parseDouble(const std::string& token) {
-    return std::stod(token);
+// Request bodies and the units in them are bounded before any work is done;
+// ids are short labels, and the server is sized for sets of up to a million.
+constexpr std::size_t kMaxRequestBytes = std::size_t{64} << 20;
+
+JsonLimits requestLimits() {
+    JsonLimits limits;
+    limits.maxBytes = kMaxRequestBytes;
+    limits.maxDepth = 8;
+    limits.maxStringBytes = 256;
+    limits.maxArrayItems = std::size_t{1} << 20;
+    return limits;
 }
 
-std::string extractString(const std::string& object, const std::string& key) {
-    const std::string pattern = "\"" + key + "\":\"";
-    const auto pos = object.find(pattern);
-    if (pos == std::string::npos) {
-        throw std::runtime_error("Missing key: " + key);
-    }
-    std::size_t i = pos + pattern.size();
-    std::string value;
-    while (i < object.size()) {
-        char c = object[i++];
-        if (c == '\\') {
-            if (i >= object.size()) {
-                throw std::runtime_error("Invalid escape in string value");
+// [{"id": "...", "x": <number>, "y": <number>}, ...]; other members are
+// skipped.
+std::vector<Unit> readUnits(JsonReader& reader) {
+    static constexpr std::string_view kFields[] = {"id", "x", "y"};
+    std::vector<Unit> units;
+    reader.beginArray();
+    while (reader.nextItem()) {
+        Unit unit{};
+        bool seen[3] = {};
+        std::string_view key;
+        reader.beginObject();
+        while (reader.nextMember(key)) {
+            const auto field = std::find(std::begin(kFields), std::end(kFields), key) -
+                               std::begin(kFields);
+            if (field == 3) {
+                reader.skipValue();
+                continue;
             }
-            char next = object[i++];
-            switch (next) {
-                case '"': value.push_back('"'); break;
-                case '\\': value.push_back('\\'); break;
-                case 'n': value.push_back('\n'); break;
-                case 'r': value.push_back('\r'); break;
-                case 't': value.push_back('\t'); break;
-                default: value.push_back(next); break;
+            if (seen[field]) {
+                reader.fail("duplicate member \"" + std::string(key) + "\"");
+            }
+            seen[field] = true;
+            if (field == 0) {
+                unit.id.assign(reader.string());
+            } else {
+                (field == 1 ? unit.x : unit.y) = reader.number();
             }
-        } else if (c == '"') {
-            return value;
-        } else {
-            value.push_back(c);
         }
+        for (std::size_t i = 0; i < 3; ++i) {
+            if (!seen[i]) {
+                reader.fail("unit without \"" + std::string(kFields[i]) + "\"");
+            }
+        }
+        units.push_back(std::move(unit));
     }
-    throw std::runtime_error("Unterminated string value");
-}
-
-double extractNumber(const std::string& object, const std::string& key) {
-    const std::string pattern = "\"" + key + "\":";
-    const auto pos = object.find(pattern);
-    if (pos == std::string::npos) {
-        throw std::runtime_error("Missing key: " + key);
-    }
-    std::size_t i = pos + pattern.size();
-    std::size_t end = i;
-    while (end < object.size() && (std::isdigit(static_cast<unsigned char>(object[end])) || object[end] == '-' || object[end] == '+' || object[end] == '.' || object[end] == 'e' || object[end] == 'E')) {
-        ++end;
-    }
-    return parseDouble(object.substr(i, end - i));
+    return units;
 }
 
-std::vector<Unit> parseUnits(const std::string& body, const std::string& key) {
-    const std::string pattern = "\"" + key + "\"";
-    auto keyPos = body.find(pattern);
-    if (keyPos == std::string::npos) {
-        throw std::runtime_error("Missing array: " + key);
-    }
-    auto arrayStart = body.find('[', keyPos);
-    auto arrayEnd = body.find(']', arrayStart);
-    if (arrayStart == std::string::npos || arrayEnd == std::string::npos || arrayEnd < arrayStart) {
-        throw std::runtime_error("Invalid array structure for " + key);
-    }
-    std::string inner = body.substr(arrayStart + 1, arrayEnd - arrayStart - 1);
-    std::vector<Unit> units;
-    std::size_t cursor = 0;
-    while (true) {
-        auto start = inner.find('{', cursor);
-        if (start == std::string::npos) {
-            break;
+struct PsiRequest {
+    std::vector<Unit> bobUnits;
+    std::vector<Unit> aliceUnits;
+};
+
+// One pass over {"bob_units": [...], "alice_units": [...]}, units parsed in
+// place. Throws std::runtime_error with the position of the first problem.
+PsiRequest parsePsiRequest(std::string_view body) {
+    PsiRequest request;
+    bool seenBob = false;
+    bool seenAlice = false;
+    JsonReader reader(body, requestLimits());
+    std::string_view key;
+    reader.beginObject();
+    while (reader.nextMember(key)) {
+        bool* seen = key == "bob_units" ? &seenBob : key == "alice_units" ? &seenAlice : nullptr;
+        if (seen == nullptr) {
+            reader.skipValue();
+            continue;
         }
-        auto end = inner.find('}', start);
-        if (end == std::string::npos) {
-            throw std::runtime_error("Unterminated object in " + key);
+        if (*seen) {
+            reader.fail("duplicate member \"" + std::string(key) + "\"");
         }
-        auto object = inner.substr(start, end - start + 1);
-        Unit unit;
-        unit.id = extractString(object, "id");
-        unit.x = extractNumber(object, "x");
-        unit.y = extractNumber(object, "y");
-        units.push_back(unit);
-        cursor = end + 1;
+        *seen = true;
+        (seen == &seenBob ? request.bobUnits : request.aliceUnits) = readUnits(reader);
     }
-    return units;
+    reader.end();
+    if (!seenBob || !seenAlice) {
+        throw std::runtime_error(std::string("Missing array: ") +
+                                 (seenBob ? "alice_units" : "bob_units"));
+    }
+    return request;
 }
 
+// The whole response in one buffer, reserved up front and written once; the
+// flights go straight into it rather than through strings of their own.
 std::string buildResponseJson(const BobInitialTagMessage& bobMessage,
                               const AliceResponseMessage& aliceMessage,
                               const BobResponseMessage& bobResponse,
                               const std::vector<MatchedUnit>& matches,
-                              const std::array<double, 4>& timingsMs) {
-    std::ostringstream oss;
-    oss << "{\"bob_message\":" << serializeBobTagMessageJson(bobMessage.tags)
-        << ",\"alice_message\":" << serializeAliceBlindedMessageJson(aliceMessage.values)
-        << ",\"bob_response\":" << serializeBobTransformedMessageJson(bobResponse.values)
-        << ",\"intersection\":[";
+                              const std::array<double, 5>& timingsMs) {
+    static constexpr const char* kTimingKeys[] = {"parse", "bob_setup", "alice_setup",
+                                                  "bob_response", "alice_finalize"};
+    constexpr std::size_t kTimingBytes = 16;  // a "%g" number plus slack
+    std::size_t expectedSize = 128 + bobTagMessageJsonSize(bobMessage.tags) +
+                               aliceBlindedMessageJsonSize(aliceMessage.values) +
+                               bobTransformedMessageJsonSize(bobResponse.values);
+    for (const auto& match : matches) {
+        expectedSize += jsonStringSize(match.element) + 1;
+    }
+    for (const char* key : kTimingKeys) {
+        expectedSize += std::strlen(key) + kTimingBytes;
+    }
+
+    JsonWriter writer(expectedSize);
+    writer.raw("{\"bob_message\":");
+    writeBobTagMessageJson(writer, bobMessage.tags);
+    writer.raw(",\"alice_message\":");
+    writeAliceBlindedMessageJson(writer, aliceMessage.values);
+    writer.raw(",\"bob_response\":");
+    writeBobTransformedMessageJson(writer, bobResponse.values);
+    writer.raw(",\"intersection\":[");
     for (std::size_t i = 0; i < matches.size(); ++i) {
         if (i > 0) {
-            oss << ',';
+            writer.raw(',');
         }
-        oss << "\"" << matches[i].element << "\"";
+        writer.string(matches[i].element);
     }
-    oss << "],\"timings_ms\":{\"bob_setup\":" << timingsMs[0]
-        << ",\"alice_setup\":" << timingsMs[1]
-        << ",\"bob_response\":" << timingsMs[2]
-        << ",\"alice_finalize\":" << timingsMs[3] << "}}";
-    return oss.str();
+    writer.raw("],\"timings_ms\":{");
+    for (std::size_t i = 0; i < timingsMs.size(); ++i) {
+        writer.raw(i > 0 ? ",\"" : "\"");
+        writer.raw(kTimingKeys[i]);
+        writer.raw("\":");
+        writer.number(timingsMs[i]);
+    }
+    writer.raw("}}");
+    return writer.take();
 }
 
-std::string handlePsiRequest(const std::string& body) {
-    const auto bobUnits = parseUnits(body, "bob_units");
-    const auto aliceUnits = parseUnits(body, "alice_units");
+std::string handlePsiRequest(std::string_view body) {
+    std::array<double, 5> timings{};
 
-    std::array<double, 4> timings{};
+    const auto request = [&]() {
+        const auto start = std::chrono::steady_clock::now();
+        auto parsed = parsePsiRequest(body);
+        timings[0] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return parsed;
+    }();
+    const auto& bobUnits = request.bobUnits;
+    const auto& aliceUnits = request.aliceUnits;
 
     // Tag mode is the default: one-way membership tags instead of ciphertexts,
     // O(A) finalisation, fixed-size wire entries.
     const auto bobMessage = [&]() {
         const auto start = std::chrono::steady_clock::now();
         auto msg = bobCreateInitialTagMessage(bobUnits);
-        timings[0] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        timings[1] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
         return msg;
     }();
 
     const auto aliceMessage = [&]() {
         const auto start = std::chrono::steady_clock::now();
         auto msg = aliceProcessBobTagMessage(bobMessage.serialized, aliceUnits);
-        timings[1] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        timings[2] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
         return msg;
     }();
 
     const auto bobResponse = [&]() {
         const auto start = std::chrono::steady_clock::now();
         auto msg = bobProcessAliceMessage(aliceMessage.serialized, bobMessage.state);
-        timings[2] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        timings[3] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
         return msg;
     }();
 
     const auto matches = [&]() {
         const auto start = std::chrono::steady_clock::now();
         auto result = aliceFinalizeIntersectionTags(bobResponse.serialized, aliceMessage.state);
-        timings[3] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        timings[4] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
         return result;
     }();
 
@@ -202,7 +239,11 @@ std::string buildHttpResponse(const std::string& payload) {
 }
 
 std::string buildErrorResponse(const std::string& message) {
-    std::string payload = std::string("{\"error\":\"") + message + "\"}";
+    JsonWriter writer(jsonStringSize(message) + 11);
+    writer.raw("{\"error\":");
+    writer.string(message);
+    writer.raw('}');
+    const std::string payload = writer.take();
     std::ostringstream oss;
     oss << "HTTP/1.1 400 Bad Request\r\n"
         << "Content-Type: application/json\r\n"
@@ -237,6 +278,7 @@ void serveLoop(int serverFd) {
         }
 
         std::string request;
+        bool tooLarge = false;
         char buffer[4096];
         ssize_t bytesRead = 0;
         while ((bytesRead = read(clientFd, buffer, sizeof(buffer))) > 0) {
@@ -251,6 +293,10 @@ void serveLoop(int serverFd) {
                     auto lenStr = request.substr(lenPos + 15, lineEnd - (lenPos + 15));
                     contentLength = static_cast<std::size_t>(std::stoul(trim(lenStr)));
                 }
+                if (contentLength > kMaxRequestBytes) {
+                    tooLarge = true;
+                    break;
+                }
                 auto bodyStart = headerEnd + 4;
                 if (request.size() >= bodyStart + contentLength) {
                     break;
@@ -275,7 +321,11 @@ void serveLoop(int serverFd) {
                 if (headerEnd == std::string::npos) {
                     throw std::runtime_error("Missing headers terminator");
                 }
-                auto body = request.substr(headerEnd + 4);
+                if (tooLarge) {
+                    throw std::runtime_error("Request body exceeds " +
+                                             std::to_string(kMaxRequestBytes) + " bytes");
+                }
+                const auto body = std::string_view(request).substr(headerEnd + 4);
                 response = buildHttpResponse(handlePsiRequest(body));
             }
         } catch (const std::exception& ex) {
@@ -295,9 +345,48 @@ void serveLoop(int serverFd) {
     }
 }
 
+constexpr char kDefaultProfilePath[] = "psi_calibration.profile";
+
+// Boot-time execution policy: per-phase serial thresholds from a calibration
+// profile (calibration.h). --calibrate measures this host and writes the
+// profile; otherwise the profile is loaded. An explicit --profile must load;
+// only the default path may be missing, and then the built-in defaults apply.
+void configureExecutionPolicy(bool calibrate, const std::string& profilePath,
+                              bool profileRequired) {
+    ExecutionPolicy policy = defaultExecutionPolicy();
+    if (calibrate) {
+        const auto profile = calibrateExecutionPolicy(policy);
+        saveCalibrationProfile(profile, profilePath);
+        applyCalibrationProfile(profile, policy);
+        std::cout << "Calibrated " << profile.threads << " threads, wrote " << profilePath
+                  << std::endl;
+    } else if (profileRequired || std::ifstream(profilePath).good()) {
+        applyCalibrationProfile(loadCalibrationProfile(profilePath), policy);
+        std::cout << "Loaded calibration profile " << profilePath << std::endl;
+    }
+    setDefaultExecutionPolicy(policy);
+}
+
 }  // namespace
 
-int main() {
+// Usage: psi_server [--profile PATH] [--calibrate]
+int main(int argc, char** argv) {
+    bool calibrate = false;
+    bool profileGiven = false;
+    std::string profilePath = kDefaultProfilePath;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--calibrate") {
+            calibrate = true;
+        } else if (arg == "--profile" && i + 1 < argc) {
+            profilePath = argv[++i];
+            profileGiven = true;
+        } else {
+            std::cerr << "Usage: psi_server [--profile PATH] [--calibrate]\n";
+            return 1;
+        }
+    }
+
     try {
         ensureSodiumInitialised();
     } catch (const std::exception& ex) {
@@ -305,6 +394,13 @@ int main() {
         return 1;
     }
 
+    try {
+        configureExecutionPolicy(calibrate, profilePath, profileGiven);
+    } catch (const std::exception& ex) {
+        std::cerr << "Calibration profile error: " << ex.what() << '\n';
+        return 1;
+    }
+
     int serverFd = socket(AF_INET, SOCK_STREAM, 0);
     if (serverFd < 0) {
         std::perror("socket");
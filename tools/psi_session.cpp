@@ -14,6 +14,12 @@
 // Audit the forged one (expect FRAUD, exit 2):
 //   psi_audit <dir>/forged.transcript <dir>/opening_q.txt <pkP> <pkQ>
 //
+// --suite v2 (or v3) records the turn under that ciphersuite (ciphersuite.h)
+// and --format binary with binary flight bodies (serialization_utils.h); the
+// audit reads both from the recorded tag flights either way. --mode mutual
+// records the turn as a mutual exchange (runMutualRecordedExchange), which
+// audits the same.
+//
 // Master keys and signing keys are freshly random per run (SystemRng-level
 // randomness); determinism inside the exchange comes from the derived seeds.
 
@@ -48,13 +54,40 @@ void writeFile(const std::string& path, const std::string& content) {
 }  // namespace
 
 int main(int argc, char** argv) {
-    if (argc != 2) {
-        std::cerr << "Usage: psi_session <output-dir>\n";
+    std::string suiteName;
+    std::string formatName;
+    std::string modeName = "sequential";
+    int next = 1;
+    while (next + 2 < argc) {
+        const std::string flag = argv[next];
+        if (flag == "--suite") {
+            suiteName = argv[next + 1];
+        } else if (flag == "--format") {
+            formatName = argv[next + 1];
+        } else if (flag == "--mode") {
+            modeName = argv[next + 1];
+        } else {
+            break;
+        }
+        next += 2;
+    }
+    if (next != argc - 1) {
+        std::cerr << "Usage: psi_session [--suite v1|v2|v3] [--format text|binary]"
+                     " [--mode sequential|mutual] <output-dir>\n";
         return 1;
     }
-    const std::string dir = argv[1];
+    const std::string dir = argv[argc - 1];
 
     try {
+        const CipherSuite suite =
+            suiteName.empty() ? kDefaultCipherSuite : parseCipherSuite(suiteName);
+        const WireFormat format =
+            formatName.empty() ? kDefaultWireFormat : parseWireFormat(formatName);
+        if (modeName != "sequential" && modeName != "mutual") {
+            throw std::runtime_error("Unknown mode: " + modeName);
+        }
+        const auto exchange =
+            (modeName == "mutual") ? runMutualRecordedExchange : runRecordedExchange;
         if (sodium_init() < 0) {
             throw std::runtime_error("libsodium initialization failed");
         }
@@ -78,16 +111,17 @@ int main(int argc, char** argv) {
                                                     "L1:7 7"};
 
         // Honest turn.
-        const auto honest = runRecordedExchange(masterKeyP, masterKeyQ, elementsP, elementsQ,
-                                                turn, nMax, gameId, keysP, keysQ,
-                                                dir + "/honest.transcript");
+        const auto honest = exchange(masterKeyP, masterKeyQ, elementsP, elementsQ,
+                                     turn, nMax, gameId, keysP, keysQ,
+                                     dir + "/honest.transcript", nullptr, nullptr, suite,
+                                     format);
 
         // Forged turn: Q commits to elementsQ but probes with one element
         // swapped, the exact fraud pattern the audit exists to catch.
         std::vector<std::string> probeQ = elementsQ;
         probeQ[1] = "L1:99 99";
-        runRecordedExchange(masterKeyP, masterKeyQ, elementsP, elementsQ, turn, nMax, gameId,
-                            keysP, keysQ, dir + "/forged.transcript", nullptr, &probeQ);
+        exchange(masterKeyP, masterKeyQ, elementsP, elementsQ, turn, nMax, gameId, keysP, keysQ,
+                 dir + "/forged.transcript", nullptr, &probeQ, suite, format);
 
         // Q's opening: the committed set and master key.
         std::string opening = "accused: Q\n";